@@ -0,0 +1,33 @@
+/*
+ * Benchmark Latency Histogram
+ * Log2-bucketed per-operation latencies: bucket k counts operations that
+ * took [2^(k-1), 2^k) microseconds (bucket 0 = under 1 us, last bucket =
+ * everything from 2^(BENCH_HIST_BUCKETS-2) us upwards).
+ */
+
+#ifndef BENCH_HIST_H
+#define BENCH_HIST_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define BENCH_HIST_BUCKETS 24   // Up to ~4 s per operation
+
+typedef struct {
+    uint16_t count[BENCH_HIST_BUCKETS];
+} bench_hist_t;
+
+static inline void bench_hist_reset(bench_hist_t *h) {
+    memset(h, 0, sizeof(*h));
+}
+
+static inline void bench_hist_add(bench_hist_t *h, uint32_t us) {
+    int k = 0;
+    while (us != 0 && k < BENCH_HIST_BUCKETS - 1) {
+        us >>= 1;
+        k++;
+    }
+    if (h->count[k] != UINT16_MAX) h->count[k]++;
+}
+
+#endif // BENCH_HIST_H
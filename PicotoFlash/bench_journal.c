@@ -0,0 +1,223 @@
+/*
+ * Benchmark History Journal Module
+ * Batched, CRC-checked, commit-marked append log with mount-time recovery
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "ff.h"
+#include "bench_journal.h"
+#include "crc32.h"
+#include "identification.h"
+#include "sd_functions.h"
+#include "str_util.h"
+
+_Static_assert(sizeof(journal_record_t) == JOURNAL_RECORD_SIZE, "journal record size");
+_Static_assert(JOURNAL_SECTOR_SIZE % JOURNAL_RECORD_SIZE == 0, "records must tile sectors");
+
+#define RECORDS_PER_SECTOR (JOURNAL_SECTOR_SIZE / JOURNAL_RECORD_SIZE)
+#define STAGE_RECORDS (JOURNAL_BATCH_SECTORS * RECORDS_PER_SECTOR)
+
+// Batch staging buffer (one f_write per commit)
+static journal_record_t g_stage[STAGE_RECORDS] __attribute__((aligned(4)));
+static uint32_t g_stage_count = 0;
+static uint32_t g_next_seq = 0;
+static bool g_needs_recover = false;   // A failed commit may have left a torn tail
+
+// Recovery scan buffer
+static journal_record_t g_scan[RECORDS_PER_SECTOR] __attribute__((aligned(4)));
+
+static void seal(journal_record_t *r, uint8_t type) {
+    r->magic = JOURNAL_MAGIC;
+    r->type = type;
+    r->version = JOURNAL_VERSION;
+    r->reserved = 0;
+    r->seq = g_next_seq++;
+    r->crc32 = crc32_calc(r, offsetof(journal_record_t, crc32));
+}
+
+static bool record_valid(const journal_record_t *r) {
+    return r->magic == JOURNAL_MAGIC &&
+           r->crc32 == crc32_calc(r, offsetof(journal_record_t, crc32));
+}
+
+// ============================================================================
+// Recovery
+// ============================================================================
+
+// Walks the journal batch by batch and truncates everything after the last
+// batch whose commit record matches the records before it. Must run after
+// every mount, before the first journal_commit(). Staged records survive.
+int journal_recover(void) {
+    g_needs_recover = false;
+
+    FIL file;
+    FRESULT fr = f_open(&file, JOURNAL_FILE, FA_READ | FA_WRITE | FA_OPEN_EXISTING);
+    if (fr == FR_NO_FILE) return SUCCESS;
+    if (fr != FR_OK) {
+        printf("[ERROR] ERROR_FILE_NOT_FOUND: Cannot open %s (%d)\n", JOURNAL_FILE, fr);
+        return ERROR_FILE_NOT_FOUND;
+    }
+
+    uint64_t t0 = time_us_64();
+    FSIZE_t size = f_size(&file);
+    FSIZE_t good_end = 0;
+    uint32_t committed = 0, batch_records = 0, batch_crc = CRC32_INIT, batch_first = 0;
+    journal_record_t *sector = g_scan;
+
+    for (FSIZE_t off = 0; off + JOURNAL_SECTOR_SIZE <= size; off += JOURNAL_SECTOR_SIZE) {
+        UINT br = 0;
+        if (f_read(&file, sector, JOURNAL_SECTOR_SIZE, &br) != FR_OK || br != JOURNAL_SECTOR_SIZE) break;
+
+        bool stop = false;
+        for (int i = 0; i < RECORDS_PER_SECTOR && !stop; i++) {
+            const journal_record_t *r = &sector[i];
+            if (!record_valid(r)) {
+                stop = true;
+            } else if (r->type == JOURNAL_TYPE_COMMIT) {
+                const journal_commit_t *c = &r->u.commit;
+                if (c->count != batch_records || c->first_seq != batch_first ||
+                    c->batch_crc32 != crc32_final(batch_crc)) {
+                    stop = true;
+                } else {
+                    good_end = off + (FSIZE_t)(i + 1) * JOURNAL_RECORD_SIZE;
+                    if (r->seq + 1 > g_next_seq) g_next_seq = r->seq + 1;
+                    committed++;
+                    batch_records = 0;
+                    batch_crc = CRC32_INIT;
+                }
+            } else {
+                if (batch_records == 0) batch_first = r->seq;
+                batch_crc = crc32_update(batch_crc, r, JOURNAL_RECORD_SIZE);
+                batch_records++;
+            }
+        }
+        if (stop) break;
+    }
+
+    fr = FR_OK;
+    if (good_end != size) {
+        fr = f_lseek(&file, good_end);
+        if (fr == FR_OK) fr = f_truncate(&file);
+        if (fr == FR_OK) fr = f_sync(&file);
+    }
+    f_close(&file);
+
+    uint32_t ms = (uint32_t)((time_us_64() - t0) / 1000u);
+    if (good_end != size) {
+        printf("[WARN] Journal: dropped %lu torn/uncommitted bytes after %lu batches (%lu ms)\n",
+               (unsigned long)(size - good_end), (unsigned long)committed, (unsigned long)ms);
+    } else {
+        printf("[INFO] Journal: %lu committed batches, clean (%lu ms)\n",
+               (unsigned long)committed, (unsigned long)ms);
+    }
+    if (fr != FR_OK) {
+        g_needs_recover = true;
+        printf("[ERROR] ERROR_SD_WRITE_FAIL: Journal truncate failed (%d)\n", fr);
+        return ERROR_SD_WRITE_FAIL;
+    }
+    return SUCCESS;
+}
+
+// ============================================================================
+// Append / commit
+// ============================================================================
+
+// Stages one data record for the current flow results. Commits first if
+// the staging buffer has no room left for the record plus a commit.
+int journal_append_run(uint8_t flags) {
+    if (g_stage_count + 2 > STAGE_RECORDS) {
+        int rc = journal_commit();
+        if (rc != SUCCESS) return rc;
+    }
+
+    journal_record_t *r = &g_stage[g_stage_count];
+    memset(r, 0, sizeof(*r));
+    journal_data_t *d = &r->u.data;
+
+    int year, month, day, hour, min, sec;
+    get_timestamp(&year, &month, &day, &hour, &min, &sec);
+    d->year = (uint16_t)year;
+    d->month = (uint8_t)month;
+    d->day = (uint8_t)day;
+    d->hour = (uint8_t)hour;
+    d->min = (uint8_t)min;
+    d->sec = (uint8_t)sec;
+
+    str_copy(d->jedec_id, sizeof(d->jedec_id), test_chip.jedec_id);
+    if (match_results[0].database_index >= 0) {
+        str_copy(d->company, sizeof(d->company), match_results[0].chip_data.company);
+        str_copy(d->model, sizeof(d->model), match_results[0].chip_data.chip_model);
+    }
+    d->match_status = (uint8_t)match_results[0].status;
+    d->match_confidence = match_results[0].confidence.overall_confidence;
+    d->capacity_mbit = test_chip.capacity_mbit;
+    d->read_speed_50mhz = test_chip.read_speed_max;
+    d->erase_64k_ms = test_chip.typ_64kb_erase_ms;
+    d->max_clock_mhz = test_chip.max_clock_freq_mhz;
+    d->flags = flags;
+
+    seal(r, JOURNAL_TYPE_DATA);
+    g_stage_count++;
+    return SUCCESS;
+}
+
+// Pads the staged records to a sector multiple, closes the batch with a
+// commit record and makes it durable with one f_write() and one f_sync().
+int journal_commit(void) {
+    if (g_stage_count == 0) return SUCCESS;
+
+    if (!check_sd_free_space()) {
+        printf("[ERROR] ERROR_SD_FULL: Journal batch not written\n");
+        return ERROR_SD_FULL;
+    }
+    if (g_needs_recover && journal_recover() != SUCCESS) {
+        return ERROR_SD_WRITE_FAIL;
+    }
+
+    uint32_t data_count = g_stage_count;
+    uint32_t total = (data_count + 1 + RECORDS_PER_SECTOR - 1) / RECORDS_PER_SECTOR * RECORDS_PER_SECTOR;
+
+    while (g_stage_count < total - 1) {
+        journal_record_t *pad = &g_stage[g_stage_count++];
+        memset(pad, 0, sizeof(*pad));
+        seal(pad, JOURNAL_TYPE_PAD);
+    }
+
+    journal_record_t *c = &g_stage[g_stage_count];
+    memset(c, 0, sizeof(*c));
+    c->u.commit.first_seq = g_stage[0].seq;
+    c->u.commit.count = g_stage_count;
+    c->u.commit.batch_crc32 = crc32_calc(g_stage, (size_t)g_stage_count * JOURNAL_RECORD_SIZE);
+    seal(c, JOURNAL_TYPE_COMMIT);
+
+    UINT len = (UINT)(total * JOURNAL_RECORD_SIZE);
+    UINT bw = 0;
+    FIL file;
+    FRESULT fr = f_open(&file, JOURNAL_FILE, FA_WRITE | FA_OPEN_APPEND);
+    if (fr == FR_OK) {
+        fr = f_write(&file, g_stage, len, &bw);
+        if (fr == FR_OK && bw != len) fr = FR_DENIED;
+        if (fr == FR_OK) fr = f_sync(&file);
+        f_close(&file);
+    }
+
+    if (fr != FR_OK) {
+        // Keep the data records for the next attempt; pads and commit are resealed
+        g_stage_count = data_count;
+        g_needs_recover = true;
+        printf("[ERROR] ERROR_SD_WRITE_FAIL: Journal commit failed (%d)\n", fr);
+        return ERROR_SD_WRITE_FAIL;
+    }
+
+    printf("✓ Journal: committed %lu records (%u bytes, 1 sync)\n",
+           (unsigned long)data_count, (unsigned)len);
+    g_stage_count = 0;
+    return SUCCESS;
+}
+
+uint32_t journal_pending(void) {
+    return g_stage_count;
+}
@@ -0,0 +1,81 @@
+/*
+ * Benchmark History Journal Module Header
+ * Crash-safe append-only log of flow results. Fixed-size CRC-protected
+ * records are staged in RAM and written in batches: data records, padding
+ * up to a sector multiple, then a commit record covering the batch, in one
+ * f_write() followed by one f_sync(). A batch without a valid commit
+ * record never happened; journal_recover() truncates it away at mount.
+ */
+
+#ifndef BENCH_JOURNAL_H
+#define BENCH_JOURNAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// File definitions
+#define JOURNAL_FILE "bench_journal.bin"
+
+// Constants
+#define JOURNAL_MAGIC 0x4A424650u      // "PFBJ"
+#define JOURNAL_VERSION 1
+#define JOURNAL_RECORD_SIZE 128
+#define JOURNAL_SECTOR_SIZE 512
+#define JOURNAL_BATCH_SECTORS 4        // Staging buffer: up to 15 data records per batch
+
+// Record types
+#define JOURNAL_TYPE_DATA   0x01
+#define JOURNAL_TYPE_PAD    0x02
+#define JOURNAL_TYPE_COMMIT 0x03
+
+#pragma pack(push, 1)
+
+typedef struct {
+    uint16_t year;
+    uint8_t month, day, hour, min, sec;
+    uint8_t match_status;              // match_status_t
+    char jedec_id[12];                 // Measured, "EF 40 18"
+    char company[24];                  // Best match
+    char model[32];
+    float capacity_mbit;               // Measured
+    float read_speed_50mhz;
+    float erase_64k_ms;
+    float match_confidence;
+    int32_t max_clock_mhz;
+    uint8_t flags;                     // JOURNAL_FLAG_*
+    uint8_t reserved[11];
+} journal_data_t;
+
+typedef struct {
+    uint32_t first_seq;                // Sequence of the batch's first record
+    uint32_t count;                    // Records before this commit (data + pad)
+    uint32_t batch_crc32;              // CRC-32 over those records
+    uint8_t reserved[100];
+} journal_commit_t;
+
+typedef struct {
+    uint32_t magic;
+    uint8_t type;                      // JOURNAL_TYPE_*
+    uint8_t version;
+    uint16_t reserved;
+    uint32_t seq;                      // Monotonic across the file
+    union {
+        journal_data_t data;
+        journal_commit_t commit;
+        uint8_t raw[112];
+    } u;
+    uint32_t crc32;                    // CRC-32 of all preceding bytes
+} journal_record_t;
+
+#pragma pack(pop)
+
+#define JOURNAL_FLAG_CACHED      0x01u
+#define JOURNAL_FLAG_DESTRUCTIVE 0x02u
+
+// Function declarations
+int journal_recover(void);
+int journal_append_run(uint8_t flags);
+int journal_commit(void);
+uint32_t journal_pending(void);
+
+#endif // BENCH_JOURNAL_H
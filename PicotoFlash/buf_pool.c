@@ -0,0 +1,90 @@
+/*
+ * Buffer Pool Module
+ * First-fit over a block bitmap, guarded by the kernel's critical section
+ * so any task (flash worker, SD writer, match) can check out and return.
+ */
+
+#include <stdio.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "buf_pool.h"
+
+_Static_assert(BUF_POOL_BLOCKS <= 32, "block bitmap is 32 bits");
+
+static uint8_t g_pool[BUF_POOL_BYTES] __attribute__((aligned(8)));   // span_event_t holds pointers
+static uint32_t g_used_mask;                    // Bit per block checked out
+static uint8_t g_run_len[BUF_POOL_BLOCKS];      // Blocks in the checkout starting here
+static buf_pool_stats_t g_stats;
+
+static uint32_t run_bits(uint32_t first, uint32_t n) {
+    return (n >= 32 ? 0xFFFFFFFFu : ((1u << n) - 1u)) << first;
+}
+
+// Caller holds the critical section; returns the first block or -1
+static int find_run(uint32_t n) {
+    uint32_t run = 0;
+    for (uint32_t i = 0; i < BUF_POOL_BLOCKS; i++) {
+        run = (g_used_mask & (1u << i)) ? 0 : run + 1;
+        if (run == n) return (int)(i + 1 - n);
+    }
+    return -1;
+}
+
+void *buf_pool_get(size_t bytes, const char *owner) {
+    uint32_t n = (uint32_t)((bytes + BUF_POOL_BLOCK_BYTES - 1) / BUF_POOL_BLOCK_BYTES);
+    if (n == 0) n = 1;
+    void *buf = NULL;
+
+    taskENTER_CRITICAL();
+    int first = n <= BUF_POOL_BLOCKS ? find_run(n) : -1;
+    if (first >= 0) {
+        g_used_mask |= run_bits((uint32_t)first, n);
+        g_run_len[first] = (uint8_t)n;
+        g_stats.blocks_used += n;
+        g_stats.checkouts++;
+        if (g_stats.blocks_used > g_stats.high_water_blocks) {
+            g_stats.high_water_blocks = g_stats.blocks_used;
+            g_stats.peak_owner = owner;
+        }
+        buf = &g_pool[(uint32_t)first * BUF_POOL_BLOCK_BYTES];
+    } else {
+        g_stats.failures++;
+    }
+    taskEXIT_CRITICAL();
+
+    if (!buf) {
+        printf("[WARN] Buffer pool: no %lu KiB run for %s (%lu/%u blocks out)\n",
+               (unsigned long)(n * BUF_POOL_BLOCK_BYTES / 1024), owner ? owner : "?",
+               (unsigned long)g_stats.blocks_used, BUF_POOL_BLOCKS);
+    }
+    return buf;
+}
+
+void buf_pool_put(void *buf) {
+    if (!buf) return;
+    uint32_t first = (uint32_t)((uint8_t *)buf - g_pool) / BUF_POOL_BLOCK_BYTES;
+    taskENTER_CRITICAL();
+    uint32_t n = first < BUF_POOL_BLOCKS ? g_run_len[first] : 0;
+    if (n) {
+        g_used_mask &= ~run_bits(first, n);
+        g_run_len[first] = 0;
+        g_stats.blocks_used -= n;
+    }
+    taskEXIT_CRITICAL();
+}
+
+buf_pool_stats_t buf_pool_get_stats(void) {
+    taskENTER_CRITICAL();
+    buf_pool_stats_t s = g_stats;
+    taskEXIT_CRITICAL();
+    return s;
+}
+
+void buf_pool_reset_peak(void) {
+    taskENTER_CRITICAL();
+    g_stats.high_water_blocks = g_stats.blocks_used;
+    g_stats.peak_owner = NULL;
+    g_stats.checkouts = 0;
+    g_stats.failures = 0;
+    taskEXIT_CRITICAL();
+}
@@ -0,0 +1,43 @@
+/*
+ * Buffer Pool Module Header
+ * Static, boot-time arena of word-aligned blocks (DMA-safe) that the flash
+ * benches, the backup pipeline and the SD writers check out and return
+ * instead of calling malloc per clock/run. A checkout takes a contiguous run
+ * of blocks; the high-water mark shows how much of the arena a flow needed.
+ * The flow traces hold their buffers for the whole flow, so each enabled
+ * trace adds its blocks on top of the benches' peak.
+ */
+
+#ifndef BUF_POOL_H
+#define BUF_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "span_trace.h"
+#include "spi_trace.h"
+
+// Constants
+#define BUF_POOL_BLOCK_BYTES 4096u
+#define BUF_POOL_BLOCKS_FOR(bytes) (((bytes) + BUF_POOL_BLOCK_BYTES - 1u) / BUF_POOL_BLOCK_BYTES)
+#define BUF_POOL_BENCH_BLOCKS 16u       // 64 KiB: the largest bench buffer
+#define BUF_POOL_BLOCKS ((unsigned)(BUF_POOL_BENCH_BLOCKS + BUF_POOL_BLOCKS_FOR(SPAN_TRACE_POOL_BYTES) + \
+                                    BUF_POOL_BLOCKS_FOR(SPI_TRACE_POOL_BYTES)))   // Max 32
+#define BUF_POOL_BYTES (BUF_POOL_BLOCK_BYTES * BUF_POOL_BLOCKS)
+
+// Counters since boot (or the last buf_pool_reset_peak())
+typedef struct {
+    uint32_t blocks_used;           // Checked out right now
+    uint32_t high_water_blocks;
+    uint32_t checkouts;
+    uint32_t failures;              // No contiguous run was free
+    const char *peak_owner;         // Checkout that set the high-water mark
+} buf_pool_stats_t;
+
+// Function declarations
+void *buf_pool_get(size_t bytes, const char *owner);
+void buf_pool_put(void *buf);
+buf_pool_stats_t buf_pool_get_stats(void);
+void buf_pool_reset_peak(void);
+
+#endif // BUF_POOL_H
@@ -0,0 +1,82 @@
+/*
+ * Button Event Module
+ * Edge IRQ -> queue, FreeRTOS timer debounce
+ */
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "buttons.h"
+#include "timers.h"
+
+typedef struct {
+    uint8_t pin;
+    volatile bool locked;       // Press reported, waiting for a stable release
+    bool released_once;         // Saw the pin high at the previous timer expiry
+    TimerHandle_t timer;
+} button_t;
+
+static button_t g_buttons[BUTTONS_MAX];
+static int g_button_count = 0;
+static QueueHandle_t g_button_queue = NULL;
+
+static button_t *find_button(uint gpio) {
+    for (int i = 0; i < g_button_count; i++) {
+        if (g_buttons[i].pin == gpio) return &g_buttons[i];
+    }
+    return NULL;
+}
+
+static void button_irq(uint gpio, uint32_t events) {
+    if (!(events & GPIO_IRQ_EDGE_FALL)) return;
+    button_t *b = find_button(gpio);
+    if (!b || b->locked) return;
+
+    b->locked = true;
+    b->released_once = false;
+
+    BaseType_t woken = pdFALSE;
+    button_event_t evt = {b->pin, time_us_64()};
+    xQueueSendFromISR(g_button_queue, &evt, &woken);
+    xTimerResetFromISR(b->timer, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+// Runs in the timer task every BUTTON_DEBOUNCE_MS while a button is locked
+static void debounce_expired(TimerHandle_t timer) {
+    button_t *b = (button_t *)pvTimerGetTimerID(timer);
+    if (!gpio_get(b->pin)) {
+        b->released_once = false;      // Still held (or bouncing)
+    } else if (b->released_once) {
+        b->locked = false;             // Released for a full period
+        return;
+    } else {
+        b->released_once = true;
+    }
+    xTimerReset(timer, 0);
+}
+
+bool buttons_init(const uint8_t *pins, int count, QueueHandle_t queue) {
+    if (count > BUTTONS_MAX || queue == NULL) return false;
+    g_button_queue = queue;
+    g_button_count = count;
+
+    for (int i = 0; i < count; i++) {
+        button_t *b = &g_buttons[i];
+        b->pin = pins[i];
+        b->locked = false;
+        b->released_once = false;
+        b->timer = xTimerCreate("debounce", pdMS_TO_TICKS(BUTTON_DEBOUNCE_MS), pdFALSE, b,
+                                debounce_expired);
+        if (!b->timer) {
+            printf("[ERROR] Cannot create debounce timer for GP%u\n", b->pin);
+            return false;
+        }
+
+        gpio_init(b->pin);
+        gpio_set_dir(b->pin, GPIO_IN);
+        gpio_pull_up(b->pin);
+        gpio_set_irq_enabled_with_callback(b->pin, GPIO_IRQ_EDGE_FALL, true, button_irq);
+    }
+    return true;
+}
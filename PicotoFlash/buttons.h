@@ -0,0 +1,30 @@
+/*
+ * Button Event Module Header
+ * GPIO falling-edge IRQs turn presses into queued events. The first edge
+ * is reported immediately (leading-edge debounce); a per-button FreeRTOS
+ * timer then keeps the button locked until it has read released for two
+ * consecutive debounce periods, swallowing bounce on press and release.
+ */
+
+#ifndef BUTTONS_H
+#define BUTTONS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "queue.h"
+
+// Constants
+#define BUTTONS_MAX 4
+#define BUTTON_DEBOUNCE_MS 50
+
+// Queued on every accepted press
+typedef struct {
+    uint8_t pin;
+    uint64_t t_us;              // time_us_64() at the IRQ
+} button_event_t;
+
+// Function declarations
+bool buttons_init(const uint8_t *pins, int count, QueueHandle_t queue);
+
+#endif // BUTTONS_H
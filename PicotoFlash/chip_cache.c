@@ -0,0 +1,165 @@
+/*
+ * Chip Result Cache Module
+ * Remembers the outcome of a full flow per physical chip so that a chip
+ * coming back to the station can be answered without re-benchmarking.
+ *
+ * The cache is a flat file of fixed-size chip_cache_entry_t records.
+ * Lookups scan it linearly (a few hundred records at most); an update for
+ * a known key overwrites its slot, a new key is appended.
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "ff.h"
+#include "chip_cache.h"
+#include "crc32.h"
+#include "sd_functions.h"
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+bool chip_cache_uid_valid(const uint8_t *uid, uint8_t uid_len) {
+    if (uid_len == 0 || uid_len > CHIP_CACHE_UID_MAX) return false;
+
+    // Parts without a unique ID command float MISO (0xFF) or hold it low
+    bool all_ff = true, all_00 = true;
+    for (uint8_t i = 0; i < uid_len; i++) {
+        if (uid[i] != 0xFF) all_ff = false;
+        if (uid[i] != 0x00) all_00 = false;
+    }
+    return !(all_ff || all_00);
+}
+
+static uint32_t entry_crc(const chip_cache_entry_t *e) {
+    return crc32_calc(e, offsetof(chip_cache_entry_t, crc32));
+}
+
+static bool entry_ok(const chip_cache_entry_t *e) {
+    return e->magic == CHIP_CACHE_MAGIC &&
+           e->version == CHIP_CACHE_VERSION &&
+           e->record_size == sizeof(chip_cache_entry_t) &&
+           e->crc32 == entry_crc(e);
+}
+
+static bool entry_key_matches(const chip_cache_entry_t *e, const uint8_t jedec[3],
+                              const uint8_t *uid, uint8_t uid_len) {
+    return memcmp(e->jedec, jedec, 3) == 0 &&
+           e->uid_len == uid_len &&
+           memcmp(e->uid, uid, uid_len) == 0;
+}
+
+// Returns slot index of the key, or -1. *free_slot receives the first
+// unusable (corrupt) slot or the append position.
+static int find_slot(FIL *file, const uint8_t jedec[3], const uint8_t *uid,
+                     uint8_t uid_len, chip_cache_entry_t *out, int *free_slot) {
+    chip_cache_entry_t e;
+    UINT br = 0;
+    int slot = 0;
+    int first_bad = -1;
+
+    f_lseek(file, 0);
+    while (slot < CHIP_CACHE_MAX_ENTRIES &&
+           f_read(file, &e, sizeof(e), &br) == FR_OK && br == sizeof(e)) {
+        if (!entry_ok(&e)) {
+            if (first_bad < 0) first_bad = slot;
+        } else if (entry_key_matches(&e, jedec, uid, uid_len)) {
+            if (out) *out = e;
+            return slot;
+        }
+        slot++;
+    }
+
+    if (free_slot) *free_slot = (first_bad >= 0) ? first_bad : slot;
+    return -1;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+bool chip_cache_lookup(const uint8_t jedec[3], const uint8_t *uid, uint8_t uid_len,
+                       chip_cache_entry_t *out) {
+    if (!chip_cache_uid_valid(uid, uid_len)) return false;
+
+    FIL file;
+    if (f_open(&file, CHIP_CACHE_FILE, FA_READ) != FR_OK) return false;
+
+    int slot = find_slot(&file, jedec, uid, uid_len, out, NULL);
+    f_close(&file);
+    return slot >= 0;
+}
+
+int chip_cache_store(chip_cache_entry_t *entry) {
+    if (!chip_cache_uid_valid(entry->uid, entry->uid_len)) {
+        printf("[CACHE] No usable unique ID, result not cached\n");
+        return ERROR_FILE_WRITE_FAIL;
+    }
+
+    FIL file;
+    FRESULT fr = f_open(&file, CHIP_CACHE_FILE, FA_READ | FA_WRITE | FA_OPEN_ALWAYS);
+    if (fr != FR_OK) {
+        printf("[ERROR] ERROR_FILE_WRITE_FAIL: Cannot open %s (%d)\n", CHIP_CACHE_FILE, fr);
+        return ERROR_FILE_WRITE_FAIL;
+    }
+
+    chip_cache_entry_t prev;
+    int free_slot = 0;
+    int slot = find_slot(&file, entry->jedec, entry->uid, entry->uid_len, &prev, &free_slot);
+    if (slot >= 0) {
+        entry->run_count = (uint16_t)(prev.run_count + 1);
+    } else {
+        if (free_slot >= CHIP_CACHE_MAX_ENTRIES) {
+            f_close(&file);
+            printf("[WARNING] Chip cache full (%d entries), result not cached\n",
+                   CHIP_CACHE_MAX_ENTRIES);
+            return ERROR_SD_FULL;
+        }
+        slot = free_slot;
+        entry->run_count = 1;
+    }
+
+    entry->magic = CHIP_CACHE_MAGIC;
+    entry->version = CHIP_CACHE_VERSION;
+    entry->record_size = sizeof(chip_cache_entry_t);
+    entry->crc32 = entry_crc(entry);
+
+    UINT bw = 0;
+    fr = f_lseek(&file, (FSIZE_t)slot * sizeof(chip_cache_entry_t));
+    if (fr == FR_OK) fr = f_write(&file, entry, sizeof(*entry), &bw);
+    f_close(&file);
+
+    if (fr != FR_OK || bw != sizeof(*entry)) {
+        printf("[ERROR] ERROR_FILE_WRITE_FAIL: Chip cache write failed (%d)\n", fr);
+        return ERROR_FILE_WRITE_FAIL;
+    }
+
+    printf("✓ Chip cache updated (slot %d, seen %u time%s)\n",
+           slot, entry->run_count, entry->run_count == 1 ? "" : "s");
+    return SUCCESS;
+}
+
+void chip_cache_print_entry(const chip_cache_entry_t *e) {
+    printf("\n=======================================================\n");
+    printf(" KNOWN CHIP (cached result)\n");
+    printf("=======================================================\n");
+    printf("JEDEC ID:     %s\n", e->measured.jedec_id);
+    printf("Unique ID:    ");
+    for (uint8_t i = 0; i < e->uid_len; i++) printf("%02X", e->uid[i]);
+    printf("\n");
+    printf("Seen before:  %u run%s\n", e->run_count, e->run_count == 1 ? "" : "s");
+    printf("Read 50MHz:   %.2f MB/s\n", e->measured.read_speed_max);
+    printf("64KB Erase:   %.1f ms\n", e->measured.typ_64kb_erase_ms);
+    if (e->match_status != MATCH_UNKNOWN) {
+        printf("Match:        %s %s (%.1f%%)\n",
+               e->matched.company, e->matched.chip_model, e->match_confidence);
+    } else {
+        printf("Match:        UNKNOWN (best %.1f%%)\n", e->match_confidence);
+    }
+    if (e->image_valid) {
+        printf("Image:        %u bytes, CRC32=%08X\n",
+               (unsigned)e->image_bytes, (unsigned)e->image_crc32);
+    }
+    printf("=======================================================\n");
+}
@@ -0,0 +1,55 @@
+/*
+ * Chip Result Cache Module Header
+ * On-SD cache of previous flow results, keyed by JEDEC ID + factory unique ID
+ */
+
+#ifndef CHIP_CACHE_H
+#define CHIP_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "identification.h"
+
+// File definitions
+#define CHIP_CACHE_FILE "chip_cache.bin"
+
+// Constants
+#define CHIP_CACHE_MAGIC 0x43434650u   // "PFCC"
+#define CHIP_CACHE_VERSION 1
+#define CHIP_CACHE_UID_MAX 16
+#define CHIP_CACHE_MAX_ENTRIES 256
+#define CHIP_CACHE_HEAD_BYTES (64u * 1024u)  // Region re-hashed for re-validation
+
+// One cached chip (fixed-size record, overwritten in place on update)
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+
+    // Key
+    uint8_t jedec[3];
+    uint8_t uid_len;
+    uint8_t uid[CHIP_CACHE_UID_MAX];
+
+    // Previous results
+    FlashChipData measured;        // test_chip at the end of the flow
+    FlashChipData matched;         // match_results[0].chip_data
+    float match_confidence;
+    uint8_t match_status;          // match_status_t
+    bool image_valid;              // Backup completed and hashed
+    uint16_t run_count;
+    uint32_t image_bytes;
+    uint32_t image_crc32;          // CRC-32 of the full backup image
+    uint32_t head_crc32;           // CRC-32 of the first CHIP_CACHE_HEAD_BYTES
+
+    uint32_t crc32;                // CRC-32 of all preceding bytes
+} chip_cache_entry_t;
+
+// Function declarations
+bool chip_cache_uid_valid(const uint8_t *uid, uint8_t uid_len);
+bool chip_cache_lookup(const uint8_t jedec[3], const uint8_t *uid, uint8_t uid_len,
+                       chip_cache_entry_t *out);
+int chip_cache_store(chip_cache_entry_t *entry);
+void chip_cache_print_entry(const chip_cache_entry_t *entry);
+
+#endif // CHIP_CACHE_H
@@ -0,0 +1,156 @@
+/*
+ * System Clock Turbo Module
+ * The switch itself runs as an SD worker job: the worker is pinned to the
+ * FreeRTOS tick core (SysTick is per core and clocked from clk_sys) and owns
+ * the SD card, so no SPI1 transfer is in flight while the clocks move. The
+ * caller is the flash worker, which is blocked in sd_worker_call() and
+ * therefore not using SPI0/PIO either.
+ */
+
+#include <stdio.h>
+#include "clock_turbo.h"
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/vreg.h"
+#include "hardware/structs/systick.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "sd_worker.h"
+#include "sd_functions.h"
+#include "hw_config.h"
+#include "span_trace.h"
+
+static spi_inst_t *sd_spi_inst(void) {
+    sd_card_t *sd = sd_get_by_num(0);
+    return (sd && sd->spi) ? sd->spi->hw_inst : NULL;
+}
+
+// spi_set_baudrate()'s divisor search, for a clk_peri that is not running yet
+static uint32_t pl022_hz_at(uint32_t freq_in, uint32_t baudrate) {
+    if (baudrate == 0) return 0;
+    uint prescale, postdiv;
+    for (prescale = 2; prescale <= 254; prescale += 2) {
+        if (freq_in < (prescale + 2) * 256 * (uint64_t)baudrate) break;
+    }
+    if (prescale > 254) return 0;
+    for (postdiv = 256; postdiv > 1; --postdiv) {
+        if (freq_in / (prescale * (postdiv - 1)) > baudrate) break;
+    }
+    return freq_in / (prescale * postdiv);
+}
+
+typedef struct {
+    clock_turbo_t *t;
+    uint32_t khz;
+    const clock_turbo_rates_t *rates;
+} switch_req_t;
+
+// Runs on the SD worker (tick core)
+static int switch_job(void *arg) {
+    switch_req_t *req = (switch_req_t *)arg;
+    clock_turbo_t *t = req->t;
+    t->switch_ok = false;
+    if (get_core_num() != configTICK_CORE) {
+        printf("[ERROR] Clock switch off the tick core\n");
+        return SUCCESS;
+    }
+
+    stdio_flush();
+    bool up = req->khz > clock_get_hz(clk_sys) / 1000u;
+    if (up && req->khz > CLOCK_TURBO_VREG_KHZ) {
+        vreg_set_voltage(VREG_VOLTAGE_1_15);
+        busy_wait_us(CLOCK_TURBO_SETTLE_US);
+    }
+
+    spi_inst_t *sd_spi = sd_spi_inst();
+    taskENTER_CRITICAL();
+    bool ok = set_sys_clock_khz(req->khz, false);
+    if (ok) {
+        uint32_t hz = clock_get_hz(clk_sys);
+        clock_configure(clk_peri, 0, CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLK_SYS, hz, hz);
+        systick_hw->rvr = hz / configTICK_RATE_HZ - 1u;
+        systick_hw->cvr = 0;
+        spi_set_baudrate(t->flash_spi, req->rates->flash_baud);
+        if (sd_spi) spi_set_baudrate(sd_spi, req->rates->sd_baud);
+#if LIB_PICO_STDIO_UART
+        uart_set_baudrate(PICO_DEFAULT_UART_INSTANCE, PICO_DEFAULT_UART_BAUD_RATE);
+#endif
+    }
+    taskEXIT_CRITICAL();
+
+    if (ok && !up && req->khz <= CLOCK_TURBO_VREG_KHZ) {
+        vreg_set_voltage(VREG_VOLTAGE_DEFAULT);
+        busy_wait_us(CLOCK_TURBO_SETTLE_US);
+    }
+    t->switch_ok = ok;
+    return SUCCESS;
+}
+
+static bool switch_to(clock_turbo_t *t, uint32_t khz, const clock_turbo_rates_t *rates) {
+    switch_req_t req = {t, khz, rates};
+    span_begin_n("clock_switch", khz);
+    sd_worker_call(switch_job, &req);
+    span_end("clock_switch");
+    if (t->switch_ok && t->pio) {
+        // The sample step is re-applied by the caller
+        pio_spi_set_hz(t->pio, rates->pio_hz);
+    }
+    return t->switch_ok;
+}
+
+// Raises clk_sys to `khz` when the PLL can reach it exactly and at least
+// one bus would then run faster than it does now
+bool clock_turbo_enter(clock_turbo_t *t, uint32_t khz, spi_inst_t *flash_spi, pio_spi_t *pio,
+                       const clock_turbo_rates_t *window) {
+    unsigned vco, pd1, pd2;
+    t->active = false;
+    t->prev_khz = clock_get_hz(clk_sys) / 1000u;
+    if (khz <= t->prev_khz || !check_sys_clock_khz(khz, &vco, &pd1, &pd2)) {
+        printf("[WARN] Turbo clock %u kHz not reachable, staying at %u kHz\n",
+               (unsigned)khz, (unsigned)t->prev_khz);
+        return false;
+    }
+
+    spi_inst_t *sd_spi = sd_spi_inst();
+    t->flash_spi = flash_spi;
+    t->pio = pio;
+    t->entry.flash_baud = spi_get_baudrate(flash_spi);
+    t->entry.sd_baud = sd_spi ? spi_get_baudrate(sd_spi) : 0;
+    t->entry.pio_hz = pio ? pio->hz : 0;
+    t->window.flash_baud = window->flash_baud ? window->flash_baud : t->entry.flash_baud;
+    t->window.sd_baud = window->sd_baud ? window->sd_baud : t->entry.sd_baud;
+    t->window.pio_hz = window->pio_hz ? window->pio_hz : t->entry.pio_hz;
+
+    // clk_peri follows clk_sys, so the PL022 divisors land differently there
+    bool raised = pl022_hz_at(khz * 1000u, t->window.flash_baud) > t->entry.flash_baud ||
+                  (sd_spi && pl022_hz_at(khz * 1000u, t->window.sd_baud) > t->entry.sd_baud) ||
+                  (pio && t->window.pio_hz > t->entry.pio_hz);
+    if (!raised) {
+        printf("[TURBO] No bus would run faster at %u kHz, window dropped\n", (unsigned)khz);
+        return false;
+    }
+
+    if (!switch_to(t, khz, &t->window)) {
+        printf("[ERROR] set_sys_clock_khz(%u) failed\n", (unsigned)khz);
+        return false;
+    }
+    t->khz = clock_get_hz(clk_sys) / 1000u;
+    t->active = true;
+    printf("[TURBO] clk_sys %u -> %u kHz (flash %u -> %u Hz, SD %u -> %u Hz",
+           (unsigned)t->prev_khz, (unsigned)t->khz,
+           (unsigned)t->entry.flash_baud, (unsigned)spi_get_baudrate(flash_spi),
+           (unsigned)t->entry.sd_baud, (unsigned)(sd_spi ? spi_get_baudrate(sd_spi) : 0));
+    if (pio) printf(", PIO %u -> %u Hz", (unsigned)t->entry.pio_hz, (unsigned)pio->hz);
+    printf(")\n");
+    return true;
+}
+
+void clock_turbo_exit(clock_turbo_t *t) {
+    if (!t->active) return;
+    if (!switch_to(t, t->prev_khz, &t->entry)) {
+        printf("[ERROR] Cannot restore clk_sys to %u kHz\n", (unsigned)t->prev_khz);
+        return;
+    }
+    t->active = false;
+    printf("[TURBO] clk_sys restored to %u kHz\n", (unsigned)(clock_get_hz(clk_sys) / 1000u));
+}
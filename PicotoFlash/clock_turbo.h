@@ -0,0 +1,46 @@
+/*
+ * System Clock Turbo Module Header
+ * Raises clk_sys (and clk_peri with it) for a bounded window such as the
+ * backup, then puts everything back. Every clock consumer whose divider was
+ * computed from the old rate is re-derived on each switch: the flash and SD
+ * PL022 baud rates and the PIO transport divider (to the window's rates on
+ * the way up, the entry rates on the way down), the FreeRTOS tick and, when
+ * enabled, the stdio UART. clk_usb runs from PLL_USB and is left alone.
+ */
+
+#ifndef CLOCK_TURBO_H
+#define CLOCK_TURBO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/spi.h"
+#include "pio_spi.h"
+
+// Constants
+#define CLOCK_TURBO_VREG_KHZ 133000u   // Above this the core supply is raised
+#define CLOCK_TURBO_SETTLE_US 1000u    // After a core voltage change
+
+// Bus clocks in Hz; in a window request, 0 = keep the entry rate
+typedef struct {
+    uint32_t flash_baud;
+    uint32_t sd_baud;
+    uint32_t pio_hz;
+} clock_turbo_rates_t;
+
+typedef struct {
+    bool active;
+    uint32_t prev_khz;
+    uint32_t khz;                  // Achieved turbo clk_sys
+    spi_inst_t *flash_spi;
+    pio_spi_t *pio;                // May be NULL
+    clock_turbo_rates_t entry;     // Actual rates at entry, restored on exit
+    clock_turbo_rates_t window;    // Requested rates inside the window
+    bool switch_ok;                // Result of the last switch job
+} clock_turbo_t;
+
+// Function declarations
+bool clock_turbo_enter(clock_turbo_t *t, uint32_t khz, spi_inst_t *flash_spi, pio_spi_t *pio,
+                       const clock_turbo_rates_t *window);
+void clock_turbo_exit(clock_turbo_t *t);
+
+#endif // CLOCK_TURBO_H
@@ -0,0 +1,33 @@
+/*
+ * CRC-32 Helper Module Header
+ * Incremental IEEE 802.3 CRC-32 (poly 0xEDB88320, reflected)
+ */
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CRC32_INIT 0xFFFFFFFFu
+
+// Feed `len` bytes into a running CRC (start from CRC32_INIT)
+uint32_t crc32_update(uint32_t crc, const void *data, size_t len);
+
+// Finalize a running CRC (applies the output XOR)
+static inline uint32_t crc32_final(uint32_t crc) { return crc ^ 0xFFFFFFFFu; }
+
+// One-shot CRC-32 of a buffer
+static inline uint32_t crc32_calc(const void *data, size_t len) {
+    return crc32_final(crc32_update(CRC32_INIT, data, len));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CRC32_H
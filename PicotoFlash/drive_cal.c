@@ -0,0 +1,421 @@
+/*
+ * Pad Drive Calibration Module
+ * On long fixture cables the clock ceiling is set by edge quality as much
+ * as by the sample point: a weak, slow edge never settles, a strong, fast
+ * one rings. For each of the eight pad settings this module drives SCK,
+ * MOSI and CS (plus IO2/IO3 on a quad fixture) with it and climbs a clock
+ * ladder until a read-back fails:
+ *   - flash: the sample-calibration pattern over the PIO transport, where a
+ *     clock passes if any sample step reads it back (sample_cal_probe);
+ *   - SD: the first DRIVE_CAL_SD_SECTORS sectors over SPI1, compared with
+ *     a copy read at the mounted baud rate.
+ * The weakest setting that reaches the highest clock wins. Results live in
+ * DRIVE_CAL_FILE keyed by fixture name, bus and clk_sys, and are applied on
+ * every run; the SD driver's spi_t/sd_card_t drive-strength fields are set
+ * too, so a re-mount keeps them. The SD bus is also moved to the ceiling
+ * its pads proved (spi_t.baud_rate included, again for a re-mount), but no
+ * further than DRIVE_CAL_SD_SPEC_HZ: the sweep only reads sectors back,
+ * and the same clock carries the card's writes.
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "ff.h"
+#include "diskio.h"
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/gpio.h"
+#include "hardware/spi.h"
+#include "drive_cal.h"
+#include "crc32.h"
+#include "sd_functions.h"
+#include "hw_config.h"
+#include "buf_pool.h"
+
+#define SD_PROBE_BYTES (DRIVE_CAL_SD_SECTORS * 512u)
+#define FLASH_PINS_MAX 5
+
+// Sweep order: weakest first, so ties keep the quieter setting
+static const uint8_t k_configs[DRIVE_CAL_CONFIGS] = {
+    DRIVE_CAL_PADS(0, false), DRIVE_CAL_PADS(1, false), DRIVE_CAL_PADS(2, false), DRIVE_CAL_PADS(3, false),
+    DRIVE_CAL_PADS(0, true),  DRIVE_CAL_PADS(1, true),  DRIVE_CAL_PADS(2, true),  DRIVE_CAL_PADS(3, true),
+};
+
+static const uint32_t k_flash_ladder[] = {
+    16000000u, 21000000u, 25000000u, 33000000u, 42000000u, 50000000u, 62500000u
+};
+
+// PL022 steps at the default clk_peri (125 MHz / even divisors)
+static const uint32_t k_sd_ladder[] = {
+    12500000u, 20833333u, 25000000u, 31250000u, 41666667u, 62500000u
+};
+
+static uint8_t g_pads[DRIVE_BUS_COUNT] = {DRIVE_CAL_PADS_DEFAULT, DRIVE_CAL_PADS_DEFAULT};
+static uint32_t g_ceiling_hz[DRIVE_BUS_COUNT];   // Of the applied pads, 0 = not calibrated
+static uint g_flash_pins[FLASH_PINS_MAX];
+static int g_flash_pin_count = 0;
+
+static uint8_t *g_sd_ref;           // Pool checkout while the SD bus is probed
+static uint8_t *g_sd_probe;
+
+// ============================================================================
+// Pads
+// ============================================================================
+
+static inline enum gpio_drive_strength pads_strength(uint8_t pads) {
+    return (enum gpio_drive_strength)(pads & 0x03u);
+}
+
+static inline enum gpio_slew_rate pads_slew(uint8_t pads) {
+    return (pads & 0x04u) ? GPIO_SLEW_RATE_FAST : GPIO_SLEW_RATE_SLOW;
+}
+
+const char *drive_cal_pads_name(uint8_t pads) {
+    static const char *names[DRIVE_CAL_CONFIGS] = {
+        "2mA/slow", "4mA/slow", "8mA/slow", "12mA/slow",
+        "2mA/fast", "4mA/fast", "8mA/fast", "12mA/fast",
+    };
+    if (!(pads & 0x80u)) return "?";
+    return names[((pads & 0x04u) ? 4 : 0) + (pads & 0x03u)];
+}
+
+static void pin_pads(uint pin, uint8_t pads) {
+    gpio_set_drive_strength(pin, pads_strength(pads));
+    gpio_set_slew_rate(pin, pads_slew(pads));
+}
+
+// Outputs the RP2040 drives on the flash bus (MISO is driven by the chip)
+void drive_cal_bind_flash(const pio_spi_t *pio, uint8_t cs_pin) {
+    g_flash_pin_count = 0;
+    g_flash_pins[g_flash_pin_count++] = pio->sck_pin;
+    g_flash_pins[g_flash_pin_count++] = pio->mosi_pin;
+    g_flash_pins[g_flash_pin_count++] = cs_pin;
+    if (pio->quad_ok) {
+        g_flash_pins[g_flash_pin_count++] = pio->io2_pin;
+        g_flash_pins[g_flash_pin_count++] = pio->io3_pin;
+    }
+}
+
+void drive_cal_set_pads(drive_bus_t bus, uint8_t pads) {
+    if (bus == DRIVE_BUS_FLASH) {
+        for (int i = 0; i < g_flash_pin_count; i++) pin_pads(g_flash_pins[i], pads);
+    } else {
+        sd_card_t *sd = sd_get_by_num(0);
+        if (!sd || !sd->spi) return;
+        spi_t *spi = sd->spi;
+        pin_pads(spi->sck_gpio, pads);
+        pin_pads(spi->mosi_gpio, pads);
+        pin_pads(sd->ss_gpio, pads);
+        // Picked up again by my_spi_init()/sd_init() on a re-mount
+        spi->set_drive_strength = true;
+        spi->sck_gpio_drive_strength = pads_strength(pads);
+        spi->mosi_gpio_drive_strength = pads_strength(pads);
+        sd->set_drive_strength = true;
+        sd->ss_gpio_drive_strength = pads_strength(pads);
+    }
+    g_pads[bus] = pads;
+}
+
+uint8_t drive_cal_pads_current(drive_bus_t bus) {
+    return g_pads[bus];
+}
+
+uint32_t drive_cal_ceiling_hz(drive_bus_t bus) {
+    return g_ceiling_hz[bus];
+}
+
+uint32_t drive_cal_sd_hz(void) {
+    uint32_t hz = g_ceiling_hz[DRIVE_BUS_SD];
+    return hz > DRIVE_CAL_SD_SPEC_HZ ? DRIVE_CAL_SD_SPEC_HZ : hz;
+}
+
+// ============================================================================
+// Clock ceiling probes
+// ============================================================================
+
+static uint32_t flash_ceiling(pio_spi_t *pio, uint8_t cs_pin) {
+    uint32_t best = 0;
+    for (size_t i = 0; i < sizeof(k_flash_ladder) / sizeof(k_flash_ladder[0]); i++) {
+        if (sample_cal_probe(pio, cs_pin, false, k_flash_ladder[i]) == 0) break;
+        best = pio->hz;
+    }
+    return best;
+}
+
+// Reference and probe sectors share one checkout
+static bool sd_bufs_get(void) {
+    g_sd_ref = (uint8_t *)buf_pool_get(2 * SD_PROBE_BYTES, "drive_cal");
+    g_sd_probe = g_sd_ref ? g_sd_ref + SD_PROBE_BYTES : NULL;
+    return g_sd_ref != NULL;
+}
+
+static void sd_bufs_put(void) {
+    buf_pool_put(g_sd_ref);
+    g_sd_ref = NULL;
+    g_sd_probe = NULL;
+}
+
+static bool sd_read_ok(sd_card_t *sd, const uint8_t *ref) {
+    for (int p = 0; p < DRIVE_CAL_SD_PASSES; p++) {
+        if (sd->read_blocks(sd, g_sd_probe, 0, DRIVE_CAL_SD_SECTORS) != SD_BLOCK_DEVICE_ERROR_NONE) return false;
+        if (ref && memcmp(g_sd_probe, ref, SD_PROBE_BYTES) != 0) return false;
+    }
+    return true;
+}
+
+// Back at the mounted rate; re-initialise the card if a failed clock upset it
+static bool sd_recover(sd_card_t *sd, uint32_t base_hz) {
+    spi_set_baudrate(sd->spi->hw_inst, base_hz);
+    if (sd_read_ok(sd, g_sd_ref)) return true;
+    printf("[WARN] SD card lost sync during the sweep, re-initialising\n");
+    sd->m_Status |= STA_NOINIT;
+    sd->init(sd);
+    spi_set_baudrate(sd->spi->hw_inst, base_hz);
+    return sd_read_ok(sd, g_sd_ref);
+}
+
+static uint32_t sd_ceiling(sd_card_t *sd) {
+    uint32_t best = 0;
+    for (size_t i = 0; i < sizeof(k_sd_ladder) / sizeof(k_sd_ladder[0]); i++) {
+        uint32_t actual = spi_set_baudrate(sd->spi->hw_inst, k_sd_ladder[i]);
+        if (actual <= best) continue;
+        if (!sd_read_ok(sd, g_sd_ref)) break;
+        best = actual;
+    }
+    return best;
+}
+
+// Move the SD bus up to hz (drive_cal_sd_hz()), checked against the reference
+// sectors read at the mounted rate; falls back to that rate on a mismatch
+static void sd_apply_clock(sd_card_t *sd, uint32_t hz) {
+    uint32_t base_hz = spi_get_baudrate(sd->spi->hw_inst);
+    if (hz <= base_hz || !sd_bufs_get()) return;
+    if (sd->read_blocks(sd, g_sd_ref, 0, DRIVE_CAL_SD_SECTORS) == SD_BLOCK_DEVICE_ERROR_NONE) {
+        uint32_t actual = spi_set_baudrate(sd->spi->hw_inst, hz);
+        if (sd_read_ok(sd, g_sd_ref)) {
+            sd->spi->baud_rate = actual;
+            printf("[DRIVE] SD bus clock %.3f -> %.3f MHz\n", base_hz / 1e6, actual / 1e6);
+        } else {
+            printf("[WARN] SD bus not clean at %.3f MHz, staying at %.3f MHz\n", actual / 1e6, base_hz / 1e6);
+            sd_recover(sd, base_hz);
+        }
+    }
+    sd_bufs_put();
+}
+
+// ============================================================================
+// Sweeps
+// ============================================================================
+
+static void sweep_begin(drive_bus_t bus, drive_cal_entry_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->bus = (uint8_t)bus;
+    out->clk_sys_hz = clock_get_hz(clk_sys);
+    printf("[DRIVE] %s bus pad sweep (fixture '%s')\n", bus == DRIVE_BUS_FLASH ? "Flash" : "SD",
+           sample_cal_fixture());
+    printf("  pads       | max clean clock\n");
+}
+
+// Strictly higher ceiling only, so the weakest setting wins a tie
+static bool sweep_end(drive_cal_entry_t *out) {
+    uint32_t best = 0;
+    for (int c = 0; c < DRIVE_CAL_CONFIGS; c++) {
+        if (out->max_hz[c] > best) {
+            best = out->max_hz[c];
+            out->pads = k_configs[c];
+        }
+    }
+    if (best == 0) {
+        printf("[WARN] No pad setting read back cleanly, keeping defaults\n");
+        out->pads = DRIVE_CAL_PADS_DEFAULT;
+        return false;
+    }
+    printf("[DRIVE] Best %s (%.3f MHz)\n", drive_cal_pads_name(out->pads), best / 1e6);
+    return true;
+}
+
+static uint32_t entry_ceiling(const drive_cal_entry_t *e) {
+    for (int c = 0; c < DRIVE_CAL_CONFIGS; c++) {
+        if (k_configs[c] == e->pads) return e->max_hz[c];
+    }
+    return 0;
+}
+
+// Transport must be attached; leaves the best pads applied and the
+// transport at its previous clock
+bool drive_cal_sweep_flash(pio_spi_t *pio, uint8_t cs_pin, drive_cal_entry_t *out) {
+    uint32_t prev_hz = pio->hz;
+    drive_cal_bind_flash(pio, cs_pin);
+    sweep_begin(DRIVE_BUS_FLASH, out);
+    for (int c = 0; c < DRIVE_CAL_CONFIGS; c++) {
+        drive_cal_set_pads(DRIVE_BUS_FLASH, k_configs[c]);
+        out->max_hz[c] = flash_ceiling(pio, cs_pin);
+        printf("  %-10s | %.3f MHz\n", drive_cal_pads_name(k_configs[c]), out->max_hz[c] / 1e6);
+    }
+    bool ok = sweep_end(out);
+    drive_cal_set_pads(DRIVE_BUS_FLASH, out->pads);
+    g_ceiling_hz[DRIVE_BUS_FLASH] = ok ? entry_ceiling(out) : 0;
+    pio_spi_set_hz(pio, prev_hz);
+    return ok;
+}
+
+// Must run on the SD worker with the card initialised; leaves the best pads
+// applied and the bus at their ceiling
+bool drive_cal_sweep_sd(drive_cal_entry_t *out) {
+    sd_card_t *sd = sd_get_by_num(0);
+    if (!sd || !sd->spi || (sd->m_Status & STA_NOINIT)) return false;
+    uint32_t base_hz = spi_get_baudrate(sd->spi->hw_inst);
+    if (!sd_bufs_get()) return false;
+    if (sd->read_blocks(sd, g_sd_ref, 0, DRIVE_CAL_SD_SECTORS) != SD_BLOCK_DEVICE_ERROR_NONE) {
+        printf("[ERROR] SD reference read failed\n");
+        sd_bufs_put();
+        return false;
+    }
+
+    sweep_begin(DRIVE_BUS_SD, out);
+    uint8_t prev = g_pads[DRIVE_BUS_SD];
+    bool lost = false;
+    for (int c = 0; c < DRIVE_CAL_CONFIGS && !lost; c++) {
+        drive_cal_set_pads(DRIVE_BUS_SD, k_configs[c]);
+        out->max_hz[c] = sd_ceiling(sd);
+        printf("  %-10s | %.3f MHz\n", drive_cal_pads_name(k_configs[c]), out->max_hz[c] / 1e6);
+        drive_cal_set_pads(DRIVE_BUS_SD, prev);
+        lost = !sd_recover(sd, base_hz);
+    }
+    sd_bufs_put();
+    if (lost) {
+        printf("[ERROR] SD card did not recover, sweep abandoned\n");
+        return false;
+    }
+    bool ok = sweep_end(out);
+    drive_cal_set_pads(DRIVE_BUS_SD, out->pads);
+    g_ceiling_hz[DRIVE_BUS_SD] = ok ? entry_ceiling(out) : 0;
+    if (ok) sd_apply_clock(sd, drive_cal_sd_hz());
+    return ok;
+}
+
+// Apply the stored setting for this fixture, sweeping first if there is none
+bool drive_cal_ensure(drive_bus_t bus, pio_spi_t *pio, uint8_t cs_pin) {
+    if (bus == DRIVE_BUS_FLASH) drive_cal_bind_flash(pio, cs_pin);
+
+    drive_cal_entry_t e;
+    if (drive_cal_lookup(bus, &e)) {
+        drive_cal_set_pads(bus, e.pads);
+        g_ceiling_hz[bus] = entry_ceiling(&e);
+        printf("[DRIVE] %s bus: stored %s (%.3f MHz)\n", bus == DRIVE_BUS_FLASH ? "Flash" : "SD",
+               drive_cal_pads_name(e.pads), g_ceiling_hz[bus] / 1e6);
+        sd_card_t *sd = sd_get_by_num(0);
+        if (bus == DRIVE_BUS_SD && sd && sd->spi && !(sd->m_Status & STA_NOINIT)) sd_apply_clock(sd, drive_cal_sd_hz());
+        return true;
+    }
+
+    bool ok = (bus == DRIVE_BUS_FLASH) ? drive_cal_sweep_flash(pio, cs_pin, &e) : drive_cal_sweep_sd(&e);
+    if (ok) drive_cal_store(&e);
+    return ok;
+}
+
+// ============================================================================
+// Storage
+// ============================================================================
+
+static uint32_t entry_crc(const drive_cal_entry_t *e) {
+    return crc32_calc(e, offsetof(drive_cal_entry_t, crc32));
+}
+
+static bool entry_ok(const drive_cal_entry_t *e) {
+    return e->magic == DRIVE_CAL_MAGIC &&
+           e->version == DRIVE_CAL_VERSION &&
+           e->record_size == sizeof(drive_cal_entry_t) &&
+           e->crc32 == entry_crc(e);
+}
+
+static bool entry_key_matches(const drive_cal_entry_t *e, const drive_cal_entry_t *key) {
+    return strncmp(e->fixture, key->fixture, SAMPLE_CAL_FIXTURE_LEN) == 0 &&
+           e->bus == key->bus &&
+           e->clk_sys_hz == key->clk_sys_hz;
+}
+
+// Slot of the key or -1; *free_slot gets the first corrupt slot or the end
+static int find_slot(FIL *file, const drive_cal_entry_t *key, drive_cal_entry_t *out, int *free_slot) {
+    drive_cal_entry_t e;
+    UINT br = 0;
+    int slot = 0;
+    int first_bad = -1;
+
+    f_lseek(file, 0);
+    while (slot < DRIVE_CAL_MAX_ENTRIES &&
+           f_read(file, &e, sizeof(e), &br) == FR_OK && br == sizeof(e)) {
+        if (!entry_ok(&e)) {
+            if (first_bad < 0) first_bad = slot;
+        } else if (entry_key_matches(&e, key)) {
+            if (out) *out = e;
+            return slot;
+        }
+        slot++;
+    }
+
+    if (free_slot) *free_slot = (first_bad >= 0) ? first_bad : slot;
+    return -1;
+}
+
+static void fill_key(drive_cal_entry_t *key, drive_bus_t bus) {
+    memset(key->fixture, 0, sizeof(key->fixture));
+    strncpy(key->fixture, sample_cal_fixture(), SAMPLE_CAL_FIXTURE_LEN - 1);
+    key->bus = (uint8_t)bus;
+    key->clk_sys_hz = clock_get_hz(clk_sys);
+}
+
+bool drive_cal_lookup(drive_bus_t bus, drive_cal_entry_t *out) {
+    drive_cal_entry_t key;
+    memset(&key, 0, sizeof(key));
+    fill_key(&key, bus);
+
+    FIL file;
+    if (f_open(&file, DRIVE_CAL_FILE, FA_READ) != FR_OK) return false;
+    int slot = find_slot(&file, &key, out, NULL);
+    f_close(&file);
+    return slot >= 0;
+}
+
+int drive_cal_store(drive_cal_entry_t *entry) {
+    fill_key(entry, (drive_bus_t)entry->bus);
+
+    FIL file;
+    FRESULT fr = f_open(&file, DRIVE_CAL_FILE, FA_READ | FA_WRITE | FA_OPEN_ALWAYS);
+    if (fr != FR_OK) {
+        printf("[ERROR] ERROR_FILE_WRITE_FAIL: Cannot open %s (%d)\n", DRIVE_CAL_FILE, fr);
+        return ERROR_FILE_WRITE_FAIL;
+    }
+
+    int free_slot = 0;
+    int slot = find_slot(&file, entry, NULL, &free_slot);
+    if (slot < 0) {
+        if (free_slot >= DRIVE_CAL_MAX_ENTRIES) {
+            f_close(&file);
+            printf("[WARNING] Drive calibration table full (%d entries), not stored\n",
+                   DRIVE_CAL_MAX_ENTRIES);
+            return ERROR_SD_FULL;
+        }
+        slot = free_slot;
+    }
+
+    entry->magic = DRIVE_CAL_MAGIC;
+    entry->version = DRIVE_CAL_VERSION;
+    entry->record_size = sizeof(drive_cal_entry_t);
+    entry->crc32 = entry_crc(entry);
+
+    UINT bw = 0;
+    fr = f_lseek(&file, (FSIZE_t)slot * sizeof(drive_cal_entry_t));
+    if (fr == FR_OK) fr = f_write(&file, entry, sizeof(*entry), &bw);
+    f_close(&file);
+
+    if (fr != FR_OK || bw != sizeof(*entry)) {
+        printf("[ERROR] ERROR_FILE_WRITE_FAIL: Drive calibration write failed (%d)\n", fr);
+        return ERROR_FILE_WRITE_FAIL;
+    }
+
+    printf("✓ Pad setting stored (%s, %s bus, %s, slot %d)\n", entry->fixture,
+           entry->bus == DRIVE_BUS_FLASH ? "flash" : "SD", drive_cal_pads_name(entry->pads), slot);
+    return SUCCESS;
+}
@@ -0,0 +1,71 @@
+/*
+ * Pad Drive Calibration Module Header
+ * Sweeps GPIO drive strength (2/4/8/12 mA) and slew rate on the flash and
+ * SD buses, probes the highest clock that still reads back cleanly for each
+ * setting, and keeps the best setting per fixture on SD
+ */
+
+#ifndef DRIVE_CAL_H
+#define DRIVE_CAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pio_spi.h"
+#include "sample_cal.h"
+
+// File definitions
+#define DRIVE_CAL_FILE "drive_cal.bin"
+
+// Constants
+#define DRIVE_CAL_MAGIC 0x44504650u    // "PFPD"
+#define DRIVE_CAL_VERSION 1
+#define DRIVE_CAL_MAX_ENTRIES 32
+#define DRIVE_CAL_CONFIGS 8            // 4 drive strengths x 2 slew rates
+#define DRIVE_CAL_SD_SECTORS 8         // Read back from sector 0
+#define DRIVE_CAL_SD_PASSES 4
+#define DRIVE_CAL_SD_SPEC_HZ 25000000u // SPI-mode default speed; the driver never switches to high speed
+
+// Pad configuration byte: bit 7 set, bit 2 fast slew, bits 1..0 drive strength
+#define DRIVE_CAL_PADS(strength, fast) ((uint8_t)(0x80u | ((fast) ? 0x04u : 0u) | ((strength) & 0x03u)))
+#define DRIVE_CAL_PADS_DEFAULT DRIVE_CAL_PADS(1, false)   // SDK reset: 4 mA, slow
+
+typedef enum {
+    DRIVE_BUS_FLASH = 0,
+    DRIVE_BUS_SD,
+    DRIVE_BUS_COUNT
+} drive_bus_t;
+
+// Sweep result for one (fixture, bus, clk_sys)
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+
+    // Key
+    char fixture[SAMPLE_CAL_FIXTURE_LEN];
+    uint8_t bus;                   // drive_bus_t
+    uint8_t reserved0[3];
+    uint32_t clk_sys_hz;
+
+    // Result
+    uint8_t pads;                  // Best configuration
+    uint8_t reserved1[3];
+    uint32_t max_hz[DRIVE_CAL_CONFIGS];  // Highest clean clock per configuration, 0 = none
+
+    uint32_t crc32;                // CRC-32 of all preceding bytes
+} drive_cal_entry_t;
+
+// Function declarations
+void drive_cal_bind_flash(const pio_spi_t *pio, uint8_t cs_pin);
+void drive_cal_set_pads(drive_bus_t bus, uint8_t pads);
+uint8_t drive_cal_pads_current(drive_bus_t bus);
+uint32_t drive_cal_ceiling_hz(drive_bus_t bus);   // At the clk_sys of the sweep, 0 = none
+uint32_t drive_cal_sd_hz(void);                   // SD clock for reads and writes, 0 = none
+const char *drive_cal_pads_name(uint8_t pads);
+bool drive_cal_sweep_flash(pio_spi_t *pio, uint8_t cs_pin, drive_cal_entry_t *out);
+bool drive_cal_sweep_sd(drive_cal_entry_t *out);
+bool drive_cal_ensure(drive_bus_t bus, pio_spi_t *pio, uint8_t cs_pin);
+bool drive_cal_lookup(drive_bus_t bus, drive_cal_entry_t *out);
+int drive_cal_store(drive_cal_entry_t *entry);
+
+#endif // DRIVE_CAL_H
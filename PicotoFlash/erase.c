@@ -4,6 +4,8 @@
 #include "pico/stdlib.h"
 #include "hardware/gpio.h"
 #include <math.h>
+#include "spi_trace.h"
+#include "span_trace.h"
 
 // ITERATION COUNT - Change this to 1000 when you want more iterations
 #define ITERS_ERASE 10
@@ -12,10 +14,10 @@
 erase_result_t g_erase_result;
 
 // SPI helper functions
-static inline void cs_low(uint8_t pin) { gpio_put(pin, 0); }
-static inline void cs_high(uint8_t pin) { gpio_put(pin, 1); }
-static inline void spi_tx(spi_inst_t *spi, const uint8_t *b, size_t n) { spi_write_blocking(spi, b, n); }
-static inline void spi_rx(spi_inst_t *spi, uint8_t *b, size_t n) { spi_read_blocking(spi, 0x00, b, n); }
+static inline void cs_low(uint8_t pin) { gpio_put(pin, 0); spi_trace_cs(true); }
+static inline void cs_high(uint8_t pin) { spi_trace_cs(false); gpio_put(pin, 1); }
+static inline void spi_tx(spi_inst_t *spi, const uint8_t *b, size_t n) { spi_trace_pl022(spi, b, n); spi_write_blocking(spi, b, n); }
+static inline void spi_rx(spi_inst_t *spi, uint8_t *b, size_t n) { spi_trace_pl022(spi, NULL, n); spi_read_blocking(spi, 0x00, b, n); }
 
 // Flash basic operations
 static void flash_wren(spi_inst_t *spi, uint8_t cs_pin) {
@@ -53,20 +55,18 @@ static void flash_wren_sr_volatile(spi_inst_t *spi, uint8_t cs_pin) {
 
 static void flash_wrsr1(spi_inst_t *spi, uint8_t cs_pin, uint8_t sr1) {
     flash_wren(spi, cs_pin);
-    uint8_t c = 0x01;
+    uint8_t c[2] = {0x01, sr1};
     cs_low(cs_pin);
-    spi_tx(spi, &c, 1);
+    spi_tx(spi, c, 2);
     cs_high(cs_pin);
-    (void)sr1;
 }
 
 static void flash_wrsr2(spi_inst_t *spi, uint8_t cs_pin, uint8_t sr2) {
     flash_wren(spi, cs_pin);
-    uint8_t c = 0x31;
+    uint8_t c[2] = {0x31, sr2};
     cs_low(cs_pin);
-    spi_tx(spi, &c, 1);
+    spi_tx(spi, c, 2);
     cs_high(cs_pin);
-    (void)sr2;
 }
 
 static bool flash_wait_busy_clear(spi_inst_t *spi, uint8_t cs_pin, 
@@ -153,20 +153,25 @@ static void bench_one_erase(spi_inst_t *spi, uint8_t cs_pin, const char *label,
                            uint8_t opcode, uint32_t size_bytes,
                            uint32_t base_addr, uint16_t db_typ_ms, uint16_t db_max_ms,
                            int mhz_for_csv_unused,
-                           double *out_avg, uint32_t *out_min, uint32_t *out_max) {
+                           double *out_avg, uint32_t *out_min, uint32_t *out_max,
+                           bench_hist_t *out_hist) {
     (void)mhz_for_csv_unused;
     
     uint32_t addr = base_addr & ~(size_bytes - 1);
     uint32_t total_ms = 0;
     
     // Time the ENTIRE batch of erase operations
+    if (out_hist) bench_hist_reset(out_hist);
+    span_begin_n("erase_batch", size_bytes);
     uint64_t batch_start = time_us_64();
     
     for (int i = 0; i < ITERS_ERASE; i++) {
+        uint64_t op_start = time_us_64();
         flash_erase_cmd(spi, cs_pin, opcode, addr);
         uint32_t elapsed_ms = 0;
         if (!flash_wait_busy_clear(spi, cs_pin, 60000, &elapsed_ms))
             printf("  [WARN] ERASE_TIMEOUT, OP=0x%02X, ADDR=0x%06X\n", opcode, (unsigned)addr);
+        if (out_hist) bench_hist_add(out_hist, (uint32_t)(time_us_64() - op_start));
         
         uint8_t chk[16];
         flash_read03(spi, cs_pin, addr, chk, sizeof chk);
@@ -181,6 +186,7 @@ static void bench_one_erase(spi_inst_t *spi, uint8_t cs_pin, const char *label,
     }
     
     uint64_t batch_end = time_us_64();
+    span_end("erase_batch");
     total_ms = (uint32_t)((batch_end - batch_start) / 1000);
     
     // Calculate average time per erase
@@ -251,17 +257,20 @@ void erase_run_benches_at_clock(spi_inst_t *spi, uint8_t cs_pin,
     if (has4) {
         printf("  [TEST] 4K erase with opcode 0x%02X\n", o4);
         bench_one_erase(spi, cs_pin, "4K-erase", o4, SECTOR_4K, test_addr, typ_4k, max_4k,
-                       mhz_print, &avg_4k_time, &min_4k_time, &max_4k_time);
+                       mhz_print, &avg_4k_time, &min_4k_time, &max_4k_time,
+                       &g_erase_result.hist_4k);
     }
     if (has32) {
         printf("  [TEST] 32K erase with opcode 0x%02X\n", o32);
         bench_one_erase(spi, cs_pin, "32K-erase", o32, BLOCK_32K, test_addr, typ_32k, max_32k,
-                       mhz_print, &avg_32k_time, &min_32k_time, &max_32k_time);
+                       mhz_print, &avg_32k_time, &min_32k_time, &max_32k_time,
+                       &g_erase_result.hist_32k);
     }
     if (has64) {
         printf("  [TEST] 64K erase with opcode 0x%02X\n", o64);
         bench_one_erase(spi, cs_pin, "64K-erase", o64, BLOCK_64K, test_addr, typ_64k, max_64k,
-                       mhz_print, &avg_64k_time, &min_64k_time, &max_64k_time);
+                       mhz_print, &avg_64k_time, &min_64k_time, &max_64k_time,
+                       &g_erase_result.hist_64k);
     }
 
     // Save results
@@ -286,15 +295,18 @@ void erase_print_summary_tables(void) {
 void erase_flash_unprotect(spi_inst_t *spi, uint8_t cs_pin, uint8_t mfr, uint32_t test_addr) {
     (void)mfr;
     (void)test_addr;
+    span_begin("erase_unprotect");
     uint8_t sr1 = flash_rdsr(spi, cs_pin);
     uint8_t sr2 = flash_rdsr2(spi, cs_pin);
     uint8_t new_sr1 = (uint8_t)(sr1 & ~(uint8_t)0x1C);
     flash_wren_sr_volatile(spi, cs_pin);
     flash_wrsr1(spi, cs_pin, new_sr1);
+    flash_wait_busy_clear(spi, cs_pin, 50, NULL);
     flash_wrsr2(spi, cs_pin, (uint8_t)(sr2 & ~(1u << 6)));
     flash_wait_busy_clear(spi, cs_pin, 50, NULL);
 
     uint8_t chk1 = flash_rdsr(spi, cs_pin), chk2 = flash_rdsr2(spi, cs_pin);
+    span_end("erase_unprotect");
     if (chk1 & 0x1C)
         printf("  [WARN] UNPROTECT_PARTIAL, SR1=0x%02X->0x%02X, SR2=0x%02X->0x%02X\n", sr1, chk1, sr2, chk2);
     else
@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "hardware/spi.h"
+#include "bench_hist.h"
 
 // Erase block sizes
 #define SECTOR_4K  4096u
@@ -18,6 +19,7 @@ typedef struct {
     uint32_t min_4k, max_4k;
     uint32_t min_32k, max_32k;
     uint32_t min_64k, max_64k;
+    bench_hist_t hist_4k, hist_32k, hist_64k;   // Per-erase latency distributions
 } erase_result_t;
 
 // Identification structure (needed for erase type detection)
@@ -54,6 +54,8 @@ void set_spi_dma_irq_channel(bool useChannel1, bool shared) {
     irqShared = shared;
 }
 
+spi_transfer_hook_t spi_transfer_hook = NULL;
+
 // SPI Transfer: Read & Write (simultaneously) on SPI bus
 //   If the data that will be received is not important, pass NULL as rx.
 //   If the data that will be transmitted is not important,
@@ -63,6 +65,8 @@ bool spi_transfer(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
     // assert(512 == length || 1 == length);
     assert(tx || rx);
     // assert(!(tx && rx));
+    const uint8_t *tx_in = tx;
+    uint32_t start_us = spi_transfer_hook ? time_us_32() : 0;
 
     // tx write increment is already false
     if (tx) {
@@ -128,6 +132,7 @@ bool spi_transfer(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
     assert(!dma_channel_is_busy(spi_p->tx_dma));
     assert(!dma_channel_is_busy(spi_p->rx_dma));
 
+    if (spi_transfer_hook) spi_transfer_hook(spi_p, tx_in, length, start_us);
     return true;
 }
 
@@ -60,6 +60,11 @@ extern "C" {
 #endif
   
 bool __not_in_flash_func(spi_transfer)(spi_t *pSPI, const uint8_t *tx, uint8_t *rx, size_t length);  
+
+// Optional observer of completed transfers (start time from time_us_32())
+typedef void (*spi_transfer_hook_t)(spi_t *pSPI, const uint8_t *tx, size_t length, uint32_t start_us);
+extern spi_transfer_hook_t spi_transfer_hook;
+
 void spi_lock(spi_t *pSPI);
 void spi_unlock(spi_t *pSPI);
 bool my_spi_init(spi_t *pSPI);
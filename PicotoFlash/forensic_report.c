@@ -0,0 +1,468 @@
+/*
+ * Structured Forensic Report Module
+ * Streams the report document through report_enc into one file per run
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "forensic_report.h"
+#include "sd_functions.h"
+#include "read.h"
+#include "write.h"
+#include "erase.h"
+#include "timing_probe.h"
+
+static forensic_report_t g_forensic_oneshot;
+
+static uint32_t le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void emit_hist(renc_t *e, const char *key, const bench_hist_t *h) {
+    renc_key(e, key);
+    renc_array_begin(e);
+    for (int k = 0; k < BENCH_HIST_BUCKETS; k++) renc_uint(e, h->count[k]);
+    renc_end(e);
+}
+
+// Optional factor score: null when the factor was not available
+static void emit_score(renc_t *e, const char *key, bool available, float score) {
+    renc_key(e, key);
+    if (available) renc_float(e, score);
+    else renc_null(e);
+}
+
+// ============================================================================
+// Identification and SFDP
+// ============================================================================
+
+static void emit_ident(renc_t *e, const forensic_meta_t *m) {
+    renc_key(e, "ident");
+    renc_map_begin(e);
+    renc_kv_bytes(e, "jedec", m->jedec, 3);
+    renc_kv_str(e, "jedec_str", test_chip.jedec_id);
+    renc_kv_bytes(e, "unique_id", m->uid, m->uid_len);
+    renc_kv_uint(e, "density_bits", m->density_bits);
+    renc_kv_float(e, "capacity_mbit", test_chip.capacity_mbit);
+    renc_kv_bool(e, "fast_read_0b", m->fast_read_0B);
+    renc_kv_uint(e, "fast_read_dummy_bytes", m->fast_read_dummy);
+    renc_end(e);
+}
+
+// One fast read mode from a BFPT DWORD half (dummy 4:0, mode 7:5, opcode 15:8)
+static void emit_fast_read(renc_t *e, const char *mode, uint16_t half) {
+    renc_map_begin(e);
+    renc_kv_str(e, "mode", mode);
+    renc_kv_uint(e, "opcode", (uint8_t)(half >> 8));
+    renc_kv_uint(e, "dummy_clocks", half & 0x1F);
+    renc_kv_uint(e, "mode_clocks", (half >> 5) & 0x07);
+    renc_end(e);
+}
+
+// JESD216 Basic Flash Parameter Table decode
+static void emit_bfpt(renc_t *e, const forensic_meta_t *m) {
+    const uint8_t *bf = m->bfpt;
+    uint16_t n = m->bfpt_len;
+
+    renc_key(e, "bfpt");
+    renc_map_begin(e);
+    renc_kv_uint(e, "ptp", m->bfpt_ptp);
+    renc_kv_bytes(e, "raw", bf, n);
+
+    if (n >= 8) {
+        uint32_t d1 = le32(&bf[0]);
+        uint32_t d2 = le32(&bf[4]);
+        static const char *const k_addr[4] = {"3", "3or4", "4", "reserved"};
+
+        renc_kv_bool(e, "erase_4k_supported", (d1 & 0x3) == 0x1);
+        renc_kv_uint(e, "erase_4k_opcode", (d1 >> 8) & 0xFF);
+        renc_kv_bool(e, "write_granularity_64b", (d1 >> 2) & 1);
+        renc_kv_str(e, "address_bytes", k_addr[(d1 >> 17) & 0x3]);
+        renc_kv_bool(e, "dtr", (d1 >> 19) & 1);
+        if (d2 & 0x80000000u) renc_kv_uint(e, "density_log2_bits", d2 & 0x7FFFFFFFu);
+        else renc_kv_uint(e, "density_bits", (uint64_t)d2 + 1u);
+
+        renc_key(e, "fast_read");
+        renc_array_begin(e);
+        if (n >= 16) {
+            uint32_t d3 = le32(&bf[8]);
+            uint32_t d4 = le32(&bf[12]);
+            if ((d1 >> 16) & 1) emit_fast_read(e, "1-1-2", (uint16_t)d4);
+            if ((d1 >> 20) & 1) emit_fast_read(e, "1-2-2", (uint16_t)(d4 >> 16));
+            if ((d1 >> 22) & 1) emit_fast_read(e, "1-1-4", (uint16_t)(d3 >> 16));
+            if ((d1 >> 21) & 1) emit_fast_read(e, "1-4-4", (uint16_t)d3);
+        }
+        if (n >= 28) {
+            uint32_t d5 = le32(&bf[16]);
+            if (d5 & 0x01) emit_fast_read(e, "2-2-2", (uint16_t)(le32(&bf[20]) >> 16));
+            if (d5 & 0x10) emit_fast_read(e, "4-4-4", (uint16_t)(le32(&bf[24]) >> 16));
+        }
+        renc_end(e);
+    }
+
+    if (n >= 36) {
+        renc_key(e, "erase_types");
+        renc_array_begin(e);
+        for (int k = 0; k < 4; k++) {
+            uint8_t szn = bf[28 + 2 * k];
+            if (szn == 0) continue;  // Type not present
+            renc_map_begin(e);
+            renc_kv_uint(e, "size", 1ull << szn);
+            renc_kv_uint(e, "opcode", bf[29 + 2 * k]);
+            renc_end(e);
+        }
+        renc_end(e);
+    }
+
+    // JESD216A+ fields
+    if (n >= 44) renc_kv_uint(e, "page_size", 1u << ((le32(&bf[40]) >> 4) & 0xF));
+    if (n >= 60) renc_kv_uint(e, "quad_enable_req", (le32(&bf[56]) >> 20) & 0x7);
+    renc_end(e);
+}
+
+static void emit_sfdp(renc_t *e, const forensic_meta_t *m) {
+    renc_key(e, "sfdp");
+    if (!m->sfdp_ok) {
+        renc_null(e);
+        return;
+    }
+    renc_map_begin(e);
+    renc_kv_uint(e, "major", m->sfdp_hdr[5]);
+    renc_kv_uint(e, "minor", m->sfdp_hdr[4]);
+    renc_kv_uint(e, "access_protocol", m->sfdp_hdr[7]);
+    renc_kv_bytes(e, "header_raw", m->sfdp_hdr, 8);
+
+    renc_key(e, "param_headers");
+    renc_array_begin(e);
+    for (uint8_t i = 0; i < m->sfdp_nph; i++) {
+        const uint8_t *p = &m->sfdp_ph[i * 8];
+        renc_map_begin(e);
+        renc_kv_uint(e, "id", ((uint16_t)p[7] << 8) | p[0]);
+        renc_kv_uint(e, "major", p[2]);
+        renc_kv_uint(e, "minor", p[1]);
+        renc_kv_uint(e, "dwords", p[3]);
+        renc_kv_uint(e, "ptp", (uint32_t)p[4] | ((uint32_t)p[5] << 8) | ((uint32_t)p[6] << 16));
+        renc_end(e);
+    }
+    renc_end(e);
+
+    if (m->bfpt_len > 0) emit_bfpt(e, m);
+    renc_end(e);
+}
+
+// ============================================================================
+// Benchmarks
+// ============================================================================
+
+static void emit_measured(renc_t *e) {
+    renc_key(e, "measured");
+    renc_map_begin(e);
+    renc_kv_float(e, "read_speed_50mhz_mbs", test_chip.read_speed_max);
+    renc_kv_float(e, "erase_64k_ms", test_chip.erase_speed);
+    renc_kv_int(e, "max_clock_mhz", test_chip.max_clock_freq_mhz);
+    renc_kv_float(e, "typ_4kb_erase_ms", test_chip.typ_4kb_erase_ms);
+    renc_kv_float(e, "max_4kb_erase_ms", test_chip.max_4kb_erase_ms);
+    renc_kv_float(e, "typ_32kb_erase_ms", test_chip.typ_32kb_erase_ms);
+    renc_kv_float(e, "max_32kb_erase_ms", test_chip.max_32kb_erase_ms);
+    renc_kv_float(e, "typ_64kb_erase_ms", test_chip.typ_64kb_erase_ms);
+    renc_kv_float(e, "max_64kb_erase_ms", test_chip.max_64kb_erase_ms);
+    renc_end(e);
+}
+
+static void emit_stats(renc_t *e, double avg, double p25, double p50, double p75,
+                       uint32_t vmin, uint32_t vmax, double std, double mb_s) {
+    renc_kv_float(e, "avg_us", avg);
+    renc_kv_float(e, "p25_us", p25);
+    renc_kv_float(e, "p50_us", p50);
+    renc_kv_float(e, "p75_us", p75);
+    renc_kv_uint(e, "min_us", vmin);
+    renc_kv_uint(e, "max_us", vmax);
+    renc_kv_float(e, "std_us", std);
+    renc_kv_float(e, "mb_s", mb_s);
+}
+
+static void emit_read(renc_t *e) {
+    renc_key(e, "read");
+    renc_array_begin(e);
+    for (int c = 0; c < g_read_result_count; c++) {
+        const read_result_t *r = &g_read_results[c];
+        if (!r->valid) continue;
+        renc_map_begin(e);
+        renc_kv_int(e, "clock_mhz", r->clock_mhz);
+        char mode[READ_MODE_LABEL_LEN];
+        snprintf(mode, sizeof mode, "1-%u-%u", r->addr_lanes ? r->addr_lanes : 1,
+                 r->data_lanes ? r->data_lanes : 1);
+        renc_kv_str(e, "mode", mode);
+        renc_key(e, "sizes");
+        renc_array_begin(e);
+        for (int s = 0; s < NUM_READ_SIZES; s++) {
+            const read_stats_t *st = &r->size_stats[s];
+            renc_map_begin(e);
+            renc_kv_uint(e, "bytes", k_read_sizes[s]);
+            emit_stats(e, st->avg_us, st->p25, st->p50, st->p75, st->vmin, st->vmax, st->std_us, st->mb_s);
+            emit_hist(e, "hist", &r->size_hist[s]);
+            renc_end(e);
+        }
+        renc_end(e);
+        renc_end(e);
+    }
+    renc_end(e);
+}
+
+static void emit_timing(renc_t *e) {
+    renc_key(e, "timing");
+    const timing_probe_result_t *t = &g_timing_probe;
+    if (!t->valid) {
+        renc_null(e);
+        return;
+    }
+    renc_map_begin(e);
+    renc_kv_uint(e, "clk_sys_hz", t->clk_sys_hz);
+    renc_kv_uint(e, "sck_hz", t->sck_hz);
+    renc_kv_int(e, "shsl_min_cycles", t->shsl_min_cycles);
+    renc_kv_int(e, "shsl_fail_cycles", t->shsl_fail_cycles);
+    renc_key(e, "ops");
+    renc_array_begin(e);
+    for (int i = 0; i < TIMING_PROBE_OPS; i++) {
+        const timing_probe_op_t *o = &t->ops[i];
+        if (!o->valid) continue;
+        renc_map_begin(e);
+        renc_kv_uint(e, "opcode", o->opcode);
+        renc_kv_uint(e, "edge", o->edge);
+        renc_kv_uint(e, "clqv_min_cycles", o->clqv_min);
+        renc_kv_float(e, "clqv_avg_cycles", o->clqv_avg);
+        renc_kv_uint(e, "clqv_max_cycles", o->clqv_max);
+        renc_kv_uint(e, "cs_to_data_cycles", o->cs_to_data);
+        renc_end(e);
+    }
+    renc_end(e);
+    renc_end(e);
+}
+
+static void emit_write(renc_t *e) {
+    renc_key(e, "write");
+    renc_array_begin(e);
+    for (int c = 0; c < g_write_result_count; c++) {
+        const write_bench_capture_t *w = &g_write_results[c];
+        if (!w->valid) continue;
+        renc_map_begin(e);
+        renc_kv_int(e, "clock_mhz_requested", w->clock_mhz_requested);
+        renc_kv_int(e, "clock_mhz", w->clock_mhz_actual);
+        renc_key(e, "sizes");
+        renc_array_begin(e);
+        for (int s = 0; s < w->num_results; s++) {
+            const write_bench_result_t *r = &w->results[s];
+            const write_stats_t *st = &r->stats;
+            renc_map_begin(e);
+            renc_kv_uint(e, "bytes", r->size_bytes);
+            emit_stats(e, st->avg_us, st->p25, st->p50, st->p75, st->vmin, st->vmax, st->std_us, st->mb_s);
+            renc_kv_bool(e, "verify_ok", r->verify_ok);
+            emit_hist(e, "hist", &r->hist);
+            renc_end(e);
+        }
+        renc_end(e);
+        renc_end(e);
+    }
+    renc_end(e);
+}
+
+static void emit_erase_type(renc_t *e, uint32_t bytes, double avg, uint32_t vmin, uint32_t vmax,
+                            const bench_hist_t *h) {
+    renc_map_begin(e);
+    renc_kv_uint(e, "bytes", bytes);
+    renc_kv_float(e, "avg_ms", avg);
+    renc_kv_uint(e, "min_ms", vmin);
+    renc_kv_uint(e, "max_ms", vmax);
+    emit_hist(e, "hist", h);
+    renc_end(e);
+}
+
+static void emit_erase(renc_t *e) {
+    renc_key(e, "erase");
+    if (!g_erase_result.valid) {
+        renc_null(e);
+        return;
+    }
+    const erase_result_t *r = &g_erase_result;
+    renc_map_begin(e);
+    renc_kv_int(e, "clock_mhz", r->clock_mhz);
+    renc_key(e, "types");
+    renc_array_begin(e);
+    emit_erase_type(e, SECTOR_4K, r->avg_4k, r->min_4k, r->max_4k, &r->hist_4k);
+    emit_erase_type(e, BLOCK_32K, r->avg_32k, r->min_32k, r->max_32k, &r->hist_32k);
+    emit_erase_type(e, BLOCK_64K, r->avg_64k, r->min_64k, r->max_64k, &r->hist_64k);
+    renc_end(e);
+    renc_end(e);
+}
+
+// ============================================================================
+// Match and backup
+// ============================================================================
+
+static const char *status_name(match_status_t s) {
+    switch (s) {
+        case MATCH_FOUND: return "FOUND";
+        case MATCH_BEST_MATCH: return "BEST_MATCH";
+        default: return "UNKNOWN";
+    }
+}
+
+static void emit_match(renc_t *e) {
+    const match_result_t *best = &match_results[0];
+
+    renc_key(e, "match");
+    renc_map_begin(e);
+    renc_kv_str(e, "status", status_name(best->status));
+    renc_kv_float(e, "confidence", best->confidence.overall_confidence);
+    renc_kv_bool(e, "outliers", best->has_outliers);
+    renc_kv_int(e, "database_entries", database_entry_count);
+
+    renc_key(e, "weights");
+    renc_map_begin(e);
+    renc_kv_float(e, "jedec_id", 0.40);
+    renc_kv_float(e, "read_speed", 0.20);
+    renc_kv_float(e, "erase_speed", 0.10);
+    renc_end(e);
+
+    renc_key(e, "top");
+    renc_array_begin(e);
+    for (int i = 0; i < TOP_MATCHES_COUNT; i++) {
+        if (match_results[i].database_index >= 0) renc_int(e, match_results[i].database_index);
+    }
+    renc_end(e);
+
+    renc_key(e, "candidates");
+    renc_array_begin(e);
+    for (int i = 0; i < match_candidate_count; i++) {
+        const match_candidate_t *c = &match_candidates[i];
+        if (c->database_index < 0 || c->database_index >= database_entry_count) continue;
+        const FlashChipData *d = &database[c->database_index];
+        confidence_result_t conf;
+        chip_candidate_confidence(c, &conf);
+        const factor_breakdown_t *b = &conf.breakdown;
+        renc_map_begin(e);
+        renc_kv_int(e, "index", c->database_index);
+        renc_kv_str(e, "company", d->company);
+        renc_kv_str(e, "model", d->chip_model);
+        renc_kv_str(e, "family", d->chip_family);
+        renc_kv_str(e, "jedec", d->jedec_id);
+        renc_kv_float(e, "capacity_mbit", d->capacity_mbit);
+        renc_kv_float(e, "confidence", conf.overall_confidence);
+        renc_kv_int(e, "factors_used", conf.factors_used);
+        emit_score(e, "jedec_id_score", b->jedec_id_available, b->jedec_id_score);
+        emit_score(e, "read_speed_score", b->read_speed_available, b->read_speed_score);
+        emit_score(e, "erase_speed_score", b->erase_speed_available, b->erase_speed_score);
+        emit_score(e, "clock_profile_score", b->clock_profile_available, b->clock_profile_score);
+        renc_kv_bool(e, "read_outlier", (c->flags & MATCH_CAND_OUTLIER) != 0);
+        if (conf.warning_message[0] != '\0') {
+            renc_kv_str(e, "warning", conf.warning_message);
+        }
+        renc_end(e);
+    }
+    renc_end(e);
+    renc_end(e);
+}
+
+static void emit_backup(renc_t *e, const forensic_meta_t *m) {
+    renc_key(e, "backup");
+    if (!m->image_valid) {
+        renc_null(e);
+        return;
+    }
+    renc_map_begin(e);
+    renc_kv_str(e, "hash", "crc32");
+    renc_kv_uint(e, "bytes", m->image_bytes);
+    renc_kv_uint(e, "crc32", m->image_crc32);
+    renc_kv_uint(e, "head_bytes", m->head_bytes);
+    renc_kv_uint(e, "head_crc32", m->head_crc32);
+    renc_end(e);
+}
+
+// ============================================================================
+// forensic_report_begin() / forensic_report_finish()
+// ============================================================================
+
+// Opens the file and streams everything settled before the write/erase
+// benchmarks: identification, SFDP, read distributions and the backup.
+int forensic_report_begin(forensic_report_t *r, const forensic_meta_t *meta, renc_format_t fmt) {
+    r->open = false;
+    if (!check_sd_free_space()) {
+        return ERROR_SD_FULL;
+    }
+
+    int year, month, day, hour, min, sec;
+    get_timestamp(&year, &month, &day, &hour, &min, &sec);
+
+    snprintf(r->filename, sizeof(r->filename), fmt == RENC_JSON ? FORENSIC_JSON_FILE : FORENSIC_CBOR_FILE,
+             year, month, day, hour, min, sec);
+
+    f_mkdir("Report");
+
+    if (f_open(&r->file, r->filename, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+        printf("[ERROR] ERROR_FILE_WRITE_FAIL: Cannot create %s\n", r->filename);
+        return ERROR_FILE_WRITE_FAIL;
+    }
+    r->open = true;
+
+    rw_init(&r->rw, &r->file, r->arena, sizeof(r->arena));
+    renc_init(&r->enc, &r->rw, fmt);
+
+    char generated[24];
+    snprintf(generated, sizeof(generated), "%04d-%02d-%02dT%02d:%02d:%02d",
+             year, month, day, hour, min, sec);
+
+    renc_t *e = &r->enc;
+    renc_map_begin(e);
+    renc_kv_str(e, "schema", FORENSIC_SCHEMA);
+    renc_kv_uint(e, "version", FORENSIC_SCHEMA_VERSION);
+    renc_kv_str(e, "generated", generated);
+    renc_kv_str(e, "hist_buckets", "log2_us");
+    emit_ident(e, meta);
+    emit_sfdp(e, meta);
+    emit_read(e);
+    emit_timing(e);
+    emit_backup(e, meta);
+    return renc_ok(e) ? SUCCESS : ERROR_SD_WRITE_FAIL;
+}
+
+// Appends the sections that depend on the write/erase benchmarks and the
+// final match, then closes the document and the file.
+int forensic_report_finish(forensic_report_t *r) {
+    if (!r->open) return ERROR_FILE_WRITE_FAIL;
+
+    renc_t *e = &r->enc;
+    emit_measured(e);
+    emit_write(e);
+    emit_erase(e);
+    emit_match(e);
+    renc_end(e);
+
+    bool ok = renc_ok(e);
+    ok = rw_finish(&r->rw) && ok;
+    f_close(&r->file);
+    r->open = false;
+    if (!ok) {
+        printf("[ERROR] ERROR_SD_WRITE_FAIL: Structured report write failed\n");
+        return ERROR_SD_WRITE_FAIL;
+    }
+
+    printf("✓ Structured report saved: %s (%lu bytes)\n", r->filename, (unsigned long)r->rw.written);
+    return SUCCESS;
+}
+
+// Drops a report that was begun but will not be finished
+void forensic_report_abort(forensic_report_t *r) {
+    if (!r->open) return;
+    f_close(&r->file);
+    f_unlink(r->filename);
+    r->open = false;
+}
+
+int forensic_report_write(const forensic_meta_t *meta, renc_format_t fmt) {
+    int rc = forensic_report_begin(&g_forensic_oneshot, meta, fmt);
+    if (rc != SUCCESS) {
+        forensic_report_abort(&g_forensic_oneshot);
+        return rc;
+    }
+    return forensic_report_finish(&g_forensic_oneshot);
+}
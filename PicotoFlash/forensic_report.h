@@ -0,0 +1,66 @@
+/*
+ * Structured Forensic Report Module Header
+ * Machine-readable counterpart of sd_create_forensic_report(): the full
+ * identification, SFDP decode, every benchmark distribution, every
+ * candidate score and the backup hash, streamed as CBOR (or JSON).
+ */
+
+#ifndef FORENSIC_REPORT_H
+#define FORENSIC_REPORT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ff.h"
+#include "report_writer.h"
+#include "report_enc.h"
+
+// File definitions
+#define FORENSIC_CBOR_FILE "Report/forensic_report_%04d%02d%02d_%02d%02d%02d.cbor"
+#define FORENSIC_JSON_FILE "Report/forensic_report_%04d%02d%02d_%02d%02d%02d.json"
+
+// Constants
+#define FORENSIC_SCHEMA "picotoflash.forensic"
+#define FORENSIC_SCHEMA_VERSION 1
+
+// Identification data not held in the global result structs
+typedef struct {
+    const uint8_t *jedec;              // 3 bytes
+    const uint8_t *uid;
+    uint8_t uid_len;
+    bool sfdp_ok;
+    const uint8_t *sfdp_hdr;           // 8 bytes
+    const uint8_t *sfdp_ph;            // sfdp_nph * 8 bytes
+    uint8_t sfdp_nph;
+    const uint8_t *bfpt;
+    uint16_t bfpt_len;
+    uint32_t bfpt_ptp;
+    uint32_t density_bits;
+    bool fast_read_0B;
+    uint8_t fast_read_dummy;
+
+    // Auto backup taken by this run
+    bool image_valid;
+    uint32_t image_bytes;
+    uint32_t image_crc32;
+    uint32_t head_bytes;
+    uint32_t head_crc32;
+} forensic_meta_t;
+
+// A report in progress: begun once the read benchmarks are done, finished
+// after the write/erase benchmarks and the final match
+typedef struct {
+    FIL file;
+    report_writer_t rw;
+    renc_t enc;
+    bool open;
+    char filename[64];
+    char arena[REPORT_ARENA_SIZE];
+} forensic_report_t;
+
+// Function declarations
+int forensic_report_begin(forensic_report_t *r, const forensic_meta_t *meta, renc_format_t fmt);
+int forensic_report_finish(forensic_report_t *r);
+void forensic_report_abort(forensic_report_t *r);
+int forensic_report_write(const forensic_meta_t *meta, renc_format_t fmt);
+
+#endif // FORENSIC_REPORT_H
@@ -13,133 +13,208 @@ extern FlashChipData database[];
 extern int database_entry_count;
 extern FlashChipData benchmark_results;
 extern match_result_t match_results[];
+extern match_candidate_t match_candidates[];
+extern int match_candidate_count;
 
 // ============================================================================
 // D7.2.3: chip_calculate_confidence()
 // ============================================================================
 
-confidence_result_t chip_calculate_confidence(FlashChipData* measured, FlashChipData* expected) {
-    confidence_result_t result;
-    memset(&result, 0, sizeof(confidence_result_t));
-    
-    // Adjusted weighting - SKIP Write (Page Program) and Clock
-    const float JEDEC_WEIGHT = 0.40;
-    const float READ_WEIGHT = 0.20;
-    const float ERASE_WEIGHT = 0.10;
-    // Write (20%) and Clock (10%) are SKIPPED - not included
-    
-    // Tolerances
-    const float READ_TOLERANCE = 0.15;
-    const float ERASE_TOLERANCE = 0.20;
-    const float MEASUREMENT_UNCERTAINTY = 0.05;
-    
-    int factors_available = 0;
-    float total_weight_available = 0.0;
-    float weighted_score = 0.0;
-    
-    // 1. JEDEC ID Match (40% weight)
-    if (strlen(measured->jedec_id) > 0 && strlen(expected->jedec_id) > 0) {
-        result.breakdown.jedec_id_available = true;
-        factors_available++;
-        total_weight_available += JEDEC_WEIGHT;
-        
-        if (strcmp(measured->jedec_id, expected->jedec_id) == 0) {
-            result.breakdown.jedec_id_score = 100.0;
-            weighted_score += JEDEC_WEIGHT * 100.0;
-        } else {
-            result.breakdown.jedec_id_score = 0.0;
-        }
-    }
-    
-    // 2. Read Speed Deviation (20% weight)
-    if (measured->read_speed_max > 0 && expected->read_speed_max > 0) {
-        result.breakdown.read_speed_available = true;
-        factors_available++;
-        total_weight_available += READ_WEIGHT;
-        
-        float deviation = fabs(measured->read_speed_max - expected->read_speed_max) / expected->read_speed_max;
-        deviation = fmax(0, deviation - MEASUREMENT_UNCERTAINTY);
-        float normalized_score = fmax(0, 100.0 * (1.0 - deviation / READ_TOLERANCE));
-        
-        result.breakdown.read_speed_score = normalized_score;
-        weighted_score += READ_WEIGHT * normalized_score;
-    }
-    
-    // 3. Write Speed (Page Program) - COMPLETELY SKIPPED
-    result.breakdown.write_speed_available = false;
-    result.breakdown.write_speed_score = 0.0;
-    
-    // 4. Erase Speed Deviation (10% weight)
-    if (measured->erase_speed > 0 && expected->erase_speed > 0) {
-        result.breakdown.erase_speed_available = true;
-        factors_available++;
-        total_weight_available += ERASE_WEIGHT;
-        
-        float deviation = fabs(measured->erase_speed - expected->erase_speed) / expected->erase_speed;
-        deviation = fmax(0, deviation - MEASUREMENT_UNCERTAINTY);
-        float normalized_score = fmax(0, 100.0 * (1.0 - deviation / ERASE_TOLERANCE));
-        
-        result.breakdown.erase_speed_score = normalized_score;
-        weighted_score += ERASE_WEIGHT * normalized_score;
-    }
+// Adjusted weighting - SKIP Write (Page Program) and Clock
+static const float JEDEC_WEIGHT = 0.40;
+static const float READ_WEIGHT = 0.20;
+static const float ERASE_WEIGHT = 0.10;
+// Write (20%) and Clock (10%) are SKIPPED - not included
+
+// Tolerances
+static const float READ_TOLERANCE = 0.15;
+static const float ERASE_TOLERANCE = 0.20;
+static const float MEASUREMENT_UNCERTAINTY = 0.05;
+
+// Overall score, factor count and warnings from the factor breakdown
+static void confidence_settle(confidence_result_t* result) {
+    const factor_breakdown_t* b = &result->breakdown;
+    int factors_available = (b->jedec_id_available ? 1 : 0) +
+                            (b->read_speed_available ? 1 : 0) +
+                            (b->erase_speed_available ? 1 : 0);
     
-    // 5. Clock Speed Profile Match - COMPLETELY SKIPPED
-    result.breakdown.clock_profile_available = false;
-    result.breakdown.clock_profile_score = 0.0;
+    // Unavailable factors score 0, so they drop out of the sum
+    float weighted_score = JEDEC_WEIGHT * b->jedec_id_score +
+                           READ_WEIGHT * b->read_speed_score +
+                           ERASE_WEIGHT * b->erase_speed_score;
     
-    result.factors_used = factors_available;
+    result->factors_used = factors_available;
+    result->warning_message[0] = '\0';
     
     // Handle insufficient data
     if (factors_available < 2) {
-        snprintf(result.warning_message, sizeof(result.warning_message),
+        snprintf(result->warning_message, sizeof(result->warning_message),
                  "WARNING_INSUFFICIENT_DATA: Only %d factors available", factors_available);
     }
     
     // Handle missing JEDEC ID (critical)
-    if (!result.breakdown.jedec_id_available) {
-        result.overall_confidence = 0.0;
-        snprintf(result.warning_message, sizeof(result.warning_message),
+    if (!b->jedec_id_available) {
+        result->overall_confidence = 0.0;
+        snprintf(result->warning_message, sizeof(result->warning_message),
                  "CRITICAL: JEDEC ID missing");
-        return result;
+        return;
     }
     
     // No redistribution - missing data = 0% for that factor
-    result.overall_confidence = fmin(100.0, weighted_score);
+    result->overall_confidence = fmin(100.0, weighted_score);
     
     // Flag low-confidence components
     char low_conf_msg[256] = "";
     bool has_low_conf = false;
     
-    if (result.breakdown.jedec_id_available && result.breakdown.jedec_id_score < 50.0) {
+    if (b->jedec_id_available && b->jedec_id_score < 50.0) {
         strcat(low_conf_msg, "JEDEC ");
         has_low_conf = true;
     }
     
-    if (result.breakdown.read_speed_available && result.breakdown.read_speed_score < 50.0) {
+    if (b->read_speed_available && b->read_speed_score < 50.0) {
         strcat(low_conf_msg, "READ ");
         has_low_conf = true;
     }
     
-    if (result.breakdown.erase_speed_available && result.breakdown.erase_speed_score < 50.0) {
+    if (b->erase_speed_available && b->erase_speed_score < 50.0) {
         strcat(low_conf_msg, "ERASE ");
         has_low_conf = true;
     }
     
     if (has_low_conf) {
-        char temp[256];
-        snprintf(temp, sizeof(temp), "Low confidence factors: %s", low_conf_msg);
-        strncpy(result.warning_message, temp, sizeof(result.warning_message) - 1);
+        snprintf(result->warning_message, sizeof(result->warning_message),
+                 "Low confidence factors: %s", low_conf_msg);
+    }
+}
+
+// Factors known once the read benchmarks have run: JEDEC ID and read speed
+confidence_result_t chip_confidence_partial(FlashChipData* measured, FlashChipData* expected) {
+    confidence_result_t result;
+    memset(&result, 0, sizeof(confidence_result_t));
+    
+    // 1. JEDEC ID Match (40% weight)
+    if (strlen(measured->jedec_id) > 0 && strlen(expected->jedec_id) > 0) {
+        result.breakdown.jedec_id_available = true;
+        result.breakdown.jedec_id_score =
+            (strcmp(measured->jedec_id, expected->jedec_id) == 0) ? 100.0 : 0.0;
+    }
+    
+    // 2. Read Speed Deviation (20% weight)
+    if (measured->read_speed_max > 0 && expected->read_speed_max > 0) {
+        result.breakdown.read_speed_available = true;
+        
+        float deviation = fabs(measured->read_speed_max - expected->read_speed_max) / expected->read_speed_max;
+        deviation = fmax(0, deviation - MEASUREMENT_UNCERTAINTY);
+        result.breakdown.read_speed_score = fmax(0, 100.0 * (1.0 - deviation / READ_TOLERANCE));
     }
     
+    // 3. Write Speed (Page Program) - COMPLETELY SKIPPED
+    result.breakdown.write_speed_available = false;
+    result.breakdown.write_speed_score = 0.0;
+    
+    // 5. Clock Speed Profile Match - COMPLETELY SKIPPED
+    result.breakdown.clock_profile_available = false;
+    result.breakdown.clock_profile_score = 0.0;
+    
+    confidence_settle(&result);
+    return result;
+}
+
+// 4. Erase Speed Deviation (10% weight), folded into a partial result
+void chip_confidence_fold_erase(confidence_result_t* result, FlashChipData* measured, FlashChipData* expected) {
+    if (measured->erase_speed > 0 && expected->erase_speed > 0) {
+        result->breakdown.erase_speed_available = true;
+        
+        float deviation = fabs(measured->erase_speed - expected->erase_speed) / expected->erase_speed;
+        deviation = fmax(0, deviation - MEASUREMENT_UNCERTAINTY);
+        result->breakdown.erase_speed_score = fmax(0, 100.0 * (1.0 - deviation / ERASE_TOLERANCE));
+    } else {
+        result->breakdown.erase_speed_available = false;
+        result->breakdown.erase_speed_score = 0.0;
+    }
+    confidence_settle(result);
+}
+
+confidence_result_t chip_calculate_confidence(FlashChipData* measured, FlashChipData* expected) {
+    confidence_result_t result = chip_confidence_partial(measured, expected);
+    chip_confidence_fold_erase(&result, measured, expected);
     return result;
 }
 
 
+// Candidates keep the factor breakdown only; overall score, factor count and
+// warning text follow from it
+static void candidate_store(match_candidate_t* c, const confidence_result_t* r) {
+    const factor_breakdown_t* b = &r->breakdown;
+    c->flags = (uint8_t)((c->flags & MATCH_CAND_OUTLIER) |
+                         (b->jedec_id_available ? MATCH_CAND_JEDEC : 0) |
+                         (b->read_speed_available ? MATCH_CAND_READ : 0) |
+                         (b->erase_speed_available ? MATCH_CAND_ERASE : 0) |
+                         (b->clock_profile_available ? MATCH_CAND_CLOCK : 0));
+    c->factors_used = (uint8_t)r->factors_used;
+    c->overall_confidence = r->overall_confidence;
+    c->jedec_id_score = b->jedec_id_score;
+    c->read_speed_score = b->read_speed_score;
+    c->erase_speed_score = b->erase_speed_score;
+    c->clock_profile_score = b->clock_profile_score;
+}
+
+void chip_candidate_confidence(const match_candidate_t* c, confidence_result_t* out) {
+    memset(out, 0, sizeof(*out));
+    factor_breakdown_t* b = &out->breakdown;
+    b->jedec_id_available = (c->flags & MATCH_CAND_JEDEC) != 0;
+    b->read_speed_available = (c->flags & MATCH_CAND_READ) != 0;
+    b->erase_speed_available = (c->flags & MATCH_CAND_ERASE) != 0;
+    b->clock_profile_available = (c->flags & MATCH_CAND_CLOCK) != 0;
+    b->jedec_id_score = c->jedec_id_score;
+    b->read_speed_score = c->read_speed_score;
+    b->erase_speed_score = c->erase_speed_score;
+    b->clock_profile_score = c->clock_profile_score;
+    confidence_settle(out);
+}
+
 // ============================================================================
 // D7.2.2: chip_match_database()
 // ============================================================================
 
-match_status_t chip_match_database(FlashChipData* test_data) {
+// Score every database entry on the factors available before the erase
+// benchmarks (JEDEC + read speed). Silent, so it can run while the flash
+// worker is still busy; chip_match_finalize() folds in erase and ranks.
+bool chip_match_partial(FlashChipData* test_data) {
+    match_candidate_count = 0;
+    if (database_entry_count == 0) return false;
+    
+    for (int i = 0; i < database_entry_count && match_candidate_count < MAX_MATCH_CANDIDATES; i++) {
+        match_candidate_t *c = &match_candidates[match_candidate_count++];
+        c->database_index = i;
+        c->flags = 0;
+        
+        // Check for performance outliers
+        if (test_data->read_speed_max > 0 && database[i].read_speed_max > 0) {
+            float deviation = fabs(test_data->read_speed_max - database[i].read_speed_max) / 
+                             database[i].read_speed_max;
+            if (deviation > 0.50) c->flags = MATCH_CAND_OUTLIER;
+        }
+        confidence_result_t conf = chip_confidence_partial(test_data, &database[i]);
+        candidate_store(c, &conf);
+    }
+    return true;
+}
+
+// Index into match_candidates[] of the best partial score, -1 if none
+int chip_match_partial_leader(void) {
+    int best = -1;
+    for (int i = 0; i < match_candidate_count; i++) {
+        if (best < 0 ||
+            match_candidates[i].overall_confidence > match_candidates[best].overall_confidence) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+match_status_t chip_match_finalize(FlashChipData* test_data) {
     if (database_entry_count == 0) {
         printf("[ERROR] ERROR_NO_DATABASE: No database loaded\n");
         return MATCH_UNKNOWN;
@@ -161,18 +236,20 @@ match_status_t chip_match_database(FlashChipData* test_data) {
     
     bool has_outlier = false;
     
-    for (int i = 0; i < database_entry_count; i++) {
-        confidence_result_t conf = chip_calculate_confidence(test_data, &database[i]);
+    for (int n = 0; n < match_candidate_count; n++) {
+        match_candidate_t *c = &match_candidates[n];
+        int i = c->database_index;
+        // Candidates from before a database reload may point past its end
+        if (i < 0 || i >= database_entry_count) continue;
+        confidence_result_t conf;
+        chip_candidate_confidence(c, &conf);
+        chip_confidence_fold_erase(&conf, test_data, &database[i]);
+        candidate_store(c, &conf);
         
-        // Check for performance outliers
-        if (test_data->read_speed_max > 0 && database[i].read_speed_max > 0) {
-            float deviation = fabs(test_data->read_speed_max - database[i].read_speed_max) / 
-                             database[i].read_speed_max;
-            if (deviation > 0.50) {
-                has_outlier = true;
-                printf("[INFO] WARNING_PERFORMANCE_OUTLIER detected for %s (Read speed)\n",
-                       database[i].chip_model);
-            }
+        if (c->flags & MATCH_CAND_OUTLIER) {
+            has_outlier = true;
+            printf("[INFO] WARNING_PERFORMANCE_OUTLIER detected for %s (Read speed)\n",
+                   database[i].chip_model);
         }
         
         // Insert into top 3
@@ -236,3 +313,8 @@ match_status_t chip_match_database(FlashChipData* test_data) {
     
     return match_results[0].status;
 }
+
+match_status_t chip_match_database(FlashChipData* test_data) {
+    chip_match_partial(test_data);
+    return chip_match_finalize(test_data);
+}
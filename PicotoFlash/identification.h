@@ -7,10 +7,14 @@
 #define IDENTIFICATION_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 // Constants
 #define MAX_FIELD_LENGTH 64
 #define TOP_MATCHES_COUNT 3
+#ifndef MAX_MATCH_CANDIDATES
+#define MAX_MATCH_CANDIDATES 100    // == MAX_DATABASE_ENTRIES
+#endif
 
 // Match status enumeration
 typedef enum {
@@ -75,13 +79,42 @@ typedef struct {
     bool has_outliers;
 } match_result_t;
 
+// Candidate flags
+#define MATCH_CAND_JEDEC   0x01u   // Factor available
+#define MATCH_CAND_READ    0x02u
+#define MATCH_CAND_ERASE   0x04u
+#define MATCH_CAND_CLOCK   0x08u
+#define MATCH_CAND_OUTLIER 0x10u   // Read speed deviates >50% from this entry
+
+// Score of one database entry from the last chip_match_partial() /
+// chip_match_finalize() run, kept compact (one per database row);
+// chip_candidate_confidence() rebuilds the full result and warning text
+typedef struct {
+    int32_t database_index;
+    uint8_t flags;              // MATCH_CAND_*
+    uint8_t factors_used;
+    float overall_confidence;
+    float jedec_id_score;
+    float read_speed_score;
+    float erase_speed_score;
+    float clock_profile_score;
+} match_candidate_t;
+
 // External global variables
 extern FlashChipData database[];
 extern int database_entry_count;
 extern match_result_t match_results[];
+extern match_candidate_t match_candidates[];
+extern int match_candidate_count;
 
 // Function declarations
 confidence_result_t chip_calculate_confidence(FlashChipData* measured, FlashChipData* expected);
+confidence_result_t chip_confidence_partial(FlashChipData* measured, FlashChipData* expected);
+void chip_confidence_fold_erase(confidence_result_t* result, FlashChipData* measured, FlashChipData* expected);
+void chip_candidate_confidence(const match_candidate_t* c, confidence_result_t* out);
 match_status_t chip_match_database(FlashChipData* test_data);
+bool chip_match_partial(FlashChipData* test_data);
+int chip_match_partial_leader(void);
+match_status_t chip_match_finalize(FlashChipData* test_data);
 
 #endif // IDENTIFICATION_H
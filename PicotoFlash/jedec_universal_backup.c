@@ -8,26 +8,48 @@
  *      * 0x0B   – fast read if SFDP says flash supports it
  * - 3-byte vs 4-byte addressing
  * - Full-chip or partial backup via callback sink
+ * - Chunk reads over the PIO transport when the bus has one attached
+ * - Dual/quad reads (0x3B / 0x6B / 0xEB) from the SFDP BFPT, with the QE
+ *   bit set per DWORD15 (or vendor) rules and restored afterwards
  */
 
 #include "jedec_universal_backup.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include "spi_trace.h"
+#include "buf_pool.h"
 
 static jedec_bus_t g_bus;
 
 // === SPI helpers ===
-static inline void cs_low(void)  { gpio_put(g_bus.cs_pin, 0); }
-static inline void cs_high(void) { gpio_put(g_bus.cs_pin, 1); }
+static inline void cs_low(void)  { gpio_put(g_bus.cs_pin, 0); spi_trace_cs(true); }
+static inline void cs_high(void) { spi_trace_cs(false); gpio_put(g_bus.cs_pin, 1); }
 
 static inline void spi_tx(const uint8_t *buf, size_t len) {
+    spi_trace_pl022(g_bus.spi, buf, len);
     spi_write_blocking(g_bus.spi, buf, len);
 }
 static inline void spi_rx(uint8_t *buf, size_t len) {
+    spi_trace_pl022(g_bus.spi, NULL, len);
     spi_read_blocking(g_bus.spi, 0x00, buf, len);
 }
 
+// Bulk path for jedec_read_chunk(): PIO (DMA-fed) when attached, else PL022
+static inline bool pio_active(void) {
+    return g_bus.pio && g_bus.pio->attached;
+}
+
+static inline void chunk_tx(const uint8_t *buf, size_t len) {
+    if (pio_active()) pio_spi_write(g_bus.pio, buf, len);
+    else spi_tx(buf, len);
+}
+
+static inline void chunk_rx(uint8_t *buf, size_t len) {
+    if (pio_active()) pio_spi_read(g_bus.pio, buf, len);
+    else spi_rx(buf, len);
+}
+
 // === Init SPI + pins ===
 bool jedec_init(const jedec_bus_t *bus) {
     g_bus = *bus;
@@ -134,8 +156,229 @@ bool jedec_probe(jedec_chip_t *out) {
     return true;
 }
 
+// === Multi-lane read selection ===
+static const char *const k_read_mode_names[JEDEC_READ_MODE_COUNT] = {
+    "1-1-1", "1-1-2", "1-1-4", "1-4-4"
+};
+
+const char *jedec_read_mode_name(jedec_read_mode_t mode) {
+    return mode < JEDEC_READ_MODE_COUNT ? k_read_mode_names[mode] : "?";
+}
+
+static uint32_t bfpt_dword(const uint8_t *bf, int n) {
+    const uint8_t *p = &bf[(n - 1) * 4];
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Opcode and clock counts for one mode from BFPT DWORD1 (support bits) and
+// DWORD3/4 (dummy 4:0, mode 7:5, opcode 15:8 per half)
+bool jedec_read_op_from_bfpt(jedec_read_mode_t mode, const uint8_t *bfpt, uint16_t bfpt_len,
+                             bool addr4, pio_spi_op_t *op) {
+    memset(op, 0, sizeof(*op));
+    op->addr_bytes = addr4 ? 4 : 3;
+    op->addr_lanes = 1;
+
+    if (mode == JEDEC_READ_1_1_1) {
+        op->opcode = 0x0B;
+        op->data_lanes = 1;
+        op->dummy_clocks = 8;
+        return true;
+    }
+    if (!bfpt || bfpt_len < 16) return false;
+
+    uint32_t d1 = bfpt_dword(bfpt, 1);
+    uint16_t half;
+    switch (mode) {
+        case JEDEC_READ_1_1_2:
+            if (!((d1 >> 16) & 1)) return false;
+            half = (uint16_t)bfpt_dword(bfpt, 4);
+            op->data_lanes = 2;
+            break;
+        case JEDEC_READ_1_1_4:
+            if (!((d1 >> 22) & 1)) return false;
+            half = (uint16_t)(bfpt_dword(bfpt, 3) >> 16);
+            op->data_lanes = 4;
+            break;
+        case JEDEC_READ_1_4_4:
+            if (!((d1 >> 21) & 1)) return false;
+            half = (uint16_t)bfpt_dword(bfpt, 3);
+            op->addr_lanes = 4;
+            op->data_lanes = 4;
+            break;
+        default:
+            return false;
+    }
+    op->opcode = (uint8_t)(half >> 8);
+    op->mode_clocks = (half >> 5) & 0x07;
+    op->dummy_clocks = half & 0x1F;
+    return op->opcode != 0x00 && op->opcode != 0xFF;
+}
+
+// Vendor defaults when the BFPT predates DWORD15 (JESD216 rev 0)
+static jedec_qer_t qer_for_vendor(uint8_t manuf_id) {
+    switch (manuf_id) {
+        case 0xEF:                  // Winbond
+        case 0xC8:                  // GigaDevice
+        case 0x85:                  // Puya
+        case 0x68:                  // Boya
+        case 0x5E:                  // Zbit
+            return JEDEC_QER_SR2_B1_RD35;
+        case 0xC2:                  // Macronix
+        case 0x9D:                  // ISSI
+            return JEDEC_QER_SR1_B6;
+        case 0x01:                  // Spansion / Cypress (CR1 bit 1)
+            return JEDEC_QER_SR2_B1;
+        case 0x20:                  // Micron: no QE bit
+            return JEDEC_QER_NONE;
+        default:
+            return JEDEC_QER_UNKNOWN;
+    }
+}
+
+static uint8_t read_reg(uint8_t cmd) {
+    uint8_t v = 0;
+    cs_low();
+    chunk_tx(&cmd, 1);
+    chunk_rx(&v, 1);
+    cs_high();
+    return v;
+}
+
+static bool wait_ready(uint32_t timeout_ms) {
+    uint64_t deadline = time_us_64() + (uint64_t)timeout_ms * 1000u;
+    while (read_reg(0x05) & 0x01) {
+        if (time_us_64() > deadline) return false;
+    }
+    return true;
+}
+
+static bool write_reg(uint8_t cmd, const uint8_t *v, size_t n) {
+    uint8_t wren = 0x06;
+    cs_low();
+    chunk_tx(&wren, 1);
+    cs_high();
+
+    uint8_t buf[3] = {cmd, 0, 0};
+    memcpy(&buf[1], v, n);
+    cs_low();
+    chunk_tx(buf, 1 + n);
+    cs_high();
+    return wait_ready(50);
+}
+
+// Set (on) or restore (off) the QE bit; sr_saved holds the original registers
+static bool quad_enable(jedec_chip_t *chip, bool on) {
+    uint8_t *sv = chip->sr_saved;
+    uint8_t v[2];
+    switch (chip->qer) {
+        case JEDEC_QER_NONE:
+            return true;
+        case JEDEC_QER_SR1_B6:
+            if (on) {
+                sv[0] = read_reg(0x05);
+                if (sv[0] & 0x40) return true;
+                v[0] = sv[0] | 0x40;
+            } else {
+                v[0] = sv[0];
+            }
+            if (!write_reg(0x01, v, 1)) return false;
+            break;
+        case JEDEC_QER_SR2_B7:
+            if (on) {
+                sv[1] = read_reg(0x3F);
+                if (sv[1] & 0x80) return true;
+                v[0] = sv[1] | 0x80;
+            } else {
+                v[0] = sv[1];
+            }
+            if (!write_reg(0x3E, v, 1)) return false;
+            break;
+        case JEDEC_QER_SR2_B1_WR31:
+            if (on) {
+                sv[1] = read_reg(0x35);
+                if (sv[1] & 0x02) return true;
+                v[0] = sv[1] | 0x02;
+            } else {
+                v[0] = sv[1];
+            }
+            if (!write_reg(0x31, v, 1)) return false;
+            break;
+        case JEDEC_QER_SR2_B1_WRSR2:
+        case JEDEC_QER_SR2_B1:
+        case JEDEC_QER_SR2_B1_RD35:
+            // Always both bytes so SR2 is never cleared by a 1-byte write
+            if (on) {
+                sv[0] = read_reg(0x05);
+                sv[1] = read_reg(0x35);
+                if (sv[1] & 0x02) return true;
+                v[0] = sv[0];
+                v[1] = sv[1] | 0x02;
+            } else {
+                v[0] = sv[0];
+                v[1] = sv[1];
+            }
+            if (!write_reg(0x01, v, 2)) return false;
+            break;
+        default:
+            return false;
+    }
+    chip->qe_set_by_us = on;
+    return true;
+}
+
+// Switch jedec_read_chunk() to a multi-lane mode (needs bus.pio); quad
+// modes set QE first. Falls back to 1-1-1 and returns false when the
+// chip, the BFPT or the fixture wiring cannot do the mode.
+bool jedec_select_read_mode(jedec_chip_t *chip, jedec_read_mode_t mode,
+                            const uint8_t *bfpt, uint16_t bfpt_len) {
+    chip->read_mode = JEDEC_READ_1_1_1;
+    if (mode == JEDEC_READ_1_1_1) return true;
+    if (!g_bus.pio) return false;
+
+    pio_spi_op_t op;
+    if (!jedec_read_op_from_bfpt(mode, bfpt, bfpt_len, chip->use_4byte_addr, &op)) {
+        printf("[UNIV] %s read not advertised in SFDP\n", jedec_read_mode_name(mode));
+        return false;
+    }
+    if (!pio_spi_op_supported(g_bus.pio, &op)) {
+        printf("[UNIV] %s read needs IO lanes this fixture does not wire\n", jedec_read_mode_name(mode));
+        return false;
+    }
+
+    if (op.data_lanes == 4 || op.addr_lanes == 4) {
+        chip->qer = (bfpt_len >= 60) ? (jedec_qer_t)((bfpt_dword(bfpt, 15) >> 20) & 0x7)
+                                     : qer_for_vendor(chip->manuf_id);
+        if (!quad_enable(chip, true)) {
+            printf("[UNIV] Could not set QE (QER %u), staying on 1-1-1\n", (unsigned)chip->qer);
+            return false;
+        }
+    }
+
+    chip->read_op = op;
+    chip->read_mode = mode;
+    printf("[UNIV] Read mode %s: opcode 0x%02X, %u mode + %u dummy clocks%s\n",
+           jedec_read_mode_name(mode), op.opcode, op.mode_clocks, op.dummy_clocks,
+           chip->qe_set_by_us ? ", QE set" : "");
+    return true;
+}
+
+// Back to 1-1-1 and, if we set QE, the original status registers
+void jedec_restore_read_mode(jedec_chip_t *chip) {
+    if (chip->qe_set_by_us) {
+        if (!quad_enable(chip, false)) printf("[UNIV] WARNING: QE restore failed\n");
+    }
+    chip->read_mode = JEDEC_READ_1_1_1;
+}
+
 // === Low-level chunk read ===
 bool jedec_read_chunk(const jedec_chip_t *chip, uint32_t addr, uint8_t *buf, size_t len) {
+    if (chip->read_mode != JEDEC_READ_1_1_1 && pio_active()) {
+        cs_low();
+        bool ok = pio_spi_read_op(g_bus.pio, &chip->read_op, addr, buf, len);
+        cs_high();
+        return ok;
+    }
+
     uint8_t hdr[6];
     size_t h = 0;
 
@@ -153,8 +396,8 @@ bool jedec_read_chunk(const jedec_chip_t *chip, uint32_t addr, uint8_t *buf, siz
     }
 
     cs_low();
-    spi_tx(hdr, h);
-    spi_rx(buf, len);
+    chunk_tx(hdr, h);
+    chunk_rx(buf, len);
     cs_high();
     return true;
 }
@@ -171,33 +414,29 @@ bool jedec_backup_stream(
     if (!sink || chunk == 0)
         return false;
 
-    uint8_t *buf = malloc(chunk);
+    uint8_t *buf = buf_pool_get(chunk, "backup_stream");
     if (!buf)
         return false;
 
     uint32_t end = offset + len;
+    bool ok = true;
 
     for (uint32_t a = offset; a < end; ) {
         size_t n = chunk;
         if (a + n > end)
             n = end - a;
 
-        if (!jedec_read_chunk(chip, a, buf, n)) {
-            free(buf);
-            return false;
-        }
-
-        if (!sink(buf, n, a, user)) {
-            free(buf);
-            return false;
+        if (!jedec_read_chunk(chip, a, buf, n) || !sink(buf, n, a, user)) {
+            ok = false;
+            break;
         }
 
         a += n;
         tight_loop_contents();
     }
 
-    free(buf);
-    return true;
+    buf_pool_put(buf);
+    return ok;
 }
 
 // === Backup entire flash ===
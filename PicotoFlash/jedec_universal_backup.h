@@ -6,6 +6,7 @@
 #include <stddef.h>
 #include "pico/stdlib.h"
 #include "hardware/spi.h"
+#include "pio_spi.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -21,8 +22,30 @@ typedef struct {
     uint mosi_pin;
     uint miso_pin;
     uint32_t clk_hz;
+    pio_spi_t *pio;             // Optional: chunk reads go over PIO while attached
 } jedec_bus_t;
 
+// Read command family (lanes for opcode-address-data)
+typedef enum {
+    JEDEC_READ_1_1_1,           // 0x03 / 0x0B
+    JEDEC_READ_1_1_2,           // 0x3B dual output
+    JEDEC_READ_1_1_4,           // 0x6B quad output
+    JEDEC_READ_1_4_4,           // 0xEB quad I/O
+    JEDEC_READ_MODE_COUNT
+} jedec_read_mode_t;
+
+// JESD216 BFPT DWORD15 Quad Enable Requirements
+typedef enum {
+    JEDEC_QER_NONE = 0,         // No QE bit (or IO2/IO3 always enabled)
+    JEDEC_QER_SR2_B1_WRSR2 = 1, // SR2 bit 1 via 2-byte 0x01; 1-byte 0x01 clears SR2
+    JEDEC_QER_SR1_B6 = 2,       // SR1 bit 6 via 1-byte 0x01
+    JEDEC_QER_SR2_B7 = 3,       // SR2 bit 7, read 0x3F / write 0x3E
+    JEDEC_QER_SR2_B1 = 4,       // SR2 bit 1 via 2-byte 0x01
+    JEDEC_QER_SR2_B1_RD35 = 5,  // SR2 bit 1, read 0x35, write 2-byte 0x01
+    JEDEC_QER_SR2_B1_WR31 = 6,  // SR2 bit 1, read 0x35, write 0x31
+    JEDEC_QER_UNKNOWN = 7
+} jedec_qer_t;
+
 // Chip properties discovered by probe
 typedef struct {
     uint8_t manuf_id;
@@ -40,6 +63,13 @@ typedef struct {
     uint8_t dummy_cycles;
 
     uint32_t effective_spi_hz;
+
+    // Multi-lane read (jedec_select_read_mode), used while the PIO transport is attached
+    jedec_read_mode_t read_mode;
+    pio_spi_op_t read_op;
+    jedec_qer_t qer;
+    bool qe_set_by_us;          // Cleared again by jedec_restore_read_mode()
+    uint8_t sr_saved[2];
 } jedec_chip_t;
 
 // Sink callback: receives each read block
@@ -73,6 +103,15 @@ bool jedec_backup_full(
     void *user
 );
 
+// Multi-lane read selection from the SFDP BFPT (raw bytes, DWORD1 first).
+// Sets the QE bit per the BFPT (or JEDEC vendor) rules for the quad modes.
+const char *jedec_read_mode_name(jedec_read_mode_t mode);
+bool jedec_read_op_from_bfpt(jedec_read_mode_t mode, const uint8_t *bfpt, uint16_t bfpt_len,
+                             bool addr4, pio_spi_op_t *op);
+bool jedec_select_read_mode(jedec_chip_t *chip, jedec_read_mode_t mode,
+                            const uint8_t *bfpt, uint16_t bfpt_len);
+void jedec_restore_read_mode(jedec_chip_t *chip);
+
 // Internal helper: read a chunk into RAM
 bool jedec_read_chunk(
     const jedec_chip_t *chip,
@@ -0,0 +1,138 @@
+/*
+ * Memory Watch Module
+ * Core stacks are the linker's SCRATCH_Y (core 0) and SCRATCH_X (core 1)
+ * regions; after the scheduler starts they only carry exceptions and
+ * interrupts. Phase snapshots come from the flash worker and the match
+ * task, one phase at a time.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include "pico/stdlib.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "buf_pool.h"
+#include "mem_watch.h"
+
+// Linker script symbols
+extern uint32_t __StackBottom[], __StackTop[];
+extern uint32_t __StackOneBottom[], __StackOneTop[];
+extern char end[];                  // First byte of the newlib heap
+
+static mem_phase_t g_phases[MEM_WATCH_PHASES];
+static uint32_t g_phase_count;
+static uint32_t g_phase_dropped;
+static uint32_t g_phase_start_ms;
+
+// ============================================================================
+// Core stacks
+// ============================================================================
+
+static void paint(uint32_t *lo, uint32_t *hi) {
+    for (uint32_t *p = lo; p < hi; p++) *p = MEM_WATCH_PAINT;
+}
+
+// Bytes of [lo, hi) ever used: the stack grows down, so scan up from lo
+static uint32_t core_stack_used(const uint32_t *lo, const uint32_t *hi) {
+    const uint32_t *p = lo;
+    while (p < hi && *p == MEM_WATCH_PAINT) p++;
+    return (uint32_t)((hi - p) * sizeof(uint32_t));
+}
+
+// Core 1 is not running yet; core 0 is painted up to just below the live
+// frame. Call first thing in main().
+void mem_watch_paint_core_stacks(void) {
+    uint32_t marker;
+    uint32_t *sp = (uint32_t *)((uintptr_t)&marker - MEM_WATCH_SP_MARGIN);
+    paint(__StackBottom, (sp > __StackBottom && sp < __StackTop) ? sp : __StackTop);
+    paint(__StackOneBottom, __StackOneTop);
+}
+
+// ============================================================================
+// Phases
+// ============================================================================
+
+static uint32_t brk_bytes(void) {
+    return (uint32_t)((char *)sbrk(0) - end);
+}
+
+void mem_watch_flow_begin(void) {
+    taskENTER_CRITICAL();
+    g_phase_count = 0;
+    g_phase_dropped = 0;
+    g_phase_start_ms = to_ms_since_boot(get_absolute_time());
+    taskEXIT_CRITICAL();
+    buf_pool_reset_peak();
+}
+
+// Closes the phase that began at the previous call (or mem_watch_flow_begin)
+void mem_watch_phase(const char *name) {
+    mem_phase_t p = {0};
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    buf_pool_stats_t pool = buf_pool_get_stats();
+
+    p.name = name;
+    p.task = pcTaskGetName(NULL);
+    p.heap_free = (uint32_t)xPortGetFreeHeapSize();
+    p.heap_min_free = (uint32_t)xPortGetMinimumEverFreeHeapSize();
+    p.brk_bytes = brk_bytes();
+    p.pool_peak_blocks = pool.high_water_blocks;
+    p.pool_failures = pool.failures;
+    p.stack_min_free = (uint32_t)uxTaskGetStackHighWaterMark(NULL) * sizeof(StackType_t);
+    buf_pool_reset_peak();
+
+    taskENTER_CRITICAL();
+    p.ms = now - g_phase_start_ms;
+    g_phase_start_ms = now;
+    if (g_phase_count < MEM_WATCH_PHASES) g_phases[g_phase_count++] = p;
+    else g_phase_dropped++;
+    taskEXIT_CRITICAL();
+}
+
+// ============================================================================
+// Report
+// ============================================================================
+
+void mem_watch_report(void) {
+    printf("\n[MEM] Per-phase memory (heap = FreeRTOS heap, brk = malloc arena, pool = %u KiB blocks)\n",
+           BUF_POOL_BLOCK_BYTES / 1024);
+    printf("  %-18s %-8s %7s %9s %9s %8s %6s %10s\n", "Phase", "Task", "ms", "heap free", "heap min",
+           "brk KiB", "pool", "stack min");
+    for (uint32_t i = 0; i < g_phase_count; i++) {
+        const mem_phase_t *p = &g_phases[i];
+        printf("  %-18s %-8s %7lu %9lu %9lu %8lu %3lu/%-2u %10lu\n", p->name, p->task,
+               (unsigned long)p->ms, (unsigned long)p->heap_free, (unsigned long)p->heap_min_free,
+               (unsigned long)(p->brk_bytes / 1024), (unsigned long)p->pool_peak_blocks, BUF_POOL_BLOCKS,
+               (unsigned long)p->stack_min_free);
+    }
+    if (g_phase_dropped) printf("  (%lu phases not recorded)\n", (unsigned long)g_phase_dropped);
+
+    TaskStatus_t tasks[MEM_WATCH_TASKS];
+    UBaseType_t n = uxTaskGetSystemState(tasks, MEM_WATCH_TASKS, NULL);
+    printf("[MEM] Stack headroom (minimum free since start)\n");
+    for (UBaseType_t i = 0; i < n; i++) {
+        printf("  %-16s %6lu bytes\n", tasks[i].pcTaskName,
+               (unsigned long)tasks[i].usStackHighWaterMark * sizeof(StackType_t));
+    }
+    printf("  %-16s %6lu / %lu bytes used\n", "core0 (MSP)",
+           (unsigned long)core_stack_used(__StackBottom, __StackTop),
+           (unsigned long)((__StackTop - __StackBottom) * sizeof(uint32_t)));
+    printf("  %-16s %6lu / %lu bytes used\n", "core1 (MSP)",
+           (unsigned long)core_stack_used(__StackOneBottom, __StackOneTop),
+           (unsigned long)((__StackOneTop - __StackOneBottom) * sizeof(uint32_t)));
+
+    uint32_t failures = 0;
+    for (uint32_t i = 0; i < g_phase_count; i++) failures += g_phases[i].pool_failures;
+    if (failures) printf("[WARN] Buffer pool: %lu failed checkouts this run\n", (unsigned long)failures);
+}
+
+// ============================================================================
+// Kernel hook
+// ============================================================================
+
+// configCHECK_FOR_STACK_OVERFLOW 2: the task's guard words were overwritten
+void vApplicationStackOverflowHook(TaskHandle_t task, char *name) {
+    (void)task;
+    printf("[ERROR] Stack overflow in task %s\n", name);
+    while (true) tight_loop_contents();
+}
@@ -0,0 +1,41 @@
+/*
+ * Memory Watch Module Header
+ * Stack and heap high-water instrumentation: paints both cores' main
+ * stacks at boot, snapshots the FreeRTOS heap, the newlib break, the
+ * buffer pool peak and the calling task's stack headroom at the end of each
+ * flow phase, and prints the table plus every task's stack headroom once
+ * the run's reports are out. Task stacks are painted by the kernel
+ * (configCHECK_FOR_STACK_OVERFLOW 2).
+ */
+
+#ifndef MEM_WATCH_H
+#define MEM_WATCH_H
+
+#include <stdint.h>
+
+// Constants
+#define MEM_WATCH_PHASES 12
+#define MEM_WATCH_TASKS 16             // Rows in the stack headroom table
+#define MEM_WATCH_PAINT 0xA5A5A5A5u     // Core stack fill word
+#define MEM_WATCH_SP_MARGIN 64          // Bytes left unpainted below the live SP
+
+// One phase's end-of-phase snapshot
+typedef struct {
+    const char *name;               // String literal
+    const char *task;               // Task that closed the phase
+    uint32_t ms;                    // Since the previous phase ended
+    uint32_t heap_free;             // FreeRTOS heap free now
+    uint32_t heap_min_free;         // FreeRTOS heap minimum-ever free
+    uint32_t brk_bytes;             // newlib heap (malloc) grown so far
+    uint32_t pool_peak_blocks;      // buf_pool peak within the phase
+    uint32_t pool_failures;         // Checkouts within the phase that found no room
+    uint32_t stack_min_free;        // Calling task, bytes, since it started
+} mem_phase_t;
+
+// Function declarations
+void mem_watch_paint_core_stacks(void);
+void mem_watch_flow_begin(void);
+void mem_watch_phase(const char *name);
+void mem_watch_report(void);
+
+#endif // MEM_WATCH_H
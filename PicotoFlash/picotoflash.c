@@ -3,13 +3,25 @@
  * Master Pico Module
  *
  * GP20 short press:
- *   1) Identify the flash
+ *   1) Identify the flash (JEDEC, SFDP, factory unique ID)
+ *      - Known chip (JEDEC + unique ID in the SD chip cache): offer the
+ *        cached result after a quick re-validation, skipping steps 2-6
  *   2) SAFE WRITE/VERIFY TEST (non-destructive; restores original 256B)
  *   3) **AUTO BACKUP to SD**: /univ_<JEDEC>.bin
  *   4) Run read/write/erase benchmarks
  *   5) Match against database, display + save reports
  *
  * GP21 short press: View database
+ * GP21 held at boot: Production station mode (auto-detect chip insertion,
+ *                    run the station.cfg pipeline, track chips/hour)
+ *
+ * Runs as a FreeRTOS task graph (SMP, both cores):
+ *   event   (core 0)  buttons -> flash / console queues
+ *   flash   (core 1)  SPI0: identify, write-test, backup reads, benchmarks
+ *   sd      (core 0)  SPI1: mount, database load, backup writes, logs, reports
+ *   match   (core 0)  database matching (partial scores during the write/erase
+ *                     benches), then hands logging to the SD writer
+ *   console (core 0)  startup text, database view, end-of-run summary
  */
 
 #include <stdio.h>
@@ -19,10 +31,17 @@
 #include <math.h>
 #include "pico/stdlib.h"
 #include "pico/stdio.h"
+#include "pico/stdio_usb.h"
 #include "hardware/gpio.h"
 #include "hardware/rtc.h"
 #include "hardware/spi.h"
 #include "hardware/clocks.h"
+#include "hardware/sync.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "event_groups.h"
 #include "ff.h"
 #include "fatfs/FatFs_SPI/sd_driver/sd_card.h"
 #include "identification.h"
@@ -31,6 +50,24 @@
 #include "read.h"
 #include "erase.h"
 #include "write.h"
+#include "crc32.h"
+#include "chip_cache.h"
+#include "station.h"
+#include "run_record.h"
+#include "forensic_report.h"
+#include "bench_journal.h"
+#include "sd_worker.h"
+#include "buf_pool.h"
+#include "mem_watch.h"
+#include "buttons.h"
+#include "pio_spi.h"
+#include "sample_cal.h"
+#include "pio_pp.h"
+#include "timing_probe.h"
+#include "clock_turbo.h"
+#include "drive_cal.h"
+#include "spi_trace.h"
+#include "span_trace.h"
 
 // === Universal JEDEC backup module (required) ===
 #include "jedec_universal_backup.h"
@@ -42,7 +79,16 @@
 #define PIN_SCK 2
 #define PIN_MOSI 3
 #define PIN_MISO 4
+#define FLASH_QUAD_FIXTURE 0       // 1 = WP#/HOLD# wired as IO2/IO3 on GP5/GP6, CS on GP7
+#if FLASH_QUAD_FIXTURE
+#define PIN_WP 5
+#define PIN_HOLD 6
+#define PIN_CS 7
+#else
+#define PIN_WP 0xFFFFFFFFu         // Strapped high on the board
+#define PIN_HOLD 0xFFFFFFFFu
 #define PIN_CS 6
+#endif
 
 // ========== System Constants ==========
 #define DEBOUNCE_DELAY_MS 50
@@ -52,14 +98,109 @@
 #define TEST_BASE_ADDR 0x100000u   // 1MB offset (safe area)
 #define PAGE_SIZE 256u
 #define ENABLE_DESTRUCTIVE_TESTS 1
+#define CACHE_OFFER_WINDOW_MS 3000 // GP20 press within this window forces a full run
+#define CACHE_REVALIDATE_MHZ 16
+#define RUN_REPORT_WRITER_BENCH 0  // 1 = time f_printf vs buffered report writer at boot
+#define FORENSIC_REPORT_JSON 0     // 1 = also render the structured report as JSON
+#define BACKUP_SLOT_BYTES (16u * 1024u)  // Ping-pong buffer size for the pipelined backup
+#define FLASH_READ_PIO 1           // 1 = read benches + backup over the PIO transport
+#define FLASH_PIO pio0             // pio1 is left to the CYW43 driver
+#define BACKUP_PIO_HZ_FAST 50000000u   // Backup SCK with fast read (0x0B)
+#define BACKUP_PIO_HZ_SAFE 25000000u   // Backup SCK with plain read (0x03)
+#define FLASH_PP_DMA 1             // 1 = page programs as PIO/DMA queues (needs FLASH_READ_PIO)
+#define FLASH_TURBO_KHZ 200000u    // clk_sys during write test + backup, 0 = stay at default
+#define FLASH_TURBO_SPI_HZ 33333333u   // PL022 SCK in the turbo window (clk_peri / 6 there)
+#define FLASH_TURBO_PIO_HZ 66666667u   // PIO backup SCK in the turbo window, capped by drive_cal
+#define BACKUP_SPI_HZ 16000000u    // PL022 SCK of the jedec_* layer outside the window
+
+// ========== Task Graph ==========
+// Core 1 is left to the flash worker so benchmark timing only competes with
+// the idle task; everything that talks to the SD card, USB or the operator
+// runs on core 0.
+#define CORE0_MASK (1u << 0)
+#define CORE1_MASK (1u << 1)
+#define EVENT_TASK_PRIORITY   (tskIDLE_PRIORITY + 4)
+#define FLASH_TASK_PRIORITY   (tskIDLE_PRIORITY + 3)
+#define SD_TASK_PRIORITY      (tskIDLE_PRIORITY + 2)
+#define MATCH_TASK_PRIORITY   (tskIDLE_PRIORITY + 2)
+#define CONSOLE_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
+#define EVENT_TASK_STACK   512
+#define FLASH_TASK_STACK   4096
+#define MATCH_TASK_STACK   2048
+#define CONSOLE_TASK_STACK 1536
+#define TASK_QUEUE_DEPTH   4
+
+// Boot bring-up (see boot_sd_job / console_task)
+#define USB_CONNECT_WAIT_MS 2000   // Console holds its banner this long for a USB host
+#define BOOT_SD_DONE   (1u << 0)   // Mount + database load attempted (success or not)
+#define BOOT_DB_READY  (1u << 1)   // Database loaded
+#define BOOT_USB_READY (1u << 2)   // USB CDC host connected (or wait timed out)
+
+// Flash worker commands
+typedef enum {
+    FLASH_CMD_RUN_FLOW,
+    FLASH_CMD_STATION
+} flash_cmd_t;
+
+// Matcher/report requests
+typedef enum {
+    MATCH_REQ_PARTIAL,          // Read benches done: score JEDEC + read, pre-render
+    MATCH_REQ_FULL,             // Match, then log + report
+    MATCH_REQ_CACHED            // Cached result: log only
+} match_req_t;
+
+// Console/display requests
+typedef enum {
+    CONSOLE_STARTUP,
+    CONSOLE_SHOW_DATABASE,
+    CONSOLE_FLOW_DONE
+} console_msg_t;
+
+static QueueHandle_t g_button_q;
+static QueueHandle_t g_flash_q;
+static QueueHandle_t g_match_q;
+static QueueHandle_t g_console_q;
+static SemaphoreHandle_t g_report_idle;   // Taken while a run's match/report is pending
+static volatile bool g_flash_busy = false;
+static EventGroupHandle_t g_boot_events;
+
+// Time-to-ready milestones, microseconds since reset (0 = not reached)
+typedef enum {
+    BOOT_MS_SCHEDULER,
+    BOOT_MS_INPUT_READY,
+    BOOT_MS_USB,
+    BOOT_MS_SD_MOUNTED,
+    BOOT_MS_DB_LOADED,
+    BOOT_MS_COUNT
+} boot_milestone_t;
+
+static const char *const k_boot_milestone_names[BOOT_MS_COUNT] = {
+    "Scheduler started",
+    "Ready for input",
+    "USB host connected",
+    "SD mounted",
+    "Database loaded",
+};
+static uint64_t g_boot_us[BOOT_MS_COUNT];
 
 // ========== Global Variables ==========
 FlashChipData database[MAX_DATABASE_ENTRIES];
 int database_entry_count = 0;
 FlashChipData benchmark_results;
 match_result_t match_results[TOP_MATCHES_COUNT];
+match_candidate_t match_candidates[MAX_MATCH_CANDIDATES];
+int match_candidate_count = 0;
 bool database_loaded = false;
 
+static FATFS g_fs;
+static bool sd_mounted = false;
+
+// PIO SPI transport sharing SCK/MOSI/MISO with FLASH_SPI
+static pio_spi_t g_flash_pio;
+static bool g_flash_pio_ok = false;
+static uint32_t g_backup_spi_hz = BACKUP_SPI_HZ;            // Raised inside the turbo window
+static uint32_t g_backup_pio_fast_hz = BACKUP_PIO_HZ_FAST;
+
 // Dynamic test chip data (populated by benchmarks)
 FlashChipData test_chip = {
     .chip_model = "UNKNOWN",
@@ -81,10 +222,10 @@ FlashChipData test_chip = {
 };
 
 // ========== Flash SPI Helper Functions ==========
-static inline void cs_low(void)  { gpio_put(PIN_CS, 0); }
-static inline void cs_high(void) { gpio_put(PIN_CS, 1); }
-static inline void spi_tx(const uint8_t *b, size_t n) { spi_write_blocking(FLASH_SPI, b, n); }
-static inline void spi_rx(uint8_t *b, size_t n)       { spi_read_blocking(FLASH_SPI, 0x00, b, n); }
+static inline void cs_low(void)  { gpio_put(PIN_CS, 0); spi_trace_cs(true); }
+static inline void cs_high(void) { spi_trace_cs(false); gpio_put(PIN_CS, 1); }
+static inline void spi_tx(const uint8_t *b, size_t n) { spi_trace_pl022(FLASH_SPI, b, n); spi_write_blocking(FLASH_SPI, b, n); }
+static inline void spi_rx(uint8_t *b, size_t n)       { spi_trace_pl022(FLASH_SPI, NULL, n); spi_read_blocking(FLASH_SPI, 0x00, b, n); }
 
 // ========== Minimal Read Helpers ==========
 static void read_jedec_id(uint8_t out[3]) {
@@ -122,6 +263,18 @@ static void flash_wait_busy(void) {
 }
 
 static void flash_page_program(uint32_t addr, const uint8_t *buf, size_t len) {
+#if FLASH_READ_PIO && FLASH_PP_DMA
+    // Same SCK as the PL022; the CPU waits on the engine's IRQ, not RDSR
+    if (g_flash_pio_ok) {
+        pio_spi_set_hz(&g_flash_pio, spi_get_baudrate(FLASH_SPI));
+        pio_spi_attach(&g_flash_pio);
+        bool queued = pio_pp_begin(&g_flash_pio, PIN_CS);
+        bool ok = queued && pio_pp_write(addr, buf, len);
+        if (queued) pio_pp_end();
+        pio_spi_detach(&g_flash_pio);
+        if (ok) return;
+    }
+#endif
     // assumes len <= 256 and does not cross page boundary
     flash_write_enable();
     uint8_t hdr[4] = {0x02, (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)addr};
@@ -143,8 +296,28 @@ typedef struct {
     uint32_t et_size_bytes[4];
     bool fastread_0B;
     uint8_t fastread_dummy;
+    uint8_t uid[CHIP_CACHE_UID_MAX];
+    uint8_t uid_len;
+
+    // Raw SFDP tables (decoded again by the structured report)
+    uint8_t sfdp_hdr[8];
+    uint8_t sfdp_nph;
+    uint8_t sfdp_ph[8 * 16];
+    uint32_t bfpt_ptp;
+    uint16_t bfpt_len;
+    uint8_t bfpt[256];
 } ident_t;
 
+// Result of the last auto backup (hashed on the fly by sd_sink)
+typedef struct {
+    bool valid;
+    uint32_t bytes;
+    uint32_t crc32;
+    uint32_t head_crc32;
+} backup_info_t;
+
+static backup_info_t g_last_backup;
+
 static bool read_sfdp(uint32_t a, uint8_t *buf, size_t n) {
     if (a > 0xFFFFFF) return false;
     uint8_t h[5] = {0x5A, (uint8_t)(a >> 16), (uint8_t)(a >> 8), (uint8_t)a, 0};
@@ -155,6 +328,83 @@ static bool read_sfdp(uint32_t a, uint8_t *buf, size_t n) {
     return true;
 }
 
+// Factory unique ID (0x4B + 4 dummy bytes). Winbond returns 64 bits,
+// GigaDevice/XMC/Puya 128 bits; JESD216 has no BFPT field advertising the
+// opcode, so the reply is validated instead (all-00/FF means unsupported).
+static void read_unique_id(ident_t *id) {
+    uint8_t c[5] = {0x4B, 0, 0, 0, 0};
+    uint8_t u[CHIP_CACHE_UID_MAX];
+    memset(u, 0xFF, sizeof(u));
+    cs_low();
+    spi_tx(c, 5);
+    spi_rx(u, sizeof(u));
+    cs_high();
+
+    // 64-bit parts repeat or float after the 8th byte
+    bool upper_ff = true;
+    for (int i = 8; i < CHIP_CACHE_UID_MAX; i++) if (u[i] != 0xFF) upper_ff = false;
+    uint8_t len = (upper_ff || memcmp(u, &u[8], 8) == 0) ? 8 : CHIP_CACHE_UID_MAX;
+
+    if (chip_cache_uid_valid(u, len)) {
+        memcpy(id->uid, u, len);
+        id->uid_len = len;
+    } else {
+        id->uid_len = 0;
+    }
+}
+
+// Basic Flash Parameter Table pointer and length from the parameter headers
+static bool sfdp_find_bfpt(const uint8_t *ph, uint8_t nph, uint32_t *ptp, uint8_t *dwords) {
+    for (uint8_t i = 0; i < nph; i++) {
+        const uint8_t *p = &ph[i * 8];
+        uint16_t idlsb = ((uint16_t)p[0]) | (((uint16_t)p[1]) << 8);
+        if (idlsb == 0xFF00) {
+            *ptp = ((uint32_t)p[5]) | (((uint32_t)p[6]) << 8) | (((uint32_t)p[7]) << 16);
+            *dwords = p[4];
+            return true;
+        }
+    }
+    return false;
+}
+
+// Density and erase types from the BFPT already in id->bfpt (no bus access)
+static void sfdp_decode_bfpt(ident_t *id) {
+    const uint8_t *bf = id->bfpt;
+    size_t bytes = id->bfpt_len;
+
+    // Parse density (DWORD 2)
+    if (bytes >= 8) {
+        uint32_t d2 = ((uint32_t)bf[4]) | (((uint32_t)bf[5]) << 8) |
+                      (((uint32_t)bf[6]) << 16) | (((uint32_t)bf[7]) << 24);
+        if ((d2 & 0x80000000u) == 0) {
+            id->density_bits = d2 + 1u;
+        } else {
+            uint32_t n = (d2 & 0x7FFFFFFFu) + 1u;
+            if (n >= 32) id->density_bits = (1u << n);
+        }
+    }
+
+    // Parse erase types (DWORD 7 & 8)
+    if (bytes >= 32) {
+        uint32_t d7 = ((uint32_t)bf[24]) | (((uint32_t)bf[25]) << 8) |
+                      (((uint32_t)bf[26]) << 16) | (((uint32_t)bf[27]) << 24);
+        uint32_t d8 = ((uint32_t)bf[28]) | (((uint32_t)bf[29]) << 8) |
+                      (((uint32_t)bf[30]) << 16) | (((uint32_t)bf[31]) << 24);
+
+        uint8_t szn[4] = {(uint8_t)(d7 >> 0), (uint8_t)(d7 >> 16),
+                          (uint8_t)(d8 >> 0), (uint8_t)(d8 >> 16)};
+        uint8_t opc[4] = {(uint8_t)(d7 >> 8), (uint8_t)(d7 >> 24),
+                          (uint8_t)(d8 >> 8), (uint8_t)(d8 >> 24)};
+
+        for (int k = 0; k < 4; k++) {
+            uint32_t sz = (1u << szn[k]);
+            id->et_present[k] = (sz != 0);
+            id->et_opcode[k] = opc[k];
+            id->et_size_bytes[k] = sz;
+        }
+    }
+}
+
 static void identify(ident_t *id) {
     memset(id, 0, sizeof(*id));
     read_jedec_id(id->jedec);
@@ -164,79 +414,36 @@ static void identify(ident_t *id) {
     spi_set_baudrate(FLASH_SPI, 5 * 100 * 1000);
 
     // Read SFDP header
+    span_begin("sfdp_read");
     uint8_t hdr[8] = {0};
     if (read_sfdp(0, hdr, 8) && hdr[0] == 'S' && hdr[1] == 'F' && hdr[2] == 'D' && hdr[3] == 'P') {
         id->sfdp_ok = true;
         id->sfdp_minor = hdr[4];
         id->sfdp_major = hdr[5];
+        memcpy(id->sfdp_hdr, hdr, sizeof(hdr));
 
         uint8_t nph = (uint8_t)(hdr[6]) + 1;
-        uint8_t ph[8 * 16] = {0};
-        size_t need = (size_t)nph * 8;
-        if (need > sizeof(ph)) need = sizeof(ph);
-        read_sfdp(8, ph, need);
+        uint8_t *ph = id->sfdp_ph;
+        if ((size_t)nph * 8 > sizeof(id->sfdp_ph)) nph = sizeof(id->sfdp_ph) / 8;
+        id->sfdp_nph = nph;
+        read_sfdp(8, ph, (size_t)nph * 8);
 
         // Find Basic Flash Parameter Table
-        bool bfpt = false;
         uint32_t ptp = 0;
         uint8_t dwords = 0;
-        for (uint8_t i = 0; i < nph; i++) {
-            const uint8_t *p = &ph[i * 8];
-            uint16_t idlsb = ((uint16_t)p[0]) | (((uint16_t)p[1]) << 8);
-            if (idlsb == 0xFF00) {
-                idlsb = 0x00FF;
-                bfpt = true;
-                ptp = ((uint32_t)p[5]) | (((uint32_t)p[6]) << 8) | (((uint32_t)p[7]) << 16);
-                dwords = p[4];
-                break;
-            }
-        }
-
-        if (!bfpt) {
+        if (!sfdp_find_bfpt(ph, nph, &ptp, &dwords)) {
             ptp = 0x000030;
             dwords = 64;
-            bfpt = true;
         }
 
-        if (bfpt) {
-            size_t bytes = (size_t)(dwords * 4);
-            if (bytes > 256) bytes = 256;
-            uint8_t bf[256] = {0};
-            read_sfdp(ptp, bf, bytes);
-
-            // Parse density (DWORD 2)
-            if (bytes >= 8) {
-                uint32_t d2 = ((uint32_t)bf[4]) | (((uint32_t)bf[5]) << 8) |
-                              (((uint32_t)bf[6]) << 16) | (((uint32_t)bf[7]) << 24);
-                if ((d2 & 0x80000000u) == 0) {
-                    id->density_bits = d2 + 1u;
-                } else {
-                    uint32_t n = (d2 & 0x7FFFFFFFu) + 1u;
-                    if (n >= 32) id->density_bits = (1u << n);
-                }
-            }
-
-            // Parse erase types (DWORD 7 & 8)
-            if (bytes >= 32) {
-                uint32_t d7 = ((uint32_t)bf[24]) | (((uint32_t)bf[25]) << 8) |
-                              (((uint32_t)bf[26]) << 16) | (((uint32_t)bf[27]) << 24);
-                uint32_t d8 = ((uint32_t)bf[28]) | (((uint32_t)bf[29]) << 8) |
-                              (((uint32_t)bf[30]) << 16) | (((uint32_t)bf[31]) << 24);
-
-                uint8_t szn[4] = {(uint8_t)(d7 >> 0), (uint8_t)(d7 >> 16),
-                                  (uint8_t)(d8 >> 0), (uint8_t)(d8 >> 16)};
-                uint8_t opc[4] = {(uint8_t)(d7 >> 8), (uint8_t)(d7 >> 24),
-                                  (uint8_t)(d8 >> 8), (uint8_t)(d8 >> 24)};
-
-                for (int k = 0; k < 4; k++) {
-                    uint32_t sz = (1u << szn[k]);
-                    id->et_present[k] = (sz != 0);
-                    id->et_opcode[k] = opc[k];
-                    id->et_size_bytes[k] = sz;
-                }
-            }
-        }
+        size_t bytes = (size_t)(dwords * 4);
+        if (bytes > sizeof(id->bfpt)) bytes = sizeof(id->bfpt);
+        read_sfdp(ptp, id->bfpt, bytes);
+        id->bfpt_ptp = ptp;
+        id->bfpt_len = (uint16_t)bytes;
+        sfdp_decode_bfpt(id);
     }
+    span_end("sfdp_read");
 
     // Test if 0x0B Fast Read works (light probe)
     uint8_t c[5] = {0x0B, 0, 0, 0, 0}, v = 0xA5;
@@ -247,6 +454,8 @@ static void identify(ident_t *id) {
     id->fastread_0B = true;
     id->fastread_dummy = 1;
 
+    read_unique_id(id);
+
     // restore SPI baud
     spi_set_baudrate(FLASH_SPI, saved);
 }
@@ -271,6 +480,10 @@ static void populate_test_chip_from_identification(ident_t *id) {
     printf("JEDEC ID:     %s\n", test_chip.jedec_id);
     printf("Capacity:     %.3f Mbit\n", test_chip.capacity_mbit);
     printf("SFDP Version: %u.%u\n", id->sfdp_major, id->sfdp_minor);
+    printf("Unique ID:    ");
+    if (id->uid_len == 0) printf("n/a");
+    for (uint8_t i = 0; i < id->uid_len; i++) printf("%02X", id->uid[i]);
+    printf("\n");
     printf("=======================================================\n");
 }
 
@@ -314,7 +527,7 @@ static void capture_erase_benchmark_results(void) {
 }
 
 // === AUTO BACKUP to SD right after identification ===
-typedef struct { FIL file; uint64_t written; } sd_sink_ctx_t;
+typedef struct { FIL file; uint64_t written; uint32_t crc; uint32_t head_crc; } sd_sink_ctx_t;
 
 static bool sd_sink(const uint8_t* data, size_t len, uint32_t off, void* user) {
     (void)off;
@@ -322,6 +535,13 @@ static bool sd_sink(const uint8_t* data, size_t len, uint32_t off, void* user) {
     UINT bw = 0;
     FRESULT fr = f_write(&ctx->file, data, (UINT)len, &bw);
     if (fr != FR_OK || bw != len) return false;
+
+    // Image hash for the chip cache (whole image + leading re-validation window)
+    ctx->crc = crc32_update(ctx->crc, data, len);
+    if (ctx->written < CHIP_CACHE_HEAD_BYTES) {
+        size_t head = CHIP_CACHE_HEAD_BYTES - (size_t)ctx->written;
+        ctx->head_crc = crc32_update(ctx->head_crc, data, len < head ? len : head);
+    }
     ctx->written += bw;
     // progress every ~1 MiB
     if ((ctx->written & ((1u<<20)-1u)) == 0) {
@@ -330,21 +550,123 @@ static bool sd_sink(const uint8_t* data, size_t len, uint32_t off, void* user) {
     return true;
 }
 
-static bool universal_dump_after_ident(void) {
-    // Use same SPI instance and pins
+// Ping-pong backup buffers: the flash worker reads the next chunk over SPI0
+// into one slot while the SD writer drains the other to the card on SPI1.
+typedef struct {
+    sd_sink_ctx_t *ctx;
+    uint8_t *buf;
+    size_t len;
+    uint32_t addr;
+    bool pending;
+    int rc;
+    SemaphoreHandle_t done;
+} backup_slot_t;
+
+static backup_slot_t g_backup_slot[2];
+
+static int backup_write_job(void *arg) {
+    backup_slot_t *slot = (backup_slot_t *)arg;
+    return sd_sink(slot->buf, slot->len, slot->addr, slot->ctx) ? SUCCESS : ERROR_SD_WRITE_FAIL;
+}
+
+typedef struct { sd_sink_ctx_t *ctx; const char *filename; } backup_open_t;
+
+static int backup_open_job(void *arg) {
+    backup_open_t *o = (backup_open_t *)arg;
+    FRESULT fr = f_open(&o->ctx->file, o->filename, FA_CREATE_ALWAYS | FA_WRITE);
+    if (fr != FR_OK) {
+        printf("[UNIV] SD open failed (%d) for %s\n", fr, o->filename);
+        return ERROR_FILE_WRITE_FAIL;
+    }
+    return SUCCESS;
+}
+
+static int backup_close_job(void *arg) {
+    f_close(&((sd_sink_ctx_t *)arg)->file);
+    return SUCCESS;
+}
+
+static bool backup_slot_wait(backup_slot_t *slot) {
+    if (!slot->pending) return true;
+    uint32_t t0 = time_us_32();
+    xSemaphoreTake(slot->done, portMAX_DELAY);
+    span_complete("backup_slot_wait", 0, false, t0);
+    slot->pending = false;
+    return slot->rc == SUCCESS;
+}
+
+static bool backup_pipelined(const jedec_chip_t *chip, sd_sink_ctx_t *ctx) {
+    bool ok = true;
+    int k = 0;
+    uint8_t *bufs = buf_pool_get(2 * BACKUP_SLOT_BYTES, "backup_slots");
+    if (!bufs) return false;
+    for (int i = 0; i < 2; i++) {
+        g_backup_slot[i].ctx = ctx;
+        g_backup_slot[i].buf = bufs + i * BACKUP_SLOT_BYTES;
+        g_backup_slot[i].pending = false;
+    }
+
+    for (uint32_t a = 0; a < chip->total_bytes && ok; k ^= 1) {
+        backup_slot_t *slot = &g_backup_slot[k];
+        if (!backup_slot_wait(slot)) {
+            ok = false;
+            break;
+        }
+        size_t n = BACKUP_SLOT_BYTES;
+        if (a + n > chip->total_bytes) n = chip->total_bytes - a;
+        if (!jedec_read_chunk(chip, a, slot->buf, n)) {
+            ok = false;
+            break;
+        }
+        slot->len = n;
+        slot->addr = a;
+        slot->pending = sd_worker_post(backup_write_job, slot, slot->done, &slot->rc);
+        if (!slot->pending) ok = false;
+        a += (uint32_t)n;
+    }
+
+    // Drain both slots even after a failure: the SD writer still owns them
+    for (int i = 0; i < 2; i++) {
+        if (!backup_slot_wait(&g_backup_slot[i])) ok = false;
+    }
+    buf_pool_put(bufs);
+    return ok;
+}
+
+// Same SPI instance and pins as the benches
+static void flow_jedec_open(jedec_chip_t *chip) {
     jedec_bus_t bus = {
         .spi = FLASH_SPI,
         .cs_pin = PIN_CS,
-        .wp_pin = 0xFFFFFFFF,
-        .hold_pin = 0xFFFFFFFF,
+        .wp_pin = PIN_WP,
+        .hold_pin = PIN_HOLD,
         .sck_pin = PIN_SCK,
         .mosi_pin = PIN_MOSI,
         .miso_pin = PIN_MISO,
-        .clk_hz = 16000000
+        .clk_hz = g_backup_spi_hz,
+        .pio = g_flash_pio_ok ? &g_flash_pio : NULL
     };
-    jedec_chip_t chip;
     jedec_init(&bus);
-    jedec_probe(&chip);
+    jedec_probe(chip);
+}
+
+// Widest read the chip advertises and the fixture wires: 1-4-4, 1-1-4,
+// then 1-1-2. Needs the PIO transport attached; sets QE where required.
+static jedec_read_mode_t flow_select_best_read(jedec_chip_t *chip, const ident_t *id) {
+    static const jedec_read_mode_t order[] = {JEDEC_READ_1_4_4, JEDEC_READ_1_1_4, JEDEC_READ_1_1_2};
+    for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+        pio_spi_op_t op;
+        if (!jedec_read_op_from_bfpt(order[i], id->bfpt, id->bfpt_len,
+                                     chip->use_4byte_addr, &op)) continue;
+        if (!pio_spi_op_supported(&g_flash_pio, &op)) continue;
+        if (jedec_select_read_mode(chip, order[i], id->bfpt, id->bfpt_len)) return order[i];
+    }
+    return JEDEC_READ_1_1_1;
+}
+
+static bool universal_dump_after_ident(const ident_t *id) {
+    jedec_chip_t chip;
+    flow_jedec_open(&chip);
 
     printf("[UNIV] JEDEC %02X %02X %02X  size=%u 4B=%d cmd=0x%02X\n",
            chip.manuf_id, chip.mem_type, chip.capacity_id,
@@ -356,350 +678,1211 @@ static bool universal_dump_after_ident(void) {
              chip.manuf_id, chip.mem_type, chip.capacity_id);
 
     sd_sink_ctx_t ctx = {0};
-    FRESULT fr = f_open(&ctx.file, filename, FA_CREATE_ALWAYS | FA_WRITE);
-    if (fr != FR_OK) {
-        printf("[UNIV] SD open failed (%d) for %s\n", fr, filename);
+    ctx.crc = CRC32_INIT;
+    ctx.head_crc = CRC32_INIT;
+    memset(&g_last_backup, 0, sizeof(g_last_backup));
+    backup_open_t open_req = {&ctx, filename};
+    if (sd_worker_call(backup_open_job, &open_req) != SUCCESS) {
         return false;
     }
 
     printf("[UNIV] Backing up %u bytes to %s...\n", chip.total_bytes, filename);
-    bool ok = jedec_backup_full(&chip, sd_sink, &ctx);
-    f_close(&ctx.file);
+#if FLASH_READ_PIO
+    if (g_flash_pio_ok) {
+        pio_spi_attach(&g_flash_pio);
+        // Multi-lane reads carry their own dummy clocks, so they run fast too
+        bool multi = flow_select_best_read(&chip, id) != JEDEC_READ_1_1_1;
+        uint8_t jedec[3] = {chip.manuf_id, chip.mem_type, chip.capacity_id};
+        sample_cal_apply(&g_flash_pio, PIN_CS, jedec, chip.use_4byte_addr,
+                         (multi || chip.read_cmd == 0x0B) ? g_backup_pio_fast_hz : BACKUP_PIO_HZ_SAFE,
+                         sd_mounted);
+    }
+#endif
+    span_begin("backup_stream");
+    bool ok = backup_pipelined(&chip, &ctx);
+    span_end("backup_stream");
+#if FLASH_READ_PIO
+    if (g_flash_pio_ok) {
+        jedec_restore_read_mode(&chip);
+        pio_spi_set_sample_step(&g_flash_pio, PIO_SPI_SAMPLE_DEFAULT);
+        pio_spi_detach(&g_flash_pio);
+    }
+#endif
+    sd_worker_call(backup_close_job, &ctx);
 
     printf("[UNIV] %s, wrote %llu bytes\n",
            ok ? "DONE" : "ERROR/ABORT", (unsigned long long)ctx.written);
+
+    if (ok) {
+        g_last_backup.valid = true;
+        g_last_backup.bytes = (uint32_t)ctx.written;
+        g_last_backup.crc32 = crc32_final(ctx.crc);
+        g_last_backup.head_crc32 = crc32_final(ctx.head_crc);
+        printf("[UNIV] Image CRC32=%08X\n", (unsigned)g_last_backup.crc32);
+    }
     return ok;
 }
 
-// ========== Main Function ==========
-int main(void) {
-    stdio_init_all();
-    sleep_ms(2000);
+// CRC-32 of the leading CHIP_CACHE_HEAD_BYTES, read over SPI0 at its current rate
+static bool flash_head_crc32(uint32_t *out) {
+    uint8_t *buf = (uint8_t *)buf_pool_get(4096, "head_crc");
+    if (!buf) {
+        printf("[ERR] NOMEM\n");
+        return false;
+    }
+    uint32_t crc = CRC32_INIT;
+    for (uint32_t a = 0; a < CHIP_CACHE_HEAD_BYTES; a += 4096) {
+        flash_read_03(a, buf, 4096);
+        crc = crc32_update(crc, buf, 4096);
+    }
+    buf_pool_put(buf);
+    *out = crc32_final(crc);
+    return true;
+}
 
-    printf("\n");
-    printf("===============================================\n");
-    printf(" UNIFIED FLASH BENCHMARK & IDENTIFICATION\n");
-    printf("===============================================\n");
-    printf("System clock: %u Hz\n", (unsigned)clock_get_hz(clk_sys));
-    printf("Peripheral clock: %u Hz\n", (unsigned)clock_get_hz(clk_peri));
-    printf("\n");
+// ========== Chip Result Cache ==========
+// Quick re-validation of a cached chip: the key (JEDEC + unique ID) already
+// matched, so only confirm the leading image window is unchanged.
+static bool cache_revalidate(const chip_cache_entry_t *e) {
+    if (!e->image_valid || e->image_bytes < CHIP_CACHE_HEAD_BYTES) {
+        printf("[CACHE] No image hash cached, key match only\n");
+        return true;
+    }
 
-    // Initialize RTC
-    datetime_t t = {.year=2024,.month=1,.day=1,.dotw=1,.hour=0,.min=0,.sec=0};
-    rtc_init();
-    rtc_set_datetime(&t);
+    uint32_t saved = spi_get_baudrate(FLASH_SPI);
+    spi_set_baudrate(FLASH_SPI, CACHE_REVALIDATE_MHZ * 1000u * 1000u);
 
-    // Initialize SPI for flash
-    spi_init(FLASH_SPI, 5 * 100 * 1000);
-    gpio_set_function(PIN_SCK, GPIO_FUNC_SPI);
-    gpio_set_function(PIN_MOSI, GPIO_FUNC_SPI);
-    gpio_set_function(PIN_MISO, GPIO_FUNC_SPI);
-    gpio_init(PIN_CS);
-    gpio_set_dir(PIN_CS, GPIO_OUT);
-    cs_high();
+    uint64_t t0 = time_us_64();
+    uint32_t crc;
+    bool read_ok = flash_head_crc32(&crc);
+    uint64_t t1 = time_us_64();
 
-    // Initialize buttons
-    gpio_init(BUTTON_PIN); gpio_set_dir(BUTTON_PIN, GPIO_IN); gpio_pull_up(BUTTON_PIN);
-    gpio_init(DISPLAY_BUTTON_PIN); gpio_set_dir(DISPLAY_BUTTON_PIN, GPIO_IN); gpio_pull_up(DISPLAY_BUTTON_PIN);
+    spi_set_baudrate(FLASH_SPI, saved);
+    if (!read_ok) return false;
 
-    display_system_banner();
+    bool ok = (crc == e->head_crc32);
+    printf("[CACHE] Re-validation %s (head CRC32 %08X vs cached %08X, %u ms)\n",
+           ok ? "PASSED" : "FAILED", (unsigned)crc, (unsigned)e->head_crc32,
+           (unsigned)((t1 - t0) / 1000u));
+    return ok;
+}
 
-    // Initialize SD card
-    FATFS fs;
-    bool sd_mounted = false;
-    int mount_attempts = 0;
+// Restore previous results as if the flow had just produced them
+static void cache_apply(const chip_cache_entry_t *e) {
+    test_chip = e->measured;
+    for (int i = 0; i < TOP_MATCHES_COUNT; i++) {
+        match_results[i].database_index = -1;
+        match_results[i].status = MATCH_UNKNOWN;
+        match_results[i].has_outliers = false;
+        memset(&match_results[i].confidence, 0, sizeof(match_results[i].confidence));
+    }
+    match_results[0].chip_data = e->matched;
+    match_results[0].confidence.overall_confidence = e->match_confidence;
+    match_results[0].status = (match_status_t)e->match_status;
+    match_results[0].database_index = (e->match_status != MATCH_UNKNOWN) ? 0 : -1;
+    if (e->match_status != MATCH_UNKNOWN) benchmark_results = e->matched;
+}
 
+// Offer the cached result. With `interactive` the operator gets a window to
+// force a full run with GP20. Returns true if the cached result was applied.
+static bool cache_try_instant_result(const ident_t *id, bool interactive) {
+    chip_cache_entry_t e;
+    if (!sd_mounted || id->uid_len == 0 ||
+        !chip_cache_lookup(id->jedec, id->uid, id->uid_len, &e)) {
+        return false;
+    }
+    chip_cache_print_entry(&e);
+
+    if (interactive) {
+        // Wait for the GP20 press that started the flow to be released
+        while (!gpio_get(BUTTON_PIN)) sleep_ms(10);
+        sleep_ms(DEBOUNCE_DELAY_MS);
+
+        printf("[CACHE] Press GP20 within %u s to force a full re-run...\n",
+               (unsigned)(CACHE_OFFER_WINDOW_MS / 1000u));
+        uint32_t start = to_ms_since_boot(get_absolute_time());
+        while (to_ms_since_boot(get_absolute_time()) - start < CACHE_OFFER_WINDOW_MS) {
+            if (!gpio_get(BUTTON_PIN)) {
+                printf("[CACHE] Full re-run requested\n");
+                return false;
+            }
+            sleep_ms(10);
+        }
+    }
+
+    if (!cache_revalidate(&e)) {
+        printf("[CACHE] Contents changed since last run, running full flow\n");
+        return false;
+    }
+
+    cache_apply(&e);
+    return true;
+}
+
+static void cache_store_result(const ident_t *id) {
+    if (id->uid_len == 0) return;
+
+    chip_cache_entry_t e;
+    memset(&e, 0, sizeof(e));
+    memcpy(e.jedec, id->jedec, 3);
+    e.uid_len = id->uid_len;
+    memcpy(e.uid, id->uid, id->uid_len);
+    e.measured = test_chip;
+    e.matched = match_results[0].chip_data;
+    e.match_confidence = match_results[0].confidence.overall_confidence;
+    e.match_status = (uint8_t)match_results[0].status;
+    e.image_valid = g_last_backup.valid;
+    e.image_bytes = g_last_backup.bytes;
+    e.image_crc32 = g_last_backup.crc32;
+    e.head_crc32 = g_last_backup.head_crc32;
+    chip_cache_store(&e);
+}
+
+// ========== SD Mount / Database ==========
+// Volume-level operations (f_mount/f_unmount are not re-entrant in FatFs)
+// always run on the SD writer task; the wrappers below hop over to it.
+static int sd_mount_job(void *arg) {
+    (void)arg;
+    int mount_attempts = 0;
     while (!sd_mounted && mount_attempts < MAX_MOUNT_ATTEMPTS) {
         display_sd_mount_attempt(mount_attempts + 1, MAX_MOUNT_ATTEMPTS);
-        FRESULT fr = f_mount(&fs, "0:", 1);
+        FRESULT fr = f_mount(&g_fs, "0:", 1);
         if (fr == FR_OK) {
             sd_mounted = true;
             display_sd_mount_success();
             display_sd_stabilization();
             sleep_ms(POST_MOUNT_DELAY_MS);
+            sd_free_space_prime();
+            journal_recover();
+            run_record_recover();
         } else {
             display_sd_mount_warning(fr);
             mount_attempts++;
             if (mount_attempts < MAX_MOUNT_ATTEMPTS) sleep_ms(MOUNT_RETRY_DELAY_MS);
         }
     }
+    return sd_mounted ? SUCCESS : ERROR_SD_NOT_PRESENT;
+}
+
+static bool sd_mount_with_retries(void) {
+    return sd_worker_call(sd_mount_job, NULL) == SUCCESS;
+}
+
+// Block until the boot-time SD bring-up has finished (mounted or given up)
+static void wait_boot_sd(void) {
+    if (xEventGroupGetBits(g_boot_events) & BOOT_SD_DONE) return;
+    printf("[BOOT] Waiting for SD card / database...\n");
+    xEventGroupWaitBits(g_boot_events, BOOT_SD_DONE, pdFALSE, pdTRUE, portMAX_DELAY);
+}
+
+static int load_database_job(void *arg) {
+    (void)arg;
+    int load_result = sd_load_chip_database();
+    if (load_result == SUCCESS) {
+        database_loaded = true;
+        display_database_loaded(database_entry_count);
+    }
+    return load_result;
+}
+
+static int load_database(void) {
+    return sd_worker_call(load_database_job, NULL);
+}
+
+// Mount (if needed) and make sure the database is loaded
+static int ensure_database_job(void *arg) {
+    (void)arg;
+    if (sd_mounted && !database_loaded) {
+        display_database_reload_attempt();
+        if (load_database() == ERROR_DATABASE_CORRUPT) {
+            display_database_corrupt_warning();
+            f_unmount("0:");
+            sd_free_space_reset();
+            sd_mounted = false;
+            database_loaded = false;
+            sleep_ms(100);
+            return ERROR_DATABASE_CORRUPT;
+        }
+    }
 
     if (!sd_mounted) {
-        display_sd_mount_failed(MAX_MOUNT_ATTEMPTS);
-    } else {
-        int load_result = sd_load_chip_database();
-        if (load_result == SUCCESS) {
-            database_loaded = true;
-            display_database_loaded(database_entry_count);
+        if (!sd_mount_with_retries()) {
+            printf("ERROR: SD card not mounted after %d attempts\n", MAX_MOUNT_ATTEMPTS);
+            return ERROR_SD_NOT_PRESENT;
         }
+        load_database();
     }
 
-    display_startup_instructions();
+    if (!database_loaded || database_entry_count == 0) {
+        display_no_database_error();
+        return ERROR_NO_DATABASE;
+    }
+    return SUCCESS;
+}
 
-    printf("\nGP20 button to start: identify → write-test → auto-backup → benches\n");
-    printf("GP21 button to view database...\n\n");
+static bool ensure_database(void) {
+    return sd_worker_call(ensure_database_job, NULL) == SUCCESS;
+}
 
-    // Button state tracking
-    bool last_button_state = true;
-    bool last_display_button_state = true;
-    uint32_t last_button_time = 0;
-    uint32_t last_display_button_time = 0;
+// ========== Flow Steps ==========
+// Shared by the GP20 flow and the station pipeline.
+static ident_t g_flow_id;
+static bool g_flow_cached = false;
+static bool g_flow_partial = false;        // match_candidates[] hold this run's partial scores
 
-    while (true) {
-        bool current_button_state = gpio_get(BUTTON_PIN);
-        bool current_display_button_state = gpio_get(DISPLAY_BUTTON_PIN);
-        uint32_t current_time = to_ms_since_boot(get_absolute_time());
+// Structured reports begun during the write/erase benches (CBOR, then JSON)
+static forensic_report_t g_prerender[1 + FORENSIC_REPORT_JSON];
 
-        // ==================== GP20 BUTTON - RUN FLOW ====================
-        if (last_button_state && !current_button_state &&
-            (current_time - last_button_time) > DEBOUNCE_DELAY_MS) {
+static void flow_reset(void) {
+    // Reset all benchmark results
+    read_reset_results();
+    write_reset_results();
+    erase_reset_results();
+    timing_probe_reset();
 
-            printf("\n");
-            printf("*******************************************************\n");
-            printf(" BUTTON PRESSED - STARTING FLOW\n");
-            printf("*******************************************************\n");
-            sleep_ms(100);
+    // Reset test_chip data
+    memset(&test_chip, 0, sizeof(test_chip));
+    strcpy(test_chip.chip_model, "UNKNOWN");
 
-            // Reset all benchmark results
-            read_reset_results();
-            erase_reset_results();
+    memset(&g_flow_id, 0, sizeof(g_flow_id));
+    memset(&g_last_backup, 0, sizeof(g_last_backup));
+    g_flow_cached = false;
+    g_flow_partial = false;
+    match_candidate_count = 0;
+}
 
-            // Reset test_chip data
-            memset(&test_chip, 0, sizeof(test_chip));
-            strcpy(test_chip.chip_model, "UNKNOWN");
+static bool jedec_looks_valid(const uint8_t j[3]) {
+    bool all_ff = (j[0] == 0xFF && j[1] == 0xFF && j[2] == 0xFF);
+    bool all_00 = (j[0] == 0x00 && j[1] == 0x00 && j[2] == 0x00);
+    return !(all_ff || all_00);
+}
 
-            // ===== STEP 1: IDENTIFY CHIP =====
-            printf("\n[STEP 1/6] Identifying Flash Chip...\n");
-            ident_t id; memset(&id, 0, sizeof(id));
-            identify(&id);
-            populate_test_chip_from_identification(&id);
+static bool flow_step_identify(void) {
+    identify(&g_flow_id);
+    populate_test_chip_from_identification(&g_flow_id);
+    return jedec_looks_valid(g_flow_id.jedec);
+}
 
-            // ===== STEP 2: SAFE WRITE/VERIFY TEST (non-destructive) =====
-            printf("\n[STEP 2/6] Write/Verify Test (non-destructive)...\n");
-            {
-                const uint32_t TEST_ADDR = 0x00010000; // 64KB offset (should be safe)
-                uint8_t original[256], pattern[256], verify[256];
+// ========== Pad Drive Calibration ==========
+static int drive_cal_sd_job(void *arg) {
+    (void)arg;
+    drive_cal_ensure(DRIVE_BUS_SD, NULL, 0);
+    return SUCCESS;
+}
 
-                // 1) Read original 256B
-                flash_read_03(TEST_ADDR, original, 256);
+// Best drive strength / slew per fixture on both buses; swept once, then
+// applied from drive_cal.bin on every run
+static void flow_step_drive_cal(void) {
+    if (!sd_mounted) return;
+    sd_worker_call(drive_cal_sd_job, NULL);
+#if FLASH_READ_PIO
+    if (!g_flash_pio_ok || !jedec_looks_valid(g_flow_id.jedec)) return;
+    pio_spi_attach(&g_flash_pio);
+    drive_cal_ensure(DRIVE_BUS_FLASH, &g_flash_pio, PIN_CS);
+    pio_spi_detach(&g_flash_pio);
+#endif
+}
 
-                // 2) Prepare test pattern
-                for (int i = 0; i < 256; i++) pattern[i] = (uint8_t)(i ^ 0xA5);
+// ========== Turbo Window ==========
+// The write test and the backup run with clk_sys raised to FLASH_TURBO_KHZ
+// and the flash buses raised with it: the PL022 to FLASH_TURBO_SPI_HZ, the
+// PIO backup to FLASH_TURBO_PIO_HZ (within the pad calibration's ceiling)
+// and the SD bus to its calibrated clock, which drive_cal_sd_hz() keeps
+// within the SPI-mode spec since FatFs writes run at it (uncalibrated, the
+// SD bus keeps its entry rate). If none of them would run
+// faster the window is not opened. Stability is judged through the CRC
+// verify path: the leading image window is hashed at a safe clock first,
+// must hash the same over the window's PL022 rate before the window is
+// used, the PIO rate must pass a sample-calibration probe, and the backup's
+// own head CRC must match afterwards, else the backup is redone at the
+// default clock.
+static bool flow_step_backup(void);
 
-                // 3) Program 256B (single page)
-                flash_page_program(TEST_ADDR, pattern, 256);
+typedef struct {
+    clock_turbo_t clk;
+    uint32_t head_ref;             // Head CRC32 at CACHE_REVALIDATE_MHZ, default clock
+} flow_turbo_t;
+
+#if FLASH_TURBO_KHZ && FLASH_READ_PIO
+// Window PIO rate for fast-read backups, or BACKUP_PIO_HZ_FAST if it does
+// not read the calibration pattern back at any sample step
+static uint32_t flow_turbo_pio_hz(void) {
+    uint32_t hz = FLASH_TURBO_PIO_HZ;
+    uint32_t ceiling = drive_cal_ceiling_hz(DRIVE_BUS_FLASH);
+    if (ceiling && ceiling < hz) hz = ceiling;
+    if (hz <= BACKUP_PIO_HZ_FAST) return BACKUP_PIO_HZ_FAST;
+    pio_spi_attach(&g_flash_pio);
+    bool clean = sample_cal_probe(&g_flash_pio, PIN_CS, false, hz) != 0;
+    pio_spi_detach(&g_flash_pio);
+    if (!clean) {
+        printf("[WARN] PIO not clean at %.3f MHz in the turbo window, backup stays at %.3f MHz\n",
+               hz / 1e6, BACKUP_PIO_HZ_FAST / 1e6);
+        return BACKUP_PIO_HZ_FAST;
+    }
+    return hz;
+}
+#endif
 
-                // 4) Read back
-                flash_read_03(TEST_ADDR, verify, 256);
+static void flow_turbo_begin(flow_turbo_t *w) {
+    memset(w, 0, sizeof(*w));
+#if FLASH_TURBO_KHZ
+    uint32_t saved = spi_get_baudrate(FLASH_SPI);
+    spi_set_baudrate(FLASH_SPI, CACHE_REVALIDATE_MHZ * 1000u * 1000u);
+    bool ref_ok = flash_head_crc32(&w->head_ref);
+    spi_set_baudrate(FLASH_SPI, saved);
+    if (!ref_ok) return;
 
-                // 5) Compare
-                bool ok = true;
-                for (int i = 0; i < 256; i++) {
-                    if (verify[i] != pattern[i]) { ok = false; break; }
-                }
-                printf("[WRITE TEST] %s\n", ok ? "✅ SUCCESS — write + verify OK" : "❌ FAILED — data mismatch");
+    clock_turbo_rates_t rates = {
+        .flash_baud = FLASH_TURBO_SPI_HZ,
+        .sd_baud = drive_cal_sd_hz(),
+#if FLASH_READ_PIO
+        .pio_hz = g_flash_pio_ok ? FLASH_TURBO_PIO_HZ : 0,
+#endif
+    };
+    if (!clock_turbo_enter(&w->clk, FLASH_TURBO_KHZ, FLASH_SPI, g_flash_pio_ok ? &g_flash_pio : NULL, &rates)) {
+        return;
+    }
+    // At the window's PL022 rate, which the write test and jedec_* use
+    uint32_t crc = 0;
+    if (!flash_head_crc32(&crc) || crc != w->head_ref) {
+        printf("[WARN] Turbo stability check FAILED at %.3f MHz (head CRC32 %08X vs %08X), back to default clock\n",
+               spi_get_baudrate(FLASH_SPI) / 1e6, (unsigned)crc, (unsigned)w->head_ref);
+        clock_turbo_exit(&w->clk);
+        return;
+    }
+    printf("[TURBO] Stability check passed at %.3f MHz (head CRC32 %08X)\n",
+           spi_get_baudrate(FLASH_SPI) / 1e6, (unsigned)crc);
+    g_backup_spi_hz = spi_get_baudrate(FLASH_SPI);
+#if FLASH_READ_PIO
+    if (g_flash_pio_ok) g_backup_pio_fast_hz = flow_turbo_pio_hz();
+#endif
+#endif
+}
 
-                // 6) Restore original
-                flash_page_program(TEST_ADDR, original, 256);
-                printf("[WRITE TEST] Original data restored.\n");
-            }
+// Closes the window; returns false if the backup had to be redone and failed
+static bool flow_turbo_end(flow_turbo_t *w) {
+    if (!w->clk.active) return true;
+    g_backup_spi_hz = BACKUP_SPI_HZ;
+    g_backup_pio_fast_hz = BACKUP_PIO_HZ_FAST;
+    clock_turbo_exit(&w->clk);
+    if (!sd_mounted) return true;
+    if (!g_last_backup.valid) {
+        printf("[WARN] Backup failed at the turbo clock, repeating at default clock\n");
+        return flow_step_backup();
+    }
+    if (g_last_backup.bytes < CHIP_CACHE_HEAD_BYTES || g_last_backup.head_crc32 == w->head_ref) return true;
+    printf("[WARN] Turbo backup head CRC32 %08X != %08X, repeating backup at default clock\n",
+           (unsigned)g_last_backup.head_crc32, (unsigned)w->head_ref);
+    return flow_step_backup();
+}
 
-            // ===== STEP 3: AUTO BACKUP TO SD (pre-benchmarks) =====
-            printf("\n[STEP 3/6] Auto backup to SD before benchmarks...\n");
-            if (sd_mounted) {
-                bool dumped = universal_dump_after_ident();
-                if (!dumped) printf("[AUTO BACKUP] Failed. Continuing with benchmarks.\n");
-            } else {
-                printf("[AUTO BACKUP] Skipped (SD not mounted).\n");
-            }
+// SAFE WRITE/VERIFY TEST (non-destructive; restores original 256B)
+static bool flow_step_write_test(void) {
+    const uint32_t TEST_ADDR = 0x00010000; // 64KB offset (should be safe)
+    uint8_t original[256], pattern[256], verify[256];
 
-            // ===== STEP 4: READ BENCHMARKS =====
-            printf("\n[STEP 4/6] Running Read Benchmarks...\n");
-            {
-                bool use_fast = id.fastread_0B;
-                uint8_t dummy = use_fast ? (id.fastread_dummy ? id.fastread_dummy : 1) : 0;
-                const int clock_list[] = {63, 32, 21, 16, 13};
-                const int NCLK = (int)(sizeof(clock_list) / sizeof(clock_list[0]));
-                read_bench_capture_t caps[NCLK]; memset(caps, 0, sizeof(caps));
-
-                for (int i = 0; i < NCLK; i++) {
-                    int mhz = clock_list[i];
-                    printf("  Testing at %d MHz (mode=%s, dummy=%u)\n",
-                           mhz, use_fast ? "0x0B" : "0x03", dummy);
-                    read_run_benches_capture(FLASH_SPI, PIN_CS, use_fast, dummy, mhz, &caps[i]);
-                }
-                read_derive_and_print_50(clock_list, caps, NCLK);
-                capture_read_benchmark_results();
-            }
+    // 1) Read original 256B
+    flash_read_03(TEST_ADDR, original, 256);
+
+    // 2) Prepare test pattern
+    for (int i = 0; i < 256; i++) pattern[i] = (uint8_t)(i ^ 0xA5);
+
+    // 3) Program 256B (single page)
+    flash_page_program(TEST_ADDR, pattern, 256);
+
+    // 4) Read back
+    flash_read_03(TEST_ADDR, verify, 256);
+
+    // 5) Compare
+    bool ok = true;
+    for (int i = 0; i < 256; i++) {
+        if (verify[i] != pattern[i]) { ok = false; break; }
+    }
+    printf("[WRITE TEST] %s\n", ok ? "✅ SUCCESS — write + verify OK" : "❌ FAILED — data mismatch");
+
+    // 6) Restore original
+    flash_page_program(TEST_ADDR, original, 256);
+    printf("[WRITE TEST] Original data restored.\n");
+    return ok;
+}
+
+static bool flow_step_backup(void) {
+    if (!sd_mounted) {
+        printf("[AUTO BACKUP] Skipped (SD not mounted).\n");
+        return false;
+    }
+    bool dumped = universal_dump_after_ident(&g_flow_id);
+    if (!dumped) printf("[AUTO BACKUP] Failed. Continuing with benchmarks.\n");
+    return dumped;
+}
 
-            // ===== STEP 5: WRITE + ERASE BENCHMARKS =====
+static void flow_step_read_benches(const int *clock_list, int nclk) {
+    bool use_fast = g_flow_id.fastread_0B;
+    uint8_t dummy = use_fast ? (g_flow_id.fastread_dummy ? g_flow_id.fastread_dummy : 1) : 0;
+    read_bench_capture_t caps[8];
+    if (nclk > 8) nclk = 8;
+    memset(caps, 0, sizeof(caps));
+
+    bool use_pio = FLASH_READ_PIO && g_flash_pio_ok;
+    if (use_pio) pio_spi_attach(&g_flash_pio);
+    for (int i = 0; i < nclk; i++) {
+        int mhz = clock_list[i];
+        printf("  Testing at %d MHz (mode=%s, dummy=%u, %s)\n",
+               mhz, use_fast ? "0x0B" : "0x03", dummy, use_pio ? "PIO" : "SPI0");
+        if (use_pio) {
+            span_begin_n("sample_cal", (uint32_t)mhz);
+            sample_cal_apply(&g_flash_pio, PIN_CS, g_flow_id.jedec, false,
+                             (uint32_t)mhz * 1000000u, sd_mounted);
+            span_end("sample_cal");
+            read_run_benches_capture_pio(&g_flash_pio, PIN_CS, use_fast, dummy,
+                                         (uint32_t)mhz * 1000000u, &caps[i]);
+        } else {
+            read_run_benches_capture(FLASH_SPI, PIN_CS, use_fast, dummy, mhz, &caps[i]);
+        }
+    }
+    // One extra row at 50 MHz in the widest mode the chip + fixture support
+    if (use_pio && nclk < 8) {
+        jedec_chip_t chip;
+        pio_spi_detach(&g_flash_pio);
+        flow_jedec_open(&chip);     // jedec_init claims the pins for SPI0, so before attach
+        pio_spi_attach(&g_flash_pio);
+        jedec_read_mode_t mode = flow_select_best_read(&chip, &g_flow_id);
+        if (mode != JEDEC_READ_1_1_1) {
+            pio_spi_op_t op = chip.read_op;
+            sample_cal_apply(&g_flash_pio, PIN_CS, g_flow_id.jedec, chip.use_4byte_addr,
+                             50000000u, sd_mounted);
+            printf("  Testing at 50 MHz (mode=%s, opcode=0x%02X, PIO)\n",
+                   jedec_read_mode_name(mode), op.opcode);
+            read_run_benches_capture_op(&g_flash_pio, PIN_CS, &op, 50000000u, &caps[nclk]);
+            jedec_restore_read_mode(&chip);
+            nclk++;
+        }
+    }
+    if (use_pio) {
+        pio_spi_set_sample_step(&g_flash_pio, PIO_SPI_SAMPLE_DEFAULT);
+        pio_spi_detach(&g_flash_pio);
+    }
+    read_derive_and_print_50(clock_list, caps, nclk);
+    capture_read_benchmark_results();
+}
+
+// Per-opcode micro-timings over the PIO transport (CS/SCK -> MISO in clk_sys cycles)
+static void flow_step_timing_probe(void) {
+#if FLASH_READ_PIO
+    if (!g_flash_pio_ok) return;
+    pio_spi_attach(&g_flash_pio);
+    if (timing_probe_run(&g_flash_pio, PIN_CS, &g_timing_probe)) {
+        timing_probe_print(&g_timing_probe);
+    } else {
+        printf("[WARN] Timing probe skipped\n");
+    }
+    pio_spi_detach(&g_flash_pio);
+#endif
+}
+
+static void flow_step_write_erase_benches(void) {
 #if ENABLE_DESTRUCTIVE_TESTS
-            printf("\n[STEP 5/6] Write & Erase Benchmarks...\n");
-
-            // Write benches (summary only; page timing disabled)
-            {
-                const int write_clocks[] = {21, 16};
-                const int num_write_clocks = (int)(sizeof(write_clocks) / sizeof(write_clocks[0]));
-                write_bench_capture_t write_captures[num_write_clocks];
-                int write_success = write_bench_run_multi_clock(
-                    FLASH_SPI, PIN_CS, write_clocks, num_write_clocks,
-                    TEST_BASE_ADDR + 0x10000, write_captures);
-                if (write_success > 0) write_bench_print_summary(write_captures, num_write_clocks);
-                test_chip.typ_page_program_ms = 0.0;
-                test_chip.max_page_program_ms = 0.0;
-            }
+    // Write benches (summary only; page timing disabled)
+    {
+        const int write_clocks[] = {21, 16};
+        const int num_write_clocks = (int)(sizeof(write_clocks) / sizeof(write_clocks[0]));
+        write_bench_capture_t write_captures[2];
+        int write_success = write_bench_run_multi_clock(
+            FLASH_SPI, PIN_CS, write_clocks, num_write_clocks,
+            TEST_BASE_ADDR + 0x10000, write_captures);
+        if (write_success > 0) write_bench_print_summary(write_captures, num_write_clocks);
+        test_chip.typ_page_program_ms = 0.0;
+        test_chip.max_page_program_ms = 0.0;
+    }
 
-            // Erase benches
-            {
-                erase_ident_t erase_id;
-                memcpy(erase_id.jedec, id.jedec, 3);
-                erase_id.sfdp_ok = id.sfdp_ok;
-                erase_id.sfdp_major = id.sfdp_major;
-                erase_id.sfdp_minor = id.sfdp_minor;
-                erase_id.density_bits = id.density_bits;
-                memcpy(erase_id.et_present, id.et_present, sizeof(id.et_present));
-                memcpy(erase_id.et_opcode, id.et_opcode, sizeof(id.et_opcode));
-                memcpy(erase_id.et_size_bytes, id.et_size_bytes, sizeof(id.et_size_bytes));
-                erase_id.fast_read_0B = id.fastread_0B;
-                erase_id.fast_read_dummy = id.fastread_dummy;
-
-                erase_flash_unprotect(FLASH_SPI, PIN_CS, id.jedec[0], TEST_BASE_ADDR);
-                const int ERASE_FIXED_MHZ = 21;
-                erase_run_benches_at_clock(FLASH_SPI, PIN_CS, &erase_id, NULL,
-                                           ERASE_FIXED_MHZ, TEST_BASE_ADDR);
-                capture_erase_benchmark_results();
-            }
+    // Erase benches
+    {
+        const ident_t *id = &g_flow_id;
+        erase_ident_t erase_id;
+        memcpy(erase_id.jedec, id->jedec, 3);
+        erase_id.sfdp_ok = id->sfdp_ok;
+        erase_id.sfdp_major = id->sfdp_major;
+        erase_id.sfdp_minor = id->sfdp_minor;
+        erase_id.density_bits = id->density_bits;
+        memcpy(erase_id.et_present, id->et_present, sizeof(id->et_present));
+        memcpy(erase_id.et_opcode, id->et_opcode, sizeof(id->et_opcode));
+        memcpy(erase_id.et_size_bytes, id->et_size_bytes, sizeof(id->et_size_bytes));
+        erase_id.fast_read_0B = id->fastread_0B;
+        erase_id.fast_read_dummy = id->fastread_dummy;
+
+        erase_flash_unprotect(FLASH_SPI, PIN_CS, id->jedec[0], TEST_BASE_ADDR);
+        const int ERASE_FIXED_MHZ = 21;
+        erase_run_benches_at_clock(FLASH_SPI, PIN_CS, &erase_id, NULL,
+                                   ERASE_FIXED_MHZ, TEST_BASE_ADDR);
+        capture_erase_benchmark_results();
+    }
 #else
-            printf("\n[STEP 5/6] WRITE/ERASE BENCHMARKS DISABLED\n");
+    printf("\n[STEP 5/6] WRITE/ERASE BENCHMARKS DISABLED\n");
 #endif
+}
 
-            // ===== STEP 6: MATCH AGAINST DATABASE =====
-            printf("\n[STEP 6/6] Matching Against Database...\n");
+static bool flow_step_match(void) {
+    if (!ensure_database()) return false;
 
-            // Ensure DB mounted/loaded
-            if (sd_mounted && !database_loaded) {
-                display_database_reload_attempt();
-                int load_result = sd_load_chip_database();
-                if (load_result == SUCCESS) {
-                    database_loaded = true;
-                    display_database_loaded(database_entry_count);
-                } else if (load_result == ERROR_DATABASE_CORRUPT) {
-                    display_database_corrupt_warning();
-                    f_unmount("0:");
-                    sd_mounted = false;
-                    database_loaded = false;
-                    sleep_ms(100);
-                    last_button_time = current_time;
-                    last_button_state = current_button_state;
-                    goto after_buttons;
-                }
-            }
+    // Partial scores from the read benches only need the erase factor
+    span_begin(g_flow_partial ? "match_finalize" : "match_database");
+    match_status_t status = g_flow_partial ? chip_match_finalize(&test_chip)
+                                           : chip_match_database(&test_chip);
+    span_end(g_flow_partial ? "match_finalize" : "match_database");
+    display_detailed_comparison();
+    if (status != MATCH_UNKNOWN) benchmark_results = match_results[0].chip_data;
+    return true;
+}
 
-            if (!sd_mounted) {
-                mount_attempts = 0;
-                while (!sd_mounted && mount_attempts < MAX_MOUNT_ATTEMPTS) {
-                    display_sd_mount_attempt(mount_attempts + 1, MAX_MOUNT_ATTEMPTS);
-                    FRESULT fr = f_mount(&fs, "0:", 1);
-                    if (fr == FR_OK) {
-                        sd_mounted = true;
-                        display_sd_mount_success();
-                        display_sd_stabilization();
-                        sleep_ms(POST_MOUNT_DELAY_MS);
-                        int load_result = sd_load_chip_database();
-                        if (load_result == SUCCESS) {
-                            database_loaded = true;
-                            display_database_loaded(database_entry_count);
-                        }
-                    } else {
-                        display_sd_mount_warning(fr);
-                        mount_attempts++;
-                        if (mount_attempts < MAX_MOUNT_ATTEMPTS) sleep_ms(MOUNT_RETRY_DELAY_MS);
-                    }
-                }
-                if (!sd_mounted) {
-                    printf("ERROR: SD card not mounted after %d attempts\n", MAX_MOUNT_ATTEMPTS);
-                    last_button_time = current_time;
-                    last_button_state = current_button_state;
-                    goto after_buttons;
-                }
-            }
+static void flow_append_run_record(void) {
+    run_record_meta_t meta = {
+        .jedec = g_flow_id.jedec,
+        .uid = g_flow_id.uid,
+        .uid_len = g_flow_id.uid_len,
+        .sfdp_major = g_flow_id.sfdp_major,
+        .sfdp_minor = g_flow_id.sfdp_minor,
+        .density_bits = g_flow_id.density_bits,
+        .image_bytes = g_last_backup.bytes,
+        .image_crc32 = g_last_backup.crc32,
+    };
+    if (g_last_backup.valid) meta.flags |= RR_FLAG_IMAGE_VALID;
+    if (g_flow_cached) meta.flags |= RR_FLAG_CACHED;
+    if (g_erase_result.valid || g_write_result_count > 0) meta.flags |= RR_FLAG_DESTRUCTIVE;
+    run_record_append(&meta);
+}
+
+static void flow_forensic_meta(forensic_meta_t *meta) {
+    *meta = (forensic_meta_t){
+        .jedec = g_flow_id.jedec,
+        .uid = g_flow_id.uid,
+        .uid_len = g_flow_id.uid_len,
+        .sfdp_ok = g_flow_id.sfdp_ok,
+        .sfdp_hdr = g_flow_id.sfdp_hdr,
+        .sfdp_ph = g_flow_id.sfdp_ph,
+        .sfdp_nph = g_flow_id.sfdp_nph,
+        .bfpt = g_flow_id.bfpt,
+        .bfpt_len = g_flow_id.bfpt_len,
+        .bfpt_ptp = g_flow_id.bfpt_ptp,
+        .density_bits = g_flow_id.density_bits,
+        .fast_read_0B = g_flow_id.fastread_0B,
+        .fast_read_dummy = g_flow_id.fastread_dummy,
+        .image_valid = g_last_backup.valid,
+        .image_bytes = g_last_backup.bytes,
+        .image_crc32 = g_last_backup.crc32,
+        .head_bytes = CHIP_CACHE_HEAD_BYTES,
+        .head_crc32 = g_last_backup.head_crc32,
+    };
+}
+
+static renc_format_t prerender_format(int i) {
+    return i == 0 ? RENC_CBOR : RENC_JSON;
+}
+
+// SD task: stream the report sections that are settled once the read
+// benches are done while the flash worker runs the write/erase benches
+static int flow_prerender_job(void *arg) {
+    (void)arg;
+    forensic_meta_t meta;
+    flow_forensic_meta(&meta);
+    for (int i = 0; i < (int)(sizeof(g_prerender) / sizeof(g_prerender[0])); i++) {
+        if (forensic_report_begin(&g_prerender[i], &meta, prerender_format(i)) != SUCCESS) {
+            forensic_report_abort(&g_prerender[i]);
+        }
+    }
+    return SUCCESS;
+}
+
+static int flow_prerender_abort_job(void *arg) {
+    (void)arg;
+    for (int i = 0; i < (int)(sizeof(g_prerender) / sizeof(g_prerender[0])); i++) {
+        forensic_report_abort(&g_prerender[i]);
+    }
+    return SUCCESS;
+}
+
+static void flow_write_structured_report(void) {
+    forensic_meta_t meta;
+    flow_forensic_meta(&meta);
+    for (int i = 0; i < (int)(sizeof(g_prerender) / sizeof(g_prerender[0])); i++) {
+        if (g_prerender[i].open) {
+            forensic_report_finish(&g_prerender[i]);
+        } else {
+            forensic_report_write(&meta, prerender_format(i));
+        }
+    }
+}
+
+static void flow_journal_run(void) {
+    uint8_t flags = 0;
+    if (g_flow_cached) flags |= JOURNAL_FLAG_CACHED;
+    if (g_erase_result.valid || g_write_result_count > 0) flags |= JOURNAL_FLAG_DESTRUCTIVE;
+    if (journal_append_run(flags) == SUCCESS) journal_commit();
+}
+
+static int flow_log_job(void *arg) {
+    (void)arg;
+    span_begin("csv_log");
+    sd_log_benchmark_results();
+    span_end("csv_log");
+    span_begin("journal");
+    flow_journal_run();
+    flow_append_run_record();
+    span_end("journal");
+    if (!g_flow_cached) {
+        span_begin("forensic_report");
+        sd_create_forensic_report();
+        span_end("forensic_report");
+        span_begin("structured_report");
+        flow_write_structured_report();
+        span_end("structured_report");
+        span_begin("cache_store");
+        cache_store_result(&g_flow_id);
+        span_end("cache_store");
+    }
+    return SUCCESS;
+}
+
+// CSV log, journal, run record, reports and cache update, on the SD writer
+static void flow_step_log(void) {
+    if (!sd_mounted) return;
+    sd_worker_call(flow_log_job, NULL);
+}
+
+// Runs on the matcher while the flash worker is in the write/erase benches:
+// JEDEC, capacity and read speed are final, only the erase factor is not
+static void flow_step_partial_match(void) {
+    if (!ensure_database()) return;
+    span_begin("match_partial");
+    bool scored = chip_match_partial(&test_chip);
+    span_end("match_partial");
+    if (!scored) return;
+    g_flow_partial = true;
+
+    int lead = chip_match_partial_leader();
+    if (lead >= 0) {
+        const FlashChipData *c = &database[match_candidates[lead].database_index];
+        printf("[INFO] Partial match (JEDEC + read): %s %s at %.1f%%, erase factor pending\n",
+               c->company, c->chip_model, match_candidates[lead].overall_confidence);
+    }
+    span_begin("report_prerender");
+    sd_worker_call(flow_prerender_job, NULL);
+    span_end("report_prerender");
+}
+
+static void print_flow_summary(void) {
+    printf("\n*******************************************************\n");
+    printf(" FLOW COMPLETE%s\n", g_flow_cached ? " (cached result)" : "");
+    printf("*******************************************************\n");
+    printf("Test Chip Summary:\n");
+    printf("  JEDEC ID:          %s\n", test_chip.jedec_id);
+    printf("  Capacity:          %.2f Mbit\n", test_chip.capacity_mbit);
+    printf("  Read Speed 50MHz:  %.2f MB/s\n", test_chip.read_speed_max);
+    printf("  4KB Erase (avg):   %.1f ms\n", test_chip.typ_4kb_erase_ms);
+    printf("  32KB Erase (avg):  %.1f ms\n", test_chip.typ_32kb_erase_ms);
+    printf("  64KB Erase (avg):  %.1f ms\n", test_chip.typ_64kb_erase_ms);
+    printf("*******************************************************\n");
+}
+
+static void post_match_request(match_req_t req) {
+    xQueueSend(g_match_q, &req, portMAX_DELAY);
+}
+
+// GP20: identify -> write-test -> backup -> benches on the flash worker;
+// match, log and reports are handed to the matcher task
+static void run_full_flow(void) {
+    printf("\n");
+    printf("*******************************************************\n");
+    printf(" BUTTON PRESSED - STARTING FLOW\n");
+    printf("*******************************************************\n");
+    sleep_ms(100);
+
+    // The previous run's report may still be reading the shared results
+    // (and the previous span trace being written)
+    xSemaphoreTake(g_report_idle, portMAX_DELAY);
+    flow_reset();
+    mem_watch_flow_begin();
+#if FLOW_SPAN_TRACE
+    span_trace_start();
+#endif
+
+    // ===== STEP 1: IDENTIFY CHIP =====
+    printf("\n[STEP 1/6] Identifying Flash Chip...\n");
+    span_begin("step1_identify");
+    flow_step_identify();
+    span_end("step1_identify");
+
+    // Identification overlaps the boot-time mount; the cache needs the card
+    span_begin("wait_boot_sd");
+    wait_boot_sd();
+    span_end("wait_boot_sd");
+    span_begin("drive_cal");
+    flow_step_drive_cal();
+    span_end("drive_cal");
+
+    // ===== KNOWN CHIP? (JEDEC + unique ID in the SD chip cache) =====
+    span_begin("cache_lookup");
+    bool cached = cache_try_instant_result(&g_flow_id, true);
+    span_end("cache_lookup");
+    mem_watch_phase("identify");
+    if (cached) {
+        g_flow_cached = true;
+        post_match_request(MATCH_REQ_CACHED);
+        return;
+    }
+
+    flow_turbo_t turbo;
+    span_begin("turbo_enter");
+    flow_turbo_begin(&turbo);
+    span_end("turbo_enter");
+
+    // ===== STEP 2: SAFE WRITE/VERIFY TEST (non-destructive) =====
+    printf("\n[STEP 2/6] Write/Verify Test (non-destructive)...\n");
+    span_begin("step2_write_test");
+    flow_step_write_test();
+    span_end("step2_write_test");
+    mem_watch_phase("write_test");
+
+    // ===== STEP 3: AUTO BACKUP TO SD (pre-benchmarks) =====
+    printf("\n[STEP 3/6] Auto backup to SD before benchmarks...\n");
+    span_begin("step3_backup");
+    flow_step_backup();
+    span_end("step3_backup");
+    span_begin("turbo_exit");
+    flow_turbo_end(&turbo);
+    span_end("turbo_exit");
+    mem_watch_phase("backup");
+
+    // ===== STEP 4: READ BENCHMARKS =====
+    printf("\n[STEP 4/6] Running Read Benchmarks...\n");
+    span_begin("step4_read_benches");
+    {
+#if FLASH_READ_PIO
+        const int clock_list[] = {62, 50, 32, 21, 16, 13};
+#else
+        const int clock_list[] = {63, 32, 21, 16, 13};
+#endif
+        flow_step_read_benches(clock_list, (int)(sizeof(clock_list) / sizeof(clock_list[0])));
+    }
+    span_end("step4_read_benches");
+    span_begin("timing_probe");
+    flow_step_timing_probe();
+    span_end("timing_probe");
+    mem_watch_phase("read_benches");
+
+    // Partial match + report pre-render overlap the write/erase benches
+    post_match_request(MATCH_REQ_PARTIAL);
+
+    // ===== STEP 5: WRITE + ERASE BENCHMARKS =====
+    printf("\n[STEP 5/6] Write & Erase Benchmarks...\n");
+    span_begin("step5_write_erase");
+    flow_step_write_erase_benches();
+    span_end("step5_write_erase");
+    mem_watch_phase("write_erase");
+
+    // ===== STEP 6: MATCH AGAINST DATABASE (matcher task) =====
+    post_match_request(MATCH_REQ_FULL);
+}
+
+// ========== Station Mode Pipeline ==========
+static station_rc_t stage_identify(void) {
+    flow_reset();
+    if (!flow_step_identify()) return STATION_RC_FAIL;
+    flow_step_drive_cal();
+    if (cache_try_instant_result(&g_flow_id, false)) {
+        g_flow_cached = true;
+        return STATION_RC_DONE;
+    }
+    return STATION_RC_OK;
+}
+
+static station_rc_t stage_verify(void) {
+    return flow_step_write_test() ? STATION_RC_OK : STATION_RC_FAIL;
+}
+
+static station_rc_t stage_backup(void) {
+    flow_turbo_t turbo;
+    flow_turbo_begin(&turbo);
+    bool ok = flow_step_backup();
+    if (!flow_turbo_end(&turbo)) ok = false;
+    return ok ? STATION_RC_OK : STATION_RC_FAIL;
+}
+
+// Quick read profile: 50 MHz directly over PIO, else the two PL022 clocks
+// that bracket the 50 MHz derivation
+static station_rc_t stage_read(void) {
+#if FLASH_READ_PIO
+    const int clock_list[] = {50};
+#else
+    const int clock_list[] = {63, 32};
+#endif
+    flow_step_read_benches(clock_list, (int)(sizeof(clock_list) / sizeof(clock_list[0])));
+    return STATION_RC_OK;
+}
+
+static station_rc_t stage_bench(void) {
+    flow_step_write_erase_benches();
+    return STATION_RC_OK;
+}
+
+static station_rc_t stage_match(void) {
+    return flow_step_match() ? STATION_RC_OK : STATION_RC_FAIL;
+}
+
+static station_rc_t stage_log(void) {
+    flow_step_log();
+    print_flow_summary();
+    return STATION_RC_OK;
+}
+
+static const station_stage_t k_station_stages[STATION_STAGE_COUNT] = {
+    [STATION_STAGE_IDENTIFY] = {"identify", stage_identify},
+    [STATION_STAGE_VERIFY]   = {"verify",   stage_verify},
+    [STATION_STAGE_BACKUP]   = {"backup",   stage_backup},
+    [STATION_STAGE_READ]     = {"read",     stage_read},
+    [STATION_STAGE_BENCH]    = {"bench",    stage_bench},
+    [STATION_STAGE_MATCH]    = {"match",    stage_match},
+    [STATION_STAGE_LOG]      = {"log",      stage_log},
+};
+
+// Socket probe: JEDEC ID plus SFDP signature at the slow identification
+// clock. A few hundred microseconds of bus time per poll.
+static bool station_probe_present(void) {
+    uint32_t saved = spi_get_baudrate(FLASH_SPI);
+    spi_set_baudrate(FLASH_SPI, 5 * 100 * 1000);
+
+    uint8_t j[3] = {0};
+    read_jedec_id(j);
+    bool present = jedec_looks_valid(j);
+    if (present) {
+        uint8_t sig[4] = {0};
+        read_sfdp(0, sig, 4);
+        present = (sig[0] == 'S' && sig[1] == 'F' && sig[2] == 'D' && sig[3] == 'P');
+    }
+
+    spi_set_baudrate(FLASH_SPI, saved);
+    return present;
+}
+
+static bool station_exit_requested(void) {
+    return !gpio_get(DISPLAY_BUTTON_PIN);
+}
 
-            if (!database_loaded || database_entry_count == 0) {
-                display_no_database_error();
-                last_button_time = current_time;
-                last_button_state = current_button_state;
-                goto after_buttons;
+static const char *station_chip_label(void) {
+    static char label[64];
+    int n = snprintf(label, sizeof(label), "%s", test_chip.jedec_id);
+    for (uint8_t i = 0; i < g_flow_id.uid_len && n < (int)sizeof(label) - 3; i++) {
+        n += snprintf(label + n, sizeof(label) - (size_t)n, i == 0 ? " %02X" : "%02X", g_flow_id.uid[i]);
+    }
+    return label;
+}
+
+static void run_station_mode(void) {
+    station_hooks_t hooks = {
+        .stages = k_station_stages,
+        .probe_present = station_probe_present,
+        .exit_requested = station_exit_requested,
+        .chip_label = station_chip_label,
+    };
+    station_init(&hooks);
+
+    // Station stages match and log inline, so no queued report may be pending
+    wait_boot_sd();
+    sd_worker_drain();
+    xSemaphoreTake(g_report_idle, portMAX_DELAY);
+
+    // Wait for the GP21 hold that selected station mode to be released
+    while (!gpio_get(DISPLAY_BUTTON_PIN)) sleep_ms(10);
+    sleep_ms(DEBOUNCE_DELAY_MS);
+
+    station_run();
+    xSemaphoreGive(g_report_idle);
+
+    while (!gpio_get(DISPLAY_BUTTON_PIN)) sleep_ms(10);
+    sleep_ms(DEBOUNCE_DELAY_MS);
+}
+
+// ========== Tasks ==========
+// Button/event task: blocks on the button IRQ queue and turns presses into
+// commands for the flash worker or the console. Presses while the flash
+// worker is busy belong to the running flow (cache offer window, station
+// exit), which reads the pins itself.
+static void event_task(void *param) {
+    (void)param;
+    button_event_t evt;
+    g_boot_us[BOOT_MS_INPUT_READY] = time_us_64();
+    for (;;) {
+        if (xQueueReceive(g_button_q, &evt, portMAX_DELAY) != pdTRUE) continue;
+        uint32_t latency_us = (uint32_t)(time_us_64() - evt.t_us);
+        if (g_flash_busy) continue;
+
+        if (evt.pin == BUTTON_PIN) {
+            printf("[EVT] GP20 press (%u us to dispatch)\n", (unsigned)latency_us);
+            flash_cmd_t cmd = FLASH_CMD_RUN_FLOW;
+            xQueueSend(g_flash_q, &cmd, 0);
+        } else if (evt.pin == DISPLAY_BUTTON_PIN) {
+            printf("[EVT] GP21 press (%u us to dispatch)\n", (unsigned)latency_us);
+            console_msg_t msg = CONSOLE_SHOW_DATABASE;
+            xQueueSend(g_console_q, &msg, 0);
+        }
+    }
+}
+
+// Flash worker: the only task that drives SPI0 / the chip under test
+static void flash_task(void *param) {
+    (void)param;
+    flash_cmd_t cmd;
+    for (;;) {
+        if (xQueueReceive(g_flash_q, &cmd, portMAX_DELAY) != pdTRUE) continue;
+        g_flash_busy = true;
+        switch (cmd) {
+            case FLASH_CMD_RUN_FLOW:
+#if SPI_TRACE_FLOW
+                // The trace file needs the card before the flow's first command
+                wait_boot_sd();
+                spi_trace_start(SPI_TRACE_SD_BUS);
+#endif
+                run_full_flow();
+#if SPI_TRACE_FLOW
+                spi_trace_stop(g_flow_id.jedec);
+#endif
+                break;
+            case FLASH_CMD_STATION: {
+                run_station_mode();
+                console_msg_t msg = CONSOLE_STARTUP;
+                xQueueSend(g_console_q, &msg, portMAX_DELAY);
+                break;
             }
+        }
+        g_flash_busy = false;
+    }
+}
 
-            match_status_t status = chip_match_database(&test_chip);
-            display_detailed_comparison();
-            if (status != MATCH_UNKNOWN) benchmark_results = match_results[0].chip_data;
-            sd_log_benchmark_results();
-            sd_create_forensic_report();
-            display_identification_complete();
-
-            printf("\n*******************************************************\n");
-            printf(" FLOW COMPLETE\n");
-            printf("*******************************************************\n");
-            printf("Test Chip Summary:\n");
-            printf("  JEDEC ID:          %s\n", test_chip.jedec_id);
-            printf("  Capacity:          %.2f Mbit\n", test_chip.capacity_mbit);
-            printf("  Read Speed 50MHz:  %.2f MB/s\n", test_chip.read_speed_max);
-            printf("  4KB Erase (avg):   %.1f ms\n", test_chip.typ_4kb_erase_ms);
-            printf("  32KB Erase (avg):  %.1f ms\n", test_chip.typ_32kb_erase_ms);
-            printf("  64KB Erase (avg):  %.1f ms\n", test_chip.typ_64kb_erase_ms);
-            printf("*******************************************************\n");
-
-after_buttons:
-            last_button_time = current_time;
+// Matcher/report task: scores the run against the database while the flash
+// worker is already free, then hands logging and reports to the SD writer
+static void match_task(void *param) {
+    (void)param;
+    match_req_t req;
+    for (;;) {
+        if (xQueueReceive(g_match_q, &req, portMAX_DELAY) != pdTRUE) continue;
+
+        if (req == MATCH_REQ_PARTIAL) {
+            flow_step_partial_match();
+            continue;
         }
 
-        // ==================== GP21 BUTTON - VIEW DATABASE ====================
-        if (last_display_button_state && !current_display_button_state &&
-            (current_time - last_display_button_time) > DEBOUNCE_DELAY_MS) {
-
-            display_button_pressed_gp21();
-
-            if (!sd_mounted) {
-                mount_attempts = 0;
-                while (!sd_mounted && mount_attempts < MAX_MOUNT_ATTEMPTS) {
-                    display_sd_mount_attempt(mount_attempts + 1, MAX_MOUNT_ATTEMPTS);
-                    FRESULT fr = f_mount(&fs, "0:", 1);
-                    if (fr == FR_OK) {
-                        sd_mounted = true;
-                        display_sd_mount_success();
-                        display_sd_stabilization();
-                        sleep_ms(POST_MOUNT_DELAY_MS);
-                        int load_result = sd_load_chip_database();
-                        if (load_result == SUCCESS) {
-                            database_loaded = true;
-                            display_database_loaded(database_entry_count);
-                        }
+        bool done = true;
+        if (req == MATCH_REQ_FULL) {
+            printf("\n[STEP 6/6] Matching Against Database...\n");
+            span_begin("step6_match");
+            done = flow_step_match();
+            span_end("step6_match");
+            mem_watch_phase("match");
+        }
+        if (done) {
+            span_begin("sd_log");
+            flow_step_log();
+            span_end("sd_log");
+            mem_watch_phase("sd_log");
+            console_msg_t msg = CONSOLE_FLOW_DONE;
+            xQueueSend(g_console_q, &msg, portMAX_DELAY);
+        } else if (sd_mounted) {
+            sd_worker_call(flow_prerender_abort_job, NULL);
+        }
+        // The flash worker is done with this run by now (it posted the request)
+        span_trace_stop(g_flow_id.jedec, sd_mounted);
+        mem_watch_report();
+        xSemaphoreGive(g_report_idle);
+    }
+}
+
+static void print_boot_milestones(void) {
+    printf("\n[BOOT] Time-to-ready (ms since reset):\n");
+    for (int i = 0; i < BOOT_MS_COUNT; i++) {
+        if (g_boot_us[i]) {
+            printf("  %-20s %8.1f\n", k_boot_milestone_names[i], g_boot_us[i] / 1000.0);
+        } else {
+            printf("  %-20s %8s\n", k_boot_milestone_names[i], "-");
+        }
+    }
+}
+
+// USB CDC drops output until a host opens the port; give it a bounded wait
+// (the SD bring-up carries on meanwhile) so the banner is not lost.
+static void wait_usb_host(void) {
+    uint64_t deadline = time_us_64() + (uint64_t)USB_CONNECT_WAIT_MS * 1000u;
+    while (!stdio_usb_connected() && time_us_64() < deadline) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    if (stdio_usb_connected()) g_boot_us[BOOT_MS_USB] = time_us_64();
+    xEventGroupSetBits(g_boot_events, BOOT_USB_READY);
+}
+
+static void print_boot_banner(void) {
+    printf("\n");
+    printf("===============================================\n");
+    printf(" UNIFIED FLASH BENCHMARK & IDENTIFICATION\n");
+    printf("===============================================\n");
+    printf("System clock: %u Hz\n", (unsigned)clock_get_hz(clk_sys));
+    printf("Peripheral clock: %u Hz\n", (unsigned)clock_get_hz(clk_peri));
+    printf("\n");
+    display_system_banner();
+}
+
+// Console/display task: everything the operator reads between runs
+static void console_task(void *param) {
+    (void)param;
+    console_msg_t msg;
+    for (;;) {
+        if (xQueueReceive(g_console_q, &msg, portMAX_DELAY) != pdTRUE) continue;
+        switch (msg) {
+            case CONSOLE_STARTUP:
+                wait_usb_host();
+                print_boot_banner();
+                // Boot-time mount/database output comes first
+                wait_boot_sd();
+                print_boot_milestones();
+                display_startup_instructions();
+                printf("\nGP20 button to start: identify → write-test → auto-backup → benches\n");
+                printf("GP21 button to view database...\n\n");
+                break;
+
+            case CONSOLE_SHOW_DATABASE:
+                display_button_pressed_gp21();
+                wait_boot_sd();
+                if (!sd_mounted) {
+                    if (sd_mount_with_retries()) {
+                        load_database();
                     } else {
-                        display_sd_mount_warning(fr);
-                        mount_attempts++;
-                        if (mount_attempts < MAX_MOUNT_ATTEMPTS) sleep_ms(MOUNT_RETRY_DELAY_MS);
+                        printf("ERROR: SD card not mounted after %d attempts\n", MAX_MOUNT_ATTEMPTS);
+                        break;
                     }
                 }
-                if (!sd_mounted) {
-                    printf("ERROR: SD card not mounted after %d attempts\n", MAX_MOUNT_ATTEMPTS);
-                    last_display_button_time = current_time;
-                    last_display_button_state = current_display_button_state;
-                    continue;
-                }
-            }
-
-            // Display full database
-            display_full_database();
+                display_full_database();
+                break;
 
-            last_display_button_time = current_time;
+            case CONSOLE_FLOW_DONE:
+                display_identification_complete();
+                print_flow_summary();
+                break;
         }
+    }
+}
+
+// Boot-time SD bring-up, queued before the scheduler starts
+// Runs in the background: buttons are live before it finishes, and anything
+// that needs the card or the database waits on BOOT_SD_DONE first.
+static int boot_sd_job(void *arg) {
+    (void)arg;
+    if (sd_mount_job(NULL) != SUCCESS) {
+        display_sd_mount_failed(MAX_MOUNT_ATTEMPTS);
+        xEventGroupSetBits(g_boot_events, BOOT_SD_DONE);
+        return ERROR_SD_NOT_PRESENT;
+    }
+    g_boot_us[BOOT_MS_SD_MOUNTED] = time_us_64();
+
+    if (load_database_job(NULL) == SUCCESS) {
+        g_boot_us[BOOT_MS_DB_LOADED] = time_us_64();
+        xEventGroupSetBits(g_boot_events, BOOT_DB_READY);
+    }
+    xEventGroupSetBits(g_boot_events, BOOT_SD_DONE);
+#if RUN_REPORT_WRITER_BENCH
+    sd_benchmark_report_writer(20);
+#endif
+    return SUCCESS;
+}
+
+// Idle: sleep until the next interrupt (tick, button edge, USB, DMA). The
+// RP2040 SMP port has no tickless idle, so each core wakes at most once per
+// tick; core 0 runs the full idle hook, core 1 the minimal one.
+void vApplicationIdleHook(void) {
+    __wfi();
+}
+
+void vApplicationMinimalIdleHook(void) {
+    __wfi();
+}
+
+static bool create_task(TaskFunction_t fn, const char *name, configSTACK_DEPTH_TYPE stack,
+                        UBaseType_t priority, UBaseType_t core_mask) {
+    if (xTaskCreateAffinitySet(fn, name, stack, NULL, priority, core_mask, NULL) != pdPASS) {
+        printf("[ERROR] Cannot create %s task\n", name);
+        return false;
+    }
+    return true;
+}
+
+// ========== Main Function ==========
+int main(void) {
+    mem_watch_paint_core_stacks();
+
+    // No boot delay: USB enumeration and the SD bring-up overlap with the
+    // scheduler start; the console prints the banner once a host is attached
+    stdio_init_all();
+
+    // Initialize RTC
+    datetime_t t = {.year=2024,.month=1,.day=1,.dotw=1,.hour=0,.min=0,.sec=0};
+    rtc_init();
+    rtc_set_datetime(&t);
+
+    // Initialize SPI for flash
+    spi_init(FLASH_SPI, 5 * 100 * 1000);
+    gpio_set_function(PIN_SCK, GPIO_FUNC_SPI);
+    gpio_set_function(PIN_MOSI, GPIO_FUNC_SPI);
+    gpio_set_function(PIN_MISO, GPIO_FUNC_SPI);
+    gpio_init(PIN_CS);
+    gpio_set_dir(PIN_CS, GPIO_OUT);
+    cs_high();
 
-        last_button_state = current_button_state;
-        last_display_button_state = current_display_button_state;
+#if FLASH_READ_PIO
+    // Loaded now, takes the pins only while the read benches / backup run
+    g_flash_pio_ok = pio_spi_init(&g_flash_pio, FLASH_PIO, PIN_SCK, PIN_MOSI, PIN_MISO);
+#if FLASH_QUAD_FIXTURE
+    if (g_flash_pio_ok) pio_spi_enable_quad(&g_flash_pio, PIN_WP, PIN_HOLD);
+#endif
+#if FLASH_PP_DMA
+    if (g_flash_pio_ok) write_bench_set_pio(&g_flash_pio);
+#endif
+#endif
 
-        sleep_ms(10);
+    // Queues between the tasks
+    g_button_q = xQueueCreate(TASK_QUEUE_DEPTH, sizeof(button_event_t));
+    g_flash_q = xQueueCreate(TASK_QUEUE_DEPTH, sizeof(flash_cmd_t));
+    g_match_q = xQueueCreate(TASK_QUEUE_DEPTH, sizeof(match_req_t));
+    g_console_q = xQueueCreate(TASK_QUEUE_DEPTH, sizeof(console_msg_t));
+    g_report_idle = xSemaphoreCreateBinary();
+    xSemaphoreGive(g_report_idle);
+    for (int i = 0; i < 2; i++) g_backup_slot[i].done = xSemaphoreCreateBinary();
+    g_boot_events = xEventGroupCreate();
+
+    // Buttons: edge IRQs on core 0 post to g_button_q
+    const uint8_t button_pins[] = {BUTTON_PIN, DISPLAY_BUTTON_PIN};
+    buttons_init(button_pins, 2, g_button_q);
+
+    // SD card bring-up is the SD writer's first job
+    sd_worker_start(SD_TASK_PRIORITY, CORE0_MASK);
+    sd_worker_post(boot_sd_job, NULL, NULL, NULL);
+
+    // GP21 held through boot selects production station mode (the pull-up
+    // was only just enabled, give it a moment before sampling)
+    busy_wait_us(100);
+    if (!gpio_get(DISPLAY_BUTTON_PIN)) {
+        flash_cmd_t cmd = FLASH_CMD_STATION;
+        xQueueSend(g_flash_q, &cmd, 0);
+    } else {
+        console_msg_t msg = CONSOLE_STARTUP;
+        xQueueSend(g_console_q, &msg, 0);
     }
 
+    create_task(event_task, "event", EVENT_TASK_STACK, EVENT_TASK_PRIORITY, CORE0_MASK);
+    create_task(flash_task, "flash", FLASH_TASK_STACK, FLASH_TASK_PRIORITY, CORE1_MASK);
+    create_task(match_task, "match", MATCH_TASK_STACK, MATCH_TASK_PRIORITY, CORE0_MASK);
+    create_task(console_task, "console", CONSOLE_TASK_STACK, CONSOLE_TASK_PRIORITY, CORE0_MASK);
+
+    g_boot_us[BOOT_MS_SCHEDULER] = time_us_64();
+    vTaskStartScheduler();
+
+    // Only reached if the scheduler could not start (heap exhausted)
+    printf("[ERROR] Scheduler exited\n");
+    while (true) tight_loop_contents();
     return 0;
 }
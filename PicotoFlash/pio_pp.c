@@ -0,0 +1,227 @@
+/*
+ * PIO Page Program Engine
+ * Builds one control block list per batch of pages: for each page an op
+ * segment (WREN, PP header), the caller's data and a trailing op segment
+ * (release CS, RDSR poll). The data DMA channel chains to a control
+ * channel that reloads it from the next block; a null block ends the chain.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pio_pp.h"
+#include "pio_pp.pio.h"
+#include "spi_trace.h"
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+#define PP_PAGE 256u
+
+// One DMA reload: written to the data channel's transfer_count and
+// read_addr_trig alias registers
+typedef struct {
+    uint32_t len;
+    const void *read_addr;
+} pp_block_t;
+
+// Op bytes around one page
+typedef struct {
+    uint8_t pre[12];            // send WREN, release, send 0x02 + addr, send (n - 1)
+    uint8_t post[5];            // release, send 0x05, status
+} pp_page_ops_t;
+
+static pio_spi_t *g_pp_spi;
+static uint g_pp_cs;
+static uint g_pp_offset;
+static int g_pp_dma_ctrl = -1;
+static bool g_pp_active = false;
+static bool g_pp_irq_ready = false;
+static SemaphoreHandle_t g_pp_done;
+
+static pp_page_ops_t g_pp_ops[PIO_PP_BATCH_PAGES];
+static pp_block_t g_pp_blocks[PIO_PP_BATCH_PAGES * 3 + 2];
+static uint8_t g_pp_done_op;
+
+// Handler address in the op byte's top 5 bits (out pc, 5)
+static inline uint8_t op(uint handler) {
+    return (uint8_t)((g_pp_offset + handler) << 3);
+}
+
+static void pp_irq_handler(void) {
+    if (!g_pp_spi || !pio_interrupt_get(g_pp_spi->pio, g_pp_spi->sm)) return;
+    pio_interrupt_clear(g_pp_spi->pio, g_pp_spi->sm);
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(g_pp_done, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static uint pp_irq_num(const pio_spi_t *s) {
+    return PIO0_IRQ_0 + 2u * pio_get_index(s->pio);
+}
+
+bool pio_pp_active(void) {
+    return g_pp_active;
+}
+
+// Pins must already be attached to the transport (pio_spi_attach)
+bool pio_pp_begin(pio_spi_t *s, uint cs_pin) {
+    if (g_pp_active || !s->attached) return false;
+    if (!pio_spi_lend_imem(s)) return false;
+    if (!pio_can_add_program(s->pio, &pio_pp_program)) {
+        printf("[ERROR] PIO PP: no instruction memory\n");
+        pio_spi_reclaim_imem(s);
+        return false;
+    }
+    if (g_pp_dma_ctrl < 0) g_pp_dma_ctrl = dma_claim_unused_channel(false);
+    if (g_pp_dma_ctrl < 0) {
+        printf("[ERROR] PIO PP: no free DMA channel\n");
+        pio_spi_reclaim_imem(s);
+        return false;
+    }
+    if (!g_pp_done) g_pp_done = xSemaphoreCreateBinary();
+
+    g_pp_spi = s;
+    g_pp_cs = cs_pin;
+    g_pp_offset = pio_add_program(s->pio, &pio_pp_program);
+    g_pp_done_op = op(pio_pp_offset_done);
+
+    pio_sm_config c = pio_pp_program_get_default_config(g_pp_offset);
+    sm_config_set_out_pins(&c, s->mosi_pin, 1);
+    sm_config_set_set_pins(&c, cs_pin, 1);
+    sm_config_set_sideset_pins(&c, s->sck_pin);
+    sm_config_set_jmp_pin(&c, s->miso_pin);
+    sm_config_set_out_shift(&c, false, true, 8);    // MSB first, autopull
+    sm_config_set_clkdiv_int_frac(&c, s->div_int, s->div_frac);
+
+    pio_sm_set_enabled(s->pio, s->sm, false);
+    pio_sm_clear_fifos(s->pio, s->sm);
+    pio_sm_init(s->pio, s->sm, g_pp_offset, &c);
+
+    // CS goes to the SM deasserted
+    uint32_t outs = (1u << s->sck_pin) | (1u << s->mosi_pin) | (1u << cs_pin);
+    pio_sm_set_pins_with_mask(s->pio, s->sm, 1u << cs_pin, outs);
+    pio_sm_set_pindirs_with_mask(s->pio, s->sm, outs, outs | (1u << s->miso_pin));
+    pio_gpio_init(s->pio, cs_pin);
+
+    if (!g_pp_irq_ready) {
+        irq_set_exclusive_handler(pp_irq_num(s), pp_irq_handler);
+        g_pp_irq_ready = true;
+    }
+    pio_interrupt_clear(s->pio, s->sm);
+    pio_set_irq0_source_enabled(s->pio, (pio_interrupt_source_t)(pis_interrupt0 + s->sm), true);
+    irq_set_enabled(pp_irq_num(s), true);
+
+    pio_sm_set_enabled(s->pio, s->sm, true);
+    g_pp_active = true;
+    return true;
+}
+
+// CS back to a SIO output (high), phase programs back in instruction memory
+void pio_pp_end(void) {
+    if (!g_pp_active) return;
+    pio_spi_t *s = g_pp_spi;
+
+    pio_set_irq0_source_enabled(s->pio, (pio_interrupt_source_t)(pis_interrupt0 + s->sm), false);
+    pio_sm_set_enabled(s->pio, s->sm, false);
+    pio_remove_program(s->pio, &pio_pp_program, g_pp_offset);
+
+    gpio_init(g_pp_cs);
+    gpio_put(g_pp_cs, 1);
+    gpio_set_dir(g_pp_cs, GPIO_OUT);
+
+    pio_spi_reclaim_imem(s);
+    g_pp_active = false;
+}
+
+// Stop the chain, raise CS and leave the SM waiting for the next op
+static void pp_abort(void) {
+    pio_spi_t *s = g_pp_spi;
+    dma_channel_abort((uint)g_pp_dma_ctrl);
+    dma_channel_abort((uint)s->dma_tx);
+    pio_sm_set_enabled(s->pio, s->sm, false);
+    pio_sm_clear_fifos(s->pio, s->sm);
+    pio_sm_restart(s->pio, s->sm);
+    pio_sm_exec(s->pio, s->sm, pio_encode_set(pio_pins, 1));
+    pio_sm_exec(s->pio, s->sm, pio_encode_jmp(g_pp_offset));
+    pio_sm_set_enabled(s->pio, s->sm, true);
+}
+
+static bool pp_run_batch(size_t nblocks, size_t pages) {
+    pio_spi_t *s = g_pp_spi;
+    g_pp_blocks[nblocks++] = (pp_block_t){1, &g_pp_done_op};
+    g_pp_blocks[nblocks++] = (pp_block_t){0, NULL};
+
+    dma_channel_config dc = dma_channel_get_default_config((uint)s->dma_tx);
+    channel_config_set_transfer_data_size(&dc, DMA_SIZE_8);
+    channel_config_set_read_increment(&dc, true);
+    channel_config_set_write_increment(&dc, false);
+    channel_config_set_dreq(&dc, pio_get_dreq(s->pio, s->sm, true));
+    channel_config_set_chain_to(&dc, (uint)g_pp_dma_ctrl);
+    channel_config_set_irq_quiet(&dc, true);
+    dma_channel_configure((uint)s->dma_tx, &dc, &s->pio->txf[s->sm], NULL, 0, false);
+
+    // Two words per block into transfer_count + read_addr_trig
+    dma_channel_config cc = dma_channel_get_default_config((uint)g_pp_dma_ctrl);
+    channel_config_set_transfer_data_size(&cc, DMA_SIZE_32);
+    channel_config_set_read_increment(&cc, true);
+    channel_config_set_write_increment(&cc, true);
+    channel_config_set_ring(&cc, true, 3);
+    channel_config_set_irq_quiet(&cc, true);
+
+    xSemaphoreTake(g_pp_done, 0);
+    dma_channel_configure((uint)g_pp_dma_ctrl, &cc, &dma_hw->ch[s->dma_tx].al3_transfer_count,
+                          g_pp_blocks, 2, true);
+
+    TickType_t wait = pdMS_TO_TICKS(pages * PIO_PP_PAGE_TIMEOUT_MS + 10u);
+    if (xSemaphoreTake(g_pp_done, wait) != pdTRUE) {
+        pp_abort();
+        printf("[ERROR] PIO PP: %u-page batch timed out (WIP stuck or chip absent)\n", (unsigned)pages);
+        return false;
+    }
+    return true;
+}
+
+// Program len bytes from addr, split at page boundaries; blocks until the
+// last page's WIP clears or the batch times out
+bool pio_pp_write(uint32_t addr, const uint8_t *data, size_t len) {
+    if (!g_pp_active) return false;
+
+    while (len > 0) {
+        size_t pages = 0, nb = 0;
+        uint32_t batch_addr = addr, batch_t0 = time_us_32();
+        size_t batch_len = len;
+        while (len > 0 && pages < PIO_PP_BATCH_PAGES) {
+            size_t n = PP_PAGE - (addr & (PP_PAGE - 1u));
+            if (n > len) n = len;
+
+            pp_page_ops_t *o = &g_pp_ops[pages];
+            const uint8_t pre[12] = {
+                op(pio_pp_offset_send), 0, 0x06, op(pio_pp_offset_release),
+                op(pio_pp_offset_send), 3, 0x02,
+                (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)addr,
+                op(pio_pp_offset_send), (uint8_t)(n - 1u)
+            };
+            const uint8_t post[5] = {
+                op(pio_pp_offset_release), op(pio_pp_offset_send), 0, 0x05, op(pio_pp_offset_status)
+            };
+            memcpy(o->pre, pre, sizeof(pre));
+            memcpy(o->post, post, sizeof(post));
+
+            g_pp_blocks[nb++] = (pp_block_t){sizeof(o->pre), o->pre};
+            g_pp_blocks[nb++] = (pp_block_t){(uint32_t)n, data};
+            g_pp_blocks[nb++] = (pp_block_t){sizeof(o->post), o->post};
+
+            addr += (uint32_t)n;
+            data += n;
+            len -= n;
+            pages++;
+        }
+        bool ok = pp_run_batch(nb, pages);
+        spi_trace_queued(0x02, batch_addr, (uint32_t)(batch_len - len), batch_t0, g_pp_spi->hz);
+        if (!ok) return false;
+    }
+    return true;
+}
@@ -0,0 +1,31 @@
+/*
+ * PIO Page Program Engine Header
+ * Queued page programming with no CPU in the loop: a DMA control-block
+ * chain feeds pio_pp.pio, which sends WREN, the 0x02 header and data, polls
+ * RDSR until WIP clears and moves on to the next page. The CPU sleeps on a
+ * semaphore until the PIO raises its IRQ after the last page.
+ *
+ * Runs on the pio_spi transport's state machine and DMA channels, borrows
+ * the instruction memory of its phase programs, and takes the CS pin from
+ * SIO for the duration of pio_pp_begin() .. pio_pp_end(). 3-byte addressing.
+ */
+
+#ifndef PIO_PP_H
+#define PIO_PP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "pio_spi.h"
+
+// Constants
+#define PIO_PP_BATCH_PAGES 64           // Pages per control-block chain
+#define PIO_PP_PAGE_TIMEOUT_MS 5        // tPP max on common parts is 3 ms
+
+// Function declarations
+bool pio_pp_begin(pio_spi_t *s, uint cs_pin);
+void pio_pp_end(void);
+bool pio_pp_active(void);
+bool pio_pp_write(uint32_t addr, const uint8_t *data, size_t len);
+
+#endif // PIO_PP_H
@@ -0,0 +1,458 @@
+/*
+ * PIO SPI Transport Module
+ * Mode-0 SPI master on one PIO state machine (pio_spi.pio), fed by a pair
+ * of DMA channels for bulk transfers, plus dual/quad read phases
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pio_spi.h"
+#include "pio_spi.pio.h"
+#include "spi_trace.h"
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+
+// TX source / RX sink for the half of a transfer the caller does not supply
+static const uint8_t s_zero = 0x00;
+static uint8_t s_discard;
+
+// Smallest divider (in 1/256ths) that keeps SCK at or below hz
+static uint32_t div256_for(uint32_t hz) {
+    uint64_t num = (uint64_t)clock_get_hz(clk_sys) * 256u;
+    uint64_t den = 2ull * hz;
+    uint32_t d = (uint32_t)((num + den - 1) / den);
+    if (d < 256u) d = 256u;                 // clk_sys / 2 ceiling
+    if (d > 0xFFFFu * 256u) d = 0xFFFFu * 256u;
+    return d;
+}
+
+// State machine programs, one loaded at a time
+typedef enum {
+    PHASE_SPI,                  // 1-bit full duplex (opcode, 1-1-x address)
+    PHASE_OUT4,                 // Address + mode on IO0..IO3
+    PHASE_CLK,                  // Dummy clocks
+    PHASE_IN1,                  // Receive-only, late sample steps
+    PHASE_IN2,
+    PHASE_IN4
+} phase_t;
+
+static const pio_program_t *const k_programs[] = {
+    &pio_spi_program, &pio_spi_out4_program, &pio_spi_clk_program,
+    &pio_spi_in1_program, &pio_spi_in2_program, &pio_spi_in4_program,
+};
+
+// Falling-edge steps; the odd steps bypass the input synchroniser
+static inline bool step_late(uint8_t step) { return step >= 2; }
+static inline bool step_bypass(uint8_t step) { return step & 1u; }
+
+static uint lane_mask(const pio_spi_t *s, int lanes) {
+    uint32_t m = 0;
+    for (int i = 0; i < lanes; i++) m |= 1u << (s->mosi_pin + (uint)i);
+    return m;
+}
+
+// Idle lanes: IO0 driven, IO1 input, WP#/HOLD# held high when PIO owns them
+static void lanes_idle(pio_spi_t *s) {
+    uint32_t out = (1u << s->sck_pin) | (1u << s->mosi_pin);
+    uint32_t all = out | (1u << s->miso_pin);
+    uint32_t high = 0;
+    if (s->quad_ok) {
+        high = (1u << s->io2_pin) | (1u << s->io3_pin);
+        out |= high;
+        all |= high;
+    }
+    pio_sm_set_pins_with_mask(s->pio, s->sm, high, (1u << s->sck_pin) | (1u << s->mosi_pin) | high);
+    pio_sm_set_pindirs_with_mask(s->pio, s->sm, out, all);
+}
+
+static pio_sm_config phase_config(const pio_spi_t *s, phase_t ph) {
+    pio_sm_config c;
+    switch (ph) {
+        case PHASE_OUT4:
+            c = pio_spi_out4_program_get_default_config(s->off_out4);
+            sm_config_set_out_pins(&c, s->mosi_pin, 4);
+            sm_config_set_out_shift(&c, false, true, 8);
+            break;
+        case PHASE_CLK:
+            c = pio_spi_clk_program_get_default_config(s->off_clk);
+            break;
+        case PHASE_IN1:
+            c = pio_spi_in1_program_get_default_config(s->off_in1);
+            sm_config_set_in_pins(&c, s->miso_pin);
+            sm_config_set_in_shift(&c, false, true, 8);
+            break;
+        case PHASE_IN2:
+            c = pio_spi_in2_program_get_default_config(s->off_in2);
+            sm_config_set_in_pins(&c, s->mosi_pin);
+            sm_config_set_in_shift(&c, false, true, 8);
+            break;
+        case PHASE_IN4:
+            c = pio_spi_in4_program_get_default_config(s->off_in4);
+            sm_config_set_in_pins(&c, s->mosi_pin);
+            sm_config_set_in_shift(&c, false, true, 8);
+            break;
+        case PHASE_SPI:
+        default:
+            c = pio_spi_program_get_default_config(s->offset);
+            sm_config_set_out_pins(&c, s->mosi_pin, 1);
+            sm_config_set_in_pins(&c, s->miso_pin);
+            sm_config_set_out_shift(&c, false, true, 8);    // MSB first, autopull
+            sm_config_set_in_shift(&c, false, true, 8);     // MSB first, autopush
+            break;
+    }
+    sm_config_set_sideset_pins(&c, s->sck_pin);
+    sm_config_set_clkdiv_int_frac(&c, s->div_int, s->div_frac);
+    return c;
+}
+
+// Reload the SM with another program; lane directions are set while stopped
+static void phase_enter(pio_spi_t *s, phase_t ph, uint32_t in_lanes, uint32_t out_lanes) {
+    pio_sm_config c = phase_config(s, ph);
+    pio_sm_set_enabled(s->pio, s->sm, false);
+    uint offset = (ph == PHASE_OUT4) ? s->off_out4 : (ph == PHASE_CLK) ? s->off_clk :
+                  (ph == PHASE_IN1) ? s->off_in1 : (ph == PHASE_IN2) ? s->off_in2 :
+                  (ph == PHASE_IN4) ? s->off_in4 : s->offset;
+    pio_sm_init(s->pio, s->sm, offset, &c);
+    if (ph == PHASE_SPI) {
+        lanes_idle(s);
+    } else {
+        pio_sm_set_pindirs_with_mask(s->pio, s->sm, out_lanes, in_lanes | out_lanes);
+    }
+    pio_sm_set_enabled(s->pio, s->sm, true);
+}
+
+bool pio_spi_init(pio_spi_t *s, PIO pio, uint sck_pin, uint mosi_pin, uint miso_pin) {
+    memset(s, 0, sizeof(*s));
+    s->pio = pio;
+    s->sck_pin = sck_pin;
+    s->mosi_pin = mosi_pin;
+    s->miso_pin = miso_pin;
+
+    for (size_t i = 0; i < sizeof(k_programs) / sizeof(k_programs[0]); i++) {
+        if (!pio_can_add_program(pio, k_programs[i])) {
+            printf("[ERROR] PIO SPI: no instruction memory\n");
+            return false;
+        }
+        uint off = pio_add_program(pio, k_programs[i]);
+        switch ((phase_t)i) {
+            case PHASE_SPI:  s->offset = off; break;
+            case PHASE_OUT4: s->off_out4 = off; break;
+            case PHASE_CLK:  s->off_clk = off; break;
+            case PHASE_IN1:  s->off_in1 = off; break;
+            case PHASE_IN2:  s->off_in2 = off; break;
+            case PHASE_IN4:  s->off_in4 = off; break;
+        }
+    }
+    s->phases_loaded = true;
+    int sm = pio_claim_unused_sm(pio, false);
+    if (sm < 0) {
+        printf("[ERROR] PIO SPI: no free state machine\n");
+        return false;
+    }
+    s->sm = (uint)sm;
+    s->dma_tx = dma_claim_unused_channel(true);
+    s->dma_rx = dma_claim_unused_channel(true);
+
+    // SCK and MOSI idle low; MISO is an input
+    pio_sm_set_pins_with_mask(pio, s->sm, 0, (1u << sck_pin) | (1u << mosi_pin));
+
+    // The data lanes are synchronous to our own SCK: skip the 2-cycle input
+    // synchroniser so the sample lands on the rising edge even at clk_sys/2
+    pio->input_sync_bypass |= lane_mask(s, 2);
+
+    s->sample_step = PIO_SPI_SAMPLE_DEFAULT;
+    pio_spi_set_hz(s, 1000000u);
+    phase_enter(s, PHASE_SPI, 0, 0);
+    return true;
+}
+
+// IO2/IO3 must follow IO0/IO1 (MOSI, MISO) on consecutive GPIOs
+bool pio_spi_enable_quad(pio_spi_t *s, uint io2_pin, uint io3_pin) {
+    if (s->miso_pin != s->mosi_pin + 1 || io2_pin != s->mosi_pin + 2 || io3_pin != s->mosi_pin + 3) {
+        printf("[WARN] PIO SPI: IO0..IO3 not consecutive (GP%u/%u/%u/%u), quad reads disabled\n",
+               s->mosi_pin, s->miso_pin, io2_pin, io3_pin);
+        s->quad_ok = false;
+        return false;
+    }
+    s->io2_pin = io2_pin;
+    s->io3_pin = io3_pin;
+    s->quad_ok = true;
+    if (step_bypass(s->sample_step)) s->pio->input_sync_bypass |= lane_mask(s, 4);
+    phase_enter(s, PHASE_SPI, 0, 0);
+    return true;
+}
+
+// Returns the actual (average) SCK frequency
+uint32_t pio_spi_set_hz(pio_spi_t *s, uint32_t hz) {
+    if (hz == 0) hz = 1;
+    uint32_t d = div256_for(hz);
+    s->div_int = (uint16_t)(d >> 8);
+    s->div_frac = (uint8_t)(d & 0xFFu);
+    pio_sm_set_clkdiv_int_frac(s->pio, s->sm, s->div_int, s->div_frac);
+    pio_sm_clkdiv_restart(s->pio, s->sm);
+
+    s->hz = (uint32_t)(((uint64_t)clock_get_hz(clk_sys) * 256u) / (2ull * d));
+    return s->hz;
+}
+
+// Rewrite the side-set bit of one instruction of a loaded receive program.
+// INSTR_MEM is write-only, so start from the program image and relocate
+// JMP targets the way pio_add_program() does.
+static void patch_side(pio_spi_t *s, const pio_program_t *p, uint off, uint k, bool high) {
+    uint16_t insn = p->instructions[k];
+    if ((insn & 0xE000u) == 0x0000u) insn = (uint16_t)((insn & ~0x1Fu) | ((insn & 0x1Fu) + off));
+    insn = high ? (uint16_t)(insn | 0x1000u) : (uint16_t)(insn & ~0x1000u);
+    s->pio->instr_mem[off + k] = insn;
+}
+
+// Select a sample step for every receive path; call between transfers
+void pio_spi_set_sample_step(pio_spi_t *s, uint8_t step) {
+    if (step >= PIO_SPI_SAMPLE_STEPS) step = PIO_SPI_SAMPLE_DEFAULT;
+    s->sample_step = step;
+
+    uint32_t lanes = lane_mask(s, s->quad_ok ? 4 : 2);
+    if (step_bypass(step)) s->pio->input_sync_bypass |= lanes;
+    else s->pio->input_sync_bypass &= ~lanes;
+
+    // out x (1), in (2), jmp (3): rising/falling/rising for the late edge
+    const struct { const pio_program_t *p; uint off; } rx[] = {
+        {&pio_spi_in1_program, s->off_in1},
+        {&pio_spi_in2_program, s->off_in2},
+        {&pio_spi_in4_program, s->off_in4},
+    };
+    bool late = step_late(step);
+    if (!s->phases_loaded) return;
+    for (size_t i = 0; i < sizeof(rx) / sizeof(rx[0]); i++) {
+        patch_side(s, rx[i].p, rx[i].off, 1, late);
+        patch_side(s, rx[i].p, rx[i].off, 2, !late);
+        patch_side(s, rx[i].p, rx[i].off, 3, late);
+    }
+}
+
+// Sample instant relative to the rising SCK edge: the falling edge is half
+// a period later, the synchroniser looks two clk_sys cycles into the past
+int32_t pio_spi_sample_offset_ps(const pio_spi_t *s, uint8_t step) {
+    int64_t t = 0;
+    if (step_late(step) && s->hz) t += 500000000000ll / s->hz;
+    if (!step_bypass(step)) t -= 2000000000000ll / (int64_t)clock_get_hz(clk_sys);
+    return (int32_t)t;
+}
+
+// The phase programs occupy most of the 32-word instruction memory. A
+// larger program (the page-program sequencer) can borrow their space;
+// multi-lane and late-sample reads are unavailable until it is returned.
+bool pio_spi_lend_imem(pio_spi_t *s) {
+    if (!s->phases_loaded) return false;
+    const uint offs[] = {s->off_out4, s->off_clk, s->off_in1, s->off_in2, s->off_in4};
+    for (size_t i = 1; i < sizeof(k_programs) / sizeof(k_programs[0]); i++) {
+        pio_remove_program(s->pio, k_programs[i], offs[i - 1]);
+    }
+    s->phases_loaded = false;
+    return true;
+}
+
+void pio_spi_reclaim_imem(pio_spi_t *s) {
+    if (s->phases_loaded) return;
+    s->off_out4 = pio_add_program(s->pio, &pio_spi_out4_program);
+    s->off_clk = pio_add_program(s->pio, &pio_spi_clk_program);
+    s->off_in1 = pio_add_program(s->pio, &pio_spi_in1_program);
+    s->off_in2 = pio_add_program(s->pio, &pio_spi_in2_program);
+    s->off_in4 = pio_add_program(s->pio, &pio_spi_in4_program);
+    s->phases_loaded = true;
+    pio_spi_set_sample_step(s, s->sample_step);     // Re-patch the edges
+    phase_enter(s, PHASE_SPI, 0, 0);
+}
+
+// Route SCK/MOSI/MISO to the state machine (CS must be high)
+void pio_spi_attach(pio_spi_t *s) {
+    if (s->attached) return;
+    pio_sm_clear_fifos(s->pio, s->sm);
+    pio_gpio_init(s->pio, s->sck_pin);
+    pio_gpio_init(s->pio, s->mosi_pin);
+    pio_gpio_init(s->pio, s->miso_pin);
+    gpio_pull_up(s->miso_pin);
+    if (s->quad_ok) {
+        pio_gpio_init(s->pio, s->io2_pin);
+        pio_gpio_init(s->pio, s->io3_pin);
+        gpio_pull_up(s->io2_pin);
+        gpio_pull_up(s->io3_pin);
+    }
+    s->attached = true;
+}
+
+// Hand the pins back to the PL022
+void pio_spi_detach(pio_spi_t *s) {
+    if (!s->attached) return;
+    gpio_set_function(s->sck_pin, GPIO_FUNC_SPI);
+    gpio_set_function(s->mosi_pin, GPIO_FUNC_SPI);
+    gpio_set_function(s->miso_pin, GPIO_FUNC_SPI);
+    if (s->quad_ok) {
+        // WP#/HOLD# back to plain GPIO outputs, deasserted
+        gpio_init(s->io2_pin);
+        gpio_init(s->io3_pin);
+        gpio_set_dir(s->io2_pin, GPIO_OUT);
+        gpio_set_dir(s->io3_pin, GPIO_OUT);
+        gpio_put(s->io2_pin, 1);
+        gpio_put(s->io3_pin, 1);
+    }
+    s->attached = false;
+}
+
+static void transfer_cpu(pio_spi_t *s, const uint8_t *tx, uint8_t *rx, size_t len) {
+    // 8-bit FIFO accesses: writes are replicated across the word, so the
+    // byte lands in the OSR's MSBs; reads return the autopushed low byte
+    io_rw_8 *txfifo = (io_rw_8 *)&s->pio->txf[s->sm];
+    io_rw_8 *rxfifo = (io_rw_8 *)&s->pio->rxf[s->sm];
+    size_t tx_left = len, rx_left = len;
+    while (tx_left || rx_left) {
+        if (tx_left && !pio_sm_is_tx_fifo_full(s->pio, s->sm)) {
+            *txfifo = tx ? *tx++ : 0x00;
+            tx_left--;
+        }
+        if (rx_left && !pio_sm_is_rx_fifo_empty(s->pio, s->sm)) {
+            uint8_t b = *rxfifo;
+            if (rx) *rx++ = b;
+            rx_left--;
+        }
+    }
+}
+
+static void transfer_dma(pio_spi_t *s, const uint8_t *tx, uint8_t *rx, size_t len) {
+    dma_channel_config tc = dma_channel_get_default_config((uint)s->dma_tx);
+    channel_config_set_transfer_data_size(&tc, DMA_SIZE_8);
+    channel_config_set_read_increment(&tc, tx != NULL);
+    channel_config_set_write_increment(&tc, false);
+    channel_config_set_dreq(&tc, pio_get_dreq(s->pio, s->sm, true));
+    dma_channel_configure((uint)s->dma_tx, &tc, &s->pio->txf[s->sm],
+                          tx ? tx : &s_zero, (uint)len, false);
+
+    dma_channel_config rc = dma_channel_get_default_config((uint)s->dma_rx);
+    channel_config_set_transfer_data_size(&rc, DMA_SIZE_8);
+    channel_config_set_read_increment(&rc, false);
+    channel_config_set_write_increment(&rc, rx != NULL);
+    channel_config_set_dreq(&rc, pio_get_dreq(s->pio, s->sm, false));
+    dma_channel_configure((uint)s->dma_rx, &rc, rx ? rx : &s_discard,
+                          &s->pio->rxf[s->sm], (uint)len, false);
+
+    // RX last byte in == last bit clocked
+    dma_start_channel_mask((1u << s->dma_tx) | (1u << s->dma_rx));
+    dma_channel_wait_for_finish_blocking((uint)s->dma_rx);
+}
+
+static void phase_read(pio_spi_t *s, uint8_t *buf, size_t len, int lanes);
+
+// Full-duplex transfer; tx NULL clocks out zeros, rx NULL discards
+void pio_spi_transfer(pio_spi_t *s, const uint8_t *tx, uint8_t *rx, size_t len) {
+    if (len == 0) return;
+    spi_trace_pio(s->hz, tx, len, 1);
+    if (!tx && rx && step_late(s->sample_step) && s->phases_loaded) {
+        // The full-duplex program only samples on the rising edge
+        phase_enter(s, PHASE_IN1, 1u << s->miso_pin, 0);
+        phase_read(s, rx, len, 1);
+        phase_enter(s, PHASE_SPI, 0, 0);
+        return;
+    }
+    if (len < PIO_SPI_DMA_MIN) {
+        transfer_cpu(s, tx, rx, len);
+    } else {
+        transfer_dma(s, tx, rx, len);
+    }
+}
+
+// ========== Multi-lane reads ==========
+
+bool pio_spi_op_supported(const pio_spi_t *s, const pio_spi_op_t *op) {
+    if (!s->phases_loaded) return false;
+    if (op->addr_lanes != 1 && op->addr_lanes != 4) return false;
+    if (op->data_lanes != 1 && op->data_lanes != 2 && op->data_lanes != 4) return false;
+    if ((op->addr_lanes == 4 || op->data_lanes == 4) && !s->quad_ok) return false;
+    if (op->data_lanes == 2 && s->miso_pin != s->mosi_pin + 1) return false;
+    return true;
+}
+
+// Run a count-driven phase program for `clocks` SCK periods and wait for
+// its completion word; `data` (addr/mode bytes) only for PHASE_OUT4
+static void phase_clocks(pio_spi_t *s, uint32_t clocks, const uint8_t *data, size_t n) {
+    pio_sm_put_blocking(s->pio, s->sm, clocks - 1);
+    io_rw_8 *txfifo = (io_rw_8 *)&s->pio->txf[s->sm];
+    for (size_t i = 0; i < n; i++) {
+        while (pio_sm_is_tx_fifo_full(s->pio, s->sm)) tight_loop_contents();
+        *txfifo = data[i];
+    }
+    (void)pio_sm_get_blocking(s->pio, s->sm);
+}
+
+static void phase_read(pio_spi_t *s, uint8_t *buf, size_t len, int lanes) {
+    pio_sm_put_blocking(s->pio, s->sm, (uint32_t)(len * 8u / (uint)lanes) - 1u);
+    if (len < PIO_SPI_DMA_MIN) {
+        io_rw_8 *rxfifo = (io_rw_8 *)&s->pio->rxf[s->sm];
+        for (size_t i = 0; i < len; i++) {
+            while (pio_sm_is_rx_fifo_empty(s->pio, s->sm)) tight_loop_contents();
+            buf[i] = *rxfifo;
+        }
+        return;
+    }
+    dma_channel_config rc = dma_channel_get_default_config((uint)s->dma_rx);
+    channel_config_set_transfer_data_size(&rc, DMA_SIZE_8);
+    channel_config_set_read_increment(&rc, false);
+    channel_config_set_write_increment(&rc, true);
+    channel_config_set_dreq(&rc, pio_get_dreq(s->pio, s->sm, false));
+    dma_channel_configure((uint)s->dma_rx, &rc, buf, &s->pio->rxf[s->sm], (uint)len, true);
+    dma_channel_wait_for_finish_blocking((uint)s->dma_rx);
+}
+
+// One read command; the caller drives CS around it
+bool pio_spi_read_op(pio_spi_t *s, const pio_spi_op_t *op, uint32_t addr, uint8_t *buf, size_t len) {
+    if (!pio_spi_op_supported(s, op)) return false;
+
+    // Address, then mode bits as whole bytes of zeros at the address width;
+    // a part-byte of mode bits borrows the difference from the dummy clocks
+    uint8_t a[10];
+    size_t na = 0;
+    a[na++] = op->opcode;
+    if (op->addr_bytes == 4) a[na++] = (uint8_t)(addr >> 24);
+    a[na++] = (uint8_t)(addr >> 16);
+    a[na++] = (uint8_t)(addr >> 8);
+    a[na++] = (uint8_t)addr;
+    uint mode_bytes = ((uint)op->mode_clocks * op->addr_lanes + 7u) / 8u;
+    uint mode_sent = mode_bytes * 8u / op->addr_lanes;
+    for (uint i = 0; i < mode_bytes; i++) a[na++] = 0x00;
+    int dummy = (int)op->dummy_clocks - (int)(mode_sent - op->mode_clocks);
+    if (dummy < 0) dummy = 0;
+    spi_trace_pio(s->hz, a, na, op->addr_lanes);
+    if (dummy > 0) spi_trace_pio(s->hz, NULL, ((size_t)dummy * op->data_lanes + 7u) / 8u, op->data_lanes);
+
+    if (op->addr_lanes == 1) {
+        transfer_cpu(s, a, NULL, na);
+    } else {
+        transfer_cpu(s, a, NULL, 1);
+        phase_enter(s, PHASE_OUT4, 0, lane_mask(s, 4));
+        phase_clocks(s, (uint32_t)(na - 1) * 2u, &a[1], na - 1);
+    }
+
+    if (op->data_lanes == 1) {
+        if (dummy > 0) {
+            phase_enter(s, PHASE_CLK, lane_mask(s, 2), 0);
+            phase_clocks(s, (uint32_t)dummy, NULL, 0);
+            phase_enter(s, PHASE_SPI, 0, 0);
+        } else if (op->addr_lanes != 1) {
+            phase_enter(s, PHASE_SPI, 0, 0);
+        }
+        pio_spi_transfer(s, NULL, buf, len);
+        return true;
+    }
+
+    // Release the lanes for turnaround, then sample the data
+    uint32_t lanes = lane_mask(s, op->data_lanes);
+    if (dummy > 0) {
+        phase_enter(s, PHASE_CLK, lanes, 0);
+        phase_clocks(s, (uint32_t)dummy, NULL, 0);
+    }
+    phase_enter(s, op->data_lanes == 4 ? PHASE_IN4 : PHASE_IN2, lanes, 0);
+    spi_trace_pio(s->hz, NULL, len, op->data_lanes);
+    phase_read(s, buf, len, op->data_lanes);
+    phase_enter(s, PHASE_SPI, 0, 0);
+    return true;
+}
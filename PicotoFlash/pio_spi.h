@@ -0,0 +1,102 @@
+/*
+ * PIO SPI Transport Module Header
+ * Flash-bus SPI master on a PIO state machine. The fractional SM clock
+ * divider reaches any SCK up to clk_sys/2 (50 MHz exactly, where the PL022
+ * only offers clk_peri/even-divisor steps); bulk transfers are DMA-fed.
+ *
+ * The transport shares SCK/MOSI/MISO with the PL022: pio_spi_attach()
+ * hands the pins to PIO, pio_spi_detach() gives them back. CS stays a
+ * software GPIO driven by the caller.
+ *
+ * A fractional divider gives the exact average frequency, with individual
+ * SCK half-periods dithered by one clk_sys cycle.
+ *
+ * Multi-lane reads (1-1-2, 1-1-4, 1-4-4) run the opcode through the 1-bit
+ * program, then switch the SM to count-driven address/dummy/data programs.
+ * IO0..IO3 must be consecutive GPIOs (MOSI, MISO, WP#, HOLD#).
+ *
+ * The read sample point is trainable (see sample_cal.c): four steps built
+ * from the sampling SCK edge (rising/falling) and the 2-cycle input
+ * synchroniser (on/bypassed), ordered by pio_spi_sample_offset_ps().
+ */
+
+#ifndef PIO_SPI_H
+#define PIO_SPI_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "hardware/pio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Constants
+#define PIO_SPI_DMA_MIN 32      // Shorter transfers are cheaper on the CPU
+#define PIO_SPI_SAMPLE_STEPS 4
+#define PIO_SPI_SAMPLE_DEFAULT 1    // Rising edge, synchroniser bypassed
+
+typedef struct {
+    PIO pio;
+    uint sm;
+    uint offset;                // pio_spi (1-bit full duplex)
+    uint off_out4;
+    uint off_clk;
+    uint off_in1;
+    uint off_in2;
+    uint off_in4;
+    uint sck_pin;
+    uint mosi_pin;              // IO0
+    uint miso_pin;              // IO1
+    uint io2_pin;               // WP#
+    uint io3_pin;               // HOLD#
+    bool quad_ok;               // IO2/IO3 wired and consecutive
+    int dma_tx;
+    int dma_rx;
+    uint32_t hz;                // Actual SCK (average)
+    uint16_t div_int;
+    uint8_t div_frac;           // 1/256ths
+    bool attached;              // Pins currently routed to PIO
+    uint8_t sample_step;        // 0..PIO_SPI_SAMPLE_STEPS-1
+    bool phases_loaded;         // Multi-lane/receive programs in instruction memory
+} pio_spi_t;
+
+// One multi-lane read command: opcode on IO0, address + mode bits on
+// addr_lanes, dummy clocks with the lanes released, data on data_lanes
+typedef struct {
+    uint8_t opcode;
+    uint8_t addr_bytes;         // 3 or 4
+    uint8_t addr_lanes;         // 1 or 4
+    uint8_t data_lanes;         // 1, 2 or 4
+    uint8_t mode_clocks;        // Driven as 0x00 (continuous read off)
+    uint8_t dummy_clocks;
+} pio_spi_op_t;
+
+// Function declarations
+bool pio_spi_init(pio_spi_t *s, PIO pio, uint sck_pin, uint mosi_pin, uint miso_pin);
+bool pio_spi_enable_quad(pio_spi_t *s, uint io2_pin, uint io3_pin);
+bool pio_spi_op_supported(const pio_spi_t *s, const pio_spi_op_t *op);
+bool pio_spi_read_op(pio_spi_t *s, const pio_spi_op_t *op, uint32_t addr, uint8_t *buf, size_t len);
+uint32_t pio_spi_set_hz(pio_spi_t *s, uint32_t hz);
+void pio_spi_set_sample_step(pio_spi_t *s, uint8_t step);
+int32_t pio_spi_sample_offset_ps(const pio_spi_t *s, uint8_t step);
+bool pio_spi_lend_imem(pio_spi_t *s);
+void pio_spi_reclaim_imem(pio_spi_t *s);
+void pio_spi_attach(pio_spi_t *s);
+void pio_spi_detach(pio_spi_t *s);
+void pio_spi_transfer(pio_spi_t *s, const uint8_t *tx, uint8_t *rx, size_t len);
+
+static inline void pio_spi_write(pio_spi_t *s, const uint8_t *tx, size_t len) {
+    pio_spi_transfer(s, tx, NULL, len);
+}
+
+static inline void pio_spi_read(pio_spi_t *s, uint8_t *rx, size_t len) {
+    pio_spi_transfer(s, NULL, rx, len);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PIO_SPI_H
@@ -5,6 +5,9 @@
 #include <math.h>
 #include "pico/stdlib.h"
 #include "hardware/gpio.h"
+#include "spi_trace.h"
+#include "span_trace.h"
+#include "buf_pool.h"
 
 // Read sizes
 const size_t k_read_sizes[NUM_READ_SIZES] = {1, 256, 4096, 32768, 65536};
@@ -31,31 +34,65 @@ static uint32_t spi_set_hz(spi_inst_t *spi, uint32_t hz) {
     return actual;
 }
 
-static inline void cs_low(uint8_t pin) { gpio_put(pin, 0); }
-static inline void cs_high(uint8_t pin) { gpio_put(pin, 1); }
-static inline void spi_tx(spi_inst_t *spi, const uint8_t *b, size_t n) { spi_write_blocking(spi, b, n); }
-static inline void spi_rx(spi_inst_t *spi, uint8_t *b, size_t n) { spi_read_blocking(spi, 0x00, b, n); }
+// Flash bus the benches run over: the PL022 or the PIO transport
+typedef struct {
+    spi_inst_t *spi;
+    pio_spi_t *pio;             // Non-NULL: use PIO instead of spi
+    const pio_spi_op_t *op;     // Non-NULL: multi-lane read over pio
+    uint8_t cs_pin;
+} read_bus_t;
+
+static inline void cs_low(uint8_t pin) { gpio_put(pin, 0); spi_trace_cs(true); }
+static inline void cs_high(uint8_t pin) { spi_trace_cs(false); gpio_put(pin, 1); }
+
+static inline void spi_tx(const read_bus_t *bus, const uint8_t *b, size_t n) {
+    if (bus->pio) pio_spi_write(bus->pio, b, n);
+    else {
+        spi_trace_pl022(bus->spi, b, n);
+        spi_write_blocking(bus->spi, b, n);
+    }
+}
+
+static inline void spi_rx(const read_bus_t *bus, uint8_t *b, size_t n) {
+    if (bus->pio) pio_spi_read(bus->pio, b, n);
+    else {
+        spi_trace_pl022(bus->spi, NULL, n);
+        spi_read_blocking(bus->spi, 0x00, b, n);
+    }
+}
 
 // Flash read functions
-static void flash_read03(spi_inst_t *spi, uint8_t cs_pin, uint32_t addr, uint8_t *buf, size_t len) {
+static void flash_read03(const read_bus_t *bus, uint32_t addr, uint8_t *buf, size_t len) {
     uint8_t h[4] = {0x03, (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)addr};
-    cs_low(cs_pin);
-    spi_tx(spi, h, 4);
-    spi_rx(spi, buf, len);
-    cs_high(cs_pin);
+    cs_low(bus->cs_pin);
+    spi_tx(bus, h, 4);
+    spi_rx(bus, buf, len);
+    cs_high(bus->cs_pin);
 }
 
-static void flash_read0B(spi_inst_t *spi, uint8_t cs_pin, uint32_t addr, uint8_t *buf,
+static void flash_read0B(const read_bus_t *bus, uint32_t addr, uint8_t *buf,
                           size_t len, uint8_t dummy) {
     uint8_t h[5] = {0x0B, (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)addr, 0x00};
-    cs_low(cs_pin);
-    spi_tx(spi, h, 5);
+    cs_low(bus->cs_pin);
+    spi_tx(bus, h, 5);
     if (dummy > 1) {
         uint8_t d[8] = {0};
-        spi_rx(spi, d, dummy - 1);
+        spi_rx(bus, d, dummy - 1);
     }
-    spi_rx(spi, buf, len);
-    cs_high(cs_pin);
+    spi_rx(bus, buf, len);
+    cs_high(bus->cs_pin);
+}
+
+static void flash_read_op(const read_bus_t *bus, uint32_t addr, uint8_t *buf, size_t len) {
+    cs_low(bus->cs_pin);
+    pio_spi_read_op(bus->pio, bus->op, addr, buf, len);
+    cs_high(bus->cs_pin);
+}
+
+// "1-1-1" style label; data_lanes 0 means a legacy single-lane row
+static const char *mode_label(uint8_t addr_lanes, uint8_t data_lanes, char out[READ_MODE_LABEL_LEN]) {
+    snprintf(out, READ_MODE_LABEL_LEN, "1-%u-%u", addr_lanes ? addr_lanes : 1, data_lanes ? data_lanes : 1);
+    return out;
 }
 
 // Print helpers
@@ -71,9 +108,9 @@ static void print_section(const char *title) {
     print_divider(72);
 }
 
-static void print_table_header(int mhz) {
+static void print_table_header(int mhz, const char *mode) {
     char title[64];
-    snprintf(title, sizeof title, "READ BENCHMARK @ %d MHz", mhz);
+    snprintf(title, sizeof title, "READ BENCHMARK @ %d MHz (%s)", mhz, mode);
     print_section(title);
     printf("size       | n   | avg(us)    | MB/s\n");
     print_divider(50);
@@ -97,40 +134,57 @@ void read_save_result(int mhz, const read_bench_capture_t *cap) {
     read_result_t *r = &g_read_results[g_read_result_count++];
     r->clock_mhz = mhz;
     r->valid = cap->filled;
+    r->addr_lanes = cap->addr_lanes;
+    r->data_lanes = cap->data_lanes;
     if (cap->filled) {
         for (size_t i = 0; i < NUM_READ_SIZES; i++) {
             r->size_stats[i] = cap->rows[i].stats;
+            r->size_hist[i] = cap->rows[i].hist;
         }
     }
 }
 
-// Main benchmark function - TIME ENTIRE BATCH
-void read_run_benches_capture(spi_inst_t *spi, uint8_t cs_pin, bool use_fast,
-                               uint8_t dummy, int mhz_req, read_bench_capture_t *cap_out) {
-    uint8_t *buf = (uint8_t *)malloc(65536);
+// Main benchmark function - TIME ENTIRE BATCH (bus clock already set)
+static void run_benches(const read_bus_t *bus, bool use_fast, uint8_t dummy,
+                        uint32_t actual, read_bench_capture_t *cap_out) {
+    uint8_t *buf = (uint8_t *)buf_pool_get(65536, "read_bench");
     if (!buf) {
         printf("[ERR] NOMEM\n");
         return;
     }
 
-    uint32_t actual = spi_set_hz(spi, (uint32_t)mhz_req * 1000u * 1000u);
     int mhz_to_print = (int)(actual / 1000000u);
+    char mode[READ_MODE_LABEL_LEN];
     
-    print_table_header(mhz_to_print);
+    cap_out->addr_lanes = bus->op ? bus->op->addr_lanes : 1;
+    cap_out->data_lanes = bus->op ? bus->op->data_lanes : 1;
+    print_table_header(mhz_to_print, mode_label(cap_out->addr_lanes, cap_out->data_lanes, mode));
     cap_out->actual_mhz = mhz_to_print;
+    cap_out->actual_hz = actual;
     
+    span_begin_n("read_bench", (uint32_t)mhz_to_print);
     for (size_t si = 0; si < NUM_READ_SIZES; ++si) {
         size_t sz = k_read_sizes[si];
+        span_begin_n("read_batch", (uint32_t)sz);
         
-        // Time the ENTIRE batch of operations
+        // Time the ENTIRE batch of operations (per-read split kept for the histogram)
+        bench_hist_t hist;
+        bench_hist_reset(&hist);
         uint64_t t0 = time_us_64();
+        uint64_t t_prev = t0;
         for (int i = 0; i < ITERS_READ; i++) {
-            if (use_fast)
-                flash_read0B(spi, cs_pin, 0, buf, sz, dummy);
+            if (bus->op)
+                flash_read_op(bus, 0, buf, sz);
+            else if (use_fast)
+                flash_read0B(bus, 0, buf, sz, dummy);
             else
-                flash_read03(spi, cs_pin, 0, buf, sz);
+                flash_read03(bus, 0, buf, sz);
+            uint64_t t_now = time_us_64();
+            bench_hist_add(&hist, (uint32_t)(t_now - t_prev));
+            t_prev = t_now;
         }
-        uint64_t t1 = time_us_64();
+        uint64_t t1 = t_prev;
+        span_end("read_batch");
         
         // Calculate average time per operation
         uint32_t total_us = (uint32_t)(t1 - t0);
@@ -154,14 +208,43 @@ void read_run_benches_capture(spi_inst_t *spi, uint8_t cs_pin, bool use_fast,
         
         cap_out->rows[si].size_bytes = sz;
         cap_out->rows[si].stats = s;
+        cap_out->rows[si].hist = hist;
     }
     
+    span_end("read_bench");
     cap_out->filled = true;
     
     // Save result for summary
     read_save_result(mhz_to_print, cap_out);
     
-    free(buf);
+    buf_pool_put(buf);
+}
+
+void read_run_benches_capture(spi_inst_t *spi, uint8_t cs_pin, bool use_fast,
+                               uint8_t dummy, int mhz_req, read_bench_capture_t *cap_out) {
+    read_bus_t bus = {.spi = spi, .pio = NULL, .op = NULL, .cs_pin = cs_pin};
+    uint32_t actual = spi_set_hz(spi, (uint32_t)mhz_req * 1000u * 1000u);
+    run_benches(&bus, use_fast, dummy, actual, cap_out);
+}
+
+// Same benches over the PIO transport (caller has attached it); hz is hit
+// exactly, so 50 MHz is measured rather than interpolated
+void read_run_benches_capture_pio(pio_spi_t *pio, uint8_t cs_pin, bool use_fast,
+                                   uint8_t dummy, uint32_t hz, read_bench_capture_t *cap_out) {
+    read_bus_t bus = {.spi = NULL, .pio = pio, .op = NULL, .cs_pin = cs_pin};
+    uint32_t actual = pio_spi_set_hz(pio, hz);
+    g_spi_hz = actual;
+    run_benches(&bus, use_fast, dummy, actual, cap_out);
+}
+
+// Multi-lane row (1-1-2 / 1-1-4 / 1-4-4) over PIO; the caller has set QE
+// for quad ops and restores it afterwards
+void read_run_benches_capture_op(pio_spi_t *pio, uint8_t cs_pin, const pio_spi_op_t *op,
+                                  uint32_t hz, read_bench_capture_t *cap_out) {
+    read_bus_t bus = {.spi = NULL, .pio = pio, .op = op, .cs_pin = cs_pin};
+    uint32_t actual = pio_spi_set_hz(pio, hz);
+    g_spi_hz = actual;
+    run_benches(&bus, true, op->dummy_clocks, actual, cap_out);
 }
 
 // Interpolation helpers
@@ -218,8 +301,9 @@ void read_derive_and_print_50(const int *req_mhz, const read_bench_capture_t *ca
     const read_bench_capture_t *used[8];
     int m = 0;
     
-    for (int i = 0; i < n_caps; i++) {
-        if (caps[i].filled) {
+    // Single-lane rows only: the derived figure is the 1-1-1 fast-read rate
+    for (int i = 0; i < n_caps && m < 8; i++) {
+        if (caps[i].filled && caps[i].data_lanes <= 1) {
             actuals[m] = caps[i].actual_mhz;
             used[m] = &caps[i];
             m++;
@@ -232,6 +316,21 @@ void read_derive_and_print_50(const int *req_mhz, const read_bench_capture_t *ca
         return;
     }
     
+    // A capture at exactly 50 MHz (PIO transport) needs no interpolation
+    for (int i = 0; i < m; i++) {
+        if (used[i]->actual_hz != 50000000u) continue;
+        printf("\n=== MEASURED 50 MHz TABLE ===\n");
+        printf("size       | n   | avg(us)     | MB/s\n");
+        printf("----------+-----+--------------+----------\n");
+        for (size_t si = 0; si < NUM_READ_SIZES; ++si) {
+            const read_stats_t *s = &used[i]->rows[si].stats;
+            print_row_derived50(k_read_labels[si], ITERS_READ, s, s->mb_s);
+        }
+        g_derived_50mhz_speed = used[i]->rows[2].stats.mb_s;  // 4KB sector
+        printf("\n[INFO] Measured 50MHz read speed (4KB): %.2f MB/s\n", g_derived_50mhz_speed);
+        return;
+    }
+    
     print_table_header_derived50();
     
     int idx_lo = find_best_below(actuals, m);
@@ -293,37 +392,40 @@ double read_get_50mhz_speed(void) {
 }
 
 void read_print_summary_tables(void) {
+    char mode[READ_MODE_LABEL_LEN];
     print_section("READ BENCHMARK SUMMARY - ALL RESULTS");
     
     // READ PERFORMANCE SUMMARY TABLE
     printf("\n=== READ PERFORMANCE SUMMARY (MB/s) ===\n");
-    printf("Clock    | 1-byte  | page    | sector  | block32k | block64k\n");
-    printf("--------+---------+---------+---------+----------+---------\n");
+    printf("Clock   | Mode  | 1-byte  | page    | sector  | block32k | block64k\n");
+    printf("--------+-------+---------+---------+---------+----------+---------\n");
     
     for (int i = 0; i < g_read_result_count; i++) {
         if (!g_read_results[i].valid) continue;
-        printf("%3d MHz | ", g_read_results[i].clock_mhz);
+        printf("%3d MHz | %-5s | ", g_read_results[i].clock_mhz,
+               mode_label(g_read_results[i].addr_lanes, g_read_results[i].data_lanes, mode));
         for (size_t s = 0; s < NUM_READ_SIZES; s++) {
             printf("%7.4f | ", g_read_results[i].size_stats[s].mb_s);
         }
         printf("\n");
     }
     
-    printf("--------+---------+---------+---------+----------+---------\n");
+    printf("--------+-------+---------+---------+---------+----------+---------\n");
     
     // READ TIMING SUMMARY TABLE
     printf("\n=== READ TIMING SUMMARY (avg microseconds) ===\n");
-    printf("Clock    | 1-byte  | page    | sector  | block32k | block64k\n");
-    printf("--------+---------+---------+---------+----------+---------\n");
+    printf("Clock   | Mode  | 1-byte  | page    | sector  | block32k | block64k\n");
+    printf("--------+-------+---------+---------+---------+----------+---------\n");
     
     for (int i = 0; i < g_read_result_count; i++) {
         if (!g_read_results[i].valid) continue;
-        printf("%3d MHz | ", g_read_results[i].clock_mhz);
+        printf("%3d MHz | %-5s | ", g_read_results[i].clock_mhz,
+               mode_label(g_read_results[i].addr_lanes, g_read_results[i].data_lanes, mode));
         for (size_t s = 0; s < NUM_READ_SIZES; s++) {
             printf("%7.1f | ", g_read_results[i].size_stats[s].avg_us);
         }
         printf("\n");
     }
     
-    printf("--------+---------+---------+---------+----------+---------\n");
+    printf("--------+-------+---------+---------+---------+----------+---------\n");
 }
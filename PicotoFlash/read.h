@@ -5,9 +5,12 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "hardware/spi.h"
+#include "bench_hist.h"
+#include "pio_spi.h"
 
 // Read sizes configuration
 #define NUM_READ_SIZES 5
+#define READ_MODE_LABEL_LEN 10     // "1-255-255" worst case, lanes are uint8_t
 
 extern const size_t k_read_sizes[NUM_READ_SIZES];
 extern const char* k_read_labels[NUM_READ_SIZES];
@@ -23,11 +26,15 @@ typedef struct {
 typedef struct {
     size_t size_bytes;
     read_stats_t stats;
+    bench_hist_t hist;          // Per-read latency distribution
 } read_bench_row_t;
 
 // Benchmark capture structure
 typedef struct {
     int actual_mhz;
+    uint32_t actual_hz;
+    uint8_t addr_lanes;         // 1 or 4
+    uint8_t data_lanes;         // 1, 2 or 4
     read_bench_row_t rows[NUM_READ_SIZES];
     bool filled;
 } read_bench_capture_t;
@@ -36,7 +43,10 @@ typedef struct {
 typedef struct {
     int clock_mhz;
     bool valid;
+    uint8_t addr_lanes;
+    uint8_t data_lanes;
     read_stats_t size_stats[NUM_READ_SIZES];
+    bench_hist_t size_hist[NUM_READ_SIZES];
 } read_result_t;
 
 // Global results storage
@@ -47,6 +57,8 @@ extern int g_read_result_count;
 void read_reset_results(void);
 void read_save_result(int mhz, const read_bench_capture_t *cap);
 void read_run_benches_capture(spi_inst_t *spi, uint8_t cs_pin, bool use_0B, uint8_t dummy, int mhz, read_bench_capture_t *out);
+void read_run_benches_capture_pio(pio_spi_t *pio, uint8_t cs_pin, bool use_0B, uint8_t dummy, uint32_t hz, read_bench_capture_t *out);
+void read_run_benches_capture_op(pio_spi_t *pio, uint8_t cs_pin, const pio_spi_op_t *op, uint32_t hz, read_bench_capture_t *out);
 void read_derive_and_print_50(const int *clocks, const read_bench_capture_t *caps, int n);
 void read_print_summary_tables(void);
 
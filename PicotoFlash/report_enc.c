@@ -0,0 +1,262 @@
+/*
+ * Structured Report Encoder Module
+ * Streaming CBOR / JSON item encoding into a report_writer_t
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "report_enc.h"
+
+// CBOR major types and simple values
+#define CBOR_UINT   0x00
+#define CBOR_NEGINT 0x20
+#define CBOR_BYTES  0x40
+#define CBOR_TEXT   0x60
+#define CBOR_ARRAY  0x80
+#define CBOR_MAP    0xA0
+#define CBOR_INDEF  0x1F
+#define CBOR_FALSE  0xF4
+#define CBOR_TRUE   0xF5
+#define CBOR_NULL   0xF6
+#define CBOR_FLOAT32 0xFA
+#define CBOR_BREAK  0xFF
+
+static const char k_hex[] = "0123456789abcdef";
+
+// ============================================================================
+// CBOR helpers
+// ============================================================================
+
+static void cbor_head(renc_t *e, uint8_t major, uint64_t v) {
+    uint8_t b[9];
+    size_t n;
+    if (v < 24) {
+        b[0] = major | (uint8_t)v;
+        n = 1;
+    } else if (v <= 0xFF) {
+        b[0] = major | 24;
+        b[1] = (uint8_t)v;
+        n = 2;
+    } else if (v <= 0xFFFF) {
+        b[0] = major | 25;
+        b[1] = (uint8_t)(v >> 8);
+        b[2] = (uint8_t)v;
+        n = 3;
+    } else if (v <= 0xFFFFFFFFull) {
+        b[0] = major | 26;
+        for (int i = 0; i < 4; i++) b[1 + i] = (uint8_t)(v >> (24 - 8 * i));
+        n = 5;
+    } else {
+        b[0] = major | 27;
+        for (int i = 0; i < 8; i++) b[1 + i] = (uint8_t)(v >> (56 - 8 * i));
+        n = 9;
+    }
+    rw_write(e->rw, b, n);
+}
+
+static void cbor_byte(renc_t *e, uint8_t b) {
+    rw_write(e->rw, &b, 1);
+}
+
+// ============================================================================
+// JSON helpers
+// ============================================================================
+
+// Separator before a new item (value or key) in the current container
+static void json_sep(renc_t *e) {
+    if (e->after_key) {
+        e->after_key = false;
+        return;
+    }
+    if (e->depth == 0) return;
+    uint16_t bit = (uint16_t)(1u << (e->depth - 1));
+    if (e->has_items & bit) rw_write(e->rw, ",", 1);
+    e->has_items |= bit;
+}
+
+static void json_string(renc_t *e, const char *s, size_t len) {
+    rw_write(e->rw, "\"", 1);
+    size_t run = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            run++;
+            continue;
+        }
+        rw_write(e->rw, s + i - run, run);
+        run = 0;
+        char esc[6] = {'\\', 'u', '0', '0', k_hex[c >> 4], k_hex[c & 0xF]};
+        if (c == '"' || c == '\\') {
+            esc[1] = (char)c;
+            rw_write(e->rw, esc, 2);
+        } else if (c == '\n') {
+            rw_write(e->rw, "\\n", 2);
+        } else {
+            rw_write(e->rw, esc, 6);
+        }
+    }
+    rw_write(e->rw, s + len - run, run);
+    rw_write(e->rw, "\"", 1);
+}
+
+// ============================================================================
+// Containers
+// ============================================================================
+
+void renc_init(renc_t *e, report_writer_t *rw, renc_format_t fmt) {
+    memset(e, 0, sizeof(*e));
+    e->rw = rw;
+    e->fmt = fmt;
+}
+
+static void begin(renc_t *e, uint8_t cbor_major, char json_open) {
+    if (e->depth >= RENC_MAX_DEPTH) {
+        e->error = true;
+        return;
+    }
+    if (e->fmt == RENC_CBOR) {
+        cbor_byte(e, cbor_major | CBOR_INDEF);
+    } else {
+        json_sep(e);
+        rw_write(e->rw, &json_open, 1);
+    }
+    uint16_t bit = (uint16_t)(1u << e->depth);
+    e->has_items &= (uint16_t)~bit;
+    if (cbor_major == CBOR_MAP) e->is_map |= bit;
+    else e->is_map &= (uint16_t)~bit;
+    e->depth++;
+}
+
+void renc_map_begin(renc_t *e) {
+    begin(e, CBOR_MAP, '{');
+}
+
+void renc_array_begin(renc_t *e) {
+    begin(e, CBOR_ARRAY, '[');
+}
+
+void renc_end(renc_t *e) {
+    if (e->depth == 0) {
+        e->error = true;
+        return;
+    }
+    e->depth--;
+    if (e->fmt == RENC_CBOR) {
+        cbor_byte(e, CBOR_BREAK);
+    } else {
+        rw_write(e->rw, (e->is_map & (1u << e->depth)) ? "}" : "]", 1);
+        if (e->depth == 0) rw_write(e->rw, "\n", 1);
+    }
+}
+
+// ============================================================================
+// Items
+// ============================================================================
+
+void renc_key(renc_t *e, const char *key) {
+    if (e->fmt == RENC_CBOR) {
+        size_t len = strlen(key);
+        cbor_head(e, CBOR_TEXT, len);
+        rw_write(e->rw, key, len);
+    } else {
+        json_sep(e);
+        json_string(e, key, strlen(key));
+        rw_write(e->rw, ":", 1);
+        e->after_key = true;
+    }
+}
+
+void renc_uint(renc_t *e, uint64_t v) {
+    if (e->fmt == RENC_CBOR) {
+        cbor_head(e, CBOR_UINT, v);
+    } else {
+        json_sep(e);
+        rw_printf(e->rw, "%llu", (unsigned long long)v);
+    }
+}
+
+void renc_int(renc_t *e, int64_t v) {
+    if (v >= 0) {
+        renc_uint(e, (uint64_t)v);
+    } else if (e->fmt == RENC_CBOR) {
+        cbor_head(e, CBOR_NEGINT, (uint64_t)(-(v + 1)));
+    } else {
+        json_sep(e);
+        rw_printf(e->rw, "%lld", (long long)v);
+    }
+}
+
+// Measurements are float-precision; CBOR carries them as float32
+void renc_float(renc_t *e, double v) {
+    if (e->fmt == RENC_CBOR) {
+        float f = (float)v;
+        uint32_t u;
+        memcpy(&u, &f, sizeof(u));
+        uint8_t b[5] = {CBOR_FLOAT32, (uint8_t)(u >> 24), (uint8_t)(u >> 16),
+                        (uint8_t)(u >> 8), (uint8_t)u};
+        rw_write(e->rw, b, sizeof(b));
+    } else if (isfinite(v)) {
+        json_sep(e);
+        rw_printf(e->rw, "%.7g", v);
+    } else {
+        renc_null(e);  // JSON has no NaN/Inf
+    }
+}
+
+void renc_bool(renc_t *e, bool v) {
+    if (e->fmt == RENC_CBOR) {
+        cbor_byte(e, v ? CBOR_TRUE : CBOR_FALSE);
+    } else {
+        json_sep(e);
+        rw_puts(e->rw, v ? "true" : "false");
+    }
+}
+
+void renc_null(renc_t *e) {
+    if (e->fmt == RENC_CBOR) {
+        cbor_byte(e, CBOR_NULL);
+    } else {
+        json_sep(e);
+        rw_puts(e->rw, "null");
+    }
+}
+
+void renc_str(renc_t *e, const char *s) {
+    size_t len = strlen(s);
+    if (e->fmt == RENC_CBOR) {
+        cbor_head(e, CBOR_TEXT, len);
+        rw_write(e->rw, s, len);
+    } else {
+        json_sep(e);
+        json_string(e, s, len);
+    }
+}
+
+// JSON renders byte strings as lowercase hex
+void renc_bytes(renc_t *e, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    if (e->fmt == RENC_CBOR) {
+        cbor_head(e, CBOR_BYTES, len);
+        rw_write(e->rw, p, len);
+        return;
+    }
+    json_sep(e);
+    rw_write(e->rw, "\"", 1);
+    char hex[32];
+    size_t n = 0;
+    for (size_t i = 0; i < len; i++) {
+        hex[n++] = k_hex[p[i] >> 4];
+        hex[n++] = k_hex[p[i] & 0xF];
+        if (n == sizeof(hex)) {
+            rw_write(e->rw, hex, n);
+            n = 0;
+        }
+    }
+    rw_write(e->rw, hex, n);
+    rw_write(e->rw, "\"", 1);
+}
+
+bool renc_ok(const renc_t *e) {
+    return !e->error && e->depth == 0 && !e->rw->error;
+}
@@ -0,0 +1,61 @@
+/*
+ * Structured Report Encoder Module Header
+ * Streaming CBOR (RFC 8949) / JSON encoder on top of the report writer.
+ * Items go straight into the writer's arena as they are emitted; there is
+ * no intermediate document tree. Maps and arrays are CBOR indefinite-length
+ * containers, so callers never need to count members up front.
+ */
+
+#ifndef REPORT_ENC_H
+#define REPORT_ENC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "report_writer.h"
+
+// Constants
+#define RENC_MAX_DEPTH 16
+
+typedef enum {
+    RENC_CBOR,
+    RENC_JSON
+} renc_format_t;
+
+typedef struct {
+    report_writer_t *rw;
+    renc_format_t fmt;
+    uint8_t depth;
+    uint16_t has_items;     // JSON: bit d set once container d has a member
+    uint16_t is_map;        // JSON: bit d set when container d is a map
+    bool after_key;         // JSON: next item is the value of a map key
+    bool error;             // Nesting overflow/underflow
+} renc_t;
+
+// Function declarations
+void renc_init(renc_t *e, report_writer_t *rw, renc_format_t fmt);
+void renc_map_begin(renc_t *e);
+void renc_array_begin(renc_t *e);
+void renc_end(renc_t *e);
+
+void renc_key(renc_t *e, const char *key);
+void renc_uint(renc_t *e, uint64_t v);
+void renc_int(renc_t *e, int64_t v);
+void renc_float(renc_t *e, double v);
+void renc_bool(renc_t *e, bool v);
+void renc_null(renc_t *e);
+void renc_str(renc_t *e, const char *s);
+void renc_bytes(renc_t *e, const void *data, size_t len);
+
+// True when every container was closed and the writer saw no error
+bool renc_ok(const renc_t *e);
+
+// Key/value shorthands
+static inline void renc_kv_uint(renc_t *e, const char *k, uint64_t v) { renc_key(e, k); renc_uint(e, v); }
+static inline void renc_kv_int(renc_t *e, const char *k, int64_t v) { renc_key(e, k); renc_int(e, v); }
+static inline void renc_kv_float(renc_t *e, const char *k, double v) { renc_key(e, k); renc_float(e, v); }
+static inline void renc_kv_bool(renc_t *e, const char *k, bool v) { renc_key(e, k); renc_bool(e, v); }
+static inline void renc_kv_str(renc_t *e, const char *k, const char *v) { renc_key(e, k); renc_str(e, v); }
+static inline void renc_kv_bytes(renc_t *e, const char *k, const void *d, size_t n) { renc_key(e, k); renc_bytes(e, d, n); }
+
+#endif // REPORT_ENC_H
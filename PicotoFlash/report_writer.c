@@ -0,0 +1,93 @@
+/*
+ * Buffered Report Writer Module
+ * Replaces chains of f_printf() calls: every f_printf() runs FatFs's own
+ * formatter (soft-float for %f on the M0+) and goes through the FIL's
+ * 512 B window. Here text is formatted once with vsnprintf() into a RAM
+ * arena and only whole sectors are passed to f_write(); the tail goes out
+ * with rw_finish(). A typical report is a single f_write().
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "report_writer.h"
+
+void rw_init(report_writer_t *rw, FIL *file, char *arena, size_t cap) {
+    memset(rw, 0, sizeof(*rw));
+    rw->file = file;
+    rw->buf = arena;
+    rw->cap = cap;
+}
+
+// Emit `n` bytes from the front of the arena and keep the remainder
+static bool emit(report_writer_t *rw, size_t n) {
+    if (n == 0 || rw->error) return !rw->error;
+    UINT bw = 0;
+    FRESULT fr = f_write(rw->file, rw->buf, (UINT)n, &bw);
+    rw->writes++;
+    if (fr != FR_OK || bw != n) {
+        rw->error = true;
+        return false;
+    }
+    rw->written += bw;
+    rw->len -= n;
+    if (rw->len) memmove(rw->buf, rw->buf + n, rw->len);
+    return true;
+}
+
+// Make room for `need` more bytes by emitting whole sectors
+static bool reserve(report_writer_t *rw, size_t need) {
+    if (rw->len + need <= rw->cap) return true;
+    size_t whole = rw->len & ~(size_t)(REPORT_SECTOR_SIZE - 1);
+    if (!emit(rw, whole)) return false;
+    if (rw->len + need <= rw->cap) return true;
+    return emit(rw, rw->len);
+}
+
+void rw_write(report_writer_t *rw, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    while (len > 0 && !rw->error) {
+        if (!reserve(rw, len < rw->cap ? len : rw->cap)) return;
+        size_t n = rw->cap - rw->len;
+        if (n > len) n = len;
+        memcpy(rw->buf + rw->len, p, n);
+        rw->len += n;
+        p += n;
+        len -= n;
+    }
+}
+
+void rw_puts(report_writer_t *rw, const char *s) {
+    rw_write(rw, s, strlen(s));
+}
+
+void rw_printf(report_writer_t *rw, const char *fmt, ...) {
+    if (rw->error) return;
+
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(rw->buf + rw->len, rw->cap - rw->len, fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+
+    if ((size_t)n >= rw->cap - rw->len) {
+        // Did not fit: flush sectors and format again
+        if (!reserve(rw, (size_t)n + 1)) return;
+        va_start(ap, fmt);
+        n = vsnprintf(rw->buf + rw->len, rw->cap - rw->len, fmt, ap);
+        va_end(ap);
+        if (n < 0) return;
+        if ((size_t)n >= rw->cap - rw->len) n = (int)(rw->cap - rw->len - 1);  // Truncate
+    }
+    rw->len += (size_t)n;
+}
+
+// Push out all complete sectors, keep the partial tail buffered
+bool rw_flush(report_writer_t *rw) {
+    return emit(rw, rw->len & ~(size_t)(REPORT_SECTOR_SIZE - 1));
+}
+
+// Push out everything
+bool rw_finish(report_writer_t *rw) {
+    return emit(rw, rw->len);
+}
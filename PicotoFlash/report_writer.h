@@ -0,0 +1,36 @@
+/*
+ * Buffered Report Writer Module Header
+ * Formats text into a RAM arena and hands it to FatFs in whole sectors
+ */
+
+#ifndef REPORT_WRITER_H
+#define REPORT_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "ff.h"
+
+// Constants
+#define REPORT_SECTOR_SIZE 512
+#define REPORT_ARENA_SIZE (8 * REPORT_SECTOR_SIZE)
+
+typedef struct {
+    FIL *file;
+    char *buf;          // Arena (caller owned, >= 2 sectors)
+    size_t cap;
+    size_t len;         // Bytes pending in the arena
+    uint32_t written;   // Bytes handed to f_write so far
+    uint32_t writes;    // Number of f_write calls
+    bool error;
+} report_writer_t;
+
+// Function declarations
+void rw_init(report_writer_t *rw, FIL *file, char *arena, size_t cap);
+void rw_printf(report_writer_t *rw, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+void rw_puts(report_writer_t *rw, const char *s);
+void rw_write(report_writer_t *rw, const void *data, size_t len);
+bool rw_flush(report_writer_t *rw);
+bool rw_finish(report_writer_t *rw);
+
+#endif // REPORT_WRITER_H
@@ -0,0 +1,195 @@
+/*
+ * Binary Run Record Module
+ * Serialises everything a flow run measured (all read clocks/sizes, write
+ * captures, erase timings, every latency histogram, identification and
+ * match summary) into one CRC-protected rr_payload_v1_t record and appends
+ * it to RUN_RECORD_FILE with a single sector-aligned f_write().
+ * tools/runrec decodes and aggregates these files on the host.
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "ff.h"
+#include "run_record.h"
+#include "crc32.h"
+#include "read.h"
+#include "write.h"
+#include "erase.h"
+#include "identification.h"
+#include "sd_functions.h"
+#include "str_util.h"
+
+_Static_assert(RR_HIST_BUCKETS == BENCH_HIST_BUCKETS, "histogram layout mismatch");
+_Static_assert(sizeof(rr_hist_t) == sizeof(bench_hist_t), "histogram layout mismatch");
+_Static_assert(RR_READ_SIZES == NUM_READ_SIZES, "read size table mismatch");
+_Static_assert(RR_WRITE_SIZES == WRITE_TEST_SIZES, "write size table mismatch");
+_Static_assert(RR_WRITE_CLOCKS == WRITE_MAX_CLOCKS, "write clock table mismatch");
+_Static_assert(RR_UID_MAX >= 16, "unique ID does not fit");
+
+// Record staging buffer (header + payload + padding)
+static uint8_t g_rr_buf[RR_RECORD_V1_SIZE] __attribute__((aligned(4)));
+static uint32_t g_rr_sequence = 0;
+
+static void copy_hist(rr_hist_t *dst, const bench_hist_t *src) {
+    memcpy(dst->count, src->count, sizeof(dst->count));
+}
+
+static void fill_payload(rr_payload_v1_t *p, const run_record_meta_t *meta) {
+    int year, month, day, hour, min, sec;
+    get_timestamp(&year, &month, &day, &hour, &min, &sec);
+    p->year = (uint16_t)year;
+    p->month = (uint8_t)month;
+    p->day = (uint8_t)day;
+    p->hour = (uint8_t)hour;
+    p->min = (uint8_t)min;
+    p->sec = (uint8_t)sec;
+
+    memcpy(p->jedec, meta->jedec, 3);
+    p->uid_len = meta->uid_len > RR_UID_MAX ? RR_UID_MAX : meta->uid_len;
+    memcpy(p->uid, meta->uid, p->uid_len);
+    p->sfdp_major = meta->sfdp_major;
+    p->sfdp_minor = meta->sfdp_minor;
+    p->density_bits = meta->density_bits;
+    p->image_bytes = meta->image_bytes;
+    p->image_crc32 = meta->image_crc32;
+
+    p->capacity_mbit = test_chip.capacity_mbit;
+    p->read_speed_50mhz = test_chip.read_speed_max;
+    p->erase_64k_ms = test_chip.typ_64kb_erase_ms;
+
+    if (match_results[0].database_index >= 0) {
+        str_copy(p->match_model, RR_NAME_LEN, match_results[0].chip_data.chip_model);
+        str_copy(p->match_company, RR_NAME_LEN, match_results[0].chip_data.company);
+    }
+    p->match_confidence = match_results[0].confidence.overall_confidence;
+    p->match_status = (uint8_t)match_results[0].status;
+
+    // Read captures: every clock, every size
+    int nr = g_read_result_count < RR_READ_CLOCKS ? g_read_result_count : RR_READ_CLOCKS;
+    p->read_count = (uint8_t)nr;
+    for (int c = 0; c < nr; c++) {
+        const read_result_t *r = &g_read_results[c];
+        rr_read_clock_t *o = &p->read[c];
+        o->clock_mhz = (uint16_t)r->clock_mhz;
+        o->valid = r->valid;
+        o->lanes = (uint8_t)((r->addr_lanes << 4) | r->data_lanes);
+        for (int s = 0; s < RR_READ_SIZES; s++) {
+            o->size[s].avg_us = (float)r->size_stats[s].avg_us;
+            o->size[s].mb_s = (float)r->size_stats[s].mb_s;
+            copy_hist(&o->size[s].hist, &r->size_hist[s]);
+        }
+    }
+
+    // Write captures
+    p->write_count = (uint8_t)g_write_result_count;
+    for (int c = 0; c < g_write_result_count; c++) {
+        const write_bench_capture_t *w = &g_write_results[c];
+        rr_write_clock_t *o = &p->write[c];
+        o->clock_mhz_requested = (uint16_t)w->clock_mhz_requested;
+        o->clock_mhz_actual = (uint16_t)w->clock_mhz_actual;
+        o->valid = w->valid;
+        o->num_results = (uint8_t)w->num_results;
+        for (int s = 0; s < w->num_results && s < RR_WRITE_SIZES; s++) {
+            o->size[s].avg_us = (float)w->results[s].stats.avg_us;
+            o->size[s].mb_s = (float)w->results[s].stats.mb_s;
+            copy_hist(&o->size[s].hist, &w->results[s].hist);
+            if (w->results[s].verify_ok) o->verify_ok_mask |= (uint8_t)(1u << s);
+        }
+    }
+
+    // Erase timings
+    p->erase_valid = g_erase_result.valid;
+    p->erase_clock_mhz = (uint16_t)g_erase_result.clock_mhz;
+    const double avg[RR_ERASE_TYPES] = {g_erase_result.avg_4k, g_erase_result.avg_32k, g_erase_result.avg_64k};
+    const uint32_t mn[RR_ERASE_TYPES] = {g_erase_result.min_4k, g_erase_result.min_32k, g_erase_result.min_64k};
+    const uint32_t mx[RR_ERASE_TYPES] = {g_erase_result.max_4k, g_erase_result.max_32k, g_erase_result.max_64k};
+    const bench_hist_t *h[RR_ERASE_TYPES] = {&g_erase_result.hist_4k, &g_erase_result.hist_32k, &g_erase_result.hist_64k};
+    for (int t = 0; t < RR_ERASE_TYPES; t++) {
+        p->erase[t].avg_ms = (float)avg[t];
+        p->erase[t].min_ms = mn[t];
+        p->erase[t].max_ms = mx[t];
+        copy_hist(&p->erase[t].hist, h[t]);
+    }
+}
+
+static bool header_valid(const rr_header_t *h) {
+    return h->magic == RUN_RECORD_MAGIC &&
+           h->header_size == sizeof(rr_header_t) &&
+           h->header_crc32 == crc32_calc(h, offsetof(rr_header_t, header_crc32));
+}
+
+// Continues the sequence from the file's last valid record, walking back
+// over a torn tail one aligned slot at a time. Must run after every mount,
+// before the first run_record_append().
+int run_record_recover(void) {
+    FIL file;
+    FRESULT fr = f_open(&file, RUN_RECORD_FILE, FA_READ | FA_OPEN_EXISTING);
+    if (fr == FR_NO_FILE) return SUCCESS;
+    if (fr != FR_OK) {
+        printf("[ERROR] ERROR_FILE_NOT_FOUND: Cannot open %s (%d)\n", RUN_RECORD_FILE, fr);
+        return ERROR_FILE_NOT_FOUND;
+    }
+
+    FSIZE_t size = f_size(&file);
+    FSIZE_t off = size & ~(FSIZE_t)(RUN_RECORD_ALIGN - 1);
+    if (off == size && off) off -= RUN_RECORD_ALIGN;
+    bool found = false;
+    rr_header_t hdr;
+    for (;;) {
+        UINT br = 0;
+        if (off + sizeof(hdr) <= size && f_lseek(&file, off) == FR_OK &&
+            f_read(&file, &hdr, sizeof(hdr), &br) == FR_OK && br == sizeof(hdr) && header_valid(&hdr)) {
+            found = true;
+            break;
+        }
+        if (off == 0) break;
+        off -= RUN_RECORD_ALIGN;
+    }
+    f_close(&file);
+
+    if (found && hdr.sequence > g_rr_sequence) g_rr_sequence = hdr.sequence;
+    printf("[INFO] Run records: continuing after #%lu\n", (unsigned long)g_rr_sequence);
+    return SUCCESS;
+}
+
+int run_record_append(const run_record_meta_t *meta) {
+    memset(g_rr_buf, 0, sizeof(g_rr_buf));
+    rr_header_t *hdr = (rr_header_t *)g_rr_buf;
+    rr_payload_v1_t *payload = (rr_payload_v1_t *)(g_rr_buf + sizeof(rr_header_t));
+
+    fill_payload(payload, meta);
+
+    hdr->magic = RUN_RECORD_MAGIC;
+    hdr->version = RUN_RECORD_VERSION;
+    hdr->header_size = sizeof(rr_header_t);
+    hdr->record_size = RR_RECORD_V1_SIZE;
+    hdr->payload_size = sizeof(rr_payload_v1_t);
+    hdr->payload_crc32 = crc32_calc(payload, sizeof(rr_payload_v1_t));
+    hdr->sequence = ++g_rr_sequence;
+    hdr->flags = meta->flags;
+    hdr->header_crc32 = crc32_calc(hdr, offsetof(rr_header_t, header_crc32));
+
+    FIL file;
+    FRESULT fr = f_open(&file, RUN_RECORD_FILE, FA_WRITE | FA_OPEN_ALWAYS);
+    if (fr != FR_OK) {
+        printf("[ERROR] ERROR_FILE_WRITE_FAIL: Cannot open %s (%d)\n", RUN_RECORD_FILE, fr);
+        return ERROR_FILE_WRITE_FAIL;
+    }
+
+    // Records always start on a sector boundary; a torn tail is skipped
+    FSIZE_t pos = (f_size(&file) + RUN_RECORD_ALIGN - 1) & ~(FSIZE_t)(RUN_RECORD_ALIGN - 1);
+    UINT bw = 0;
+    fr = f_lseek(&file, pos);
+    if (fr == FR_OK) fr = f_write(&file, g_rr_buf, sizeof(g_rr_buf), &bw);
+    f_close(&file);
+
+    if (fr != FR_OK || bw != sizeof(g_rr_buf)) {
+        printf("[ERROR] ERROR_SD_WRITE_FAIL: Run record write failed (%d)\n", fr);
+        return ERROR_SD_WRITE_FAIL;
+    }
+
+    printf("✓ Run record #%u appended to %s (%u bytes)\n",
+           (unsigned)hdr->sequence, RUN_RECORD_FILE, (unsigned)sizeof(g_rr_buf));
+    return SUCCESS;
+}
@@ -0,0 +1,156 @@
+/*
+ * Binary Run Record Format
+ * One record per flow run, appended to RUN_RECORD_FILE. Shared verbatim by
+ * the firmware (writer) and tools/runrec (host decoder), so it only depends
+ * on <stdint.h>. All fields are little-endian, structs are packed.
+ *
+ * File layout: a sequence of records, each padded to a multiple of
+ * RUN_RECORD_ALIGN bytes and starting on a RUN_RECORD_ALIGN boundary.
+ * A torn or corrupt record fails its CRC and the reader resynchronises at
+ * the next aligned offset carrying RUN_RECORD_MAGIC.
+ */
+
+#ifndef RUN_RECORD_H
+#define RUN_RECORD_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// File definitions
+#define RUN_RECORD_FILE "run_records.bin"
+
+// Constants
+#define RUN_RECORD_MAGIC 0x52524650u   // "PFRR"
+#define RUN_RECORD_VERSION 1
+#define RUN_RECORD_ALIGN 512u
+
+#define RR_HIST_BUCKETS 24             // == BENCH_HIST_BUCKETS
+#define RR_READ_SIZES 5                // == NUM_READ_SIZES
+#define RR_READ_CLOCKS 8
+#define RR_WRITE_SIZES 5               // == WRITE_TEST_SIZES
+#define RR_WRITE_CLOCKS 4              // == WRITE_MAX_CLOCKS
+#define RR_ERASE_TYPES 3               // 4K, 32K, 64K
+#define RR_UID_MAX 16
+#define RR_NAME_LEN 32
+
+// Header flags
+#define RR_FLAG_IMAGE_VALID  0x01u     // image_crc32 covers a complete backup
+#define RR_FLAG_CACHED       0x02u     // Result came from the chip cache
+#define RR_FLAG_DESTRUCTIVE  0x04u     // Write/erase benches ran
+
+#pragma pack(push, 1)
+
+typedef struct {
+    uint16_t count[RR_HIST_BUCKETS];   // Bucket k: [2^(k-1), 2^k) us
+} rr_hist_t;
+
+typedef struct {
+    float avg_us;
+    float mb_s;
+    rr_hist_t hist;
+} rr_size_stat_t;
+
+typedef struct {
+    uint16_t clock_mhz;                // Actual SPI clock
+    uint8_t valid;
+    uint8_t lanes;                     // addr lanes << 4 | data lanes; 0 = 1-1-1
+    rr_size_stat_t size[RR_READ_SIZES];
+} rr_read_clock_t;
+
+typedef struct {
+    uint16_t clock_mhz_requested;
+    uint16_t clock_mhz_actual;
+    uint8_t valid;
+    uint8_t num_results;
+    uint8_t verify_ok_mask;            // Bit i: size i verified
+    uint8_t reserved;
+    rr_size_stat_t size[RR_WRITE_SIZES];
+} rr_write_clock_t;
+
+typedef struct {
+    float avg_ms;
+    uint32_t min_ms;
+    uint32_t max_ms;
+    rr_hist_t hist;
+} rr_erase_type_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;              // sizeof(rr_header_t)
+    uint32_t record_size;              // Header + payload + padding
+    uint32_t payload_size;             // sizeof(rr_payload_v1_t)
+    uint32_t payload_crc32;
+    uint32_t sequence;                 // Run counter, continued across boots
+    uint8_t flags;
+    uint8_t reserved[3];
+    uint32_t header_crc32;             // CRC-32 of all preceding header bytes
+} rr_header_t;
+
+typedef struct {
+    // When
+    uint16_t year;
+    uint8_t month, day, hour, min, sec;
+    uint8_t reserved0;
+
+    // Identification
+    uint8_t jedec[3];
+    uint8_t uid_len;
+    uint8_t uid[RR_UID_MAX];
+    uint8_t sfdp_major, sfdp_minor;
+    uint16_t reserved1;
+    uint32_t density_bits;
+    uint32_t image_bytes;
+    uint32_t image_crc32;
+
+    // Summary (test_chip)
+    float capacity_mbit;
+    float read_speed_50mhz;
+    float erase_64k_ms;
+
+    // Match
+    char match_model[RR_NAME_LEN];
+    char match_company[RR_NAME_LEN];
+    float match_confidence;
+    uint8_t match_status;              // match_status_t
+    uint8_t read_count;
+    uint8_t write_count;
+    uint8_t erase_valid;
+
+    // Captures
+    rr_read_clock_t read[RR_READ_CLOCKS];
+    rr_write_clock_t write[RR_WRITE_CLOCKS];
+    uint16_t erase_clock_mhz;
+    uint16_t reserved2;
+    rr_erase_type_t erase[RR_ERASE_TYPES];
+} rr_payload_v1_t;
+
+#pragma pack(pop)
+
+// Firmware side: identification data not held in the global result structs
+typedef struct {
+    const uint8_t *jedec;              // 3 bytes
+    const uint8_t *uid;
+    uint8_t uid_len;
+    uint8_t sfdp_major, sfdp_minor;
+    uint8_t flags;                     // RR_FLAG_*
+    uint32_t density_bits;
+    uint32_t image_bytes;
+    uint32_t image_crc32;
+} run_record_meta_t;
+
+int run_record_recover(void);
+int run_record_append(const run_record_meta_t *meta);
+
+// Padded on-disk size of one v1 record
+#define RR_RECORD_V1_SIZE \
+    (((sizeof(rr_header_t) + sizeof(rr_payload_v1_t)) + RUN_RECORD_ALIGN - 1) & ~(RUN_RECORD_ALIGN - 1))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RUN_RECORD_H
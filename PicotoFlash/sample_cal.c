@@ -0,0 +1,409 @@
+/*
+ * Read Sample-Point Calibration Module
+ * On long fixture cables MISO settles after the rising SCK edge, so the
+ * clock ceiling is set by where we sample, not by the chip. For each SCK
+ * above SAMPLE_CAL_MIN_HZ this module reads a reference pattern at
+ * SAMPLE_CAL_REF_HZ, re-reads it at every PIO sample step, and settles on
+ * the centre of the passing window.
+ *
+ * Results live in SAMPLE_CAL_FILE as fixed-size records keyed by fixture
+ * name (first `name=` line of FIXTURE_CONFIG_FILE, else "default"), JEDEC
+ * ID, clk_sys, actual SCK and the flash pad configuration. A stored step is re-verified before use and
+ * retrained if the window has moved.
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "ff.h"
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "sample_cal.h"
+#include "drive_cal.h"
+#include "crc32.h"
+#include "sd_functions.h"
+#include "spi_trace.h"
+#include "buf_pool.h"
+#include "str_util.h"
+
+#define PATTERN_BYTES (SAMPLE_CAL_SFDP_BYTES + SAMPLE_CAL_DATA_BYTES)
+
+// Reference pattern and the re-read under test
+static uint8_t *g_golden;           // Pool checkout for the length of a public call
+static uint8_t *g_probe;
+static bool g_golden_sfdp;          // SFDP part of the pattern is present
+
+static char g_fixture[SAMPLE_CAL_FIXTURE_LEN] = "default";
+static bool g_fixture_loaded = false;
+
+// ============================================================================
+// Pattern reads
+// ============================================================================
+
+// SFDP table (varied bytes on every part that has one), then the start of
+// the array with fast read; SFDP is skipped in 4-byte address mode
+static void read_pattern(pio_spi_t *pio, uint8_t cs_pin, bool addr4, uint8_t *buf) {
+    if (!addr4) {
+        const uint8_t sfdp[5] = {0x5A, 0x00, 0x00, 0x00, 0x00};
+        gpio_put(cs_pin, 0);
+        spi_trace_cs(true);
+        pio_spi_write(pio, sfdp, sizeof(sfdp));
+        pio_spi_read(pio, buf, SAMPLE_CAL_SFDP_BYTES);
+        spi_trace_cs(false);
+        gpio_put(cs_pin, 1);
+    } else {
+        memset(buf, 0, SAMPLE_CAL_SFDP_BYTES);
+    }
+
+    uint8_t h[6];
+    size_t n = 0;
+    h[n++] = 0x0B;
+    if (addr4) h[n++] = 0x00;
+    h[n++] = 0x00;
+    h[n++] = 0x00;
+    h[n++] = 0x00;
+    h[n++] = 0x00;                  // 8 dummy clocks
+    gpio_put(cs_pin, 0);
+    spi_trace_cs(true);
+    pio_spi_write(pio, h, n);
+    pio_spi_read(pio, buf + SAMPLE_CAL_SFDP_BYTES, SAMPLE_CAL_DATA_BYTES);
+    spi_trace_cs(false);
+    gpio_put(cs_pin, 1);
+}
+
+// A blank array with no SFDP is all one byte value and proves nothing
+static bool pattern_usable(const uint8_t *buf, bool sfdp) {
+    if (sfdp) return true;
+    const uint8_t *d = buf + SAMPLE_CAL_SFDP_BYTES;
+    for (size_t i = 1; i < SAMPLE_CAL_DATA_BYTES; i++) {
+        if (d[i] != d[0]) return true;
+    }
+    return false;
+}
+
+// Leaves the transport at the reference clock and the default step
+// Golden and probe patterns share one checkout
+static bool pattern_get(void) {
+    g_golden = (uint8_t *)buf_pool_get(2 * PATTERN_BYTES, "sample_cal");
+    g_probe = g_golden ? g_golden + PATTERN_BYTES : NULL;
+    return g_golden != NULL;
+}
+
+static void pattern_put(void) {
+    buf_pool_put(g_golden);
+    g_golden = NULL;
+    g_probe = NULL;
+}
+
+static bool read_golden(pio_spi_t *pio, uint8_t cs_pin, bool addr4) {
+    pio_spi_set_hz(pio, SAMPLE_CAL_REF_HZ);
+    pio_spi_set_sample_step(pio, PIO_SPI_SAMPLE_DEFAULT);
+    read_pattern(pio, cs_pin, addr4, g_golden);
+    g_golden_sfdp = !addr4 && memcmp(g_golden, "SFDP", 4) == 0;
+    return pattern_usable(g_golden, g_golden_sfdp);
+}
+
+static bool step_passes(pio_spi_t *pio, uint8_t cs_pin, bool addr4, uint8_t step) {
+    pio_spi_set_sample_step(pio, step);
+    for (int i = 0; i < SAMPLE_CAL_PASSES; i++) {
+        read_pattern(pio, cs_pin, addr4, g_probe);
+        if (memcmp(g_probe, g_golden, PATTERN_BYTES) != 0) return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// Training
+// ============================================================================
+
+// Steps sorted by sample instant (the order depends on SCK vs clk_sys)
+static void order_steps(const pio_spi_t *pio, uint8_t order[PIO_SPI_SAMPLE_STEPS]) {
+    for (uint8_t i = 0; i < PIO_SPI_SAMPLE_STEPS; i++) order[i] = i;
+    for (int i = 1; i < PIO_SPI_SAMPLE_STEPS; i++) {
+        uint8_t v = order[i];
+        int32_t t = pio_spi_sample_offset_ps(pio, v);
+        int j = i - 1;
+        while (j >= 0 && pio_spi_sample_offset_ps(pio, order[j]) > t) {
+            order[j + 1] = order[j];
+            j--;
+        }
+        order[j + 1] = v;
+    }
+}
+
+// Sweep every step at hz against the golden pattern already in g_golden
+static bool train_at(pio_spi_t *pio, uint8_t cs_pin, bool addr4, sample_cal_entry_t *out) {
+    uint8_t order[PIO_SPI_SAMPLE_STEPS];
+    order_steps(pio, order);
+
+    printf("[CAL] Sample sweep @ %.3f MHz\n", pio->hz / 1e6);
+    printf("  step | offset(ns) | result\n");
+    out->pass_mask = 0;
+    int best_start = -1, best_len = 0, run_start = -1;
+    for (int i = 0; i < PIO_SPI_SAMPLE_STEPS; i++) {
+        uint8_t st = order[i];
+        bool ok = step_passes(pio, cs_pin, addr4, st);
+        printf("  %4u | %+10.2f | %s\n", st, pio_spi_sample_offset_ps(pio, st) / 1000.0,
+               ok ? "pass" : "FAIL");
+        if (ok) {
+            out->pass_mask |= (uint8_t)(1u << st);
+            if (run_start < 0) run_start = i;
+            if (i - run_start + 1 > best_len) {
+                best_len = i - run_start + 1;
+                best_start = run_start;
+            }
+        } else {
+            run_start = -1;
+        }
+    }
+
+    if (best_len == 0) {
+        pio_spi_set_sample_step(pio, PIO_SPI_SAMPLE_DEFAULT);
+        printf("[WARN] No passing sample step @ %.3f MHz\n", pio->hz / 1e6);
+        return false;
+    }
+
+    // Centre of the widest window; an even window leans late, where a long
+    // cable pushes the data eye
+    out->step = order[best_start + best_len / 2];
+    pio_spi_set_sample_step(pio, out->step);
+    printf("[CAL] Window %d step%s wide, using step %u (%+.2f ns)\n", best_len,
+           best_len == 1 ? "" : "s", out->step, pio_spi_sample_offset_ps(pio, out->step) / 1000.0);
+    return true;
+}
+
+bool sample_cal_train(pio_spi_t *pio, uint8_t cs_pin, bool addr4, uint32_t hz, sample_cal_entry_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (!pattern_get()) {
+        pio_spi_set_hz(pio, hz);
+        return false;
+    }
+    bool ok = false;
+    if (!read_golden(pio, cs_pin, addr4)) {
+        pio_spi_set_hz(pio, hz);
+        printf("[WARN] Calibration pattern is blank (no SFDP, uniform array), default sample step\n");
+    } else {
+        out->hz = pio_spi_set_hz(pio, hz);
+        out->clk_sys_hz = clock_get_hz(clk_sys);
+        ok = train_at(pio, cs_pin, addr4, out);
+    }
+    pattern_put();
+    return ok;
+}
+
+// Quiet sweep for clock-ceiling probes: bit i of the result set when step i
+// reads the pattern back at hz (0 = no step, or a blank pattern). Leaves the
+// transport at hz with the default step.
+uint8_t sample_cal_probe(pio_spi_t *pio, uint8_t cs_pin, bool addr4, uint32_t hz) {
+    if (!pattern_get()) {
+        pio_spi_set_hz(pio, hz);
+        return 0;
+    }
+    bool usable = read_golden(pio, cs_pin, addr4);
+    pio_spi_set_hz(pio, hz);
+    uint8_t mask = 0;
+    for (uint8_t st = 0; usable && st < PIO_SPI_SAMPLE_STEPS; st++) {
+        if (step_passes(pio, cs_pin, addr4, st)) mask |= (uint8_t)(1u << st);
+    }
+    pio_spi_set_sample_step(pio, PIO_SPI_SAMPLE_DEFAULT);
+    pattern_put();
+    return mask;
+}
+
+static uint8_t apply_step(pio_spi_t *pio, uint8_t cs_pin, const uint8_t jedec[3], bool addr4,
+                          uint32_t hz, bool persist) {
+    uint32_t actual = pio_spi_set_hz(pio, hz);
+    if (actual < SAMPLE_CAL_MIN_HZ) {
+        pio_spi_set_sample_step(pio, PIO_SPI_SAMPLE_DEFAULT);
+        return PIO_SPI_SAMPLE_DEFAULT;
+    }
+
+    sample_cal_entry_t e;
+    bool stored = persist && sample_cal_lookup(jedec, actual, &e);
+    if (!read_golden(pio, cs_pin, addr4)) {
+        pio_spi_set_hz(pio, hz);
+        pio_spi_set_sample_step(pio, stored ? e.step : PIO_SPI_SAMPLE_DEFAULT);
+        printf("[WARN] Calibration pattern is blank, %s sample step\n", stored ? "stored" : "default");
+        return pio->sample_step;
+    }
+    pio_spi_set_hz(pio, hz);
+
+    if (stored) {
+        if (step_passes(pio, cs_pin, addr4, e.step)) {
+            printf("[CAL] %s @ %.3f MHz: stored step %u verified\n", sample_cal_fixture(),
+                   actual / 1e6, e.step);
+            return e.step;
+        }
+        printf("[CAL] Stored step %u no longer reads back, retraining\n", e.step);
+    }
+
+    memset(&e, 0, sizeof(e));
+    e.hz = actual;
+    e.clk_sys_hz = clock_get_hz(clk_sys);
+    if (!train_at(pio, cs_pin, addr4, &e)) return PIO_SPI_SAMPLE_DEFAULT;
+
+    if (persist) {
+        memcpy(e.jedec, jedec, 3);
+        sample_cal_store(&e);
+    }
+    return e.step;
+}
+
+// Set hz and the best known sample step for it: the stored step if it still
+// reads the pattern back, otherwise a fresh sweep (stored when persist).
+// Returns the step in use.
+uint8_t sample_cal_apply(pio_spi_t *pio, uint8_t cs_pin, const uint8_t jedec[3], bool addr4,
+                         uint32_t hz, bool persist) {
+    if (!pattern_get()) {
+        pio_spi_set_hz(pio, hz);
+        pio_spi_set_sample_step(pio, PIO_SPI_SAMPLE_DEFAULT);
+        return PIO_SPI_SAMPLE_DEFAULT;
+    }
+    uint8_t step = apply_step(pio, cs_pin, jedec, addr4, hz, persist);
+    pattern_put();
+    return step;
+}
+
+// ============================================================================
+// Storage
+// ============================================================================
+
+static void trim(char *s) {
+    char *p = s;
+    while (*p == ' ' || *p == '\t') p++;
+    if (p != s) memmove(s, p, strlen(p) + 1);
+    int n = (int)strlen(s);
+    while (n > 0 && (s[n - 1] == ' ' || s[n - 1] == '\t' || s[n - 1] == '\r' || s[n - 1] == '\n')) {
+        s[--n] = '\0';
+    }
+}
+
+// fixture.cfg (optional):
+//   name=pogo-long
+const char *sample_cal_fixture(void) {
+    if (g_fixture_loaded) return g_fixture;
+    g_fixture_loaded = true;
+
+    FIL file;
+    if (f_open(&file, FIXTURE_CONFIG_FILE, FA_READ) != FR_OK) return g_fixture;
+    char line[64];
+    while (f_gets(line, sizeof(line), &file) != NULL) {
+        if (line[0] == '#' || strncmp(line, "name=", 5) != 0) continue;
+        char *val = line + 5;
+        trim(val);
+        if (val[0]) {
+            str_copy(g_fixture, SAMPLE_CAL_FIXTURE_LEN, val);
+        }
+        break;
+    }
+    f_close(&file);
+    printf("[CAL] Fixture '%s'\n", g_fixture);
+    return g_fixture;
+}
+
+static uint32_t entry_crc(const sample_cal_entry_t *e) {
+    return crc32_calc(e, offsetof(sample_cal_entry_t, crc32));
+}
+
+static bool entry_ok(const sample_cal_entry_t *e) {
+    return e->magic == SAMPLE_CAL_MAGIC &&
+           e->version == SAMPLE_CAL_VERSION &&
+           e->record_size == sizeof(sample_cal_entry_t) &&
+           e->crc32 == entry_crc(e);
+}
+
+static bool entry_key_matches(const sample_cal_entry_t *e, const sample_cal_entry_t *key) {
+    return strncmp(e->fixture, key->fixture, SAMPLE_CAL_FIXTURE_LEN) == 0 &&
+           memcmp(e->jedec, key->jedec, 3) == 0 &&
+           e->clk_sys_hz == key->clk_sys_hz &&
+           e->hz == key->hz &&
+           e->pads == key->pads;
+}
+
+// Slot of the key or -1; *free_slot gets the first corrupt slot or the end
+static int find_slot(FIL *file, const sample_cal_entry_t *key, sample_cal_entry_t *out, int *free_slot) {
+    sample_cal_entry_t e;
+    UINT br = 0;
+    int slot = 0;
+    int first_bad = -1;
+
+    f_lseek(file, 0);
+    while (slot < SAMPLE_CAL_MAX_ENTRIES &&
+           f_read(file, &e, sizeof(e), &br) == FR_OK && br == sizeof(e)) {
+        if (!entry_ok(&e)) {
+            if (first_bad < 0) first_bad = slot;
+        } else if (entry_key_matches(&e, key)) {
+            if (out) *out = e;
+            return slot;
+        }
+        slot++;
+    }
+
+    if (free_slot) *free_slot = (first_bad >= 0) ? first_bad : slot;
+    return -1;
+}
+
+static void fill_key(sample_cal_entry_t *key, const uint8_t jedec[3], uint32_t hz) {
+    str_copy(key->fixture, SAMPLE_CAL_FIXTURE_LEN, sample_cal_fixture());
+    memcpy(key->jedec, jedec, 3);
+    key->clk_sys_hz = clock_get_hz(clk_sys);
+    key->hz = hz;
+    key->pads = drive_cal_pads_current(DRIVE_BUS_FLASH);
+}
+
+bool sample_cal_lookup(const uint8_t jedec[3], uint32_t hz, sample_cal_entry_t *out) {
+    sample_cal_entry_t key;
+    memset(&key, 0, sizeof(key));
+    fill_key(&key, jedec, hz);
+
+    FIL file;
+    if (f_open(&file, SAMPLE_CAL_FILE, FA_READ) != FR_OK) return false;
+    int slot = find_slot(&file, &key, out, NULL);
+    f_close(&file);
+    return slot >= 0;
+}
+
+int sample_cal_store(sample_cal_entry_t *entry) {
+    uint8_t jedec[3];
+    memcpy(jedec, entry->jedec, 3);
+    memset(entry->fixture, 0, sizeof(entry->fixture));
+    fill_key(entry, jedec, entry->hz);
+
+    FIL file;
+    FRESULT fr = f_open(&file, SAMPLE_CAL_FILE, FA_READ | FA_WRITE | FA_OPEN_ALWAYS);
+    if (fr != FR_OK) {
+        printf("[ERROR] ERROR_FILE_WRITE_FAIL: Cannot open %s (%d)\n", SAMPLE_CAL_FILE, fr);
+        return ERROR_FILE_WRITE_FAIL;
+    }
+
+    int free_slot = 0;
+    int slot = find_slot(&file, entry, NULL, &free_slot);
+    if (slot < 0) {
+        if (free_slot >= SAMPLE_CAL_MAX_ENTRIES) {
+            f_close(&file);
+            printf("[WARNING] Sample calibration table full (%d entries), not stored\n",
+                   SAMPLE_CAL_MAX_ENTRIES);
+            return ERROR_SD_FULL;
+        }
+        slot = free_slot;
+    }
+
+    entry->magic = SAMPLE_CAL_MAGIC;
+    entry->version = SAMPLE_CAL_VERSION;
+    entry->record_size = sizeof(sample_cal_entry_t);
+    entry->crc32 = entry_crc(entry);
+
+    UINT bw = 0;
+    fr = f_lseek(&file, (FSIZE_t)slot * sizeof(sample_cal_entry_t));
+    if (fr == FR_OK) fr = f_write(&file, entry, sizeof(*entry), &bw);
+    f_close(&file);
+
+    if (fr != FR_OK || bw != sizeof(*entry)) {
+        printf("[ERROR] ERROR_FILE_WRITE_FAIL: Sample calibration write failed (%d)\n", fr);
+        return ERROR_FILE_WRITE_FAIL;
+    }
+
+    printf("✓ Sample step stored (%s, %02X%02X%02X @ %.3f MHz, slot %d)\n", entry->fixture,
+           entry->jedec[0], entry->jedec[1], entry->jedec[2], entry->hz / 1e6, slot);
+    return SUCCESS;
+}
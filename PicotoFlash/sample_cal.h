@@ -0,0 +1,60 @@
+/*
+ * Read Sample-Point Calibration Module Header
+ * Trains the PIO read sample step per SCK frequency against a pattern read
+ * at a safe clock, and keeps the result on SD per fixture + chip (JEDEC ID)
+ */
+
+#ifndef SAMPLE_CAL_H
+#define SAMPLE_CAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pio_spi.h"
+
+// File definitions
+#define SAMPLE_CAL_FILE "sample_cal.bin"
+#define FIXTURE_CONFIG_FILE "fixture.cfg"
+
+// Constants
+#define SAMPLE_CAL_MAGIC 0x43534650u   // "PFSC"
+#define SAMPLE_CAL_VERSION 1
+#define SAMPLE_CAL_MAX_ENTRIES 128
+#define SAMPLE_CAL_FIXTURE_LEN 16
+#define SAMPLE_CAL_MIN_HZ 30000000u    // Below this the default step has margin to spare
+#define SAMPLE_CAL_REF_HZ 12500000u    // Pattern reference clock
+#define SAMPLE_CAL_DATA_BYTES 4096u    // Array region at address 0
+#define SAMPLE_CAL_SFDP_BYTES 256u
+#define SAMPLE_CAL_PASSES 4            // Reads per step that must all match
+
+// One trained (fixture, chip, clk_sys, SCK) point
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+
+    // Key
+    char fixture[SAMPLE_CAL_FIXTURE_LEN];
+    uint8_t jedec[3];
+    uint8_t reserved0;
+    uint32_t clk_sys_hz;           // Offsets are clk_sys relative
+    uint32_t hz;                   // Actual SCK
+
+    // Result
+    uint8_t step;                  // Centre of the passing window
+    uint8_t pass_mask;             // Bit i: step i passed
+    uint8_t pads;                  // Also key: flash pad configuration (drive_cal.h)
+    uint8_t reserved1;
+
+    uint32_t crc32;                // CRC-32 of all preceding bytes
+} sample_cal_entry_t;
+
+// Function declarations
+const char *sample_cal_fixture(void);
+bool sample_cal_train(pio_spi_t *pio, uint8_t cs_pin, bool addr4, uint32_t hz, sample_cal_entry_t *out);
+uint8_t sample_cal_probe(pio_spi_t *pio, uint8_t cs_pin, bool addr4, uint32_t hz);
+uint8_t sample_cal_apply(pio_spi_t *pio, uint8_t cs_pin, const uint8_t jedec[3], bool addr4,
+                         uint32_t hz, bool persist);
+bool sample_cal_lookup(const uint8_t jedec[3], uint32_t hz, sample_cal_entry_t *out);
+int sample_cal_store(sample_cal_entry_t *entry);
+
+#endif // SAMPLE_CAL_H
@@ -12,6 +12,8 @@
 #include "ff.h"
 #include "sd_functions.h"
 #include "identification.h"
+#include "report_writer.h"
+#include "str_util.h"
 
 // External references to global data from main.c
 extern FlashChipData database[];
@@ -20,6 +22,9 @@ extern FlashChipData benchmark_results;
 extern match_result_t match_results[];
 extern FlashChipData test_chip;
 
+// Formatting arena shared by the report/log writers (one writer at a time)
+static char g_report_arena[REPORT_ARENA_SIZE];
+
 // ============================================================================
 // Utility Functions
 // ============================================================================
@@ -97,18 +102,56 @@ void get_timestamp(int* year, int* month, int* day, int* hour, int* min, int* se
     *sec = t.sec;
 }
 
-bool check_sd_free_space(void) {
-    FATFS* fs;
-    DWORD fre_clust, fre_sect;
+// ============================================================================
+// Free-space accounting
+// ============================================================================
+// f_getfree() is O(1) only while FatFs's free-cluster counter is valid. On a
+// FAT32 volume whose FSInfo is missing or stale the first call after mount
+// walks the whole FAT (seconds on a 32 GB card). We pay that once, right
+// after mount, and from then on read the counter FatFs maintains itself on
+// every cluster allocation/release (our writes included) - no FAT access
+// and no disk I/O in the per-run checks.
+
+static FATFS *g_free_fs = NULL;
+
+bool sd_free_space_prime(void) {
+    DWORD fre_clust;
+    FATFS *fs;
+    uint64_t t0 = time_us_64();
     FRESULT res = f_getfree("0:", &fre_clust, &fs);
-    
     if (res != FR_OK) {
-        printf("[ERROR] ERROR_SD_NOT_PRESENT: Cannot access SD card\n");
+        g_free_fs = NULL;
         return false;
     }
+    g_free_fs = fs;
+    printf("[INFO] SD free-space count primed in %u ms\n",
+           (unsigned)((time_us_64() - t0) / 1000u));
+    return true;
+}
+
+void sd_free_space_reset(void) {
+    g_free_fs = NULL;
+}
+
+bool sd_free_space_get(uint64_t *free_bytes) {
+    const FATFS *fs = g_free_fs;
+    if (!fs || fs->fs_type == 0) return false;           // Not primed / unmounted
+    if (fs->free_clst > fs->n_fatent - 2) return false;  // Counter invalidated
+    *free_bytes = (uint64_t)fs->free_clst * fs->csize * FF_MIN_SS;
+    return true;
+}
+
+bool check_sd_free_space(void) {
+    uint64_t free_bytes = 0;
+    if (!sd_free_space_get(&free_bytes)) {
+        // Not primed yet (e.g. mounted elsewhere): fall back to one f_getfree()
+        if (!sd_free_space_prime() || !sd_free_space_get(&free_bytes)) {
+            printf("[ERROR] ERROR_SD_NOT_PRESENT: Cannot access SD card\n");
+            return false;
+        }
+    }
     
-    fre_sect = fre_clust * fs->csize;
-    float free_mb = (float)(fre_sect) / 2048.0;
+    float free_mb = (float)((double)free_bytes / 1048576.0);
     
     printf("[INFO] SD Card Free Space: %.1f MB\n", free_mb);
     
@@ -161,11 +204,11 @@ int sd_load_chip_database(void) {
         FlashChipData entry;
         memset(&entry, 0, sizeof(FlashChipData));
         
-        strncpy(entry.chip_model, fields[0], MAX_FIELD_LENGTH - 1);
-        strncpy(entry.company, fields[1], MAX_FIELD_LENGTH - 1);
-        strncpy(entry.chip_family, fields[2], MAX_FIELD_LENGTH - 1);
+        str_copy(entry.chip_model, sizeof(entry.chip_model), fields[0]);
+        str_copy(entry.company, sizeof(entry.company), fields[1]);
+        str_copy(entry.chip_family, sizeof(entry.chip_family), fields[2]);
         entry.capacity_mbit = atof(fields[3]);
-        strncpy(entry.jedec_id, fields[4], MAX_FIELD_LENGTH - 1);
+        str_copy(entry.jedec_id, sizeof(entry.jedec_id), fields[4]);
         
         // Validate
         if (!validate_jedec_format(entry.jedec_id)) continue;
@@ -224,21 +267,29 @@ int sd_log_benchmark_results(void) {
         return ERROR_FILE_WRITE_FAIL;
     }
     
+    report_writer_t rw;
+    rw_init(&rw, &file, g_report_arena, sizeof(g_report_arena));
+    
     if (!file_exists) {
-        f_printf(&file, "Timestamp,JEDEC_ID,Manufacturer,PartNumber,");
-        f_printf(&file, "Capacity_Mbit,ReadSpeed_MBps,EraseSpeed_ms,ClockFreq_MHz\n");
+        rw_printf(&rw, "Timestamp,JEDEC_ID,Manufacturer,PartNumber,");
+        rw_printf(&rw, "Capacity_Mbit,ReadSpeed_MBps,EraseSpeed_ms,ClockFreq_MHz\n");
     }
     
-    f_printf(&file, "%04d-%02d-%02d %02d:%02d:%02d,", year, month, day, hour, min, sec);
-    f_printf(&file, "%s,", benchmark_results.jedec_id);
-    f_printf(&file, "%s,", benchmark_results.company);
-    f_printf(&file, "%s,", benchmark_results.chip_model);
-    f_printf(&file, "%.1f,", benchmark_results.capacity_mbit);
-    f_printf(&file, "%.2f,", benchmark_results.read_speed_max);
-    f_printf(&file, "%.1f,", benchmark_results.erase_speed);
-    f_printf(&file, "%d\n", benchmark_results.max_clock_freq_mhz);
+    rw_printf(&rw, "%04d-%02d-%02d %02d:%02d:%02d,", year, month, day, hour, min, sec);
+    rw_printf(&rw, "%s,", benchmark_results.jedec_id);
+    rw_printf(&rw, "%s,", benchmark_results.company);
+    rw_printf(&rw, "%s,", benchmark_results.chip_model);
+    rw_printf(&rw, "%.1f,", benchmark_results.capacity_mbit);
+    rw_printf(&rw, "%.2f,", benchmark_results.read_speed_max);
+    rw_printf(&rw, "%.1f,", benchmark_results.erase_speed);
+    rw_printf(&rw, "%d\n", benchmark_results.max_clock_freq_mhz);
     
+    bool ok = rw_finish(&rw);
     f_close(&file);
+    if (!ok) {
+        printf("[ERROR] ERROR_SD_WRITE_FAIL: Log write failed\n");
+        return ERROR_SD_WRITE_FAIL;
+    }
     
     printf("✓ Benchmark results logged to %s\n", filename);
     return SUCCESS;
@@ -269,93 +320,198 @@ int sd_create_forensic_report(void) {
         return ERROR_FILE_WRITE_FAIL;
     }
     
+    report_writer_t rw;
+    rw_init(&rw, &file, g_report_arena, sizeof(g_report_arena));
+    
     // Header
-    f_printf(&file, "========================================\n");
-    f_printf(&file, "  FLASH CHIP FORENSIC IDENTIFICATION REPORT\n");
-    f_printf(&file, "========================================\n");
-    f_printf(&file, "Generated: %04d-%02d-%02d %02d:%02d:%02d\n\n", 
+    rw_printf(&rw, "========================================\n");
+    rw_printf(&rw, "  FLASH CHIP FORENSIC IDENTIFICATION REPORT\n");
+    rw_printf(&rw, "========================================\n");
+    rw_printf(&rw, "Generated: %04d-%02d-%02d %02d:%02d:%02d\n\n", 
              year, month, day, hour, min, sec);
     
     // Test Chip Data
-    f_printf(&file, "--- Test Chip Benchmarks ---\n");
-    f_printf(&file, "JEDEC ID: %s\n", test_chip.jedec_id);
-    f_printf(&file, "Capacity: %.0f Mbit\n", test_chip.capacity_mbit);
-    f_printf(&file, "Read Speed (50MHz): %.2f MB/s\n", test_chip.read_speed_max);
-    f_printf(&file, "Erase Speed (64KB): %.1f ms\n", test_chip.erase_speed);
-    f_printf(&file, "Max Clock: %d MHz\n\n", test_chip.max_clock_freq_mhz);
+    rw_printf(&rw, "--- Test Chip Benchmarks ---\n");
+    rw_printf(&rw, "JEDEC ID: %s\n", test_chip.jedec_id);
+    rw_printf(&rw, "Capacity: %.0f Mbit\n", test_chip.capacity_mbit);
+    rw_printf(&rw, "Read Speed (50MHz): %.2f MB/s\n", test_chip.read_speed_max);
+    rw_printf(&rw, "Erase Speed (64KB): %.1f ms\n", test_chip.erase_speed);
+    rw_printf(&rw, "Max Clock: %d MHz\n\n", test_chip.max_clock_freq_mhz);
     
     // Identification Results
-    f_printf(&file, "--- Identification Results ---\n");
+    rw_printf(&rw, "--- Identification Results ---\n");
     
     if (match_results[0].status == MATCH_FOUND) {
-        f_printf(&file, "Status: FOUND (Exact Match)\n");
+        rw_printf(&rw, "Status: FOUND (Exact Match)\n");
     } else if (match_results[0].status == MATCH_BEST_MATCH) {
-        f_printf(&file, "Status: BEST MATCH\n");
+        rw_printf(&rw, "Status: BEST MATCH\n");
     } else {
-        f_printf(&file, "Status: UNKNOWN\n");
+        rw_printf(&rw, "Status: UNKNOWN\n");
     }
     
-    f_printf(&file, "Overall Confidence: %.1f%%\n\n", 
+    rw_printf(&rw, "Overall Confidence: %.1f%%\n\n", 
              match_results[0].confidence.overall_confidence);
     
     // Best Match Details
     if (match_results[0].database_index >= 0) {
-        f_printf(&file, "--- Best Match Details ---\n");
-        f_printf(&file, "Manufacturer: %s\n", match_results[0].chip_data.company);
-        f_printf(&file, "Model: %s\n", match_results[0].chip_data.chip_model);
-        f_printf(&file, "Family: %s\n", match_results[0].chip_data.chip_family);
-        f_printf(&file, "JEDEC ID: %s\n", match_results[0].chip_data.jedec_id);
-        f_printf(&file, "Capacity: %.0f Mbit\n\n", match_results[0].chip_data.capacity_mbit);
+        rw_printf(&rw, "--- Best Match Details ---\n");
+        rw_printf(&rw, "Manufacturer: %s\n", match_results[0].chip_data.company);
+        rw_printf(&rw, "Model: %s\n", match_results[0].chip_data.chip_model);
+        rw_printf(&rw, "Family: %s\n", match_results[0].chip_data.chip_family);
+        rw_printf(&rw, "JEDEC ID: %s\n", match_results[0].chip_data.jedec_id);
+        rw_printf(&rw, "Capacity: %.0f Mbit\n\n", match_results[0].chip_data.capacity_mbit);
         
         // Confidence Breakdown
-        f_printf(&file, "--- Confidence Factor Breakdown ---\n");
+        rw_printf(&rw, "--- Confidence Factor Breakdown ---\n");
         if (match_results[0].confidence.breakdown.jedec_id_available) {
-            f_printf(&file, "JEDEC ID Match (40%% weight): %.0f%%\n", 
+            rw_printf(&rw, "JEDEC ID Match (40%% weight): %.0f%%\n", 
                      match_results[0].confidence.breakdown.jedec_id_score);
         }
         if (match_results[0].confidence.breakdown.read_speed_available) {
-            f_printf(&file, "Read Speed Match (20%% weight): %.0f%%\n", 
+            rw_printf(&rw, "Read Speed Match (20%% weight): %.0f%%\n", 
                      match_results[0].confidence.breakdown.read_speed_score);
         }
         if (match_results[0].confidence.breakdown.erase_speed_available) {
-            f_printf(&file, "Erase Speed Match (10%% weight): %.0f%%\n", 
+            rw_printf(&rw, "Erase Speed Match (10%% weight): %.0f%%\n", 
                      match_results[0].confidence.breakdown.erase_speed_score);
         }
         if (match_results[0].confidence.breakdown.clock_profile_available) {
-            f_printf(&file, "Clock Profile Match (10%% weight): %.0f%%\n", 
+            rw_printf(&rw, "Clock Profile Match (10%% weight): %.0f%%\n", 
                      match_results[0].confidence.breakdown.clock_profile_score);
         }
-        f_printf(&file, "\n");
+        rw_printf(&rw, "\n");
     }
     
     // Top 3 Matches
-    f_printf(&file, "--- Top 3 Candidate Matches ---\n");
+    rw_printf(&rw, "--- Top 3 Candidate Matches ---\n");
     for (int i = 0; i < TOP_MATCHES_COUNT; i++) {
         if (match_results[i].database_index >= 0) {
-            f_printf(&file, "%d. %s %s (%.1f%% confidence)\n",
+            rw_printf(&rw, "%d. %s %s (%.1f%% confidence)\n",
                      i + 1,
                      match_results[i].chip_data.company,
                      match_results[i].chip_data.chip_model,
                      match_results[i].confidence.overall_confidence);
         }
     }
-    f_printf(&file, "\n");
+    rw_printf(&rw, "\n");
     
     // Warnings
     if (match_results[0].has_outliers) {
-        f_printf(&file, "--- Warnings ---\n");
-        f_printf(&file, "WARNING_PERFORMANCE_OUTLIER: Significant performance deviations detected\n");
+        rw_printf(&rw, "--- Warnings ---\n");
+        rw_printf(&rw, "WARNING_PERFORMANCE_OUTLIER: Significant performance deviations detected\n");
     }
     if (strlen(match_results[0].confidence.warning_message) > 0) {
-        f_printf(&file, "%s\n", match_results[0].confidence.warning_message);
+        rw_printf(&rw, "%s\n", match_results[0].confidence.warning_message);
     }
     
-    f_printf(&file, "\n========================================\n");
-    f_printf(&file, "End of Report\n");
-    f_printf(&file, "========================================\n");
+    rw_printf(&rw, "\n========================================\n");
+    rw_printf(&rw, "End of Report\n");
+    rw_printf(&rw, "========================================\n");
     
+    bool ok = rw_finish(&rw);
     f_close(&file);
+    if (!ok) {
+        printf("[ERROR] ERROR_SD_WRITE_FAIL: Report write failed\n");
+        return ERROR_SD_WRITE_FAIL;
+    }
     
     printf("✓ Forensic report saved: %s\n", filename);
     return SUCCESS;
 }
+
+// ============================================================================
+// Report writer before/after benchmark
+// ============================================================================
+
+// The forensic report's field set, emitted through either writer so both
+// paths format byte-identical output.
+#define REPORT_BENCH_BODY(EMIT, dst)                                                   \
+    do {                                                                               \
+        EMIT(dst, "========================================\n");                      \
+        EMIT(dst, "  FLASH CHIP FORENSIC IDENTIFICATION REPORT\n");                   \
+        EMIT(dst, "========================================\n");                      \
+        EMIT(dst, "Generated: %04d-%02d-%02d %02d:%02d:%02d\n\n", 2024, 1, 1, 0, 0, 0); \
+        EMIT(dst, "--- Test Chip Benchmarks ---\n");                                  \
+        EMIT(dst, "JEDEC ID: %s\n", test_chip.jedec_id);                              \
+        EMIT(dst, "Capacity: %.0f Mbit\n", test_chip.capacity_mbit);                  \
+        EMIT(dst, "Read Speed (50MHz): %.2f MB/s\n", test_chip.read_speed_max);       \
+        EMIT(dst, "Erase Speed (64KB): %.1f ms\n", test_chip.erase_speed);            \
+        EMIT(dst, "Max Clock: %d MHz\n\n", test_chip.max_clock_freq_mhz);             \
+        for (int _i = 0; _i < TOP_MATCHES_COUNT; _i++) {                               \
+            EMIT(dst, "Manufacturer: %s\n", match_results[_i].chip_data.company);     \
+            EMIT(dst, "Model: %s\n", match_results[_i].chip_data.chip_model);         \
+            EMIT(dst, "Family: %s\n", match_results[_i].chip_data.chip_family);       \
+            EMIT(dst, "JEDEC ID: %s\n", match_results[_i].chip_data.jedec_id);        \
+            EMIT(dst, "Capacity: %.0f Mbit\n", match_results[_i].chip_data.capacity_mbit); \
+            EMIT(dst, "JEDEC ID Match (40%% weight): %.0f%%\n",                       \
+                 match_results[_i].confidence.breakdown.jedec_id_score);               \
+            EMIT(dst, "Read Speed Match (20%% weight): %.0f%%\n",                     \
+                 match_results[_i].confidence.breakdown.read_speed_score);             \
+            EMIT(dst, "Erase Speed Match (10%% weight): %.0f%%\n",                    \
+                 match_results[_i].confidence.breakdown.erase_speed_score);            \
+            EMIT(dst, "%d. %s %s (%.1f%% confidence)\n", _i + 1,                      \
+                 match_results[_i].chip_data.company,                                  \
+                 match_results[_i].chip_data.chip_model,                               \
+                 match_results[_i].confidence.overall_confidence);                     \
+        }                                                                              \
+        EMIT(dst, "\n========================================\n");                    \
+        EMIT(dst, "End of Report\n");                                                 \
+        EMIT(dst, "========================================\n");                      \
+    } while (0)
+
+// Times report generation through the legacy per-field f_printf() path and
+// through the buffered writer, `iterations` reports each, into a scratch file.
+void sd_benchmark_report_writer(int iterations) {
+    const char *scratch = "Report/_rw_bench.tmp";
+    FIL file;
+    f_mkdir("Report");
+
+    printf("\n====================================\n");
+    printf("  Report Writer Benchmark (%d reports)\n", iterations);
+    printf("====================================\n");
+
+    // Before: one f_printf() per field
+    if (f_open(&file, scratch, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+        printf("[ERROR] ERROR_FILE_WRITE_FAIL: Cannot create %s\n", scratch);
+        return;
+    }
+    uint64_t t0 = time_us_64();
+    for (int i = 0; i < iterations; i++) {
+        REPORT_BENCH_BODY(f_printf, &file);
+    }
+    f_sync(&file);
+    uint64_t t_legacy = time_us_64() - t0;
+    FSIZE_t legacy_size = f_size(&file);
+    f_close(&file);
+
+    // After: format into the arena, whole-sector f_write()
+    if (f_open(&file, scratch, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+        printf("[ERROR] ERROR_FILE_WRITE_FAIL: Cannot create %s\n", scratch);
+        return;
+    }
+    report_writer_t rw;
+    rw_init(&rw, &file, g_report_arena, sizeof(g_report_arena));
+    t0 = time_us_64();
+    for (int i = 0; i < iterations; i++) {
+        REPORT_BENCH_BODY(rw_printf, &rw);
+    }
+    rw_finish(&rw);
+    f_sync(&file);
+    uint64_t t_buffered = time_us_64() - t0;
+    FSIZE_t buffered_size = f_size(&file);
+    f_close(&file);
+    f_unlink(scratch);
+
+    printf("path       | total(us)  | per report(us) | bytes\n");
+    printf("-----------+------------+----------------+--------\n");
+    printf("f_printf   | %10llu | %14.1f | %llu\n", (unsigned long long)t_legacy,
+           (double)t_legacy / iterations, (unsigned long long)legacy_size);
+    printf("buffered   | %10llu | %14.1f | %llu (%u f_write)\n", (unsigned long long)t_buffered,
+           (double)t_buffered / iterations, (unsigned long long)buffered_size, (unsigned)rw.writes);
+    if (t_buffered > 0) {
+        printf("Speed-up: %.1fx\n", (double)t_legacy / (double)t_buffered);
+    }
+    if (legacy_size != buffered_size) {
+        printf("[WARNING] Output size differs between paths\n");
+    }
+}
@@ -6,6 +6,7 @@
 #define SD_FUNCTIONS_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "identification.h"
 #include "ff.h"
 
@@ -16,7 +17,9 @@
 
 // Constants
 #define MAX_LINE_LENGTH 512
-#define MAX_DATABASE_ENTRIES 100
+#ifndef MAX_DATABASE_ENTRIES
+#define MAX_DATABASE_ENTRIES 100     // Host benches build with larger catalogs
+#endif
 #define MIN_SD_FREE_SPACE_MB 1
 
 // Error codes
@@ -47,8 +50,12 @@ bool validate_jedec_format(const char* jedec);
 bool is_power_of_two(float capacity);
 void get_timestamp(int* year, int* month, int* day, int* hour, int* min, int* sec);
 bool check_sd_free_space(void);
+bool sd_free_space_prime(void);
+void sd_free_space_reset(void);
+bool sd_free_space_get(uint64_t *free_bytes);
 int sd_load_chip_database(void);
 int sd_log_benchmark_results(void);
 int sd_create_forensic_report(void);
+void sd_benchmark_report_writer(int iterations);
 
 #endif // SD_FUNCTIONS_H
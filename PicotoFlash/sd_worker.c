@@ -0,0 +1,89 @@
+/*
+ * SD Writer Task Module
+ * Job queue in front of FatFs, served by a single task
+ */
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "sd_worker.h"
+#include "task.h"
+#include "queue.h"
+#include "sd_functions.h"
+#include "span_trace.h"
+
+typedef struct {
+    sd_job_fn fn;
+    void *arg;
+    SemaphoreHandle_t done;     // Given after the job ran (may be NULL)
+    TaskHandle_t notify;        // Notified after the job ran (sd_worker_call)
+    int *result;
+} sd_job_t;
+
+static QueueHandle_t g_sd_queue = NULL;
+static TaskHandle_t g_sd_task = NULL;
+
+static void sd_worker_task(void *param) {
+    (void)param;
+    sd_job_t job;
+    for (;;) {
+        if (xQueueReceive(g_sd_queue, &job, portMAX_DELAY) != pdTRUE) continue;
+        uint32_t t0 = time_us_32();
+        int rc = job.fn ? job.fn(job.arg) : SUCCESS;
+        span_complete("sd_job", (uint32_t)(uintptr_t)job.fn, true, t0);
+        if (job.result) *job.result = rc;
+        if (job.done) xSemaphoreGive(job.done);
+        if (job.notify) xTaskNotifyGive(job.notify);
+    }
+}
+
+bool sd_worker_start(UBaseType_t priority, UBaseType_t core_mask) {
+    g_sd_queue = xQueueCreate(SD_WORKER_QUEUE_DEPTH, sizeof(sd_job_t));
+    if (!g_sd_queue) return false;
+    if (xTaskCreateAffinitySet(sd_worker_task, "sd", SD_WORKER_STACK_WORDS, NULL,
+                               priority, core_mask, &g_sd_task) != pdPASS) {
+        printf("[ERROR] Cannot create SD writer task\n");
+        return false;
+    }
+    return true;
+}
+
+bool sd_worker_in_context(void) {
+    return g_sd_task != NULL && xTaskGetCurrentTaskHandle() == g_sd_task;
+}
+
+// Runs `fn` on the SD task and waits for it. Called from the SD task itself
+// (a job that needs another job) or before the scheduler runs, it executes
+// inline instead of deadlocking on its own queue.
+int sd_worker_call(sd_job_fn fn, void *arg) {
+    if (g_sd_task == NULL || sd_worker_in_context() ||
+        xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) {
+        return fn(arg);
+    }
+
+    int rc = SUCCESS;
+    sd_job_t job = {fn, arg, NULL, xTaskGetCurrentTaskHandle(), &rc};
+    uint32_t t0 = time_us_32();
+    xTaskNotifyStateClear(NULL);
+    xQueueSend(g_sd_queue, &job, portMAX_DELAY);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    span_complete("sd_wait", (uint32_t)(uintptr_t)fn, true, t0);
+    return rc;
+}
+
+// Queues `fn` and returns. Blocks only while the queue is full, which is
+// the back-pressure that keeps a fast producer in step with the card.
+bool sd_worker_post(sd_job_fn fn, void *arg, SemaphoreHandle_t done, int *result) {
+    if (g_sd_queue == NULL) return false;
+    sd_job_t job = {fn, arg, done, NULL, result};
+    return xQueueSend(g_sd_queue, &job, portMAX_DELAY) == pdTRUE;
+}
+
+static int drain_job(void *arg) {
+    (void)arg;
+    return SUCCESS;
+}
+
+// Waits until every job queued before this call has finished
+void sd_worker_drain(void) {
+    sd_worker_call(drain_job, NULL);
+}
@@ -0,0 +1,31 @@
+/*
+ * SD Writer Task Module Header
+ * One FreeRTOS task owns the SD card's volume-level operations (mount,
+ * unmount, database load) and performs all bulk writes (backup image,
+ * logs, reports) so the flash worker never waits on SPI1. Other tasks hand
+ * it jobs: sd_worker_call() blocks until the job ran, sd_worker_post()
+ * returns immediately and signals an optional semaphore when done.
+ */
+
+#ifndef SD_WORKER_H
+#define SD_WORKER_H
+
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+// Constants
+#define SD_WORKER_QUEUE_DEPTH 8
+#define SD_WORKER_STACK_WORDS 2048
+
+// Job body; the return value is handed back to the caller (SUCCESS/ERROR_*)
+typedef int (*sd_job_fn)(void *arg);
+
+// Function declarations
+bool sd_worker_start(UBaseType_t priority, UBaseType_t core_mask);
+bool sd_worker_in_context(void);
+int sd_worker_call(sd_job_fn fn, void *arg);
+bool sd_worker_post(sd_job_fn fn, void *arg, SemaphoreHandle_t done, int *result);
+void sd_worker_drain(void);
+
+#endif // SD_WORKER_H
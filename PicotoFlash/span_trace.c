@@ -0,0 +1,235 @@
+/*
+ * Flow Span Trace Module
+ * Span events filled from any task under the kernel's critical section into
+ * a pool checkout held from span_trace_start() to span_trace_stop(), then
+ * rendered as Chrome trace JSON by the SD writer once the flow's reports
+ * are out.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "ff.h"
+#include "sd_functions.h"
+#include "sd_worker.h"
+#include "report_writer.h"
+#include "buf_pool.h"
+#include "span_trace.h"
+
+volatile bool g_span_trace_on = false;
+
+static span_event_t *g_events;          // Pool checkout while tracing
+static uint32_t g_count;
+static uint32_t g_dropped;
+static uint32_t g_start_us;
+static TaskHandle_t g_tasks[SPAN_TRACE_TASKS];
+static uint8_t g_task_cores[SPAN_TRACE_TASKS];  // Bit per core the task recorded on
+static int16_t g_last_x[SPAN_TRACE_TASKS];      // Task's latest 'X', merge candidate
+
+// ============================================================================
+// Recording
+// ============================================================================
+
+// Caller holds the critical section; slot SPAN_TRACE_TASKS when the table is full
+static uint8_t task_slot(void) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (uint8_t i = 0; i < SPAN_TRACE_TASKS; i++) {
+        if (g_tasks[i] == self) return i;
+        if (g_tasks[i] == NULL) {
+            g_tasks[i] = self;
+            return i;
+        }
+    }
+    return SPAN_TRACE_TASKS;
+}
+
+static span_event_t *alloc_event(uint8_t slot) {
+    if (slot >= SPAN_TRACE_TASKS || g_count >= SPAN_TRACE_EVENTS) {
+        g_dropped++;
+        return NULL;
+    }
+    span_event_t *e = &g_events[g_count++];
+    memset(e, 0, sizeof(*e));
+    e->core = (uint8_t)get_core_num();
+    e->task = slot;
+    g_task_cores[slot] |= (uint8_t)(1u << e->core);
+    return e;
+}
+
+void span_record(uint8_t ph, const char *name, uint32_t arg, bool has_arg) {
+    uint32_t now = time_us_32();
+    taskENTER_CRITICAL();
+    if (g_span_trace_on) {
+        span_event_t *e = alloc_event(task_slot());
+        if (e) {
+            g_last_x[e->task] = -1;     // A begin/end/mark closes the task's burst
+            e->t_us = now;
+            e->name = name;
+            e->ph = ph;
+            e->arg = arg;
+            e->has_arg = has_arg;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+void span_complete_slow(const char *name, uint32_t arg, bool arg_is_addr, uint32_t t0_us) {
+    uint32_t now = time_us_32();
+    taskENTER_CRITICAL();
+    if (g_span_trace_on) {
+        uint8_t slot = task_slot();
+        span_event_t *prev = NULL;
+        if (slot < SPAN_TRACE_TASKS && g_last_x[slot] >= 0) prev = &g_events[g_last_x[slot]];
+        if (prev && prev->name == name && prev->arg == arg && prev->count < UINT16_MAX &&
+            t0_us - (prev->t_us + prev->dur_us) < SPAN_TRACE_MERGE_GAP_US) {
+            prev->dur_us = now - prev->t_us;
+            prev->busy_us += now - t0_us;
+            prev->count++;
+        } else {
+            span_event_t *e = alloc_event(slot);
+            if (e) {
+                e->t_us = t0_us;
+                e->dur_us = now - t0_us;
+                e->busy_us = e->dur_us;
+                e->name = name;
+                e->ph = 'X';
+                e->arg = arg;
+                e->has_arg = true;
+                e->arg_is_addr = arg_is_addr;
+                e->count = 1;
+                g_last_x[slot] = (int16_t)(e - g_events);
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+// ============================================================================
+// Chrome trace output
+// ============================================================================
+
+typedef struct {
+    const uint8_t *jedec;
+} write_req_t;
+
+static void write_event(report_writer_t *rw, const span_event_t *e, bool first) {
+    rw_printf(rw, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lu,\"pid\":%u,\"tid\":%u", first ? "" : ",\n",
+              e->name, e->ph, (unsigned long)(e->t_us - g_start_us), e->core, e->task);
+    if (e->ph == 'X') {
+        rw_printf(rw, ",\"dur\":%lu,\"args\":{\"n\":%u,\"busy_us\":%lu", (unsigned long)e->dur_us, e->count,
+                  (unsigned long)e->busy_us);
+        if (e->arg_is_addr) {
+            rw_printf(rw, ",\"fn\":\"0x%08lx\"}", (unsigned long)e->arg);
+        } else {
+            rw_printf(rw, ",\"arg\":%lu}", (unsigned long)e->arg);
+        }
+    } else if (e->ph == 'i') {
+        rw_puts(rw, ",\"s\":\"t\"");
+    } else if (e->has_arg) {
+        rw_printf(rw, ",\"args\":{\"arg\":%lu}", (unsigned long)e->arg);
+    }
+    rw_puts(rw, "}");
+}
+
+static int write_job(void *arg) {
+    const write_req_t *req = (const write_req_t *)arg;
+    int year, month, day, hour, min, sec;
+    char path[64];
+
+    get_timestamp(&year, &month, &day, &hour, &min, &sec);
+    snprintf(path, sizeof(path), SPAN_TRACE_FILE, year, month, day, hour, min, sec);
+    f_mkdir(SPAN_TRACE_DIR);
+
+    char *arena = buf_pool_get(REPORT_ARENA_SIZE, "span_trace");
+    if (!arena) {
+        return ERROR_FILE_WRITE_FAIL;
+    }
+    FIL file;
+    if (f_open(&file, path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK) {
+        printf("[WARN] Span trace: cannot create %s\n", path);
+        buf_pool_put(arena);
+        return ERROR_FILE_WRITE_FAIL;
+    }
+    report_writer_t rw;
+    rw_init(&rw, &file, arena, REPORT_ARENA_SIZE);
+
+    rw_puts(&rw, "{\"traceEvents\":[\n");
+    bool first = true;
+    uint8_t cores = 0;
+    for (uint8_t i = 0; i < SPAN_TRACE_TASKS; i++) cores |= g_task_cores[i];
+    for (uint8_t c = 0; c < 8; c++) {
+        if (!(cores & (1u << c))) continue;
+        rw_printf(&rw, "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"args\":{\"name\":\"core %u\"}}",
+                  first ? "" : ",\n", c, c);
+        first = false;
+    }
+    for (uint8_t i = 0; i < SPAN_TRACE_TASKS && g_tasks[i]; i++) {
+        for (uint8_t c = 0; c < 8; c++) {
+            if (!(g_task_cores[i] & (1u << c))) continue;
+            rw_printf(&rw, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                      c, i, pcTaskGetName(g_tasks[i]));
+        }
+    }
+    for (uint32_t i = 0; i < g_count; i++) {
+        write_event(&rw, &g_events[i], first);
+        first = false;
+    }
+    rw_puts(&rw, "\n],\n\"displayTimeUnit\":\"ms\",\n");
+    rw_printf(&rw, "\"otherData\":{\"jedec\":\"%02X %02X %02X\",\"clk_sys_hz\":%lu,\"events\":%lu,\"dropped\":%lu}}\n",
+              req->jedec[0], req->jedec[1], req->jedec[2], (unsigned long)clock_get_hz(clk_sys),
+              (unsigned long)g_count, (unsigned long)g_dropped);
+
+    bool ok = rw_finish(&rw);
+    ok = (f_close(&file) == FR_OK) && ok;
+    buf_pool_put(arena);
+    if (!ok) {
+        printf("[WARN] Span trace: write to %s failed\n", path);
+        return ERROR_FILE_WRITE_FAIL;
+    }
+    printf("[INFO] Span trace -> %s (%lu events, %lu dropped)\n", path, (unsigned long)g_count,
+           (unsigned long)g_dropped);
+    return SUCCESS;
+}
+
+// ============================================================================
+// Control
+// ============================================================================
+
+void span_trace_start(void) {
+    if (!g_events) {
+        g_events = (span_event_t *)buf_pool_get(SPAN_TRACE_EVENTS * sizeof(span_event_t), "span_trace");
+        if (!g_events) {
+            printf("[WARN] Span trace: no buffer, flow not traced\n");
+            return;
+        }
+    }
+    taskENTER_CRITICAL();
+    g_count = 0;
+    g_dropped = 0;
+    memset(g_tasks, 0, sizeof(g_tasks));
+    memset(g_task_cores, 0, sizeof(g_task_cores));
+    for (int i = 0; i < SPAN_TRACE_TASKS; i++) g_last_x[i] = -1;
+    g_start_us = time_us_32();
+    g_span_trace_on = true;
+    taskEXIT_CRITICAL();
+}
+
+// Stops recording; with write_file the events are rendered to the card by
+// the SD writer (mounted card required)
+void span_trace_stop(const uint8_t jedec[3], bool write_file) {
+    if (!g_span_trace_on) return;
+    taskENTER_CRITICAL();
+    g_span_trace_on = false;
+    taskEXIT_CRITICAL();
+    if (write_file) {
+        static const uint8_t k_none[3] = {0};
+        write_req_t req = {jedec ? jedec : k_none};
+        sd_worker_call(write_job, &req);
+    }
+    buf_pool_put(g_events);
+    g_events = NULL;
+}
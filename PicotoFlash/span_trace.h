@@ -0,0 +1,89 @@
+/*
+ * Flow Span Trace Module Header
+ * Begin/end timing spans from every task, recorded into a buffer checked out
+ * of the pool for the duration of a GP20 flow and written to Trace/flow_*.json as a Chrome trace
+ * (chrome://tracing, ui.perfetto.dev): one process per core, one thread
+ * per task.
+ *
+ * span_begin()/span_end() nest per task. span_complete() records a span
+ * after the fact and folds it into the task's previous one when the name
+ * and argument match, the gap is short and the task recorded nothing in
+ * between, so per-chunk events (SD jobs, backup slot waits) cost one
+ * record per burst rather than one per chunk.
+ * All calls cost one load and branch while no flow is being traced.
+ */
+
+#ifndef SPAN_TRACE_H
+#define SPAN_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// File definitions
+#define SPAN_TRACE_DIR "Trace"
+#define SPAN_TRACE_FILE "Trace/flow_%04d%02d%02d_%02d%02d%02d.json"
+
+// Build flags
+#ifndef FLOW_SPAN_TRACE
+#define FLOW_SPAN_TRACE 1               // 1 = write each GP20 flow's timing spans to Trace/flow_*.json
+#endif
+
+// Constants
+#define SPAN_TRACE_EVENTS 256           // Per flow (a full flow records ~200); later events are dropped (counted)
+#define SPAN_TRACE_TASKS 8
+#define SPAN_TRACE_MERGE_GAP_US 250000  // span_complete() bursts closer than this merge
+
+// One event (28 bytes)
+typedef struct {
+    uint32_t t_us;
+    uint32_t dur_us;                // 'X' only
+    uint32_t busy_us;               // 'X': summed durations of the merged spans
+    const char *name;               // String literal
+    uint32_t arg;
+    uint16_t count;                 // 'X': spans merged into this one
+    uint8_t ph;                     // 'B', 'E', 'X', 'i'
+    uint8_t core;
+    uint8_t task;                   // Slot in the task table
+    uint8_t has_arg;
+    uint8_t arg_is_addr;            // Printed as hex (SD job functions)
+} span_event_t;
+
+// Pool blocks reserved for the event buffer (buf_pool.h)
+#if FLOW_SPAN_TRACE
+#define SPAN_TRACE_POOL_BYTES (SPAN_TRACE_EVENTS * sizeof(span_event_t))
+#else
+#define SPAN_TRACE_POOL_BYTES 0u
+#endif
+
+extern volatile bool g_span_trace_on;
+
+// Function declarations
+void span_trace_start(void);
+void span_trace_stop(const uint8_t jedec[3], bool write_file);
+
+void span_record(uint8_t ph, const char *name, uint32_t arg, bool has_arg);
+void span_complete_slow(const char *name, uint32_t arg, bool arg_is_addr, uint32_t t0_us);
+
+static inline void span_begin(const char *name) {
+    if (g_span_trace_on) span_record('B', name, 0, false);
+}
+
+// Begin with a numeric argument (size, MHz, ...) shown in the trace viewer
+static inline void span_begin_n(const char *name, uint32_t arg) {
+    if (g_span_trace_on) span_record('B', name, arg, true);
+}
+
+static inline void span_end(const char *name) {
+    if (g_span_trace_on) span_record('E', name, 0, false);
+}
+
+static inline void span_mark(const char *name) {
+    if (g_span_trace_on) span_record('i', name, 0, false);
+}
+
+// A span that started at t0_us (time_us_32()) and ends now
+static inline void span_complete(const char *name, uint32_t arg, bool arg_is_addr, uint32_t t0_us) {
+    if (g_span_trace_on) span_complete_slow(name, arg, arg_is_addr, t0_us);
+}
+
+#endif // SPAN_TRACE_H
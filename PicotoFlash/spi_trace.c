@@ -0,0 +1,272 @@
+/*
+ * SPI Transaction Trace Module
+ * RAM ring of 16-byte transaction records in two halves, checked out of the
+ * buffer pool for the length of a trace: while one half fills, the SD
+ * worker appends the other to Trace/spi_*.bin in a single 4 KiB write. A half that fills while the SD worker still owns the other
+ * one drops records (counted) rather than stalling the flash bus.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "ff.h"
+#include "spi.h"
+#include "sd_functions.h"
+#include "sd_worker.h"
+#include "buf_pool.h"
+#include "spi_trace.h"
+
+#define HALF (SPI_TRACE_RING / 2)
+
+volatile bool g_spi_trace_on = false;
+
+static spi_trace_rec_t *g_ring;         // Pool checkout while tracing
+static uint32_t g_fill_half;
+static uint32_t g_fill_idx;
+static volatile bool g_half_busy[2];    // Full, waiting for or in an SD write
+static volatile uint8_t g_flush_owed;   // Halves that filled inside the SD worker
+static FIL g_file;
+static bool g_file_open;
+static spi_trace_stats_t g_stats;
+
+// Flash transaction being assembled (flash worker only)
+static struct {
+    bool active;
+    uint32_t t_us;
+    uint8_t hdr[SPI_TRACE_HDR_BYTES];
+    uint8_t nhdr;
+    uint32_t len;
+    uint32_t hz;
+    uint8_t flags;
+} g_cur;
+
+// ============================================================================
+// SD side
+// ============================================================================
+
+static int flush_job(void *arg) {
+    uint32_t h = (uint32_t)(uintptr_t)arg;
+    UINT bw = 0;
+    if (g_file_open && f_write(&g_file, &g_ring[h * HALF], HALF * sizeof(spi_trace_rec_t), &bw) == FR_OK &&
+        bw == HALF * sizeof(spi_trace_rec_t)) {
+        g_stats.bytes_written += bw;
+        g_stats.flushes++;
+    } else {
+        g_stats.write_error = true;
+    }
+    g_half_busy[h] = false;
+    return SUCCESS;
+}
+
+static void post_flush(uint32_t h) {
+    if (!sd_worker_post(flush_job, (void *)(uintptr_t)h, NULL, NULL)) g_half_busy[h] = false;
+}
+
+static void push(const spi_trace_rec_t *r) {
+    int post = -1;
+    uint8_t owed = 0;
+    bool in_sd = sd_worker_in_context();
+
+    taskENTER_CRITICAL();
+    if (g_half_busy[g_fill_half]) {
+        g_stats.dropped++;
+    } else {
+        g_ring[g_fill_half * HALF + g_fill_idx] = *r;
+        g_stats.records++;
+        if (++g_fill_idx == HALF) {
+            g_half_busy[g_fill_half] = true;
+            if (in_sd) g_flush_owed |= (uint8_t)(1u << g_fill_half);
+            else post = (int)g_fill_half;
+            g_fill_half ^= 1u;
+            g_fill_idx = 0;
+        }
+    }
+    if (!in_sd) {
+        owed = g_flush_owed;
+        g_flush_owed = 0;
+    }
+    taskEXIT_CRITICAL();
+
+    // The SD worker cannot queue work for itself; the next flash record does
+    for (uint32_t h = 0; h < 2; h++) {
+        if (owed & (1u << h)) post_flush(h);
+    }
+    if (post >= 0) post_flush((uint32_t)post);
+}
+
+// FatFs_SPI hook: one record per SD transfer
+static void sd_transfer_hook(spi_t *spi_p, const uint8_t *tx, size_t length, uint32_t start_us) {
+    if (!g_spi_trace_on) return;
+    spi_trace_rec_t r = {0};
+    uint32_t nhdr = 0;
+    r.t_us = start_us;
+    if (tx) {
+        for (; nhdr < SPI_TRACE_HDR_BYTES && nhdr < length; nhdr++) {
+            r.op_addr |= (uint32_t)tx[nhdr] << (24 - 8 * nhdr);
+        }
+    }
+    uint32_t dur = time_us_32() - start_us;
+    r.cs = spi_trace_cs_encode(dur);
+    r.sck_100khz = (uint16_t)(spi_get_baudrate(spi_p->hw_inst) / 100000u);
+    r.len_flags = (uint32_t)(length > SPI_TRACE_LEN_MAX ? SPI_TRACE_LEN_MAX : length) |
+                  ((uint32_t)(SPI_TRACE_F_SD | (nhdr << SPI_TRACE_F_HDR_SHIFT)) << 24);
+    push(&r);
+}
+
+static int open_job(void *arg) {
+    bool *ok = (bool *)arg;
+    int year, month, day, hour, min, sec;
+    char path[64];
+
+    get_timestamp(&year, &month, &day, &hour, &min, &sec);
+    snprintf(path, sizeof(path), SPI_TRACE_FILE, year, month, day, hour, min, sec);
+    f_mkdir(SPI_TRACE_DIR);
+    if (f_open(&g_file, path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK) {
+        printf("[WARN] SPI trace: cannot create %s\n", path);
+        return ERROR_FILE_WRITE_FAIL;
+    }
+
+    spi_trace_file_hdr_t hdr = {0};
+    hdr.magic = SPI_TRACE_MAGIC;
+    hdr.version = SPI_TRACE_VERSION;
+    hdr.record_size = sizeof(spi_trace_rec_t);
+    hdr.clk_sys_hz = clock_get_hz(clk_sys);
+    hdr.start_us = time_us_32();
+    hdr.header_size = sizeof(hdr);
+    UINT bw = 0;
+    if (f_write(&g_file, &hdr, sizeof(hdr), &bw) != FR_OK || bw != sizeof(hdr)) {
+        f_close(&g_file);
+        return ERROR_FILE_WRITE_FAIL;
+    }
+    g_file_open = true;
+    *ok = true;
+    printf("[INFO] SPI trace -> %s\n", path);
+    return SUCCESS;
+}
+
+// Owed full halves, then the partial one, the JEDEC ID into the header,
+// then close
+static int close_job(void *arg) {
+    const uint8_t *jedec = (const uint8_t *)arg;
+    for (uint32_t h = 0; h < 2; h++) {
+        if (g_flush_owed & (1u << h)) flush_job((void *)(uintptr_t)h);
+    }
+    g_flush_owed = 0;
+    if (!g_file_open) return SUCCESS;
+
+    UINT bw = 0;
+    size_t n = g_fill_idx * sizeof(spi_trace_rec_t);
+    if (n && (f_write(&g_file, &g_ring[g_fill_half * HALF], (UINT)n, &bw) != FR_OK || bw != n)) {
+        g_stats.write_error = true;
+    }
+    g_stats.bytes_written += bw;
+    if (jedec && f_lseek(&g_file, offsetof(spi_trace_file_hdr_t, jedec)) == FR_OK) {
+        f_write(&g_file, jedec, 3, &bw);
+    }
+    if (f_close(&g_file) != FR_OK) g_stats.write_error = true;
+    g_file_open = false;
+    return SUCCESS;
+}
+
+// ============================================================================
+// Control
+// ============================================================================
+
+bool spi_trace_start(bool sd_bus) {
+    if (g_spi_trace_on) return true;
+    memset(&g_stats, 0, sizeof(g_stats));
+    memset(&g_cur, 0, sizeof(g_cur));
+    g_fill_half = 0;
+    g_fill_idx = 0;
+    g_half_busy[0] = g_half_busy[1] = false;
+    g_flush_owed = 0;
+
+    g_ring = (spi_trace_rec_t *)buf_pool_get(SPI_TRACE_RING * sizeof(spi_trace_rec_t), "spi_trace");
+    if (!g_ring) return false;
+    bool ok = false;
+    sd_worker_call(open_job, &ok);
+    if (!ok) {
+        buf_pool_put(g_ring);
+        g_ring = NULL;
+        return false;
+    }
+
+    spi_transfer_hook = sd_bus ? sd_transfer_hook : NULL;
+    g_spi_trace_on = true;
+    return true;
+}
+
+void spi_trace_stop(const uint8_t jedec[3]) {
+    if (!g_spi_trace_on) return;
+    g_spi_trace_on = false;
+    spi_transfer_hook = NULL;
+    sd_worker_drain();
+    sd_worker_call(close_job, (void *)jedec);
+    buf_pool_put(g_ring);
+    g_ring = NULL;
+    printf("[INFO] SPI trace: %lu records, %lu dropped, %lu bytes%s\n", (unsigned long)g_stats.records,
+           (unsigned long)g_stats.dropped, (unsigned long)g_stats.bytes_written,
+           g_stats.write_error ? " (write error)" : "");
+}
+
+spi_trace_stats_t spi_trace_get_stats(void) {
+    return g_stats;
+}
+
+// ============================================================================
+// Flash transport hooks
+// ============================================================================
+
+static void finish_cur(void) {
+    spi_trace_rec_t r;
+    uint32_t dur = time_us_32() - g_cur.t_us;
+    r.t_us = g_cur.t_us;
+    r.op_addr = 0;
+    for (uint32_t i = 0; i < g_cur.nhdr; i++) r.op_addr |= (uint32_t)g_cur.hdr[i] << (24 - 8 * i);
+    r.len_flags = (g_cur.len > SPI_TRACE_LEN_MAX ? SPI_TRACE_LEN_MAX : g_cur.len) |
+                  ((uint32_t)(g_cur.flags | (g_cur.nhdr << SPI_TRACE_F_HDR_SHIFT)) << 24);
+    r.cs = spi_trace_cs_encode(dur);
+    r.sck_100khz = (uint16_t)(g_cur.hz / 100000u);
+    g_cur.active = false;
+    push(&r);
+}
+
+void spi_trace_cs_slow(bool asserted) {
+    if (g_cur.active) finish_cur();
+    if (asserted) {
+        memset(&g_cur, 0, sizeof(g_cur));
+        g_cur.active = true;
+        g_cur.t_us = time_us_32();
+    }
+}
+
+void spi_trace_bytes_slow(const uint8_t *tx, size_t n, uint32_t hz, uint8_t flags) {
+    // Bytes without a CS edge we saw (raw gpio_put callers) open their own record
+    if (!g_cur.active) {
+        memset(&g_cur, 0, sizeof(g_cur));
+        g_cur.active = true;
+        g_cur.t_us = time_us_32();
+    }
+    if (tx && g_cur.len == g_cur.nhdr) {
+        for (size_t i = 0; i < n && g_cur.nhdr < SPI_TRACE_HDR_BYTES; i++) g_cur.hdr[g_cur.nhdr++] = tx[i];
+    }
+    g_cur.len += (uint32_t)n;
+    g_cur.hz = hz;
+    g_cur.flags |= flags;
+}
+
+void spi_trace_queued_slow(uint8_t opcode, uint32_t addr, uint32_t bytes, uint32_t t0_us, uint32_t hz) {
+    spi_trace_rec_t r;
+    uint32_t dur = time_us_32() - t0_us;
+    r.t_us = t0_us;
+    r.op_addr = ((uint32_t)opcode << 24) | (addr & 0x00FFFFFFu);
+    r.len_flags = (bytes > SPI_TRACE_LEN_MAX ? SPI_TRACE_LEN_MAX : bytes) |
+                  ((uint32_t)(SPI_TRACE_F_QUEUED | SPI_TRACE_F_PIO | (4u << SPI_TRACE_F_HDR_SHIFT)) << 24);
+    r.cs = spi_trace_cs_encode(dur);
+    r.sck_100khz = (uint16_t)(hz / 100000u);
+    push(&r);
+}
@@ -0,0 +1,134 @@
+/*
+ * SPI Transaction Trace Module Header
+ * Records every flash-bus transaction (one record per CS assertion: first
+ * opcode/address bytes, byte count, CS low time, SCK) into a RAM ring,
+ * checked out of the pool while a trace runs, and streams full ring halves
+ * to SD through the SD worker. Optionally also
+ * records SD-bus transfers via the FatFs_SPI spi_transfer hook.
+ *
+ * The transports call the spi_trace_*() inlines below; they cost one load
+ * and branch while no trace is running. tools/hostsim/spi_trace_tool
+ * decodes a trace, summarises bus time and replays it against the NOR model.
+ */
+
+#ifndef SPI_TRACE_H
+#define SPI_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "hardware/spi.h"
+
+// File definitions
+#define SPI_TRACE_DIR "Trace"
+#define SPI_TRACE_FILE "Trace/spi_%04d%02d%02d_%02d%02d%02d.bin"
+
+// Build flags
+#ifndef SPI_TRACE_FLOW
+#define SPI_TRACE_FLOW 0                // 1 = record each GP20 flow's flash bus to Trace/spi_*.bin
+#endif
+#ifndef SPI_TRACE_SD_BUS
+#define SPI_TRACE_SD_BUS 0              // 1 = ...and the SD card's transfers in the same trace
+#endif
+
+// Constants
+#define SPI_TRACE_MAGIC 0x54534650u     // "PFST"
+#define SPI_TRACE_VERSION 1
+#define SPI_TRACE_RING 512              // Records; flushed a half (4 KiB) at a time
+#define SPI_TRACE_HDR_BYTES 4           // Opcode + 24-bit address
+#define SPI_TRACE_LEN_MAX 0x00FFFFFFu
+#define SPI_TRACE_CS_COARSE 0x8000u     // cs field: bits 0..14 in 64 us units
+#define SPI_TRACE_CS_COARSE_SHIFT 6     // (up to 2 s) rather than 1 us units
+
+// Record flags
+#define SPI_TRACE_F_SD (1u << 0)        // SD bus (one record per spi_transfer)
+#define SPI_TRACE_F_LANES_SHIFT 1       // Data lanes: 0 = x1, 1 = x2, 2 = x4
+#define SPI_TRACE_F_LANES_MASK (3u << SPI_TRACE_F_LANES_SHIFT)
+#define SPI_TRACE_F_HDR_SHIFT 3         // Header bytes captured (0..4)
+#define SPI_TRACE_F_HDR_MASK (7u << SPI_TRACE_F_HDR_SHIFT)
+#define SPI_TRACE_F_QUEUED (1u << 6)    // PIO page-program batch: WREN/PP/RDSR polls in one record
+#define SPI_TRACE_F_PIO (1u << 7)       // Clocked by the PIO transport
+
+// File header
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t clk_sys_hz;
+    uint32_t start_us;              // time_us_32() when the trace started
+    uint8_t jedec[3];               // Chip under test, filled in by spi_trace_stop()
+    uint8_t reserved[3];
+    uint16_t header_size;
+} spi_trace_file_hdr_t;
+
+// One transaction (16 bytes)
+typedef struct {
+    uint32_t t_us;                  // CS assert, time_us_32()
+    uint32_t op_addr;               // Header bytes, big-endian: opcode << 24 | address
+    uint32_t len_flags;             // Bytes clocked under CS (bits 0..23) | flags << 24
+    uint16_t cs;                    // CS low time, spi_trace_cs_encode()
+    uint16_t sck_100khz;            // SCK in 100 kHz units
+} spi_trace_rec_t;
+
+// Counters of the current/last trace
+typedef struct {
+    uint32_t records;
+    uint32_t dropped;               // Ring full while the SD worker was behind
+    uint32_t flushes;
+    uint32_t bytes_written;
+    bool write_error;
+} spi_trace_stats_t;
+
+// Pool blocks reserved for the ring (buf_pool.h)
+#if SPI_TRACE_FLOW
+#define SPI_TRACE_POOL_BYTES (SPI_TRACE_RING * sizeof(spi_trace_rec_t))
+#else
+#define SPI_TRACE_POOL_BYTES 0u
+#endif
+
+extern volatile bool g_spi_trace_on;
+
+// Function declarations
+bool spi_trace_start(bool sd_bus);
+void spi_trace_stop(const uint8_t jedec[3]);
+spi_trace_stats_t spi_trace_get_stats(void);
+
+void spi_trace_cs_slow(bool asserted);
+void spi_trace_bytes_slow(const uint8_t *tx, size_t n, uint32_t hz, uint8_t flags);
+void spi_trace_queued_slow(uint8_t opcode, uint32_t addr, uint32_t bytes, uint32_t t0_us, uint32_t hz);
+
+// 1 us resolution below 32 ms, 64 us above, saturating at ~2 s
+static inline uint16_t spi_trace_cs_encode(uint32_t us) {
+    if (us < SPI_TRACE_CS_COARSE) return (uint16_t)us;
+    us >>= SPI_TRACE_CS_COARSE_SHIFT;
+    return (uint16_t)(SPI_TRACE_CS_COARSE | (us > 0x7FFFu ? 0x7FFFu : us));
+}
+
+static inline uint32_t spi_trace_cs_decode(uint16_t cs) {
+    if (!(cs & SPI_TRACE_CS_COARSE)) return cs;
+    return (uint32_t)(cs & 0x7FFFu) << SPI_TRACE_CS_COARSE_SHIFT;
+}
+
+// Flash CS edge (call after asserting / before releasing is fine either way)
+static inline void spi_trace_cs(bool asserted) {
+    if (g_spi_trace_on) spi_trace_cs_slow(asserted);
+}
+
+// Bytes clocked in the open transaction (tx NULL for reads), PL022 or PIO
+static inline void spi_trace_pl022(spi_inst_t *spi, const uint8_t *tx, size_t n) {
+    if (g_spi_trace_on) spi_trace_bytes_slow(tx, n, spi_get_baudrate(spi), 0);
+}
+
+static inline void spi_trace_pio(uint32_t hz, const uint8_t *tx, size_t n, uint8_t lanes) {
+    if (g_spi_trace_on) {
+        uint8_t code = lanes == 4 ? 2 : lanes == 2 ? 1 : 0;
+        spi_trace_bytes_slow(tx, n, hz, SPI_TRACE_F_PIO | (uint8_t)(code << SPI_TRACE_F_LANES_SHIFT));
+    }
+}
+
+// A hardware-queued operation that never surfaces as CS edges on the CPU
+static inline void spi_trace_queued(uint8_t opcode, uint32_t addr, uint32_t bytes, uint32_t t0_us, uint32_t hz) {
+    if (g_spi_trace_on) spi_trace_queued_slow(opcode, addr, bytes, t0_us, hz);
+}
+
+#endif // SPI_TRACE_H
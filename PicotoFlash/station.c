@@ -0,0 +1,314 @@
+/*
+ * Production Station Module
+ * Replaces the per-chip GP20 press with socket polling: a chip is
+ * considered inserted once JEDEC ID + SFDP answer on consecutive polls and
+ * removed once they stop answering. Every insertion runs the configured
+ * pipeline once; per-stage time and chips-per-hour are tracked and the
+ * station summary is rewritten on SD after every chip.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "ff.h"
+#include "station.h"
+#include "sd_functions.h"
+#include "report_writer.h"
+
+static station_hooks_t g_hooks;
+static uint32_t g_pipeline_mask = STATION_PIPELINE_DEFAULT;
+static uint32_t g_poll_ms = STATION_POLL_MS_DEFAULT;
+static station_stats_t g_stats;
+
+// Per-chip stage times for the station log line
+static uint32_t g_chip_stage_ms[STATION_STAGE_COUNT];
+
+// Formatting arena for the summary / log writers
+static char g_station_arena[2 * REPORT_SECTOR_SIZE];
+
+// ============================================================================
+// Configuration
+// ============================================================================
+
+void station_init(const station_hooks_t *hooks) {
+    g_hooks = *hooks;
+    memset(&g_stats, 0, sizeof(g_stats));
+    for (int i = 0; i < STATION_STAGE_COUNT; i++) g_stats.stage[i].min_ms = UINT32_MAX;
+}
+
+static void trim(char *s) {
+    char *p = s;
+    while (*p == ' ' || *p == '\t') p++;
+    if (p != s) memmove(s, p, strlen(p) + 1);
+    int n = (int)strlen(s);
+    while (n > 0 && (s[n - 1] == ' ' || s[n - 1] == '\t' || s[n - 1] == '\r' || s[n - 1] == '\n')) {
+        s[--n] = '\0';
+    }
+}
+
+static uint32_t parse_pipeline(char *list) {
+    uint32_t mask = 0;
+    for (char *tok = strtok(list, ","); tok; tok = strtok(NULL, ",")) {
+        trim(tok);
+        bool known = false;
+        for (int i = 0; i < STATION_STAGE_COUNT; i++) {
+            if (g_hooks.stages[i].name && strcmp(tok, g_hooks.stages[i].name) == 0) {
+                mask |= (1u << i);
+                known = true;
+            }
+        }
+        if (!known) printf("[STATION] Unknown stage '%s' ignored\n", tok);
+    }
+    return mask;
+}
+
+// station.cfg (optional):
+//   pipeline=identify,backup,read,match,log
+//   poll_ms=250
+void station_load_config(void) {
+    FIL file;
+    if (f_open(&file, STATION_CONFIG_FILE, FA_READ) == FR_OK) {
+        char line[128];
+        while (f_gets(line, sizeof(line), &file) != NULL) {
+            if (line[0] == '#') continue;
+            char *eq = strchr(line, '=');
+            if (!eq) continue;
+            *eq = '\0';
+            char *key = line, *val = eq + 1;
+            trim(key);
+            trim(val);
+            if (strcmp(key, "pipeline") == 0) {
+                uint32_t m = parse_pipeline(val);
+                if (m) g_pipeline_mask = m;
+            } else if (strcmp(key, "poll_ms") == 0) {
+                int v = atoi(val);
+                if (v >= 20 && v <= 5000) g_poll_ms = (uint32_t)v;
+            }
+        }
+        f_close(&file);
+        printf("[STATION] Loaded %s\n", STATION_CONFIG_FILE);
+    }
+
+    // Nothing else is meaningful without an identified chip
+    g_pipeline_mask |= (1u << STATION_STAGE_IDENTIFY);
+
+    printf("[STATION] Pipeline:");
+    for (int i = 0; i < STATION_STAGE_COUNT; i++) {
+        if (g_pipeline_mask & (1u << i)) printf(" %s", g_hooks.stages[i].name);
+    }
+    printf("  (poll %u ms)\n", (unsigned)g_poll_ms);
+}
+
+// ============================================================================
+// Statistics
+// ============================================================================
+
+const station_stats_t *station_get_stats(void) {
+    return &g_stats;
+}
+
+float station_chips_per_hour(void) {
+    uint64_t elapsed = time_us_64() - g_stats.session_start_us;
+    if (g_stats.chips == 0 || elapsed == 0) return 0.0f;
+    return (float)g_stats.chips * 3600.0f * 1e6f / (float)elapsed;
+}
+
+static void record_stage(int i, uint64_t us) {
+    station_stage_stats_t *st = &g_stats.stage[i];
+    uint32_t ms = (uint32_t)(us / 1000u);
+    st->runs++;
+    st->total_us += us;
+    if (ms < st->min_ms) st->min_ms = ms;
+    if (ms > st->max_ms) st->max_ms = ms;
+    g_chip_stage_ms[i] = ms;
+}
+
+void station_print_summary(void) {
+    uint64_t elapsed = time_us_64() - g_stats.session_start_us;
+    printf("\n=======================================================\n");
+    printf(" STATION SUMMARY\n");
+    printf("=======================================================\n");
+    printf("Session:        %.1f min\n", (double)elapsed / 60e6);
+    printf("Chips:          %u (pass %u, fail %u, cached %u)\n",
+           (unsigned)g_stats.chips, (unsigned)g_stats.passed,
+           (unsigned)g_stats.failed, (unsigned)g_stats.cached);
+    printf("Throughput:     %.1f chips/hour\n", station_chips_per_hour());
+    if (g_stats.chips > 0) {
+        printf("Avg cycle:      %.1f s\n", (double)g_stats.busy_us / 1e6 / g_stats.chips);
+        printf("Utilization:    %.0f%%\n", 100.0 * (double)g_stats.busy_us / (double)elapsed);
+    }
+    if (g_stats.handling_count > 0) {
+        printf("Avg handling:   %.1f s (removal -> insertion)\n",
+               (double)g_stats.handling_us_total / 1e6 / g_stats.handling_count);
+    }
+    printf("\nstage      | runs |  avg(ms) |  min(ms) |  max(ms)\n");
+    printf("-----------+------+----------+----------+---------\n");
+    for (int i = 0; i < STATION_STAGE_COUNT; i++) {
+        const station_stage_stats_t *st = &g_stats.stage[i];
+        if (st->runs == 0) continue;
+        printf("%-10s | %4u | %8.1f | %8u | %7u\n", g_hooks.stages[i].name,
+               (unsigned)st->runs, (double)st->total_us / 1000.0 / st->runs,
+               (unsigned)st->min_ms, (unsigned)st->max_ms);
+    }
+    printf("=======================================================\n");
+}
+
+int station_write_summary(void) {
+    FIL file;
+    if (f_open(&file, STATION_SUMMARY_FILE, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+        printf("[ERROR] ERROR_FILE_WRITE_FAIL: Cannot write %s\n", STATION_SUMMARY_FILE);
+        return ERROR_FILE_WRITE_FAIL;
+    }
+
+    int year, month, day, hour, min, sec;
+    get_timestamp(&year, &month, &day, &hour, &min, &sec);
+    uint64_t elapsed = time_us_64() - g_stats.session_start_us;
+
+    report_writer_t rw;
+    rw_init(&rw, &file, g_station_arena, sizeof(g_station_arena));
+    rw_printf(&rw, "========================================\n");
+    rw_printf(&rw, "  PRODUCTION STATION SUMMARY\n");
+    rw_printf(&rw, "========================================\n");
+    rw_printf(&rw, "Updated: %04d-%02d-%02d %02d:%02d:%02d\n", year, month, day, hour, min, sec);
+    rw_printf(&rw, "Session: %.1f min\n", (double)elapsed / 60e6);
+    rw_printf(&rw, "Chips: %u (pass %u, fail %u, cached %u)\n",
+             (unsigned)g_stats.chips, (unsigned)g_stats.passed,
+             (unsigned)g_stats.failed, (unsigned)g_stats.cached);
+    rw_printf(&rw, "Throughput: %.1f chips/hour\n", station_chips_per_hour());
+    if (g_stats.chips > 0) {
+        rw_printf(&rw, "Avg cycle: %.1f s\n", (double)g_stats.busy_us / 1e6 / g_stats.chips);
+    }
+    if (g_stats.handling_count > 0) {
+        rw_printf(&rw, "Avg handling: %.1f s\n",
+                 (double)g_stats.handling_us_total / 1e6 / g_stats.handling_count);
+    }
+    rw_printf(&rw, "\n--- Stage Timing (ms) ---\n");
+    rw_printf(&rw, "stage,runs,avg,min,max\n");
+    for (int i = 0; i < STATION_STAGE_COUNT; i++) {
+        const station_stage_stats_t *st = &g_stats.stage[i];
+        if (st->runs == 0) continue;
+        rw_printf(&rw, "%s,%u,%.1f,%u,%u\n", g_hooks.stages[i].name, (unsigned)st->runs,
+                 (double)st->total_us / 1000.0 / st->runs,
+                 (unsigned)st->min_ms, (unsigned)st->max_ms);
+    }
+    bool ok = rw_finish(&rw);
+    f_close(&file);
+    return ok ? SUCCESS : ERROR_SD_WRITE_FAIL;
+}
+
+static void log_chip(const char *result, uint32_t cycle_ms) {
+    int year, month, day, hour, min, sec;
+    get_timestamp(&year, &month, &day, &hour, &min, &sec);
+
+    char filename[64];
+    snprintf(filename, sizeof(filename), STATION_LOG_FILE, year, month, day);
+    bool file_exists = (f_stat(filename, NULL) == FR_OK);
+
+    FIL file;
+    if (f_open(&file, filename, FA_WRITE | FA_OPEN_APPEND) != FR_OK) {
+        printf("[ERROR] ERROR_FILE_WRITE_FAIL: Cannot open %s\n", filename);
+        return;
+    }
+    report_writer_t rw;
+    rw_init(&rw, &file, g_station_arena, sizeof(g_station_arena));
+    if (!file_exists) {
+        rw_printf(&rw, "Timestamp,Chip,Result,Cycle_ms");
+        for (int i = 0; i < STATION_STAGE_COUNT; i++) rw_printf(&rw, ",%s_ms", g_hooks.stages[i].name);
+        rw_printf(&rw, "\n");
+    }
+    rw_printf(&rw, "%04d-%02d-%02d %02d:%02d:%02d,%s,%s,%u",
+             year, month, day, hour, min, sec,
+             g_hooks.chip_label ? g_hooks.chip_label() : "", result, (unsigned)cycle_ms);
+    for (int i = 0; i < STATION_STAGE_COUNT; i++) rw_printf(&rw, ",%u", (unsigned)g_chip_stage_ms[i]);
+    rw_printf(&rw, "\n");
+    rw_finish(&rw);
+    f_close(&file);
+}
+
+// ============================================================================
+// Socket presence + pipeline
+// ============================================================================
+
+// Wait until `want` presence is seen on `polls` consecutive probes.
+// Returns false if station mode should exit.
+static bool wait_for_presence(bool want, int polls) {
+    int streak = 0;
+    while (streak < polls) {
+        if (g_hooks.exit_requested && g_hooks.exit_requested()) return false;
+        streak = (g_hooks.probe_present() == want) ? streak + 1 : 0;
+        if (streak < polls) sleep_ms(g_poll_ms);
+    }
+    return true;
+}
+
+static void run_pipeline(void) {
+    memset(g_chip_stage_ms, 0, sizeof(g_chip_stage_ms));
+    station_rc_t rc = STATION_RC_OK;
+    uint64_t t_chip = time_us_64();
+
+    for (int i = 0; i < STATION_STAGE_COUNT; i++) {
+        if (!(g_pipeline_mask & (1u << i)) || !g_hooks.stages[i].fn) continue;
+        // After DONE/FAIL only the log stage still runs
+        if (rc != STATION_RC_OK && i != STATION_STAGE_LOG) continue;
+
+        printf("\n[STATION] Stage %s...\n", g_hooks.stages[i].name);
+        uint64_t t0 = time_us_64();
+        station_rc_t r = g_hooks.stages[i].fn();
+        record_stage(i, time_us_64() - t0);
+        if (rc == STATION_RC_OK) rc = r;
+    }
+
+    uint64_t cycle_us = time_us_64() - t_chip;
+    g_stats.busy_us += cycle_us;
+    g_stats.chips++;
+    const char *result = "PASS";
+    if (rc == STATION_RC_FAIL) {
+        g_stats.failed++;
+        result = "FAIL";
+    } else {
+        g_stats.passed++;
+        if (rc == STATION_RC_DONE) {
+            g_stats.cached++;
+            result = "CACHED";
+        }
+    }
+
+    printf("\n[STATION] Chip #%u %s in %.1f s  |  %.1f chips/hour\n",
+           (unsigned)g_stats.chips, result, (double)cycle_us / 1e6, station_chips_per_hour());
+    log_chip(result, (uint32_t)(cycle_us / 1000u));
+    station_write_summary();
+}
+
+void station_run(void) {
+    printf("\n*******************************************************\n");
+    printf(" PRODUCTION STATION MODE\n");
+    printf(" Insert a chip to start, remove it when done.\n");
+    printf(" Press GP21 to leave station mode.\n");
+    printf("*******************************************************\n");
+
+    station_load_config();
+    g_stats.session_start_us = time_us_64();
+
+    while (true) {
+        printf("\n[STATION] Waiting for chip...\n");
+        if (!wait_for_presence(true, STATION_PRESENT_POLLS)) break;
+
+        if (g_stats.last_removal_us != 0) {
+            g_stats.handling_us_total += time_us_64() - g_stats.last_removal_us;
+            g_stats.handling_count++;
+        }
+
+        printf("[STATION] Chip inserted\n");
+        run_pipeline();
+
+        printf("\n[STATION] Remove chip...\n");
+        if (!wait_for_presence(false, STATION_ABSENT_POLLS)) break;
+        g_stats.last_removal_us = time_us_64();
+        printf("[STATION] Chip removed\n");
+    }
+
+    station_print_summary();
+    station_write_summary();
+    printf("[STATION] Leaving station mode\n");
+}
@@ -0,0 +1,91 @@
+/*
+ * Production Station Module Header
+ * Hands-free operation: detect chip insertion/removal on the flash socket,
+ * run a configurable pipeline per chip and track throughput
+ */
+
+#ifndef STATION_H
+#define STATION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// File definitions
+#define STATION_CONFIG_FILE "station.cfg"
+#define STATION_SUMMARY_FILE "station_summary.txt"
+#define STATION_LOG_FILE "station_log_%04d%02d%02d.csv"
+
+// Constants
+#define STATION_POLL_MS_DEFAULT 250     // Socket probe period while idle
+#define STATION_PRESENT_POLLS 2         // Consecutive hits before a chip counts as inserted
+#define STATION_ABSENT_POLLS 2          // Consecutive misses before a chip counts as removed
+
+// Pipeline stages (bit index in the pipeline mask)
+typedef enum {
+    STATION_STAGE_IDENTIFY = 0,
+    STATION_STAGE_VERIFY,
+    STATION_STAGE_BACKUP,
+    STATION_STAGE_READ,
+    STATION_STAGE_BENCH,
+    STATION_STAGE_MATCH,
+    STATION_STAGE_LOG,
+    STATION_STAGE_COUNT
+} station_stage_id_t;
+
+#define STATION_PIPELINE_DEFAULT ((1u << STATION_STAGE_IDENTIFY) | (1u << STATION_STAGE_BACKUP) | \
+                                  (1u << STATION_STAGE_READ) | (1u << STATION_STAGE_MATCH) | \
+                                  (1u << STATION_STAGE_LOG))
+
+// Stage return codes
+typedef enum {
+    STATION_RC_OK,          // Continue with the next stage
+    STATION_RC_DONE,        // Chip finished early (e.g. cached result), skip to LOG
+    STATION_RC_FAIL         // Chip failed, skip to LOG
+} station_rc_t;
+
+typedef station_rc_t (*station_stage_fn)(void);
+
+typedef struct {
+    const char *name;       // Also the keyword used in station.cfg
+    station_stage_fn fn;
+} station_stage_t;
+
+// Per-stage timing
+typedef struct {
+    uint32_t runs;
+    uint64_t total_us;
+    uint32_t min_ms, max_ms;
+} station_stage_stats_t;
+
+// Session statistics
+typedef struct {
+    uint64_t session_start_us;
+    uint64_t busy_us;               // Time spent inside pipelines
+    uint32_t chips;
+    uint32_t passed;
+    uint32_t failed;
+    uint32_t cached;
+    uint64_t last_removal_us;       // For operator handling time (removal -> insertion)
+    uint64_t handling_us_total;
+    uint32_t handling_count;
+    station_stage_stats_t stage[STATION_STAGE_COUNT];
+} station_stats_t;
+
+// Hooks supplied by the application
+typedef struct {
+    const station_stage_t *stages;  // Indexed by station_stage_id_t
+    bool (*probe_present)(void);    // Cheap socket probe (JEDEC + SFDP)
+    bool (*exit_requested)(void);   // Leave station mode (e.g. GP21 pressed)
+    const char *(*chip_label)(void);// JEDEC/UID string for the per-chip log
+} station_hooks_t;
+
+// Function declarations
+void station_init(const station_hooks_t *hooks);
+void station_load_config(void);
+void station_run(void);
+const station_stats_t *station_get_stats(void);
+float station_chips_per_hour(void);
+void station_print_summary(void);
+int station_write_summary(void);
+
+#endif // STATION_H
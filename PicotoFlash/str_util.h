@@ -0,0 +1,21 @@
+/*
+ * String Helpers
+ * Bounded copies into the fixed-width name fields of on-card records
+ */
+
+#ifndef STR_UTIL_H
+#define STR_UTIL_H
+
+#include <stddef.h>
+#include <string.h>
+
+// Copies at most cap - 1 bytes and always terminates (strncpy neither
+// guarantees the terminator nor keeps -Wstringop-truncation quiet)
+static inline void str_copy(char *dst, size_t cap, const char *src) {
+    if (cap == 0) return;
+    size_t n = strnlen(src, cap - 1);
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+}
+
+#endif // STR_UTIL_H
@@ -0,0 +1,295 @@
+/*
+ * Command Timing Probe Module
+ * time_us_64() resolves 1 us; the chip's own timings are tens of ns. A
+ * second state machine on the transport's PIO runs at clk_sys and counts
+ * two-cycle loop iterations between a trigger (CS falling edge, or the
+ * k-th SCK falling edge after it) and MISO leaving its idle level, while
+ * the transport runs the command at TIMING_PROBE_SCK_HZ.
+ *
+ * The probe program is assembled at run time: `wait pin` takes an index
+ * relative to the IN base, which depends on the fixture's pin order. It
+ * borrows the phase programs' instruction memory like the page-program
+ * engine. Resolution is one loop iteration (2 cycles, ~16 ns at 125 MHz).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "timing_probe.h"
+#include "spi_trace.h"
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/gpio.h"
+#include "hardware/pio.h"
+
+timing_probe_result_t g_timing_probe;
+
+// Command shapes: header bytes (opcode + address), dummy bytes, response
+typedef struct {
+    uint8_t opcode;
+    const char *name;
+    uint8_t addr_bytes;
+    uint8_t dummy_bytes;
+    uint8_t resp_bytes;
+} probe_cmd_t;
+
+static const probe_cmd_t k_cmds[TIMING_PROBE_OPS] = {
+    {0x9F, "JEDEC ID",   0, 0, 3},
+    {0x05, "RDSR",       0, 0, 2},
+    {0x90, "REMS",       3, 0, 2},
+    {0xAB, "RES",        0, 3, 1},
+    {0x03, "READ",       3, 0, 16},
+    {0x0B, "FAST READ",  3, 1, 16},
+    {0x5A, "SFDP",       3, 1, 16},
+};
+
+// Program layout (JMP targets are relocated by pio_add_program)
+enum {
+    P_PULL, P_OUT_Y, P_MOV_X, P_CS_HIGH, P_CS_LOW, P_JMP_NOT_Y, P_PREDEC,
+    P_SCK_HIGH, P_SCK_LOW, P_EDGE_LOOP, P_COUNT, P_COUNT_DEC, P_RESULT, P_PUSH,
+    P_LEN
+};
+
+typedef struct {
+    PIO pio;
+    uint sm;
+    uint offset;
+    uint16_t insn[P_LEN];
+    pio_program_t prog;
+} probe_sm_t;
+
+void timing_probe_reset(void) {
+    memset(&g_timing_probe, 0, sizeof(g_timing_probe));
+}
+
+static void build_program(probe_sm_t *p, uint cs_idx, uint sck_idx) {
+    uint16_t *i = p->insn;
+    i[P_PULL] = (uint16_t)pio_encode_pull(false, true);         // Arm: k
+    i[P_OUT_Y] = (uint16_t)pio_encode_out(pio_y, 32);
+    i[P_MOV_X] = (uint16_t)pio_encode_mov_not(pio_x, pio_null); // x = ~0
+    i[P_CS_HIGH] = (uint16_t)pio_encode_wait_pin(true, cs_idx);
+    i[P_CS_LOW] = (uint16_t)pio_encode_wait_pin(false, cs_idx);
+    i[P_JMP_NOT_Y] = (uint16_t)pio_encode_jmp_not_y(P_COUNT);   // k == 0: from CS
+    i[P_PREDEC] = (uint16_t)pio_encode_jmp_y_dec(P_SCK_HIGH);   // y = k - 1
+    i[P_SCK_HIGH] = (uint16_t)pio_encode_wait_pin(true, sck_idx);
+    i[P_SCK_LOW] = (uint16_t)pio_encode_wait_pin(false, sck_idx);
+    i[P_EDGE_LOOP] = (uint16_t)pio_encode_jmp_y_dec(P_SCK_HIGH);
+    i[P_COUNT] = (uint16_t)pio_encode_jmp_pin(P_RESULT);        // MISO (inverted) high
+    i[P_COUNT_DEC] = (uint16_t)pio_encode_jmp_x_dec(P_COUNT);
+    i[P_RESULT] = (uint16_t)pio_encode_mov_not(pio_isr, pio_x); // Iterations
+    i[P_PUSH] = (uint16_t)pio_encode_push(false, true);
+    p->prog.instructions = p->insn;
+    p->prog.length = P_LEN;
+    p->prog.origin = -1;
+}
+
+static bool probe_start(probe_sm_t *p, pio_spi_t *s, uint cs_pin) {
+    uint base = s->sck_pin;
+    if (s->miso_pin < base) base = s->miso_pin;
+    if (cs_pin < base) base = cs_pin;
+
+    int sm = pio_claim_unused_sm(s->pio, false);
+    if (sm < 0) {
+        printf("[ERROR] Timing probe: no free state machine\n");
+        return false;
+    }
+    if (!pio_spi_lend_imem(s)) {
+        pio_sm_unclaim(s->pio, (uint)sm);
+        return false;
+    }
+    p->pio = s->pio;
+    p->sm = (uint)sm;
+    build_program(p, cs_pin - base, s->sck_pin - base);
+    if (!pio_can_add_program(p->pio, &p->prog)) {
+        printf("[ERROR] Timing probe: no instruction memory\n");
+        pio_spi_reclaim_imem(s);
+        pio_sm_unclaim(p->pio, p->sm);
+        return false;
+    }
+    p->offset = pio_add_program(p->pio, &p->prog);
+
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_in_pins(&c, base);
+    sm_config_set_jmp_pin(&c, s->miso_pin);
+    sm_config_set_wrap(&c, p->offset, p->offset + P_PUSH);
+    sm_config_set_clkdiv_int_frac(&c, 1, 0);
+    pio_sm_init(p->pio, p->sm, p->offset, &c);     // All pins stay inputs
+    pio_sm_set_enabled(p->pio, p->sm, true);
+    return true;
+}
+
+static void probe_stop(probe_sm_t *p, pio_spi_t *s) {
+    pio_sm_set_enabled(p->pio, p->sm, false);
+    pio_remove_program(p->pio, &p->prog, p->offset);
+    pio_sm_unclaim(p->pio, p->sm);
+    pio_spi_reclaim_imem(s);
+}
+
+// Back to P_PULL after a timeout
+static void probe_rearm(probe_sm_t *p) {
+    pio_sm_set_enabled(p->pio, p->sm, false);
+    pio_sm_clear_fifos(p->pio, p->sm);
+    pio_sm_restart(p->pio, p->sm);
+    pio_sm_exec(p->pio, p->sm, pio_encode_jmp(p->offset));
+    pio_sm_set_enabled(p->pio, p->sm, true);
+}
+
+static void run_cmd(pio_spi_t *s, uint cs_pin, const probe_cmd_t *c, uint8_t *resp) {
+    uint8_t hdr[8] = {c->opcode};
+    size_t n = 1u + c->addr_bytes + c->dummy_bytes;    // Address 0, dummies 0
+    gpio_put(cs_pin, 0);
+    spi_trace_cs(true);
+    pio_spi_write(s, hdr, n);
+    pio_spi_read(s, resp, c->resp_bytes);
+    spi_trace_cs(false);
+    gpio_put(cs_pin, 1);
+}
+
+// One armed transaction; returns loop iterations or -1 if no edge was seen
+static int32_t measure(probe_sm_t *p, pio_spi_t *s, uint cs_pin, const probe_cmd_t *c, uint32_t k) {
+    uint8_t resp[16];
+    pio_sm_put_blocking(p->pio, p->sm, k);
+    busy_wait_us(2);                                // Past wait-for-CS-high
+    run_cmd(s, cs_pin, c, resp);
+
+    uint64_t deadline = time_us_64() + TIMING_PROBE_TIMEOUT_US;
+    while (pio_sm_is_rx_fifo_empty(p->pio, p->sm)) {
+        if (time_us_64() > deadline) {
+            probe_rearm(p);
+            return -1;
+        }
+    }
+    return (int32_t)pio_sm_get(p->pio, p->sm);
+}
+
+// Two cycles per iteration plus the cycle that sees the edge
+static inline uint32_t iter_cycles(int32_t it) {
+    return 2u * (uint32_t)it + 1u;
+}
+
+static void probe_op(probe_sm_t *p, pio_spi_t *s, uint cs_pin, const probe_cmd_t *c,
+                     timing_probe_op_t *o) {
+    memset(o, 0, sizeof(*o));
+    o->opcode = c->opcode;
+    o->name = c->name;
+
+    // Reference response with MISO as-is: the first 0 bit is the first edge
+    uint8_t resp[16];
+    run_cmd(s, cs_pin, c, resp);
+    int first0 = -1;
+    for (int b = 0; b < c->resp_bytes * 8 && first0 < 0; b++) {
+        if (!(resp[b / 8] & (0x80u >> (b % 8)))) first0 = b;
+    }
+    if (first0 < 0) return;
+    o->edge = (uint16_t)((1u + c->addr_bytes + c->dummy_bytes) * 8u + (uint)first0);
+
+    // Idle (pulled-up) MISO reads 1; inverted, the first driven 0 ends the count
+    gpio_set_inover(s->miso_pin, GPIO_OVERRIDE_INVERT);
+    uint32_t sum = 0;
+    int n = 0;
+    o->clqv_min = 0xFFFF;
+    for (int r = 0; r < TIMING_PROBE_REPEATS; r++) {
+        int32_t it = measure(p, s, cs_pin, c, o->edge);
+        if (it < 0) continue;
+        uint32_t cyc = iter_cycles(it);
+        if (cyc < o->clqv_min) o->clqv_min = (uint16_t)cyc;
+        if (cyc > o->clqv_max) o->clqv_max = (uint16_t)cyc;
+        sum += cyc;
+        n++;
+    }
+    int32_t it = measure(p, s, cs_pin, c, 0);
+    gpio_set_inover(s->miso_pin, GPIO_OVERRIDE_NORMAL);
+
+    if (n == 0) return;
+    o->clqv_avg = (float)sum / (float)n;
+    o->cs_to_data = it < 0 ? 0 : iter_cycles(it);
+    o->valid = true;
+}
+
+// Back-to-back JEDEC ID reads with a swept CS-high gap
+static void probe_shsl(pio_spi_t *s, uint cs_pin, timing_probe_result_t *r) {
+    static const uint16_t gaps[] = {0, 1, 2, 4, 8, 16, 32, 64};
+    const probe_cmd_t *jedec = &k_cmds[0];
+    uint8_t ref[16], got[16];
+    run_cmd(s, cs_pin, jedec, ref);
+
+    r->shsl_min_cycles = -1;
+    r->shsl_fail_cycles = -1;
+
+    // The trace hooks would widen the swept gap; leave the sweep unrecorded
+    bool traced = g_spi_trace_on;
+    g_spi_trace_on = false;
+    for (size_t i = 0; i < sizeof(gaps) / sizeof(gaps[0]); i++) {
+        bool ok = true;
+        for (int rep = 0; rep < TIMING_PROBE_REPEATS && ok; rep++) {
+            uint8_t cmd = jedec->opcode;
+            gpio_put(cs_pin, 0);
+            pio_spi_write(s, &cmd, 1);
+            pio_spi_read(s, got, jedec->resp_bytes);
+            gpio_put(cs_pin, 1);
+            busy_wait_at_least_cycles(gaps[i]);
+            gpio_put(cs_pin, 0);
+            pio_spi_write(s, &cmd, 1);
+            pio_spi_read(s, got, jedec->resp_bytes);
+            gpio_put(cs_pin, 1);
+            ok = memcmp(got, ref, jedec->resp_bytes) == 0;
+        }
+        if (ok && r->shsl_min_cycles < 0) r->shsl_min_cycles = (int16_t)gaps[i];
+        if (!ok) r->shsl_fail_cycles = (int16_t)gaps[i];
+    }
+    g_spi_trace_on = traced;
+}
+
+// Transport must be attached; leaves it at its previous SCK
+bool timing_probe_run(pio_spi_t *s, uint cs_pin, timing_probe_result_t *out) {
+    memset(out, 0, sizeof(*out));
+    uint32_t prev_hz = s->hz;
+    uint32_t prev_bypass = s->pio->input_sync_bypass;
+
+    probe_sm_t p;
+    memset(&p, 0, sizeof(p));
+    if (!probe_start(&p, s, cs_pin)) return false;
+
+    // Probe inputs unsynchronised too, so trigger and event see equal delay
+    s->pio->input_sync_bypass |= (1u << s->sck_pin) | (1u << cs_pin) | (1u << s->miso_pin);
+    out->sck_hz = pio_spi_set_hz(s, TIMING_PROBE_SCK_HZ);
+    out->clk_sys_hz = clock_get_hz(clk_sys);
+
+    for (int i = 0; i < TIMING_PROBE_OPS; i++) {
+        probe_op(&p, s, cs_pin, &k_cmds[i], &out->ops[i]);
+    }
+    probe_shsl(s, cs_pin, out);
+
+    probe_stop(&p, s);
+    s->pio->input_sync_bypass = prev_bypass;
+    pio_spi_set_hz(s, prev_hz);
+    out->valid = true;
+    return true;
+}
+
+void timing_probe_print(const timing_probe_result_t *r) {
+    if (!r->valid) return;
+    double ns = 1e9 / (double)r->clk_sys_hz;
+    printf("\n=== COMMAND TIMING PROBE (clk_sys %.1f MHz, SCK %.3f MHz, 1 cycle = %.1f ns) ===\n",
+           r->clk_sys_hz / 1e6, r->sck_hz / 1e6, ns);
+    printf("opcode | command    | edge | SCK->MISO cyc min/avg/max | avg ns | CS->data us\n");
+    printf("-------+------------+------+---------------------------+--------+------------\n");
+    for (int i = 0; i < TIMING_PROBE_OPS; i++) {
+        const timing_probe_op_t *o = &r->ops[i];
+        if (!o->valid) {
+            printf(" 0x%02X  | %-10s |    - | (no 0 bit in response)    |      - |          -\n",
+                   o->opcode, o->name);
+            continue;
+        }
+        printf(" 0x%02X  | %-10s | %4u | %6u / %7.1f / %6u  | %6.1f | %10.3f\n",
+               o->opcode, o->name, o->edge, o->clqv_min, o->clqv_avg, o->clqv_max,
+               o->clqv_avg * ns, o->cs_to_data * ns / 1000.0);
+    }
+    if (r->shsl_min_cycles >= 0) {
+        printf("tSHSL: back-to-back commands OK with CS-high gap >= %d cycles (+GPIO overhead)",
+               r->shsl_min_cycles);
+        if (r->shsl_fail_cycles >= 0) printf(", failed at %d", r->shsl_fail_cycles);
+        printf("\n");
+    } else {
+        printf("tSHSL: no swept CS-high gap passed\n");
+    }
+}
@@ -0,0 +1,50 @@
+/*
+ * Command Timing Probe Module Header
+ * Measures per-opcode micro-timings in clk_sys cycles with a second PIO
+ * state machine watching the flash pins: SCK falling edge to MISO valid
+ * (tCLQV plus pad/cable delay), CS falling edge to the first data edge,
+ * and the shortest CS-high gap (tSHSL) the chip tolerates between commands.
+ */
+
+#ifndef TIMING_PROBE_H
+#define TIMING_PROBE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pio_spi.h"
+
+// Constants
+#define TIMING_PROBE_SCK_HZ 1000000u   // Slow enough that the probe sees every edge
+#define TIMING_PROBE_REPEATS 8
+#define TIMING_PROBE_TIMEOUT_US 10000u
+#define TIMING_PROBE_OPS 7
+
+typedef struct {
+    uint8_t opcode;
+    const char *name;
+    bool valid;                 // Response had a 0 bit to time against
+    uint16_t edge;              // SCK falling edge that launched that bit
+    uint16_t clqv_min;          // Cycles, SCK falling edge -> MISO valid
+    uint16_t clqv_max;
+    float clqv_avg;
+    uint32_t cs_to_data;        // Cycles, CS falling edge -> first data edge
+} timing_probe_op_t;
+
+typedef struct {
+    bool valid;
+    uint32_t clk_sys_hz;
+    uint32_t sck_hz;
+    timing_probe_op_t ops[TIMING_PROBE_OPS];
+    int16_t shsl_min_cycles;    // Shortest passing CS-high gap, -1 if none passed
+    int16_t shsl_fail_cycles;   // Longest failing gap, -1 if none failed
+} timing_probe_result_t;
+
+// Last probe run (reports read it)
+extern timing_probe_result_t g_timing_probe;
+
+// Function declarations
+void timing_probe_reset(void);
+bool timing_probe_run(pio_spi_t *s, uint cs_pin, timing_probe_result_t *out);
+void timing_probe_print(const timing_probe_result_t *r);
+
+#endif // TIMING_PROBE_H
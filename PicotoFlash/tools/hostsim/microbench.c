@@ -0,0 +1,331 @@
+/*
+ * Host Micro-Benchmark Harness
+ * Runs the benchmark tables from microbench_*.c with Google Benchmark's
+ * flags and output layout. Firmware printf output goes to /dev/null unless
+ * --verbose; results go to the real stdout. A CSV written with
+ * --benchmark_out can be passed back as --baseline to fail (exit 1) when
+ * any benchmark's CPU time regressed by more than --max_regression percent.
+ *
+ *   picotoflash_microbench --benchmark_filter=match --benchmark_out=base.csv
+ *   picotoflash_microbench --benchmark_filter=match --baseline=base.csv --max_regression=10
+ */
+
+#include <math.h>
+#include <regex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "microbench.h"
+#include "sim.h"
+
+#define MB_MAX_RESULTS 256
+#define MB_MAX_ITERATIONS 1000000000ull
+#define MB_NAME_LEN 64
+
+typedef struct {
+    char name[MB_NAME_LEN];
+    int64_t arg;
+    uint64_t iterations;
+    double real_ns;                 // Per iteration
+    double cpu_ns;
+    double items_per_s;
+    double bytes_per_s;
+} mb_result_t;
+
+static struct {
+    const char *filter;
+    double min_time_s;
+    bool csv;
+    const char *out;
+    const char *baseline;
+    double max_regression;
+    bool list;
+    bool verbose;
+    const char *image;
+} g_opts = {NULL, 0.5, false, NULL, NULL, 10.0, false, false, "microbench_sd.img"};
+
+static FILE *g_report;
+static mb_result_t g_results[MB_MAX_RESULTS];
+static int g_result_count;
+
+static const mb_def_t *const g_tables[] = {
+    mb_catalog_benches,
+    mb_sfdp_benches,
+    mb_crc_benches,
+};
+
+// ========== Clocks ==========
+
+static uint64_t wall_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void mb_pause(mb_state_t *st) {
+    st->pause_start_ns = wall_ns();
+    st->pause_start_cpu_ns = cpu_ns();
+}
+
+void mb_resume(mb_state_t *st) {
+    st->paused_ns += wall_ns() - st->pause_start_ns;
+    st->paused_cpu_ns += cpu_ns() - st->pause_start_cpu_ns;
+}
+
+// ========== Runner ==========
+
+// Grow the iteration count until one run lasts min_time (as Google
+// Benchmark does), then keep that run
+static void run_one(const mb_def_t *def, int64_t arg, mb_result_t *r) {
+    uint64_t min_ns = (uint64_t)(g_opts.min_time_s * 1e9);
+    uint64_t iters = 1;
+    for (;;) {
+        mb_state_t st = {0};
+        st.iterations = iters;
+        st.arg = arg;
+        uint64_t w0 = wall_ns(), c0 = cpu_ns();
+        def->fn(&st);
+        uint64_t real = wall_ns() - w0 - st.paused_ns;
+        uint64_t cpu = cpu_ns() - c0 - st.paused_cpu_ns;
+
+        if (real >= min_ns || iters >= MB_MAX_ITERATIONS) {
+            r->arg = arg;
+            r->iterations = iters;
+            r->real_ns = (double)real / (double)iters;
+            r->cpu_ns = (double)cpu / (double)iters;
+            r->items_per_s = st.items ? (double)st.items * 1e9 / (double)real : 0.0;
+            r->bytes_per_s = st.bytes ? (double)st.bytes * 1e9 / (double)real : 0.0;
+            return;
+        }
+        double mult = real ? (double)min_ns * 1.4 / (double)real : 10.0;
+        if (mult > 10.0) mult = 10.0;
+        if (mult < 1.2) mult = 1.2;
+        iters = (uint64_t)ceil((double)iters * mult);
+        if (iters > MB_MAX_ITERATIONS) iters = MB_MAX_ITERATIONS;
+    }
+}
+
+static const char *human_rate(double v, char *buf, size_t n, const char *unit) {
+    const char *pre[] = {"", "k", "M", "G", "T"};
+    int i = 0;
+    while (v >= 1000.0 && i < 4) { v /= 1000.0; i++; }
+    snprintf(buf, n, "%.4g%s%s", v, pre[i], unit);
+    return buf;
+}
+
+static void print_time(double ns, char *buf, size_t n) {
+    if (ns < 1e4) snprintf(buf, n, "%10.1f ns", ns);
+    else if (ns < 1e7) snprintf(buf, n, "%10.1f us", ns / 1e3);
+    else snprintf(buf, n, "%10.1f ms", ns / 1e6);
+}
+
+static void print_result(const mb_result_t *r) {
+    char t[32], c[32], rate[48] = "", tmp[24];
+    if (g_opts.csv) {
+        fprintf(g_report, "\"%s\",%llu,%.3f,%.3f,ns,%.6g,%.6g\n", r->name, (unsigned long long)r->iterations,
+                r->real_ns, r->cpu_ns, r->bytes_per_s, r->items_per_s);
+        return;
+    }
+    print_time(r->real_ns, t, sizeof(t));
+    print_time(r->cpu_ns, c, sizeof(c));
+    if (r->bytes_per_s > 0.0) {
+        snprintf(rate, sizeof(rate), "bytes_per_second=%s", human_rate(r->bytes_per_s, tmp, sizeof(tmp), "/s"));
+    } else if (r->items_per_s > 0.0) {
+        snprintf(rate, sizeof(rate), "items_per_second=%s", human_rate(r->items_per_s, tmp, sizeof(tmp), "/s"));
+    }
+    fprintf(g_report, "%-36s %s %s %12llu %s\n", r->name, t, c, (unsigned long long)r->iterations, rate);
+}
+
+// Least-squares fit of t(N) = c * f(N) for the usual complexity classes;
+// the class with the lowest normalised RMS wins (Google Benchmark's oAuto)
+static void print_complexity(const char *name, const mb_result_t *r, int n) {
+    static const char *labels[] = {"(1)", "N", "NlgN", "N^2"};
+    int best = 0;
+    double best_c = 0.0, best_rms = INFINITY;
+    for (int k = 0; k < 4; k++) {
+        double sff = 0.0, sft = 0.0, mean = 0.0;
+        for (int i = 0; i < n; i++) {
+            double N = (double)r[i].arg;
+            double f = k == 0 ? 1.0 : k == 1 ? N : k == 2 ? N * log2(N) : N * N;
+            sff += f * f;
+            sft += f * r[i].cpu_ns;
+            mean += r[i].cpu_ns;
+        }
+        double c = sft / sff, err = 0.0;
+        for (int i = 0; i < n; i++) {
+            double N = (double)r[i].arg;
+            double f = k == 0 ? 1.0 : k == 1 ? N : k == 2 ? N * log2(N) : N * N;
+            err += (r[i].cpu_ns - c * f) * (r[i].cpu_ns - c * f);
+        }
+        double rms = sqrt(err / n) / (mean / n);
+        if (rms < best_rms) {
+            best = k;
+            best_c = c;
+            best_rms = rms;
+        }
+    }
+    if (g_opts.csv) return;
+    char bigo[MB_NAME_LEN + 8], rms[MB_NAME_LEN + 8];
+    snprintf(bigo, sizeof(bigo), "%s_BigO", name);
+    snprintf(rms, sizeof(rms), "%s_RMS", name);
+    fprintf(g_report, "%-36s %10.2f %-4s %10.2f %-4s\n", bigo, best_c, labels[best], best_c, labels[best]);
+    fprintf(g_report, "%-36s %10.0f %%    %10.0f %%\n", rms, best_rms * 100.0, best_rms * 100.0);
+}
+
+static bool selected(const regex_t *re, const char *name) {
+    return !re || regexec(re, name, 0, NULL, 0) == 0;
+}
+
+static void run_def(const mb_def_t *def, const regex_t *re) {
+    int64_t args[32];
+    int nargs = 0;
+    if (def->range_lo > 0) {
+        for (int64_t a = def->range_lo; a < def->range_hi && nargs < 31; a *= def->range_mult) args[nargs++] = a;
+        args[nargs++] = def->range_hi;
+    } else {
+        args[nargs++] = 0;
+    }
+
+    int first = g_result_count;
+    for (int i = 0; i < nargs && g_result_count < MB_MAX_RESULTS; i++) {
+        mb_result_t *r = &g_results[g_result_count];
+        if (def->range_lo > 0) snprintf(r->name, sizeof(r->name), "%s/%lld", def->name, (long long)args[i]);
+        else snprintf(r->name, sizeof(r->name), "%s", def->name);
+        if (!selected(re, r->name)) continue;
+        if (g_opts.list) {
+            fprintf(g_report, "%s\n", r->name);
+            continue;
+        }
+        run_one(def, args[i], r);
+        print_result(r);
+        fflush(g_report);
+        g_result_count++;
+    }
+    if (def->complexity && g_result_count - first >= 3) {
+        print_complexity(def->name, &g_results[first], g_result_count - first);
+    }
+}
+
+// ========== Baseline ==========
+
+static int compare_baseline(void) {
+    FILE *f = fopen(g_opts.baseline, "r");
+    if (!f) {
+        fprintf(stderr, "[ERROR] cannot read baseline %s\n", g_opts.baseline);
+        return 2;
+    }
+    int regressions = 0, compared = 0;
+    char line[256];
+    fprintf(g_report, "\nComparison against %s (CPU time, limit +%.1f%%)\n", g_opts.baseline, g_opts.max_regression);
+    while (fgets(line, sizeof(line), f)) {
+        char name[MB_NAME_LEN];
+        unsigned long long iters;
+        double real, cpu;
+        if (sscanf(line, "\"%63[^\"]\",%llu,%lf,%lf", name, &iters, &real, &cpu) != 4) continue;
+        for (int i = 0; i < g_result_count; i++) {
+            if (strcmp(g_results[i].name, name) != 0) continue;
+            double dev = (g_results[i].cpu_ns - cpu) / cpu * 100.0;
+            bool bad = dev > g_opts.max_regression;
+            fprintf(g_report, "%-36s %+8.1f%%%s\n", name, dev, bad ? "  REGRESSION" : "");
+            regressions += bad;
+            compared++;
+        }
+    }
+    fclose(f);
+    fprintf(g_report, "%d compared, %d regressed\n", compared, regressions);
+    return regressions ? 1 : 0;
+}
+
+static void write_out(void) {
+    FILE *f = fopen(g_opts.out, "w");
+    if (!f) {
+        fprintf(stderr, "[ERROR] cannot write %s\n", g_opts.out);
+        return;
+    }
+    fprintf(f, "name,iterations,real_time,cpu_time,time_unit,bytes_per_second,items_per_second\n");
+    for (int i = 0; i < g_result_count; i++) {
+        const mb_result_t *r = &g_results[i];
+        fprintf(f, "\"%s\",%llu,%.3f,%.3f,ns,%.6g,%.6g\n", r->name, (unsigned long long)r->iterations, r->real_ns,
+                r->cpu_ns, r->bytes_per_s, r->items_per_s);
+    }
+    fclose(f);
+}
+
+// ========== Main ==========
+
+static const char *flag_value(const char *arg, const char *flag) {
+    size_t n = strlen(flag);
+    return (strncmp(arg, flag, n) == 0 && arg[n] == '=') ? arg + n + 1 : NULL;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: picotoflash_microbench [options]\n"
+            "  --benchmark_filter=REGEX      run matching benchmarks only\n"
+            "  --benchmark_min_time=SECONDS  time per measurement (default 0.5)\n"
+            "  --benchmark_format=console|csv\n"
+            "  --benchmark_out=FILE          also write results as CSV\n"
+            "  --benchmark_list_tests        list names and exit\n"
+            "  --baseline=FILE               compare with an earlier --benchmark_out\n"
+            "  --max_regression=PCT          allowed CPU time increase (default 10)\n"
+            "  --image=PATH                  scratch SD card image (default microbench_sd.img)\n"
+            "  --verbose                     keep firmware console output\n");
+}
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i], *v;
+        if ((v = flag_value(a, "--benchmark_filter"))) g_opts.filter = v;
+        else if ((v = flag_value(a, "--benchmark_min_time"))) g_opts.min_time_s = atof(v);
+        else if ((v = flag_value(a, "--benchmark_format"))) g_opts.csv = strcmp(v, "csv") == 0;
+        else if ((v = flag_value(a, "--benchmark_out"))) g_opts.out = v;
+        else if ((v = flag_value(a, "--baseline"))) g_opts.baseline = v;
+        else if ((v = flag_value(a, "--max_regression"))) g_opts.max_regression = atof(v);
+        else if ((v = flag_value(a, "--image"))) g_opts.image = v;
+        else if (strcmp(a, "--benchmark_list_tests") == 0) g_opts.list = true;
+        else if (strcmp(a, "--verbose") == 0) g_opts.verbose = true;
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    regex_t re;
+    if (g_opts.filter && regcomp(&re, g_opts.filter, REG_EXTENDED | REG_NOSUB) != 0) {
+        fprintf(stderr, "[ERROR] bad filter %s\n", g_opts.filter);
+        return 2;
+    }
+
+    // Results keep the real stdout; the firmware's console goes quiet
+    g_report = fdopen(dup(STDOUT_FILENO), "w");
+    if (!g_opts.verbose && !freopen("/dev/null", "w", stdout)) return 2;
+
+    // Compute only: no bus pacing, the card image is a scratch file
+    sim_spi_set_wire_time(false);
+    if (!g_opts.list && !sim_sd_open(g_opts.image, 64)) return 2;
+
+    if (!g_opts.list && !g_opts.csv) {
+        fprintf(g_report, "%-36s %13s %13s %12s %s\n", "Benchmark", "Time", "CPU", "Iterations", "UserCounters...");
+        fprintf(g_report, "-------------------------------------------------------------------------------------------\n");
+    }
+    if (g_opts.csv) fprintf(g_report, "name,iterations,real_time,cpu_time,time_unit,bytes_per_second,items_per_second\n");
+
+    for (size_t t = 0; t < sizeof(g_tables) / sizeof(g_tables[0]); t++) {
+        for (const mb_def_t *d = g_tables[t]; d->name; d++) run_def(d, g_opts.filter ? &re : NULL);
+    }
+
+    int rc = 0;
+    if (g_opts.out) write_out();
+    if (g_opts.baseline) rc = compare_baseline();
+    if (!g_opts.list) sim_sd_close();
+    fflush(g_report);
+    return rc;
+}
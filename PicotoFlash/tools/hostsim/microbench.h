@@ -0,0 +1,51 @@
+/*
+ * Host Micro-Benchmark Harness Header
+ * A small Google Benchmark work-alike for the pure-compute firmware paths:
+ * each benchmark runs its loop st->iterations times, the runner grows the
+ * count until the loop takes --benchmark_min_time, and ranged benchmarks
+ * are repeated per argument to give a scaling curve with a fitted O(N).
+ */
+
+#ifndef MICROBENCH_H
+#define MICROBENCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    uint64_t iterations;            // Loop count for this run
+    int64_t arg;                    // Current range argument (0 if unranged)
+    uint64_t items;                 // Items processed, for items/s
+    uint64_t bytes;                 // Bytes processed, for bytes/s
+    uint64_t paused_ns;             // Wall time excluded by mb_pause/mb_resume
+    uint64_t paused_cpu_ns;
+    uint64_t pause_start_ns;
+    uint64_t pause_start_cpu_ns;
+} mb_state_t;
+
+typedef void (*mb_fn_t)(mb_state_t *st);
+
+typedef struct {
+    const char *name;
+    mb_fn_t fn;
+    int64_t range_lo;               // 0 = unranged
+    int64_t range_hi;
+    int range_mult;
+    bool complexity;                // Fit and print O(N) over the range
+} mb_def_t;
+
+// Setup inside the loop that should not count (PauseTiming/ResumeTiming)
+void mb_pause(mb_state_t *st);
+void mb_resume(mb_state_t *st);
+
+// Keep a result alive without letting the compiler drop the work
+static inline void mb_keep(const void *p) {
+    __asm__ volatile("" : : "g"(p) : "memory");
+}
+
+// Benchmark tables, one per source file
+extern const mb_def_t mb_catalog_benches[];
+extern const mb_def_t mb_sfdp_benches[];
+extern const mb_def_t mb_crc_benches[];
+
+#endif // MICROBENCH_H
@@ -0,0 +1,192 @@
+/*
+ * Host Micro-Benchmarks: Chip Database
+ * DATASHEET.csv parsing (parse_csv_line, sd_load_chip_database through
+ * FatFs on the scratch card) and matching (chip_calculate_confidence,
+ * chip_match_partial, chip_match_database) over synthetic catalogs of
+ * 10 to 100k rows.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ff.h"
+#include "identification.h"
+#include "sd_functions.h"
+#include "microbench.h"
+#include "sim.h"
+
+#define CATALOG_MIN_ROWS 10
+#define CATALOG_MAX_ROWS 100000
+
+#if MAX_DATABASE_ENTRIES < CATALOG_MAX_ROWS
+#error "microbench needs MAX_DATABASE_ENTRIES >= CATALOG_MAX_ROWS"
+#endif
+
+static const struct {
+    const char *company;
+    uint8_t mfr;
+} k_vendors[] = {
+    {"Winbond", 0xEF}, {"Macronix", 0xC2}, {"GigaDevice", 0xC8}, {"Micron", 0x20},
+    {"ISSI", 0x9D},    {"Puya", 0x85},     {"XMC", 0x20},        {"Zbit", 0x5E},
+};
+#define VENDOR_COUNT (sizeof(k_vendors) / sizeof(k_vendors[0]))
+
+// Deterministic row i of the synthetic catalog, as a DATASHEET.csv line
+static int catalog_line(int i, char *buf, size_t n) {
+    uint32_t h = (uint32_t)i * 2654435761u;
+    int shift = 3 + (int)(h >> 29) % 6;          // 8..256 Mbit
+    unsigned vendor = (unsigned)i % VENDOR_COUNT;
+    float t4k = 30.0f + (float)(h % 40);
+    float t32 = 100.0f + (float)((h >> 8) % 150);
+    float t64 = 150.0f + (float)((h >> 16) % 250);
+    float tpp = 0.3f + (float)((h >> 4) % 8) * 0.1f;
+    float rd = 4.0f + (float)((h >> 12) % 30) * 0.1f;
+    return snprintf(buf, n, "SYN%06d,%s,Q%d,%d,%02X %02X %02X,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.1f,%.1f,%d,%.1f\n",
+                    i, k_vendors[vendor].company, shift, 1 << shift, k_vendors[vendor].mfr,
+                    0x40 + (i / (int)VENDOR_COUNT) % 32, 0x11 + shift, t4k, t4k * 9, t32, t32 * 13, t64, t64 * 13,
+                    tpp, tpp * 6, 104 + (int)(h % 3) * 15, rd);
+}
+
+static void catalog_entry(int i, FlashChipData *e) {
+    char line[MAX_LINE_LENGTH];
+    char fields[30][MAX_FIELD_LENGTH];
+    int count;
+    catalog_line(i, line, sizeof(line));
+    parse_csv_line(line, fields, &count);
+    memset(e, 0, sizeof(*e));
+    snprintf(e->chip_model, sizeof(e->chip_model), "%s", fields[0]);
+    snprintf(e->company, sizeof(e->company), "%s", fields[1]);
+    snprintf(e->chip_family, sizeof(e->chip_family), "%s", fields[2]);
+    e->capacity_mbit = (float)atof(fields[3]);
+    snprintf(e->jedec_id, sizeof(e->jedec_id), "%s", fields[4]);
+    e->typ_4kb_erase_ms = (float)atof(fields[5]);
+    e->typ_32kb_erase_ms = (float)atof(fields[7]);
+    e->typ_64kb_erase_ms = (float)atof(fields[9]);
+    e->typ_page_program_ms = (float)atof(fields[11]);
+    e->max_clock_freq_mhz = atoi(fields[13]);
+    e->read_speed_max = (float)atof(fields[14]);
+    e->erase_speed = e->typ_64kb_erase_ms;
+}
+
+// database[] holding rows 0..n-1, as sd_load_chip_database() would leave it
+static void catalog_fill(int n) {
+    static int filled = -1;
+    if (filled == n && database_entry_count == n) return;
+    for (int i = 0; i < n; i++) catalog_entry(i, &database[i]);
+    database_entry_count = n;
+    filled = n;
+}
+
+// A measured chip close to (not equal to) row i
+static void catalog_probe(int i, FlashChipData *m) {
+    catalog_entry(i, m);
+    m->read_speed_max *= 1.04f;
+    m->erase_speed *= 0.97f;
+    m->typ_64kb_erase_ms = m->erase_speed;
+}
+
+// ========== Parsing ==========
+
+static void bm_parse_csv_line(mb_state_t *st) {
+    char lines[64][MAX_LINE_LENGTH];
+    char fields[30][MAX_FIELD_LENGTH];
+    for (int i = 0; i < 64; i++) catalog_line(i, lines[i], sizeof(lines[i]));
+    uint64_t bytes = 0;
+    for (uint64_t it = 0; it < st->iterations; it++) {
+        char line[MAX_LINE_LENGTH];
+        int count;
+        // parse_csv_line() only reads the line; the copy keeps it honest
+        strcpy(line, lines[it & 63]);
+        parse_csv_line(line, fields, &count);
+        mb_keep(fields);
+        bytes += strlen(line);
+    }
+    st->items = st->iterations;
+    st->bytes = bytes;
+}
+
+static bool catalog_write_file(int rows) {
+    static int written = -1;
+    if (written == rows) return true;
+    FIL f;
+    if (f_open(&f, CHIP_DATABASE_FILE, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK) return false;
+    char line[MAX_LINE_LENGTH];
+    UINT bw;
+    int n = snprintf(line, sizeof(line),
+                     "chip_model,company,chip_family,capacity_mbit,jedec_id,typ_4kb_erase,max_4kb_erase,"
+                     "typ_32kb_erase,max_32kb_erase,typ_64kb_erase,max_64kb_erase,typ_page_program,"
+                     "max_page_program,max_clock_mhz,50mhz_read_speed\n");
+    bool ok = f_write(&f, line, (UINT)n, &bw) == FR_OK;
+    for (int i = 0; ok && i < rows; i++) {
+        n = catalog_line(i, line, sizeof(line));
+        ok = f_write(&f, line, (UINT)n, &bw) == FR_OK && bw == (UINT)n;
+    }
+    ok = (f_close(&f) == FR_OK) && ok;
+    if (ok) written = rows;
+    return ok;
+}
+
+static void bm_sd_load_chip_database(mb_state_t *st) {
+    mb_pause(st);
+    bool ok = sim_sd_mount() && catalog_write_file((int)st->arg);
+    mb_resume(st);
+    if (!ok) {
+        fprintf(stderr, "[ERROR] cannot write %s to the scratch image\n", CHIP_DATABASE_FILE);
+        return;
+    }
+    for (uint64_t it = 0; it < st->iterations; it++) {
+        sd_load_chip_database();
+        mb_keep(database);
+    }
+    st->items = st->iterations * (uint64_t)st->arg;
+}
+
+// ========== Matching ==========
+
+static void bm_chip_calculate_confidence(mb_state_t *st) {
+    FlashChipData expected, measured;
+    catalog_entry(7, &expected);
+    catalog_probe(7, &measured);
+    for (uint64_t it = 0; it < st->iterations; it++) {
+        confidence_result_t r = chip_calculate_confidence(&measured, &expected);
+        mb_keep(&r);
+    }
+    st->items = st->iterations;
+}
+
+static void bm_chip_match_partial(mb_state_t *st) {
+    int rows = (int)st->arg;
+    FlashChipData probe;
+    mb_pause(st);
+    catalog_fill(rows);
+    catalog_probe(rows / 2, &probe);
+    mb_resume(st);
+    for (uint64_t it = 0; it < st->iterations; it++) {
+        chip_match_partial(&probe);
+        mb_keep(match_candidates);
+    }
+    st->items = st->iterations * (uint64_t)rows;
+}
+
+static void bm_chip_match_database(mb_state_t *st) {
+    int rows = (int)st->arg;
+    FlashChipData probe;
+    mb_pause(st);
+    catalog_fill(rows);
+    catalog_probe(rows / 2, &probe);
+    mb_resume(st);
+    for (uint64_t it = 0; it < st->iterations; it++) {
+        match_status_t s = chip_match_database(&probe);
+        mb_keep(&s);
+    }
+    st->items = st->iterations * (uint64_t)rows;
+}
+
+const mb_def_t mb_catalog_benches[] = {
+    {"BM_parse_csv_line", bm_parse_csv_line},
+    {"BM_sd_load_chip_database", bm_sd_load_chip_database, CATALOG_MIN_ROWS, CATALOG_MAX_ROWS, 10, true},
+    {"BM_chip_calculate_confidence", bm_chip_calculate_confidence},
+    {"BM_chip_match_partial", bm_chip_match_partial, CATALOG_MIN_ROWS, CATALOG_MAX_ROWS, 10, true},
+    {"BM_chip_match_database", bm_chip_match_database, CATALOG_MIN_ROWS, CATALOG_MAX_ROWS, 10, true},
+    {NULL},
+};
@@ -0,0 +1,49 @@
+/*
+ * Host Micro-Benchmarks: SD Driver CRCs
+ * crc7 over SD command frames and crc16 over data blocks (sd_driver/crc.c),
+ * which sit on every SD card transfer.
+ */
+
+#include <stdint.h>
+#include "crc.h"
+#include "microbench.h"
+
+#define CRC_MAX_BLOCK 4096
+
+static char g_block[CRC_MAX_BLOCK];
+
+static void fill_block(void) {
+    uint32_t x = 0x12345678u;
+    for (int i = 0; i < CRC_MAX_BLOCK; i++) {
+        x = x * 1664525u + 1013904223u;
+        g_block[i] = (char)(x >> 24);
+    }
+}
+
+// One command frame (opcode + 4 argument bytes) per iteration
+static void bm_crc7(mb_state_t *st) {
+    fill_block();
+    char sum = 0;
+    for (uint64_t it = 0; it < st->iterations; it++) {
+        sum ^= crc7(&g_block[it & 255], 5);
+    }
+    mb_keep(&sum);
+    st->items = st->iterations;
+    st->bytes = st->iterations * 5u;
+}
+
+static void bm_crc16(mb_state_t *st) {
+    fill_block();
+    unsigned short sum = 0;
+    for (uint64_t it = 0; it < st->iterations; it++) {
+        sum ^= crc16(g_block, (int)st->arg);
+        mb_keep(&sum);
+    }
+    st->bytes = st->iterations * (uint64_t)st->arg;
+}
+
+const mb_def_t mb_crc_benches[] = {
+    {"BM_crc7_cmd", bm_crc7},
+    {"BM_crc16", bm_crc16, 64, CRC_MAX_BLOCK, 8, true},
+    {NULL},
+};
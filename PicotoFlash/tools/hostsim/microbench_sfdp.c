@@ -0,0 +1,77 @@
+/*
+ * Host Micro-Benchmarks: SFDP Decode
+ * identify()'s parameter-header search and BFPT decode on their own, and
+ * identify() end to end against the NOR model (no wire time, so the
+ * figure is firmware plus model CPU cost, not bus time).
+ *
+ * picotoflash.c is compiled into this file so its static helpers are
+ * reachable; the microbench target leaves it out of its source list.
+ */
+
+#define main picotoflash_main
+#include "picotoflash.c"
+#undef main
+
+#include "microbench.h"
+#include "nor_model.h"
+#include "sim.h"
+
+static nor_model_t g_mb_nor;
+static bool g_mb_nor_ready;
+
+// Default-profile NOR model on the firmware's flash bus
+static bool nor_ready(void) {
+    if (g_mb_nor_ready) return true;
+    nor_config_t cfg;
+    nor_config_default(&cfg);
+    if (!nor_model_init(&g_mb_nor, &cfg)) return false;
+    sim_spi_device_t dev = {&g_mb_nor, nor_model_select, nor_model_xfer, nor_model_sck};
+    sim_spi_attach(FLASH_SPI, PIN_CS, &dev);
+    spi_init(FLASH_SPI, 5 * 100 * 1000);
+    gpio_init(PIN_CS);
+    gpio_set_dir(PIN_CS, GPIO_OUT);
+    gpio_put(PIN_CS, 1);
+    g_mb_nor_ready = true;
+    return true;
+}
+
+// Header search + BFPT decode over tables captured once from the model
+static void bm_sfdp_decode(mb_state_t *st) {
+    static ident_t raw;
+    mb_pause(st);
+    bool ok = nor_ready();
+    if (ok) identify(&raw);
+    mb_resume(st);
+    if (!ok || !raw.sfdp_ok) {
+        fprintf(stderr, "[ERROR] NOR model returned no SFDP\n");
+        return;
+    }
+    for (uint64_t it = 0; it < st->iterations; it++) {
+        ident_t id;
+        uint32_t ptp = 0;
+        uint8_t dwords = 0;
+        memcpy(id.bfpt, raw.bfpt, raw.bfpt_len);
+        if (!sfdp_find_bfpt(raw.sfdp_ph, raw.sfdp_nph, &ptp, &dwords)) dwords = 64;
+        id.bfpt_len = (uint16_t)(dwords * 4u > sizeof(id.bfpt) ? sizeof(id.bfpt) : dwords * 4u);
+        sfdp_decode_bfpt(&id);
+        mb_keep(&id);
+    }
+    st->items = st->iterations;
+    st->bytes = st->iterations * raw.bfpt_len;
+}
+
+static void bm_identify(mb_state_t *st) {
+    if (!nor_ready()) return;
+    for (uint64_t it = 0; it < st->iterations; it++) {
+        ident_t id;
+        identify(&id);
+        mb_keep(&id);
+    }
+    st->items = st->iterations;
+}
+
+const mb_def_t mb_sfdp_benches[] = {
+    {"BM_sfdp_decode", bm_sfdp_decode},
+    {"BM_identify_nor_model", bm_identify},
+    {NULL},
+};
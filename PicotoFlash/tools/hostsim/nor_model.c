@@ -0,0 +1,492 @@
+/*
+ * Behavioral SPI NOR Flash Model
+ * Byte-level state machine behind sim_spi: the opcode is the first byte
+ * after CS falls, address/dummy/data phases follow, and anything that
+ * changes the array or a register is committed on CS rising. While WIP is
+ * set only the status reads are answered, as on real parts.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nor_model.h"
+#include "sim.h"
+
+#define SFDP_BFPT_PTP 0x30u
+#define SFDP_BFPT_DWORDS 16u
+#define BUSY_FLOOR 0.25f            // Shortest draw, as a fraction of typical
+
+static const char *const k_op_names[NOR_OP_COUNT] = {
+    "page-program", "4K-erase", "32K-erase", "64K-erase", "chip-erase", "status-write"
+};
+
+const char *nor_op_name(nor_op_t op) {
+    return op < NOR_OP_COUNT ? k_op_names[op] : "?";
+}
+
+// W25Q128JV datasheet figures
+void nor_config_default(nor_config_t *cfg) {
+    static const uint8_t uid[8] = {0xD2, 0x66, 0x38, 0x45, 0x53, 0x1A, 0x2C, 0x29};
+    memset(cfg, 0, sizeof(*cfg));
+    snprintf(cfg->model, sizeof(cfg->model), "W25Q128JV");
+    snprintf(cfg->company, sizeof(cfg->company), "Winbond");
+    cfg->jedec[0] = 0xEF;
+    cfg->jedec[1] = 0x40;
+    cfg->jedec[2] = 0x18;
+    cfg->device_id = 0x17;
+    cfg->size_bytes = 16u * 1024u * 1024u;
+    memcpy(cfg->uid, uid, sizeof(uid));
+    cfg->uid_len = sizeof(uid);
+    cfg->t[NOR_OP_PP] = (nor_timing_t){0.4f, 3.0f};
+    cfg->t[NOR_OP_SE] = (nor_timing_t){45.0f, 400.0f};
+    cfg->t[NOR_OP_BE32] = (nor_timing_t){120.0f, 1600.0f};
+    cfg->t[NOR_OP_BE64] = (nor_timing_t){150.0f, 2000.0f};
+    cfg->t[NOR_OP_CE] = (nor_timing_t){40000.0f, 200000.0f};
+    cfg->t[NOR_OP_WRSR] = (nor_timing_t){10.0f, 15.0f};
+    cfg->max_hz = 133000000u;
+    cfg->read03_max_hz = 50000000u;
+    cfg->spread = 0.06f;
+    cfg->endurance = 100000u;
+    cfg->wear_slowdown = 0.3f;
+    cfg->seed = 1u;
+}
+
+// Raw SFDP dump (as read with 0x5A from address 0)
+bool nor_config_load_sfdp(nor_config_t *cfg, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    size_t n = fread(cfg->sfdp, 1, sizeof(cfg->sfdp), f);
+    fclose(f);
+    if (n < 16 || memcmp(cfg->sfdp, "SFDP", 4) != 0) return false;
+    if (n < sizeof(cfg->sfdp)) memset(&cfg->sfdp[n], 0xFF, sizeof(cfg->sfdp) - n);
+    cfg->sfdp_len = (uint16_t)n;
+    return true;
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+// JESD216B header, one parameter header, 16-DWORD BFPT (single-lane only).
+// Erase types advertise the sizes that have a datasheet time.
+static void build_sfdp(nor_model_t *nor) {
+    uint8_t *s = nor->sfdp;
+    if (nor->cfg.sfdp_len) {
+        memcpy(s, nor->cfg.sfdp, NOR_SFDP_SIZE);
+        return;
+    }
+    memset(s, 0xFF, NOR_SFDP_SIZE);
+    put32(&s[0], 0x50444653u);             // "SFDP"
+    s[4] = 0x06;                            // Minor revision (JESD216B)
+    s[5] = 0x01;                            // Major revision
+    s[6] = 0x00;                            // NPH - 1
+    s[7] = 0xFF;
+
+    s[8] = 0x00;                            // BFPT ID LSB
+    s[9] = 0x06;
+    s[10] = 0x01;
+    s[11] = SFDP_BFPT_DWORDS;
+    s[12] = (uint8_t)SFDP_BFPT_PTP;
+    s[13] = (uint8_t)(SFDP_BFPT_PTP >> 8);
+    s[14] = (uint8_t)(SFDP_BFPT_PTP >> 16);
+    s[15] = 0xFF;                           // BFPT ID MSB
+
+    uint32_t dw[SFDP_BFPT_DWORDS];
+    for (uint32_t i = 0; i < SFDP_BFPT_DWORDS; i++) dw[i] = 0xFFFFFFFFu;
+    bool big = nor->cfg.size_bytes > (16u << 20);
+    bool has4k = nor->cfg.t[NOR_OP_SE].typ_ms > 0.0f;
+    dw[0] = 0xFF800000u | 0xE4u | (has4k ? ((0x20u << 8) | 0x01u) : (0xFFu << 8) | 0x03u) |
+            (big ? (1u << 17) : 0u);
+    uint64_t bits = (uint64_t)nor->cfg.size_bytes * 8u;
+    if (bits <= (1ull << 31)) {
+        dw[1] = (uint32_t)(bits - 1u);
+    } else {
+        uint32_t n = 0;
+        while ((1ull << n) < bits) n++;
+        dw[1] = 0x80000000u | n;
+    }
+    dw[2] = 0x00000000u;                    // No 1-4-4 / 1-1-4
+    dw[3] = 0x00000000u;                    // No 1-1-2 / 1-2-2
+    dw[4] = 0xFFFFFFEEu;                    // No 2-2-2 / 4-4-4
+    dw[5] = 0x0000FFFFu;
+    dw[6] = 0x0000FFFFu;
+
+    // Erase types 1..4 (DWORD 8/9), smallest first
+    uint8_t et_size[4] = {0}, et_op[4] = {0};
+    int n = 0;
+    if (has4k) { et_size[n] = 12; et_op[n++] = 0x20; }
+    if (nor->cfg.t[NOR_OP_BE32].typ_ms > 0.0f) { et_size[n] = 15; et_op[n++] = 0x52; }
+    if (nor->cfg.t[NOR_OP_BE64].typ_ms > 0.0f) { et_size[n] = 16; et_op[n++] = 0xD8; }
+    dw[7] = ((uint32_t)et_op[1] << 24) | ((uint32_t)et_size[1] << 16) | ((uint32_t)et_op[0] << 8) | et_size[0];
+    dw[8] = ((uint32_t)et_op[3] << 24) | ((uint32_t)et_size[3] << 16) | ((uint32_t)et_op[2] << 8) | et_size[2];
+
+    for (uint32_t i = 0; i < SFDP_BFPT_DWORDS; i++) put32(&s[SFDP_BFPT_PTP + i * 4u], dw[i]);
+}
+
+bool nor_model_init(nor_model_t *nor, const nor_config_t *cfg) {
+    memset(nor, 0, sizeof(*nor));
+    nor->cfg = *cfg;
+    if (cfg->size_bytes < NOR_SECTOR_SIZE || (cfg->size_bytes & (cfg->size_bytes - 1u)) != 0) return false;
+    nor->mem = (uint8_t *)malloc(cfg->size_bytes);
+    nor->erase_cycles = (uint32_t *)calloc(cfg->size_bytes / NOR_SECTOR_SIZE, sizeof(uint32_t));
+    if (!nor->mem || !nor->erase_cycles) {
+        nor_model_free(nor);
+        return false;
+    }
+    memset(nor->mem, 0xFF, cfg->size_bytes);
+    pthread_mutex_init(&nor->lock, NULL);
+    nor->rng = ((uint64_t)cfg->seed << 1) | 1u;
+    nor->sr1 = cfg->sr1 & (uint8_t)~(NOR_SR1_WIP | NOR_SR1_WEL);
+    nor->sr2 = cfg->sr2;
+    for (int i = 0; i < NOR_OP_COUNT; i++) nor->stats.ops[i].min_ms = INFINITY;
+    build_sfdp(nor);
+    return true;
+}
+
+void nor_model_free(nor_model_t *nor) {
+    free(nor->mem);
+    free(nor->erase_cycles);
+    nor->mem = NULL;
+    nor->erase_cycles = NULL;
+}
+
+// Pre-wears every sector, e.g. to exercise end-of-life behaviour
+void nor_model_age(nor_model_t *nor, uint32_t cycles) {
+    uint32_t n = nor->cfg.size_bytes / NOR_SECTOR_SIZE;
+    for (uint32_t i = 0; i < n; i++) nor->erase_cycles[i] += cycles;
+}
+
+void nor_model_print_stats(const nor_model_t *nor) {
+    const nor_stats_t *st = &nor->stats;
+    printf("\n[NOR] %s %s (%02X %02X %02X) busy-time statistics\n", nor->cfg.company, nor->cfg.model,
+           nor->cfg.jedec[0], nor->cfg.jedec[1], nor->cfg.jedec[2]);
+    printf("op            |     n |  avg(ms) |  min(ms) |  max(ms) | typ(ms) | max spec\n");
+    printf("--------------+-------+----------+----------+----------+---------+---------\n");
+    for (int i = 0; i < NOR_OP_COUNT; i++) {
+        const nor_op_stats_t *o = &st->ops[i];
+        if (!o->count) continue;
+        printf("%-13s | %5u | %8.3f | %8.3f | %8.3f | %7.2f | %7.1f\n", k_op_names[i], (unsigned)o->count,
+               o->total_ms / o->count, o->min_ms, o->max_ms, nor->cfg.t[i].typ_ms, nor->cfg.t[i].max_ms);
+    }
+    printf("protected drops %u, ignored while busy %u, overclocked bytes %u, worn erases %u\n",
+           (unsigned)st->protected_drops, (unsigned)st->busy_ignored, (unsigned)st->overclocked_bytes,
+           (unsigned)st->worn_erases);
+}
+
+// ============================================================================
+// Timing, protection and wear
+// ============================================================================
+
+static uint64_t rng_next(nor_model_t *nor) {
+    uint64_t x = nor->rng;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    nor->rng = x;
+    return x * 0x2545F4914F6CDD1Dull;
+}
+
+static double rng_unit(nor_model_t *nor) {
+    return ((rng_next(nor) >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static double rng_gauss(nor_model_t *nor) {
+    return sqrt(-2.0 * log(rng_unit(nor))) * cos(2.0 * M_PI * rng_unit(nor));
+}
+
+static bool busy(const nor_model_t *nor) {
+    return sim_now_ns() < nor->busy_until_ns;
+}
+
+// Log-normal draw with mean = typical, slowed by wear, clipped to the spec max
+static void start_busy(nor_model_t *nor, nor_op_t op, uint32_t cycles) {
+    const nor_timing_t *t = &nor->cfg.t[op];
+    if (t->typ_ms <= 0.0f) return;
+    double sigma = nor->cfg.spread;
+    double ms = t->typ_ms * exp(sigma * rng_gauss(nor) - sigma * sigma / 2.0);
+    if (nor->cfg.endurance) {
+        double life = (double)cycles / nor->cfg.endurance;
+        ms *= 1.0 + nor->cfg.wear_slowdown * (life < 2.0 ? life : 2.0);
+    }
+    if (ms < t->typ_ms * BUSY_FLOOR) ms = t->typ_ms * BUSY_FLOOR;
+    if (t->max_ms > 0.0f && ms > t->max_ms) ms = t->max_ms;
+
+    nor->busy_until_ns = sim_now_ns() + (uint64_t)(ms * 1e6);
+    nor_op_stats_t *o = &nor->stats.ops[op];
+    o->count++;
+    o->total_ms += ms;
+    if (ms < o->min_ms) o->min_ms = (float)ms;
+    if (ms > o->max_ms) o->max_ms = (float)ms;
+}
+
+// Winbond layout: BP=1..6 protects size/64..size/2 (4..32 KB with SEC),
+// BP=7 everything; TB picks the bottom, CMP protects the complement
+static bool is_protected(const nor_model_t *nor, uint32_t addr, uint32_t len) {
+    uint32_t size = nor->cfg.size_bytes;
+    uint32_t bp = (nor->sr1 & NOR_SR1_BP_MASK) >> 2;
+    uint32_t span = 0;
+    if (bp == 7) {
+        span = size;
+    } else if (bp && (nor->sr1 & NOR_SR1_SEC)) {
+        span = NOR_SECTOR_SIZE << (bp < 4 ? bp - 1 : 3);
+    } else if (bp) {
+        span = size >> (7 - bp);
+    }
+    uint32_t lo = (nor->sr1 & NOR_SR1_TB) ? 0 : size - span;
+    uint32_t hi = lo + span;
+    bool overlap = span && addr < hi && addr + len > lo;
+    if (!(nor->sr2 & NOR_SR2_CMP)) return overlap;
+    // Complement: protected unless the range lies inside [lo, hi)
+    return !(span && addr >= lo && addr + len <= hi);
+}
+
+static void erase_region(nor_model_t *nor, nor_op_t op, uint32_t size) {
+    uint32_t base = (size >= nor->cfg.size_bytes) ? 0 : (nor->addr & (nor->cfg.size_bytes - 1u)) & ~(size - 1u);
+    if (size > nor->cfg.size_bytes) size = nor->cfg.size_bytes;
+    if (is_protected(nor, base, size)) {
+        nor->stats.protected_drops++;
+        return;
+    }
+    memset(&nor->mem[base], 0xFF, size);
+
+    uint32_t worst = 0;
+    for (uint32_t s = base / NOR_SECTOR_SIZE; s < (base + size) / NOR_SECTOR_SIZE; s++) {
+        uint32_t c = ++nor->erase_cycles[s];
+        if (c > worst) worst = c;
+        if (nor->cfg.endurance && c > nor->cfg.endurance) {
+            double p = (double)(c - nor->cfg.endurance) / nor->cfg.endurance;
+            if (rng_unit(nor) < p) {
+                uint32_t off = (uint32_t)(rng_next(nor) % NOR_SECTOR_SIZE);
+                nor->mem[s * NOR_SECTOR_SIZE + off] &= (uint8_t)~(1u << (rng_next(nor) & 7u));
+                nor->stats.worn_erases++;
+            }
+        }
+    }
+    start_busy(nor, op, worst);
+}
+
+static uint32_t addr_bytes(const nor_model_t *nor) {
+    return nor->addr4 ? 4u : 3u;
+}
+
+static uint8_t status1(const nor_model_t *nor) {
+    uint8_t v = nor->sr1 & (uint8_t)~(NOR_SR1_WIP | NOR_SR1_WEL);
+    if (busy(nor)) v |= NOR_SR1_WIP;
+    if (nor->wel) v |= NOR_SR1_WEL;
+    return v;
+}
+
+// Collects the address phase; true once it is complete
+static bool take_addr(nor_model_t *nor, uint8_t mosi) {
+    uint32_t n = addr_bytes(nor);
+    if (nor->idx <= n) {
+        nor->addr = (nor->addr << 8) | mosi;
+        return false;
+    }
+    return true;
+}
+
+// Array data above the SCK limit: the master samples one bit late
+static uint8_t drive_data(nor_model_t *nor, uint8_t v, uint32_t limit_hz) {
+    if (limit_hz && nor->sck_hz > limit_hz) {
+        nor->stats.overclocked_bytes++;
+        v = (uint8_t)((nor->last_out << 7) | (v >> 1));
+    }
+    return v;
+}
+
+// ============================================================================
+// Bus interface
+// ============================================================================
+
+static void commit(nor_model_t *nor) {
+    uint32_t n = addr_bytes(nor);
+    bool addr_done = nor->idx >= 1u + n;
+    bool volatile_sr = nor->vwel;
+
+    // 0x50 only arms the status write that immediately follows it
+    if (nor->opcode != 0x50 && nor->opcode != 0x01 && nor->opcode != 0x31) nor->vwel = false;
+
+    switch (nor->opcode) {
+        case 0x06: nor->wel = true; break;
+        case 0x04: nor->wel = false; break;
+        case 0x50: nor->vwel = true; break;
+        case 0xB7: nor->addr4 = true; break;
+        case 0xE9: nor->addr4 = false; break;
+        case 0xB9: nor->powered_down = true; break;
+        case 0xAB: nor->powered_down = false; break;
+        case 0x66: nor->reset_armed = true; return;
+        case 0x99:
+            if (nor->reset_armed) {
+                nor->wel = false;
+                nor->addr4 = false;
+            }
+            break;
+
+        case 0x01:
+        case 0x31:
+            if (nor->wr_len == 0 || !(nor->wel || volatile_sr)) break;
+            if (nor->opcode == 0x01) {
+                nor->sr1 = nor->wr[0] & (uint8_t)~(NOR_SR1_WIP | NOR_SR1_WEL);
+                if (nor->wr_len >= 2) nor->sr2 = nor->wr[1];
+            } else {
+                nor->sr2 = nor->wr[0];
+            }
+            if (!volatile_sr) start_busy(nor, NOR_OP_WRSR, 0);
+            nor->wel = false;
+            nor->vwel = false;
+            break;
+
+        case 0x02:
+            if (!nor->wel || nor->idx < 2u + n) break;
+            {
+                uint32_t base = (nor->addr & (nor->cfg.size_bytes - 1u)) & ~(NOR_PAGE_SIZE - 1u);
+                if (is_protected(nor, base, NOR_PAGE_SIZE)) {
+                    nor->stats.protected_drops++;
+                } else {
+                    for (uint32_t i = 0; i < NOR_PAGE_SIZE; i++) {
+                        if (nor->page_used[i]) nor->mem[base + i] &= nor->page[i];
+                    }
+                    start_busy(nor, NOR_OP_PP, nor->erase_cycles[base / NOR_SECTOR_SIZE]);
+                }
+            }
+            nor->wel = false;
+            break;
+
+        case 0x20:
+            if (nor->wel && addr_done) erase_region(nor, NOR_OP_SE, NOR_SECTOR_SIZE);
+            nor->wel = false;
+            break;
+        case 0x52:
+            if (nor->wel && addr_done) erase_region(nor, NOR_OP_BE32, 32768u);
+            nor->wel = false;
+            break;
+        case 0xD8:
+            if (nor->wel && addr_done) erase_region(nor, NOR_OP_BE64, 65536u);
+            nor->wel = false;
+            break;
+        case 0xC7:
+        case 0x60:
+            if (nor->wel) erase_region(nor, NOR_OP_CE, nor->cfg.size_bytes);
+            nor->wel = false;
+            break;
+        default:
+            break;
+    }
+    nor->reset_armed = false;
+}
+
+void nor_model_sck(void *ctx, uint32_t hz) {
+    ((nor_model_t *)ctx)->sck_hz = hz;
+}
+
+void nor_model_select(void *ctx, bool selected) {
+    nor_model_t *nor = (nor_model_t *)ctx;
+    pthread_mutex_lock(&nor->lock);
+    if (selected) {
+        nor->selected = true;
+        nor->idx = 0;
+        nor->addr = 0;
+        nor->wr_len = 0;
+        nor->last_out = 0xFF;
+        memset(nor->page_used, 0, sizeof(nor->page_used));
+    } else if (nor->selected) {
+        nor->selected = false;
+        bool status_op = nor->opcode == 0x05 || nor->opcode == 0x35 || nor->opcode == 0x15;
+        bool wake = nor->opcode == 0xAB;
+        if (nor->idx > 0 && busy(nor) && !status_op) {
+            nor->stats.busy_ignored++;
+        } else if (nor->idx > 0 && (!nor->powered_down || wake)) {
+            commit(nor);
+        }
+    }
+    pthread_mutex_unlock(&nor->lock);
+}
+
+uint8_t nor_model_xfer(void *ctx, uint8_t mosi) {
+    nor_model_t *nor = (nor_model_t *)ctx;
+    uint8_t out = 0xFF;
+    pthread_mutex_lock(&nor->lock);
+    if (!nor->selected) {
+        pthread_mutex_unlock(&nor->lock);
+        return out;
+    }
+    if (nor->idx == 0) {
+        nor->opcode = mosi;
+        nor->idx = 1;
+        pthread_mutex_unlock(&nor->lock);
+        return out;
+    }
+
+    uint8_t op = nor->opcode;
+    bool status_op = op == 0x05 || op == 0x35 || op == 0x15;
+    if ((busy(nor) && !status_op) || (nor->powered_down && op != 0xAB)) {
+        nor->idx++;
+        pthread_mutex_unlock(&nor->lock);
+        return out;
+    }
+
+    uint32_t n = addr_bytes(nor);
+    uint32_t mask = nor->cfg.size_bytes - 1u;
+    switch (op) {
+        case 0x9F:
+            out = nor->cfg.jedec[(nor->idx - 1u) % 3u];
+            break;
+        case 0x05: out = status1(nor); break;
+        case 0x35: out = nor->sr2; break;
+        case 0x15: out = nor->sr3; break;
+        case 0x01:
+        case 0x31:
+            if (nor->wr_len < sizeof(nor->wr)) nor->wr[nor->wr_len++] = mosi;
+            break;
+
+        case 0x03:
+            if (take_addr(nor, mosi)) out = drive_data(nor, nor->mem[nor->addr++ & mask], nor->cfg.read03_max_hz);
+            break;
+        case 0x0B:
+            if (take_addr(nor, mosi) && nor->idx > 1u + n) {
+                out = drive_data(nor, nor->mem[nor->addr++ & mask], nor->cfg.max_hz);
+            }
+            break;
+        case 0x5A:
+            if (nor->idx <= 3u) {
+                nor->addr = (nor->addr << 8) | mosi;
+            } else if (nor->idx > 4u) {
+                out = nor->addr < NOR_SFDP_SIZE ? nor->sfdp[nor->addr] : 0xFF;
+                nor->addr++;
+            }
+            break;
+        case 0x02:
+            if (take_addr(nor, mosi)) {
+                uint32_t col = (nor->addr + (nor->idx - 1u - n)) & (NOR_PAGE_SIZE - 1u);
+                nor->page[col] = nor->page_used[col] ? (uint8_t)(nor->page[col] & mosi) : mosi;
+                nor->page_used[col] = true;
+            }
+            break;
+        case 0x20:
+        case 0x52:
+        case 0xD8:
+            take_addr(nor, mosi);
+            break;
+
+        case 0x4B:
+            if (nor->idx > 4u && nor->idx - 5u < nor->cfg.uid_len) out = nor->cfg.uid[nor->idx - 5u];
+            break;
+        case 0x90:
+            if (nor->idx > 3u) out = ((nor->idx - 4u) & 1u) ? nor->cfg.device_id : nor->cfg.jedec[0];
+            break;
+        case 0xAB:
+            if (nor->idx > 3u) out = nor->cfg.device_id;
+            break;
+        default:
+            break;
+    }
+    nor->last_out = out;
+    nor->idx++;
+    pthread_mutex_unlock(&nor->lock);
+    return out;
+}
@@ -0,0 +1,150 @@
+/*
+ * Behavioral SPI NOR Flash Model
+ * Single-lane command set used by the firmware: 9F, 90, AB, 4B, 5A (SFDP,
+ * generated from the configuration or loaded raw), 03/0B, 02,
+ * 20/52/D8/C7/60, 05/35/15, 06/04, 50/01/31, B7/E9, B9, 66/99. Commands
+ * take effect on CS rising.
+ *
+ * Timing: program/erase/status-write busy times are drawn per operation
+ * from a log-normal distribution whose mean is the datasheet typical,
+ * clipped at the datasheet maximum, and stretched as a sector wears.
+ * Reads clocked above the part's limit come back one bit late.
+ *
+ * Protection: Winbond-style BP2..0/TB/SEC (SR1) and CMP (SR2) regions;
+ * program/erase into a protected range is dropped, as on the chip.
+ *
+ * Wear: per-4 KB erase counters. Past the rated endurance erases leave
+ * stuck-at-0 bits with growing probability.
+ */
+
+#ifndef HOSTSIM_NOR_MODEL_H
+#define HOSTSIM_NOR_MODEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Constants
+#define NOR_PAGE_SIZE 256u
+#define NOR_SECTOR_SIZE 4096u
+#define NOR_SFDP_SIZE 512u
+#define NOR_UID_MAX 16u
+#define NOR_NAME_LEN 32u
+
+// Status register bits
+#define NOR_SR1_WIP 0x01u
+#define NOR_SR1_WEL 0x02u
+#define NOR_SR1_BP_MASK 0x1Cu
+#define NOR_SR1_TB 0x20u
+#define NOR_SR1_SEC 0x40u
+#define NOR_SR2_QE 0x02u
+#define NOR_SR2_CMP 0x40u
+
+typedef enum {
+    NOR_OP_PP = 0,
+    NOR_OP_SE,
+    NOR_OP_BE32,
+    NOR_OP_BE64,
+    NOR_OP_CE,
+    NOR_OP_WRSR,
+    NOR_OP_COUNT
+} nor_op_t;
+
+typedef struct {
+    float typ_ms;
+    float max_ms;
+} nor_timing_t;
+
+typedef struct {
+    char model[NOR_NAME_LEN];
+    char company[NOR_NAME_LEN];
+    uint8_t jedec[3];
+    uint8_t device_id;             // 0x90 / 0xAB response
+    uint32_t size_bytes;           // Power of two
+    uint8_t uid[NOR_UID_MAX];
+    uint8_t uid_len;               // 0 = 0x4B not supported
+    nor_timing_t t[NOR_OP_COUNT];
+    uint32_t max_hz;               // 0x0B and everything else
+    uint32_t read03_max_hz;        // Plain 0x03 read
+    float spread;                  // Sigma of ln(busy time), per operation
+    uint32_t endurance;            // Erase cycles per sector
+    float wear_slowdown;           // Busy-time growth at rated endurance
+    uint32_t seed;
+    uint8_t sr1;                   // Power-on status registers
+    uint8_t sr2;
+    uint8_t sfdp[NOR_SFDP_SIZE];
+    uint16_t sfdp_len;             // 0 = generate
+} nor_config_t;
+
+typedef struct {
+    uint32_t count;
+    double total_ms;
+    float min_ms;
+    float max_ms;
+} nor_op_stats_t;
+
+typedef struct {
+    nor_op_stats_t ops[NOR_OP_COUNT];
+    uint32_t protected_drops;      // Program/erase into a protected range
+    uint32_t busy_ignored;         // Commands sent while WIP
+    uint32_t overclocked_bytes;    // Data bytes read above the SCK limit
+    uint32_t worn_erases;          // Erases that left stuck bits
+} nor_stats_t;
+
+typedef struct {
+    nor_config_t cfg;
+    uint8_t *mem;
+    uint32_t *erase_cycles;        // Per 4 KB sector
+    uint8_t sfdp[NOR_SFDP_SIZE];
+    pthread_mutex_t lock;
+    uint64_t rng;
+    nor_stats_t stats;
+
+    // Registers and modes
+    uint8_t sr1;
+    uint8_t sr2;
+    uint8_t sr3;
+    bool wel;
+    bool vwel;                     // 0x50 armed for the next status write
+    bool addr4;
+    bool powered_down;
+    bool reset_armed;              // 0x66 seen, 0x99 resets
+    uint64_t busy_until_ns;
+    uint32_t sck_hz;               // Bus clock of the current transfer
+
+    // Current transaction
+    bool selected;
+    uint8_t opcode;
+    uint32_t idx;                  // Bytes clocked since CS fell
+    uint32_t addr;
+    uint8_t last_out;
+    uint8_t page[NOR_PAGE_SIZE];
+    bool page_used[NOR_PAGE_SIZE];
+    uint8_t wr[3];                 // Status write data
+    uint8_t wr_len;
+} nor_model_t;
+
+// Function declarations
+void nor_config_default(nor_config_t *cfg);
+bool nor_config_load_sfdp(nor_config_t *cfg, const char *path);
+bool nor_model_init(nor_model_t *nor, const nor_config_t *cfg);
+void nor_model_free(nor_model_t *nor);
+void nor_model_age(nor_model_t *nor, uint32_t cycles);
+void nor_model_print_stats(const nor_model_t *nor);
+const char *nor_op_name(nor_op_t op);
+
+// sim_spi device callbacks
+void nor_model_select(void *ctx, bool selected);
+uint8_t nor_model_xfer(void *ctx, uint8_t mosi);
+void nor_model_sck(void *ctx, uint32_t hz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOSTSIM_NOR_MODEL_H
@@ -0,0 +1,175 @@
+/*
+ * NOR Model Vendor Profiles
+ * One CSV row is one part. Columns (as in the firmware's loader):
+ * model, company, family, capacity_mbit, jedec_id ("EF 40 18"), typ/max
+ * 4 KB, 32 KB, 64 KB erase (ms), typ/max page program (ms), max clock
+ * (MHz), 50 MHz read speed (MB/s). Figures the CSV does not carry (chip
+ * erase, status write, unique ID) are derived or taken from the vendor.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "nor_profile.h"
+
+#define PROFILE_FIELDS 15
+#define PROFILE_FIELD_LEN 64
+#define PROFILE_LINE_LEN 512
+#define READ03_LIMIT_HZ 50000000u   // Plain read is specified to 50 MHz on all listed vendors
+
+typedef char profile_row_t[PROFILE_FIELDS][PROFILE_FIELD_LEN];
+
+static int split_row(char *line, profile_row_t f) {
+    int n = 0;
+    char *p = line;
+    while (n < PROFILE_FIELDS) {
+        bool quoted = (*p == '"');
+        if (quoted) p++;
+        char *start = p;
+        while (*p && (quoted ? *p != '"' : (*p != ',' && *p != '\r' && *p != '\n'))) p++;
+        size_t len = (size_t)(p - start);
+        if (len >= PROFILE_FIELD_LEN) len = PROFILE_FIELD_LEN - 1;
+        memcpy(f[n], start, len);
+        f[n][len] = '\0';
+        n++;
+        if (quoted && *p == '"') p++;
+        if (*p != ',') break;
+        p++;
+    }
+    return n;
+}
+
+static bool parse_jedec(const char *s, uint8_t out[3]) {
+    unsigned a, b, c;
+    if (sscanf(s, "%x %x %x", &a, &b, &c) == 3 && a < 256 && b < 256 && c < 256) {
+        out[0] = (uint8_t)a;
+        out[1] = (uint8_t)b;
+        out[2] = (uint8_t)c;
+        return true;
+    }
+    unsigned long v = strtoul(s, NULL, 16);
+    if (strlen(s) != 6 || v > 0xFFFFFFul) return false;
+    out[0] = (uint8_t)(v >> 16);
+    out[1] = (uint8_t)(v >> 8);
+    out[2] = (uint8_t)v;
+    return true;
+}
+
+static uint32_t fnv1a(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) h = (h ^ (uint8_t)*s++) * 16777619u;
+    return h;
+}
+
+static nor_timing_t timing(const char *typ, const char *max) {
+    nor_timing_t t = {(float)atof(typ), (float)atof(max)};
+    if (t.max_ms < t.typ_ms) t.max_ms = t.typ_ms;
+    return t;
+}
+
+static bool row_to_config(profile_row_t f, nor_config_t *cfg, nor_profile_ref_t *ref) {
+    nor_config_default(cfg);
+    snprintf(cfg->model, sizeof(cfg->model), "%s", f[0]);
+    snprintf(cfg->company, sizeof(cfg->company), "%s", f[1]);
+    if (!parse_jedec(f[4], cfg->jedec)) return false;
+    cfg->device_id = (uint8_t)(cfg->jedec[2] - 1u);
+
+    double mbit = atof(f[3]);
+    uint64_t bytes = (uint64_t)(mbit * 131072.0);
+    if (bytes < NOR_SECTOR_SIZE || bytes > (1ull << 31) || (bytes & (bytes - 1u))) return false;
+    cfg->size_bytes = (uint32_t)bytes;
+
+    cfg->t[NOR_OP_SE] = timing(f[5], f[6]);
+    cfg->t[NOR_OP_BE32] = timing(f[7], f[8]);
+    cfg->t[NOR_OP_BE64] = timing(f[9], f[10]);
+    cfg->t[NOR_OP_PP] = timing(f[11], f[12]);
+
+    // Chip erase is roughly the 64 KB (or 4 KB) erase times the block count
+    const nor_timing_t *unit = cfg->t[NOR_OP_BE64].typ_ms > 0.0f ? &cfg->t[NOR_OP_BE64] : &cfg->t[NOR_OP_SE];
+    uint32_t units = cfg->size_bytes / (unit == &cfg->t[NOR_OP_BE64] ? 65536u : NOR_SECTOR_SIZE);
+    cfg->t[NOR_OP_CE] = (nor_timing_t){unit->typ_ms * units, unit->max_ms * units};
+
+    int mhz = atoi(f[13]);
+    cfg->max_hz = mhz > 0 ? (uint32_t)mhz * 1000000u : READ03_LIMIT_HZ;
+    cfg->read03_max_hz = cfg->max_hz < READ03_LIMIT_HZ ? cfg->max_hz : READ03_LIMIT_HZ;
+
+    // 0x4B: Winbond 64-bit, GigaDevice 128-bit, others not supported
+    cfg->seed = fnv1a(cfg->model);
+    cfg->uid_len = cfg->jedec[0] == 0xEF ? 8u : cfg->jedec[0] == 0xC8 ? 16u : 0u;
+    uint32_t h = cfg->seed;
+    for (uint32_t i = 0; i < NOR_UID_MAX; i++) {
+        h = h * 1103515245u + 12345u;
+        cfg->uid[i] = (uint8_t)(h >> 16);
+    }
+
+    if (ref) {
+        ref->typ_4k_ms = cfg->t[NOR_OP_SE].typ_ms;
+        ref->typ_32k_ms = cfg->t[NOR_OP_BE32].typ_ms;
+        ref->typ_64k_ms = cfg->t[NOR_OP_BE64].typ_ms;
+        ref->typ_pp_ms = cfg->t[NOR_OP_PP].typ_ms;
+        ref->read_mb_s_50mhz = (float)atof(f[14]);
+    }
+    return true;
+}
+
+static bool key_matches(profile_row_t f, const nor_config_t *cfg, const char *key) {
+    if (!key || !*key) return true;
+    if (strcasecmp(key, f[0]) == 0) return true;
+    uint8_t j[3];
+    return parse_jedec(key, j) && memcmp(j, cfg->jedec, 3) == 0;
+}
+
+// key: part name (case-insensitive) or JEDEC ID ("EF4018" / "EF 40 18");
+// NULL or "" takes the first valid row
+bool nor_profile_find(const char *csv_path, const char *key, nor_config_t *cfg, nor_profile_ref_t *ref) {
+    FILE *f = fopen(csv_path, "r");
+    if (!f) return false;
+    char line[PROFILE_LINE_LEN];
+    profile_row_t row;
+    bool found = false;
+    bool header = true;
+    while (!found && fgets(line, sizeof(line), f)) {
+        if (header) {
+            header = false;
+            continue;
+        }
+        if (split_row(line, row) < PROFILE_FIELDS) continue;
+        nor_config_t c;
+        nor_profile_ref_t r;
+        if (!row_to_config(row, &c, &r)) continue;
+        if (key_matches(row, &c, key)) {
+            *cfg = c;
+            if (ref) *ref = r;
+            found = true;
+        }
+    }
+    fclose(f);
+    return found;
+}
+
+int nor_profile_list(const char *csv_path) {
+    FILE *f = fopen(csv_path, "r");
+    if (!f) return -1;
+    char line[PROFILE_LINE_LEN];
+    profile_row_t row;
+    int n = 0;
+    bool header = true;
+    printf("%-20s %-12s %-8s %8s %8s %8s %8s %8s %5s\n", "model", "company", "jedec", "Mbit",
+           "pp(ms)", "4K(ms)", "32K(ms)", "64K(ms)", "MHz");
+    while (fgets(line, sizeof(line), f)) {
+        if (header) {
+            header = false;
+            continue;
+        }
+        nor_config_t c;
+        if (split_row(line, row) < PROFILE_FIELDS || !row_to_config(row, &c, NULL)) continue;
+        printf("%-20s %-12s %02X%02X%02X   %8u %8.2f %8.1f %8.1f %8.1f %5u\n", c.model, c.company,
+               c.jedec[0], c.jedec[1], c.jedec[2], (unsigned)(c.size_bytes / 131072u),
+               c.t[NOR_OP_PP].typ_ms, c.t[NOR_OP_SE].typ_ms, c.t[NOR_OP_BE32].typ_ms,
+               c.t[NOR_OP_BE64].typ_ms, (unsigned)(c.max_hz / 1000000u));
+        n++;
+    }
+    fclose(f);
+    return n;
+}
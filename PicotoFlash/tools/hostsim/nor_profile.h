@@ -0,0 +1,34 @@
+/*
+ * NOR Model Vendor Profiles
+ * Builds nor_config_t from DATASHEET.csv rows (the firmware's chip
+ * database, same column layout as load_database_job()).
+ */
+
+#ifndef HOSTSIM_NOR_PROFILE_H
+#define HOSTSIM_NOR_PROFILE_H
+
+#include <stdbool.h>
+#include "nor_model.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Datasheet figures a run is checked against (fields 11-14 of the row)
+typedef struct {
+    float read_mb_s_50mhz;
+    float typ_4k_ms;
+    float typ_32k_ms;
+    float typ_64k_ms;
+    float typ_pp_ms;
+} nor_profile_ref_t;
+
+// Function declarations
+bool nor_profile_find(const char *csv_path, const char *key, nor_config_t *cfg, nor_profile_ref_t *ref);
+int nor_profile_list(const char *csv_path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOSTSIM_NOR_PROFILE_H
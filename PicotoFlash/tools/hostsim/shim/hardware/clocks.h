@@ -0,0 +1,31 @@
+/*
+ * Host shim: hardware/clocks.h
+ * clk_sys/clk_peri are plain numbers; set_sys_clock_khz accepts any
+ * frequency the RP2040 PLL could reach (checked the same way as the SDK).
+ */
+
+#ifndef HOSTSIM_HARDWARE_CLOCKS_H
+#define HOSTSIM_HARDWARE_CLOCKS_H
+
+#include "pico/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum clock_index { clk_gpout0 = 0, clk_gpout1, clk_gpout2, clk_gpout3, clk_ref, clk_sys,
+                   clk_peri, clk_usb, clk_adc, clk_rtc, CLK_COUNT };
+
+#define CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLK_SYS 0u
+
+uint32_t clock_get_hz(enum clock_index clk_index);
+bool clock_configure(enum clock_index clk_index, uint32_t src, uint32_t auxsrc,
+                     uint32_t src_freq, uint32_t freq);
+bool check_sys_clock_khz(uint32_t freq_khz, uint *vco_freq_out, uint *post_div1_out, uint *post_div2_out);
+bool set_sys_clock_khz(uint32_t freq_khz, bool required);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOSTSIM_HARDWARE_CLOCKS_H
@@ -0,0 +1,15 @@
+/*
+ * Host shim: hardware/dma.h (types only; nothing in the host build moves
+ * data by DMA)
+ */
+
+#ifndef HOSTSIM_HARDWARE_DMA_H
+#define HOSTSIM_HARDWARE_DMA_H
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t ctrl;
+} dma_channel_config;
+
+#endif // HOSTSIM_HARDWARE_DMA_H
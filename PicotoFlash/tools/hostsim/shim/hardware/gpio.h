@@ -0,0 +1,64 @@
+/*
+ * Host shim: hardware/gpio.h
+ * Pin levels and pad settings are kept in a table. Outputs notify the
+ * simulated bus (CS edges); inputs are driven by the harness, which also
+ * raises the registered edge callbacks.
+ */
+
+#ifndef HOSTSIM_HARDWARE_GPIO_H
+#define HOSTSIM_HARDWARE_GPIO_H
+
+#include "pico/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NUM_BANK0_GPIOS 30
+#define GPIO_OUT 1
+#define GPIO_IN 0
+#define GPIO_IRQ_LEVEL_LOW 0x1u
+#define GPIO_IRQ_LEVEL_HIGH 0x2u
+#define GPIO_IRQ_EDGE_FALL 0x4u
+#define GPIO_IRQ_EDGE_RISE 0x8u
+
+enum gpio_function {
+    GPIO_FUNC_XIP = 0, GPIO_FUNC_SPI = 1, GPIO_FUNC_UART = 2, GPIO_FUNC_I2C = 3,
+    GPIO_FUNC_PWM = 4, GPIO_FUNC_SIO = 5, GPIO_FUNC_PIO0 = 6, GPIO_FUNC_PIO1 = 7,
+    GPIO_FUNC_NULL = 0x1f
+};
+enum gpio_drive_strength {
+    GPIO_DRIVE_STRENGTH_2MA = 0, GPIO_DRIVE_STRENGTH_4MA = 1,
+    GPIO_DRIVE_STRENGTH_8MA = 2, GPIO_DRIVE_STRENGTH_12MA = 3
+};
+enum gpio_slew_rate { GPIO_SLEW_RATE_SLOW = 0, GPIO_SLEW_RATE_FAST = 1 };
+enum gpio_override {
+    GPIO_OVERRIDE_NORMAL = 0, GPIO_OVERRIDE_INVERT = 1, GPIO_OVERRIDE_LOW = 2, GPIO_OVERRIDE_HIGH = 3
+};
+
+typedef void (*gpio_irq_callback_t)(uint gpio, uint32_t event_mask);
+
+void gpio_init(uint gpio);
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+void gpio_pull_up(uint gpio);
+void gpio_pull_down(uint gpio);
+void gpio_disable_pulls(uint gpio);
+void gpio_set_drive_strength(uint gpio, enum gpio_drive_strength drive);
+enum gpio_drive_strength gpio_get_drive_strength(uint gpio);
+void gpio_set_slew_rate(uint gpio, enum gpio_slew_rate slew);
+enum gpio_slew_rate gpio_get_slew_rate(uint gpio);
+void gpio_set_inover(uint gpio, uint value);
+void gpio_set_outover(uint gpio, uint value);
+void gpio_set_input_hysteresis_enabled(uint gpio, bool enabled);
+void gpio_set_irq_enabled(uint gpio, uint32_t events, bool enabled);
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t events, bool enabled,
+                                        gpio_irq_callback_t callback);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOSTSIM_HARDWARE_GPIO_H
@@ -0,0 +1,10 @@
+/*
+ * Host shim: hardware/irq.h (types only)
+ */
+
+#ifndef HOSTSIM_HARDWARE_IRQ_H
+#define HOSTSIM_HARDWARE_IRQ_H
+
+typedef void (*irq_handler_t)(void);
+
+#endif // HOSTSIM_HARDWARE_IRQ_H
@@ -0,0 +1,87 @@
+/*
+ * Host shim: hardware/pio.h
+ * There is no PIO model: every state machine claim fails, so the firmware
+ * takes its PL022 paths. Instruction encoders are real (pure functions).
+ */
+
+#ifndef HOSTSIM_HARDWARE_PIO_H
+#define HOSTSIM_HARDWARE_PIO_H
+
+#include "pico/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    volatile uint32_t ctrl;
+    volatile uint32_t input_sync_bypass;
+    volatile uint32_t instr_mem[32];
+} pio_hw_t;
+
+typedef pio_hw_t *PIO;
+extern pio_hw_t *const pio0;
+extern pio_hw_t *const pio1;
+
+typedef struct {
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin;
+} pio_program_t;
+
+typedef struct {
+    uint32_t clkdiv;
+    uint32_t execctrl;
+    uint32_t shiftctrl;
+    uint32_t pinctrl;
+} pio_sm_config;
+
+enum pio_src_dest {
+    pio_pins = 0u, pio_x = 1u, pio_y = 2u, pio_null = 3u, pio_pindirs = 4u,
+    pio_exec_mov = 4u, pio_status = 5u, pio_pc = 5u, pio_isr = 6u, pio_osr = 7u, pio_exec_out = 7u
+};
+
+// Encoders
+uint pio_encode_jmp(uint addr);
+uint pio_encode_jmp_not_x(uint addr);
+uint pio_encode_jmp_x_dec(uint addr);
+uint pio_encode_jmp_not_y(uint addr);
+uint pio_encode_jmp_y_dec(uint addr);
+uint pio_encode_jmp_pin(uint addr);
+uint pio_encode_wait_pin(bool polarity, uint pin);
+uint pio_encode_in(enum pio_src_dest src, uint count);
+uint pio_encode_out(enum pio_src_dest dest, uint count);
+uint pio_encode_push(bool if_full, bool block);
+uint pio_encode_pull(bool if_empty, bool block);
+uint pio_encode_mov(enum pio_src_dest dest, enum pio_src_dest src);
+uint pio_encode_mov_not(enum pio_src_dest dest, enum pio_src_dest src);
+uint pio_encode_set(enum pio_src_dest dest, uint value);
+uint pio_encode_nop(void);
+
+// Configuration
+pio_sm_config pio_get_default_sm_config(void);
+void sm_config_set_in_pins(pio_sm_config *c, uint in_base);
+void sm_config_set_jmp_pin(pio_sm_config *c, uint pin);
+void sm_config_set_wrap(pio_sm_config *c, uint wrap_target, uint wrap);
+void sm_config_set_clkdiv_int_frac(pio_sm_config *c, uint16_t div_int, uint8_t div_frac);
+
+// Programs and state machines (unavailable)
+bool pio_can_add_program(PIO pio, const pio_program_t *program);
+uint pio_add_program(PIO pio, const pio_program_t *program);
+void pio_remove_program(PIO pio, const pio_program_t *program, uint loaded_offset);
+int pio_claim_unused_sm(PIO pio, bool required);
+void pio_sm_unclaim(PIO pio, uint sm);
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config);
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+void pio_sm_restart(PIO pio, uint sm);
+void pio_sm_clear_fifos(PIO pio, uint sm);
+void pio_sm_exec(PIO pio, uint sm, uint instr);
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm);
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data);
+uint32_t pio_sm_get(PIO pio, uint sm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOSTSIM_HARDWARE_PIO_H
@@ -0,0 +1,23 @@
+/*
+ * Host shim: hardware/rtc.h
+ * Runs from the set datetime at host wall-clock pace.
+ */
+
+#ifndef HOSTSIM_HARDWARE_RTC_H
+#define HOSTSIM_HARDWARE_RTC_H
+
+#include "pico/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void rtc_init(void);
+bool rtc_set_datetime(const datetime_t *t);
+bool rtc_get_datetime(datetime_t *t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOSTSIM_HARDWARE_RTC_H
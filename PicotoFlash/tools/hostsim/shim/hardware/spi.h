@@ -0,0 +1,34 @@
+/*
+ * Host shim: hardware/spi.h
+ * PL022 model: baud rates follow the real prescaler arithmetic against the
+ * simulated clk_peri; bytes are exchanged with whatever sim_bus device
+ * currently has its chip select low.
+ */
+
+#ifndef HOSTSIM_HARDWARE_SPI_H
+#define HOSTSIM_HARDWARE_SPI_H
+
+#include "pico/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct spi_inst spi_inst_t;
+extern spi_inst_t *const spi0;
+extern spi_inst_t *const spi1;
+
+uint spi_init(spi_inst_t *spi, uint baudrate);
+void spi_deinit(spi_inst_t *spi);
+uint spi_set_baudrate(spi_inst_t *spi, uint baudrate);
+uint spi_get_baudrate(const spi_inst_t *spi);
+uint spi_get_index(const spi_inst_t *spi);
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len);
+int spi_write_read_blocking(spi_inst_t *spi, const uint8_t *src, uint8_t *dst, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOSTSIM_HARDWARE_SPI_H
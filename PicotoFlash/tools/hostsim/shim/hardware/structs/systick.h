@@ -0,0 +1,19 @@
+/*
+ * Host shim: hardware/structs/systick.h
+ */
+
+#ifndef HOSTSIM_HARDWARE_STRUCTS_SYSTICK_H
+#define HOSTSIM_HARDWARE_STRUCTS_SYSTICK_H
+
+#include <stdint.h>
+
+typedef struct {
+    volatile uint32_t csr;
+    volatile uint32_t rvr;
+    volatile uint32_t cvr;
+    volatile uint32_t calib;
+} systick_hw_t;
+
+extern systick_hw_t *const systick_hw;
+
+#endif // HOSTSIM_HARDWARE_STRUCTS_SYSTICK_H
@@ -0,0 +1,14 @@
+/*
+ * Host shim: hardware/sync.h
+ */
+
+#ifndef HOSTSIM_HARDWARE_SYNC_H
+#define HOSTSIM_HARDWARE_SYNC_H
+
+#include "pico/types.h"
+
+static inline void __dmb(void) { __sync_synchronize(); }
+static inline void __sev(void) {}
+static inline void __wfe(void) {}
+
+#endif // HOSTSIM_HARDWARE_SYNC_H
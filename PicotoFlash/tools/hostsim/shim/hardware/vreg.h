@@ -0,0 +1,17 @@
+/*
+ * Host shim: hardware/vreg.h
+ */
+
+#ifndef HOSTSIM_HARDWARE_VREG_H
+#define HOSTSIM_HARDWARE_VREG_H
+
+enum vreg_voltage {
+    VREG_VOLTAGE_0_85 = 6, VREG_VOLTAGE_0_90, VREG_VOLTAGE_0_95, VREG_VOLTAGE_1_00,
+    VREG_VOLTAGE_1_05, VREG_VOLTAGE_1_10, VREG_VOLTAGE_1_15, VREG_VOLTAGE_1_20,
+    VREG_VOLTAGE_1_25, VREG_VOLTAGE_1_30,
+    VREG_VOLTAGE_DEFAULT = VREG_VOLTAGE_1_10
+};
+
+void vreg_set_voltage(enum vreg_voltage voltage);
+
+#endif // HOSTSIM_HARDWARE_VREG_H
@@ -0,0 +1,15 @@
+/*
+ * Host shim: pico/mutex.h (type only; the SD driver that uses it is
+ * replaced by the file-backed card)
+ */
+
+#ifndef HOSTSIM_PICO_MUTEX_H
+#define HOSTSIM_PICO_MUTEX_H
+
+#include <pthread.h>
+
+typedef struct {
+    pthread_mutex_t m;
+} mutex_t;
+
+#endif // HOSTSIM_PICO_MUTEX_H
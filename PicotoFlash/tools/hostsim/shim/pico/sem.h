@@ -0,0 +1,12 @@
+/*
+ * Host shim: pico/sem.h (type only)
+ */
+
+#ifndef HOSTSIM_PICO_SEM_H
+#define HOSTSIM_PICO_SEM_H
+
+typedef struct {
+    int permits;
+} semaphore_t;
+
+#endif // HOSTSIM_PICO_SEM_H
@@ -0,0 +1,10 @@
+/*
+ * Host shim: pico/stdio.h
+ */
+
+#ifndef HOSTSIM_PICO_STDIO_H
+#define HOSTSIM_PICO_STDIO_H
+
+#include "pico/stdlib.h"
+
+#endif // HOSTSIM_PICO_STDIO_H
@@ -0,0 +1,13 @@
+/*
+ * Host shim: pico/stdio_usb.h
+ * The host terminal is always "connected".
+ */
+
+#ifndef HOSTSIM_PICO_STDIO_USB_H
+#define HOSTSIM_PICO_STDIO_USB_H
+
+#include <stdbool.h>
+
+static inline bool stdio_usb_connected(void) { return true; }
+
+#endif // HOSTSIM_PICO_STDIO_USB_H
@@ -0,0 +1,51 @@
+/*
+ * Host shim: pico/stdlib.h
+ * Time comes from CLOCK_MONOTONIC since process start; sleeps block the
+ * calling thread.
+ */
+
+#ifndef HOSTSIM_PICO_STDLIB_H
+#define HOSTSIM_PICO_STDLIB_H
+
+#include "pico/types.h"
+#include "hardware/gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef count_of
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+#endif
+
+#define PICO_DEFAULT_LED_PIN 25
+#define PICO_DEFAULT_UART_INSTANCE uart0
+#define PICO_DEFAULT_UART_BAUD_RATE 115200
+
+uint64_t time_us_64(void);
+static inline uint32_t time_us_32(void) { return (uint32_t)time_us_64(); }
+static inline absolute_time_t get_absolute_time(void) { return time_us_64(); }
+static inline uint32_t to_ms_since_boot(absolute_time_t t) { return (uint32_t)(t / 1000u); }
+static inline uint64_t to_us_since_boot(absolute_time_t t) { return t; }
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+    return (int64_t)(to - from);
+}
+
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+void busy_wait_us(uint64_t us);
+static inline void busy_wait_us_32(uint32_t us) { busy_wait_us(us); }
+static inline void busy_wait_ms(uint32_t ms) { busy_wait_us((uint64_t)ms * 1000u); }
+void busy_wait_at_least_cycles(uint32_t cycles);
+static inline void tight_loop_contents(void) {}
+static inline void __wfi(void) {}
+
+bool stdio_init_all(void);
+void stdio_flush(void);
+uint get_core_num(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOSTSIM_PICO_STDLIB_H
@@ -0,0 +1,28 @@
+/*
+ * Host shim: pico/types.h
+ */
+
+#ifndef HOSTSIM_PICO_TYPES_H
+#define HOSTSIM_PICO_TYPES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define __not_in_flash_func(f) f
+#define __time_critical_func(f) f
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+
+typedef struct {
+    int16_t year;
+    int8_t month;
+    int8_t day;
+    int8_t dotw;
+    int8_t hour;
+    int8_t min;
+    int8_t sec;
+} datetime_t;
+
+#endif // HOSTSIM_PICO_TYPES_H
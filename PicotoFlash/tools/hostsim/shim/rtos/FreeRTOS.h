@@ -0,0 +1,55 @@
+/*
+ * Host shim: FreeRTOS.h
+ * The kernel API the firmware uses, implemented on POSIX threads in
+ * sim_rtos.c. Tasks are real threads running concurrently (as on the SMP
+ * port); priorities and stack depths are recorded but not enforced. One
+ * tick is one millisecond of host monotonic time.
+ */
+
+#ifndef HOSTSIM_FREERTOS_H
+#define HOSTSIM_FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define configSTACK_DEPTH_TYPE uint32_t
+#define configTICK_RATE_HZ 1000u
+#define configNUM_CORES 2
+#define configTICK_CORE 0
+#define configMAX_PRIORITIES 32
+#define configMINIMAL_STACK_SIZE 256
+#define configTOTAL_HEAP_SIZE (64 * 1024)
+#define configASSERT(x) do { if (!(x)) sim_rtos_assert(__FILE__, __LINE__); } while (0)
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define errQUEUE_EMPTY ((BaseType_t)0)
+#define errQUEUE_FULL ((BaseType_t)0)
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFu)
+#define portTICK_PERIOD_MS ((TickType_t)1000u / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000u))
+#define portYIELD_FROM_ISR(x) ((void)(x))
+#define portYIELD() sim_rtos_yield()
+
+void sim_rtos_assert(const char *file, int line);
+size_t xPortGetFreeHeapSize(void);
+size_t xPortGetMinimumEverFreeHeapSize(void);
+void sim_rtos_yield(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOSTSIM_FREERTOS_H
@@ -0,0 +1,33 @@
+/*
+ * Host shim: semphr.h
+ * Semaphores are queues of zero-size items, as in the kernel; mutexes are
+ * binary semaphores created full (no priority inheritance).
+ */
+
+#ifndef HOSTSIM_SEMPHR_H
+#define HOSTSIM_SEMPHR_H
+
+#include "queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t sim_rtos_semaphore_create(UBaseType_t max, UBaseType_t initial);
+
+#define xSemaphoreCreateBinary() sim_rtos_semaphore_create(1, 0)
+#define xSemaphoreCreateCounting(max, initial) sim_rtos_semaphore_create((max), (initial))
+#define xSemaphoreCreateMutex() sim_rtos_semaphore_create(1, 1)
+#define vSemaphoreDelete(s) vQueueDelete(s)
+#define xSemaphoreTake(s, ticks) xQueueReceive((s), NULL, (ticks))
+#define xSemaphoreGive(s) xQueueSend((s), NULL, 0)
+#define xSemaphoreGiveFromISR(s, woken) xQueueSendFromISR((s), NULL, (woken))
+#define uxSemaphoreGetCount(s) uxQueueMessagesWaiting(s)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOSTSIM_SEMPHR_H
@@ -0,0 +1,66 @@
+/*
+ * Host shim: task.h
+ */
+
+#ifndef HOSTSIM_TASK_H
+#define HOSTSIM_TASK_H
+
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sim_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define taskSCHEDULER_SUSPENDED ((BaseType_t)0)
+#define taskSCHEDULER_NOT_STARTED ((BaseType_t)1)
+#define taskSCHEDULER_RUNNING ((BaseType_t)2)
+#define tskIDLE_PRIORITY ((UBaseType_t)0)
+#define tskNO_AFFINITY ((UBaseType_t)-1)
+
+// uxTaskGetSystemState() row (the fields the firmware reads)
+typedef struct {
+    TaskHandle_t xHandle;
+    const char *pcTaskName;
+    UBaseType_t uxCurrentPriority;
+    configSTACK_DEPTH_TYPE usStackHighWaterMark;
+} TaskStatus_t;
+
+#define taskENTER_CRITICAL() sim_rtos_enter_critical()
+#define taskEXIT_CRITICAL() sim_rtos_exit_critical()
+#define taskYIELD() sim_rtos_yield()
+
+void sim_rtos_enter_critical(void);
+void sim_rtos_exit_critical(void);
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, configSTACK_DEPTH_TYPE stack_depth,
+                       void *param, UBaseType_t priority, TaskHandle_t *created);
+BaseType_t xTaskCreateAffinitySet(TaskFunction_t fn, const char *name, configSTACK_DEPTH_TYPE stack_depth,
+                                  void *param, UBaseType_t priority, UBaseType_t core_mask,
+                                  TaskHandle_t *created);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+void vTaskStartScheduler(void);
+void vTaskSuspendAll(void);
+BaseType_t xTaskResumeAll(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+BaseType_t xTaskGetSchedulerState(void);
+TickType_t xTaskGetTickCount(void);
+const char *pcTaskGetName(TaskHandle_t task);
+UBaseType_t uxTaskGetNumberOfTasks(void);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t max, uint32_t *total_runtime);
+void vTaskCoreAffinitySet(TaskHandle_t task, UBaseType_t core_mask);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+BaseType_t xTaskNotifyStateClear(TaskHandle_t task);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOSTSIM_TASK_H
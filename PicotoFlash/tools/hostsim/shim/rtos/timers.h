@@ -0,0 +1,32 @@
+/*
+ * Host shim: timers.h
+ * Software timers run their callbacks on one daemon thread, like the
+ * kernel's timer task.
+ */
+
+#ifndef HOSTSIM_TIMERS_H
+#define HOSTSIM_TIMERS_H
+
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sim_timer *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload,
+                           void *id, TimerCallbackFunction_t callback);
+BaseType_t xTimerStart(TimerHandle_t t, TickType_t ticks);
+BaseType_t xTimerStop(TimerHandle_t t, TickType_t ticks);
+BaseType_t xTimerReset(TimerHandle_t t, TickType_t ticks);
+BaseType_t xTimerResetFromISR(TimerHandle_t t, BaseType_t *woken);
+BaseType_t xTimerIsTimerActive(TimerHandle_t t);
+void *pvTimerGetTimerID(TimerHandle_t t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOSTSIM_TIMERS_H
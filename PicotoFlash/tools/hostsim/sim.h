@@ -0,0 +1,64 @@
+/*
+ * Host Simulation Internals
+ * Hooks between the SDK/kernel shims, the simulated devices and the
+ * harness in sim_main.c. Firmware sources never include this header.
+ */
+
+#ifndef HOSTSIM_SIM_H
+#define HOSTSIM_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "pico/types.h"
+#include "hardware/spi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ========== Kernel ==========
+bool sim_rtos_idle(void);
+
+// ========== Time and cores ==========
+uint64_t sim_now_ns(void);
+void sim_wait_until_ns(uint64_t t_ns);
+void sim_set_core(uint core);
+
+// ========== GPIO ==========
+// Harness side of an input pin: sets the level and raises the edge callback
+void sim_gpio_drive(uint gpio, bool level);
+void sim_gpio_release(uint gpio);
+
+// Firmware side: called on every output level change (CS edges)
+typedef void (*sim_gpio_out_hook_t)(uint gpio, bool level);
+void sim_gpio_set_output_hook(sim_gpio_out_hook_t hook);
+
+// ========== SPI bus ==========
+// One device per (PL022, chip-select GPIO); bytes go to the device whose CS
+// is low. select() sees every CS edge, xfer() one full-duplex byte, sck()
+// (optional) the bus clock ahead of each blocking transfer.
+typedef struct {
+    void *ctx;
+    void (*select)(void *ctx, bool selected);
+    uint8_t (*xfer)(void *ctx, uint8_t mosi);
+    void (*sck)(void *ctx, uint32_t hz);
+} sim_spi_device_t;
+
+bool sim_spi_attach(spi_inst_t *spi, uint cs_gpio, const sim_spi_device_t *dev);
+void sim_spi_set_wire_time(bool enabled);
+void sim_spi_pace(spi_inst_t *spi, uint64_t start_ns, size_t bytes);
+
+// ========== SD card ==========
+bool sim_sd_open(const char *image_path, uint32_t size_mib);
+bool sim_sd_put(const char *host_path, const char *volume_name);
+bool sim_sd_get(const char *volume_name, const char *host_path);
+bool sim_sd_exists(const char *volume_name);
+bool sim_sd_mount(void);
+void sim_sd_close(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOSTSIM_SIM_H
@@ -0,0 +1,357 @@
+/*
+ * Host Simulation: Harness
+ * Boots the unmodified firmware (picotoflash.c's main, renamed) against the
+ * simulated NOR chip on spi0 and the file-backed SD card, presses GP20 the
+ * requested number of times, waits for each flow to reach its completion
+ * screen and for the task graph to go quiet, then exports files from the
+ * card image and exits. Exit status is 0 when every flow completed (and,
+ * with --check-profile, the measured figures matched the datasheet), 4 when
+ * the firmware booted without a chip database. A card without DATASHEET.csv
+ * gets the fixture next to this file (SIM_DEFAULT_DATASHEET).
+ *
+ *   picotoflash_sim --put DATASHEET.csv --runs 1 --get benchmark_results_20240101.csv
+ *   picotoflash_sim --put DATASHEET.csv --profile DATASHEET.csv:MX25L12835F --check-profile 10
+ */
+
+#include <getopt.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "pico/stdlib.h"
+#include "display_functions.h"
+#include "sd_functions.h"
+#include "write.h"
+#include "nor_model.h"
+#include "nor_profile.h"
+#include "sim.h"
+
+// Board wiring (picotoflash.c, hw_config.c)
+#define SIM_FLASH_CS 6
+#define SIM_BUTTON_RUN 20
+#define SIM_PRESS_MS 120
+#define SIM_MAX_FILES 16
+#define SIM_PP_SLACK_MS 0.25f       // write.c polls WIP every 200 us, plus host sleep overshoot
+
+typedef struct {
+    const char *image;
+    uint32_t image_mib;
+    const char *put[SIM_MAX_FILES];
+    int put_count;
+    const char *get[SIM_MAX_FILES];
+    int get_count;
+    int runs;
+    uint32_t settle_ms;
+    uint32_t timeout_s;
+    bool wire_time;
+    nor_config_t chip;
+    bool have_ref;
+    nor_profile_ref_t ref;
+    float check_pct;                // 0 = no datasheet check
+    uint32_t age_cycles;
+    bool no_datasheet;              // Leave the card without DATASHEET.csv
+} sim_opts_t;
+
+int picotoflash_main(void);
+void __real_display_identification_complete(void);
+
+static sim_opts_t g_opts;
+static nor_model_t g_nor;
+static atomic_int g_flows_done = 0;
+
+// Linked with --wrap: the console task calls this once per completed flow
+void __wrap_display_identification_complete(void) {
+    __real_display_identification_complete();
+    atomic_fetch_add(&g_flows_done, 1);
+}
+
+// ============================================================================
+// Harness
+// ============================================================================
+
+// True once the kernel has stayed idle for settle_ms
+static bool wait_settled(uint32_t settle_ms, uint64_t deadline_us) {
+    uint64_t quiet_since = 0;
+    while (time_us_64() < deadline_us) {
+        if (sim_rtos_idle()) {
+            if (!quiet_since) quiet_since = time_us_64();
+            if (time_us_64() - quiet_since >= (uint64_t)settle_ms * 1000u) return true;
+        } else {
+            quiet_since = 0;
+        }
+        sleep_ms(5);
+    }
+    return false;
+}
+
+static void press_button(uint gpio) {
+    sim_gpio_drive(gpio, false);
+    sleep_ms(SIM_PRESS_MS);
+    sim_gpio_release(gpio);
+}
+
+static void export_files(void) {
+    for (int i = 0; i < g_opts.get_count; i++) {
+        char name[256];
+        snprintf(name, sizeof(name), "%s", g_opts.get[i]);
+        char *host = strchr(name, ':');
+        if (host) *host++ = '\0';
+        else host = name;
+        if (sim_sd_get(name, host)) printf("[SIM] Exported %s -> %s\n", name, host);
+    }
+}
+
+static bool check_one(const char *what, float measured, float datasheet, float allowance) {
+    if (datasheet <= 0.0f) {
+        printf("  %-22s %10.3f %10s   -\n", what, measured, "n/a");
+        return true;
+    }
+    float dev = (measured - datasheet) / datasheet * 100.0f;
+    bool ok = measured > 0.0f &&
+              (fabsf(dev) <= g_opts.check_pct || fabsf(measured - datasheet) <= allowance);
+    printf("  %-22s %10.3f %10.3f %+7.1f%%  %s\n", what, measured, datasheet, dev, ok ? "OK" : "OUT");
+    return ok;
+}
+
+// Page program time from the write bench's page row, minus its wire time
+static float measured_pp_ms(void) {
+    for (int c = g_write_result_count - 1; c >= 0; c--) {
+        const write_bench_capture_t *cap = &g_write_results[c];
+        for (int i = 0; cap->valid && i < cap->num_results; i++) {
+            if (cap->results[i].size_bytes != 256 || cap->clock_mhz_actual <= 0) continue;
+            double wire_us = (4.0 + 256.0) * 8.0 / cap->clock_mhz_actual;
+            return (float)((cap->results[i].stats.avg_us - wire_us) / 1000.0);
+        }
+    }
+    return 0.0f;
+}
+
+// Benchmarks against the profile's own datasheet row
+static bool check_profile(void) {
+    printf("\n[SIM] Datasheet check for %s (tolerance %.1f%%)\n", g_opts.chip.model, g_opts.check_pct);
+    printf("  %-22s %10s %10s %8s\n", "figure", "measured", "datasheet", "dev");
+    bool ok = true;
+    // Throughput only means something when the bus is paced
+    ok &= check_one("read MB/s @50MHz", test_chip.read_speed_max,
+                    g_opts.wire_time ? g_opts.ref.read_mb_s_50mhz : 0.0f, 0.0f);
+    ok &= check_one("4K erase ms", test_chip.typ_4kb_erase_ms, g_opts.ref.typ_4k_ms, 0.0f);
+    ok &= check_one("32K erase ms", test_chip.typ_32kb_erase_ms, g_opts.ref.typ_32k_ms, 0.0f);
+    ok &= check_one("64K erase ms", test_chip.typ_64kb_erase_ms, g_opts.ref.typ_64k_ms, 0.0f);
+    ok &= check_one("page program ms", measured_pp_ms(), g_opts.ref.typ_pp_ms, SIM_PP_SLACK_MS);
+    return ok;
+}
+
+static void finish(int code) {
+    nor_model_print_stats(&g_nor);
+    if (code == 0 && g_opts.check_pct > 0.0f && !check_profile()) code = 3;
+    export_files();
+    fflush(stdout);
+    fflush(stderr);
+    _exit(code);
+}
+
+static void *harness(void *arg) {
+    (void)arg;
+    uint64_t t0 = time_us_64();
+    uint64_t deadline = t0 + (uint64_t)g_opts.timeout_s * 1000000u;
+
+    if (!wait_settled(g_opts.settle_ms, deadline)) {
+        printf("[SIM] [ERROR] Boot did not settle\n");
+        finish(2);
+    }
+    printf("[SIM] Boot settled after %.1f ms\n", (time_us_64() - t0) / 1000.0);
+    // Without one every flow stops short of its completion screen
+    if (!database_loaded) {
+        printf("[SIM] [ERROR] No chip database loaded at boot (%s missing or unreadable on the card)\n",
+               CHIP_DATABASE_FILE);
+        finish(4);
+    }
+
+    for (int run = 0; run < g_opts.runs; run++) {
+        uint64_t r0 = time_us_64();
+        int want = atomic_load(&g_flows_done) + 1;
+        printf("[SIM] Pressing GP%d (run %d/%d)\n", SIM_BUTTON_RUN, run + 1, g_opts.runs);
+        press_button(SIM_BUTTON_RUN);
+        while (atomic_load(&g_flows_done) < want) {
+            if (time_us_64() > deadline) {
+                printf("[SIM] [ERROR] Flow %d did not complete before the timeout\n", run + 1);
+                finish(1);
+            }
+            sleep_ms(10);
+        }
+        if (!wait_settled(g_opts.settle_ms, deadline)) {
+            printf("[SIM] [ERROR] Tasks still busy after flow %d\n", run + 1);
+            finish(1);
+        }
+        printf("[SIM] Flow %d complete in %.1f s\n", run + 1, (time_us_64() - r0) / 1e6);
+    }
+    finish(0);
+    return NULL;
+}
+
+// ============================================================================
+// Options
+// ============================================================================
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --image PATH        SD card image (default hostsim_sd.img, created if missing)\n"
+            "  --image-mib N       size of a new image (default 64)\n"
+            "  --put HOST[:NAME]   copy a host file onto the card before boot (repeatable)\n"
+            "  --get NAME[:HOST]   copy a card file to the host at exit (repeatable)\n"
+            "  --no-datasheet      do not add the bundled DATASHEET.csv to a card without one\n"
+            "  --runs N            GP20 presses, each waiting for its flow (default 1)\n"
+            "  --profile CSV[:KEY] simulated chip from a DATASHEET.csv row (KEY = part or JEDEC ID)\n"
+            "  --list-profiles CSV print the parts a CSV provides and exit\n"
+            "  --jedec XXXXXX      simulated chip JEDEC ID (default EF4018)\n"
+            "  --size-mib N        simulated chip size (default 16)\n"
+            "  --sfdp FILE         raw SFDP table instead of the generated one\n"
+            "  --protect SR1       power-on status register 1 (BP/TB/SEC bits)\n"
+            "  --age N             pre-wear every sector by N erase cycles\n"
+            "  --seed N            busy-time random seed\n"
+            "  --check-profile PCT exit 3 unless benchmarks match the profile's datasheet row\n"
+            "  --settle-ms N       quiet period that counts as idle (default 1500)\n"
+            "  --timeout-s N       give up after this long (default 900)\n"
+            "  --no-wire-time      do not pace SPI/SD transfers to their bus time\n",
+            argv0);
+}
+
+static bool parse_args(int argc, char **argv) {
+    enum { O_IMAGE = 1, O_IMAGE_MIB, O_PUT, O_GET, O_RUNS, O_JEDEC, O_SIZE, O_SETTLE, O_TIMEOUT, O_NOWIRE,
+           O_PROFILE, O_LIST, O_SFDP, O_PROTECT, O_AGE, O_SEED, O_CHECK, O_NODS };
+    static const struct option longopts[] = {
+        {"image", required_argument, NULL, O_IMAGE},
+        {"image-mib", required_argument, NULL, O_IMAGE_MIB},
+        {"put", required_argument, NULL, O_PUT},
+        {"get", required_argument, NULL, O_GET},
+        {"runs", required_argument, NULL, O_RUNS},
+        {"jedec", required_argument, NULL, O_JEDEC},
+        {"size-mib", required_argument, NULL, O_SIZE},
+        {"settle-ms", required_argument, NULL, O_SETTLE},
+        {"timeout-s", required_argument, NULL, O_TIMEOUT},
+        {"no-wire-time", no_argument, NULL, O_NOWIRE},
+        {"profile", required_argument, NULL, O_PROFILE},
+        {"list-profiles", required_argument, NULL, O_LIST},
+        {"sfdp", required_argument, NULL, O_SFDP},
+        {"protect", required_argument, NULL, O_PROTECT},
+        {"age", required_argument, NULL, O_AGE},
+        {"seed", required_argument, NULL, O_SEED},
+        {"check-profile", required_argument, NULL, O_CHECK},
+        {"no-datasheet", no_argument, NULL, O_NODS},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+
+    g_opts.image = "hostsim_sd.img";
+    g_opts.image_mib = 64;
+    g_opts.runs = 1;
+    g_opts.settle_ms = 1500;
+    g_opts.timeout_s = 900;
+    g_opts.wire_time = true;
+    nor_config_default(&g_opts.chip);
+
+    int c;
+    while ((c = getopt_long(argc, argv, "h", longopts, NULL)) != -1) {
+        switch (c) {
+            case O_IMAGE: g_opts.image = optarg; break;
+            case O_IMAGE_MIB: g_opts.image_mib = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case O_PUT:
+                if (g_opts.put_count >= SIM_MAX_FILES) return false;
+                g_opts.put[g_opts.put_count++] = optarg;
+                break;
+            case O_GET:
+                if (g_opts.get_count >= SIM_MAX_FILES) return false;
+                g_opts.get[g_opts.get_count++] = optarg;
+                break;
+            case O_RUNS: g_opts.runs = atoi(optarg); break;
+            case O_JEDEC: {
+                uint32_t id = (uint32_t)strtoul(optarg, NULL, 16);
+                g_opts.chip.jedec[0] = (uint8_t)(id >> 16);
+                g_opts.chip.jedec[1] = (uint8_t)(id >> 8);
+                g_opts.chip.jedec[2] = (uint8_t)id;
+                g_opts.chip.device_id = (uint8_t)(id - 1u);
+                break;
+            }
+            case O_SIZE: g_opts.chip.size_bytes = (uint32_t)strtoul(optarg, NULL, 0) << 20; break;
+            case O_SETTLE: g_opts.settle_ms = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case O_TIMEOUT: g_opts.timeout_s = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case O_NOWIRE: g_opts.wire_time = false; break;
+            case O_PROFILE: {
+                char csv[256];
+                snprintf(csv, sizeof(csv), "%s", optarg);
+                char *key = strchr(csv, ':');
+                if (key) *key++ = '\0';
+                if (!nor_profile_find(csv, key, &g_opts.chip, &g_opts.ref)) {
+                    fprintf(stderr, "[SIM] no profile %s in %s\n", key ? key : "(first)", csv);
+                    return false;
+                }
+                g_opts.have_ref = true;
+                break;
+            }
+            case O_LIST: exit(nor_profile_list(optarg) > 0 ? 0 : 2);
+            case O_SFDP:
+                if (!nor_config_load_sfdp(&g_opts.chip, optarg)) {
+                    fprintf(stderr, "[SIM] %s is not an SFDP dump\n", optarg);
+                    return false;
+                }
+                break;
+            case O_PROTECT: g_opts.chip.sr1 = (uint8_t)strtoul(optarg, NULL, 16); break;
+            case O_AGE: g_opts.age_cycles = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case O_SEED: g_opts.chip.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case O_CHECK: g_opts.check_pct = (float)atof(optarg); break;
+            case O_NODS: g_opts.no_datasheet = true; break;
+            default: return false;
+        }
+    }
+    return optind == argc;
+}
+
+int main(int argc, char **argv) {
+    if (!parse_args(argc, argv)) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (g_opts.check_pct > 0.0f && !g_opts.have_ref) {
+        fprintf(stderr, "[SIM] --check-profile needs --profile\n");
+        return 2;
+    }
+    sim_spi_set_wire_time(g_opts.wire_time);
+
+    if (!sim_sd_open(g_opts.image, g_opts.image_mib)) return 2;
+    for (int i = 0; i < g_opts.put_count; i++) {
+        char host[256];
+        snprintf(host, sizeof(host), "%s", g_opts.put[i]);
+        char *name = strchr(host, ':');
+        if (name) {
+            *name++ = '\0';
+        } else {
+            name = strrchr(host, '/') ? strrchr(host, '/') + 1 : host;
+        }
+        if (!sim_sd_put(host, name)) return 2;
+    }
+    if (!g_opts.no_datasheet && !sim_sd_exists(CHIP_DATABASE_FILE)) {
+        if (!sim_sd_put(SIM_DEFAULT_DATASHEET, CHIP_DATABASE_FILE)) return 2;
+        printf("[SIM] Card had no %s, added %s\n", CHIP_DATABASE_FILE, SIM_DEFAULT_DATASHEET);
+    }
+
+    if (!nor_model_init(&g_nor, &g_opts.chip)) {
+        fprintf(stderr, "[SIM] bad chip configuration\n");
+        return 2;
+    }
+    nor_model_age(&g_nor, g_opts.age_cycles);
+    printf("[SIM] Flash: %s %s, %u Mbit, JEDEC %02X %02X %02X\n", g_opts.chip.company, g_opts.chip.model,
+           (unsigned)(g_opts.chip.size_bytes / 131072u), g_opts.chip.jedec[0], g_opts.chip.jedec[1],
+           g_opts.chip.jedec[2]);
+    sim_spi_device_t dev = {&g_nor, nor_model_select, nor_model_xfer, nor_model_sck};
+    sim_spi_attach(spi0, SIM_FLASH_CS, &dev);
+
+    pthread_t th;
+    pthread_create(&th, NULL, harness, NULL);
+    pthread_detach(th);
+
+    return picotoflash_main();
+}
@@ -0,0 +1,390 @@
+/*
+ * Host Simulation: pico SDK Shim
+ * Time, cores, GPIO, clocks, RTC, voltage regulator and SysTick for the
+ * host build. Time is host CLOCK_MONOTONIC since process start, so the
+ * firmware's time_us_64() benchmarks measure real elapsed time (device
+ * busy periods and, by default, SPI wire time are paced in real time).
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/clocks.h"
+#include "hardware/rtc.h"
+#include "hardware/vreg.h"
+#include "hardware/structs/systick.h"
+#include "sim.h"
+
+#define XOSC_KHZ 12000u
+#define PLL_VCO_MIN_KHZ 750000u
+#define PLL_VCO_MAX_KHZ 1600000u
+#define SPIN_BELOW_NS 50000u        // Shorter waits spin instead of sleeping
+
+typedef struct {
+    enum gpio_function fn;
+    bool out;
+    bool level;                     // Output latch
+    bool driven;                    // Input held by the harness
+    bool drive_level;
+    bool pull_up;
+    bool pull_down;
+    uint inover;
+    uint32_t irq_events;
+    enum gpio_drive_strength drive;
+    enum gpio_slew_rate slew;
+} sim_gpio_t;
+
+static uint64_t g_t0_ns;
+static __thread uint t_core = 0;
+static pthread_mutex_t g_gpio_lock = PTHREAD_MUTEX_INITIALIZER;
+static sim_gpio_t g_gpio[NUM_BANK0_GPIOS];
+static gpio_irq_callback_t g_gpio_cb = NULL;
+static sim_gpio_out_hook_t g_out_hook = NULL;
+static uint32_t g_clk_hz[CLK_COUNT];
+static datetime_t g_rtc_set;
+static uint64_t g_rtc_set_us;
+static bool g_rtc_running = false;
+static enum vreg_voltage g_vreg = VREG_VOLTAGE_DEFAULT;
+static systick_hw_t g_systick;
+systick_hw_t *const systick_hw = &g_systick;
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+__attribute__((constructor)) static void sim_pico_init(void) {
+    g_t0_ns = mono_ns();
+    g_clk_hz[clk_ref] = XOSC_KHZ * 1000u;
+    g_clk_hz[clk_sys] = 125000000u;
+    g_clk_hz[clk_peri] = 125000000u;
+    g_clk_hz[clk_usb] = 48000000u;
+    g_clk_hz[clk_adc] = 48000000u;
+    g_clk_hz[clk_rtc] = 46875u;
+    g_systick.rvr = 125000000u / 1000u - 1u;
+    for (uint i = 0; i < NUM_BANK0_GPIOS; i++) {
+        g_gpio[i].fn = GPIO_FUNC_NULL;
+        g_gpio[i].pull_down = true;
+        g_gpio[i].drive = GPIO_DRIVE_STRENGTH_4MA;
+    }
+}
+
+// ============================================================================
+// Time and cores
+// ============================================================================
+
+uint64_t sim_now_ns(void) {
+    return mono_ns() - g_t0_ns;
+}
+
+void sim_wait_until_ns(uint64_t t_ns) {
+    uint64_t now = sim_now_ns();
+    while (now < t_ns) {
+        uint64_t left = t_ns - now;
+        if (left > SPIN_BELOW_NS) {
+            struct timespec ts = {0, (long)(left - SPIN_BELOW_NS / 2)};
+            if (left - SPIN_BELOW_NS / 2 >= 1000000000ull) {
+                ts.tv_sec = (time_t)((left - SPIN_BELOW_NS / 2) / 1000000000ull);
+                ts.tv_nsec = (long)((left - SPIN_BELOW_NS / 2) % 1000000000ull);
+            }
+            nanosleep(&ts, NULL);
+        }
+        now = sim_now_ns();
+    }
+}
+
+uint64_t time_us_64(void) {
+    return sim_now_ns() / 1000u;
+}
+
+void sleep_us(uint64_t us) {
+    sim_wait_until_ns(sim_now_ns() + us * 1000u);
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us((uint64_t)ms * 1000u);
+}
+
+void busy_wait_us(uint64_t us) {
+    sleep_us(us);
+}
+
+void busy_wait_at_least_cycles(uint32_t cycles) {
+    uint64_t ns = ((uint64_t)cycles * 1000000000ull + g_clk_hz[clk_sys] - 1) / g_clk_hz[clk_sys];
+    sim_wait_until_ns(sim_now_ns() + ns);
+}
+
+void sim_set_core(uint core) {
+    t_core = core;
+}
+
+uint get_core_num(void) {
+    return t_core;
+}
+
+// The linker script's per-core stack regions (SCRATCH_Y, SCRATCH_X). Host
+// threads run on their own stacks, so these stay as painted.
+uint32_t sim_core_stack[2][1024];
+__asm__(".globl __StackBottom, __StackTop, __StackOneBottom, __StackOneTop\n"
+        ".set __StackBottom, sim_core_stack\n"
+        ".set __StackTop, sim_core_stack + 4096\n"
+        ".set __StackOneBottom, sim_core_stack + 4096\n"
+        ".set __StackOneTop, sim_core_stack + 8192\n");
+
+bool stdio_init_all(void) {
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    return true;
+}
+
+void stdio_flush(void) {
+    fflush(stdout);
+}
+
+// ============================================================================
+// GPIO
+// ============================================================================
+
+static bool pin_ok(uint gpio) {
+    return gpio < NUM_BANK0_GPIOS;
+}
+
+static bool pin_level(const sim_gpio_t *g) {
+    bool v;
+    if (g->out && g->fn == GPIO_FUNC_SIO) v = g->level;
+    else if (g->driven) v = g->drive_level;
+    else v = g->pull_up;
+    if (g->inover == GPIO_OVERRIDE_INVERT) v = !v;
+    else if (g->inover == GPIO_OVERRIDE_LOW) v = false;
+    else if (g->inover == GPIO_OVERRIDE_HIGH) v = true;
+    return v;
+}
+
+void sim_gpio_set_output_hook(sim_gpio_out_hook_t hook) {
+    g_out_hook = hook;
+}
+
+void gpio_init(uint gpio) {
+    if (!pin_ok(gpio)) return;
+    pthread_mutex_lock(&g_gpio_lock);
+    g_gpio[gpio].fn = GPIO_FUNC_SIO;
+    g_gpio[gpio].out = false;
+    g_gpio[gpio].level = false;
+    pthread_mutex_unlock(&g_gpio_lock);
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn) {
+    if (!pin_ok(gpio)) return;
+    g_gpio[gpio].fn = fn;
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    if (!pin_ok(gpio)) return;
+    g_gpio[gpio].out = out;
+}
+
+void gpio_put(uint gpio, bool value) {
+    if (!pin_ok(gpio)) return;
+    pthread_mutex_lock(&g_gpio_lock);
+    bool changed = g_gpio[gpio].level != value;
+    g_gpio[gpio].level = value;
+    pthread_mutex_unlock(&g_gpio_lock);
+    if (changed && g_out_hook) g_out_hook(gpio, value);
+}
+
+bool gpio_get(uint gpio) {
+    if (!pin_ok(gpio)) return false;
+    pthread_mutex_lock(&g_gpio_lock);
+    bool v = pin_level(&g_gpio[gpio]);
+    pthread_mutex_unlock(&g_gpio_lock);
+    return v;
+}
+
+void gpio_pull_up(uint gpio) {
+    if (!pin_ok(gpio)) return;
+    g_gpio[gpio].pull_up = true;
+    g_gpio[gpio].pull_down = false;
+}
+
+void gpio_pull_down(uint gpio) {
+    if (!pin_ok(gpio)) return;
+    g_gpio[gpio].pull_up = false;
+    g_gpio[gpio].pull_down = true;
+}
+
+void gpio_disable_pulls(uint gpio) {
+    if (!pin_ok(gpio)) return;
+    g_gpio[gpio].pull_up = false;
+    g_gpio[gpio].pull_down = false;
+}
+
+void gpio_set_drive_strength(uint gpio, enum gpio_drive_strength drive) {
+    if (pin_ok(gpio)) g_gpio[gpio].drive = drive;
+}
+
+enum gpio_drive_strength gpio_get_drive_strength(uint gpio) {
+    return pin_ok(gpio) ? g_gpio[gpio].drive : GPIO_DRIVE_STRENGTH_4MA;
+}
+
+void gpio_set_slew_rate(uint gpio, enum gpio_slew_rate slew) {
+    if (pin_ok(gpio)) g_gpio[gpio].slew = slew;
+}
+
+enum gpio_slew_rate gpio_get_slew_rate(uint gpio) {
+    return pin_ok(gpio) ? g_gpio[gpio].slew : GPIO_SLEW_RATE_SLOW;
+}
+
+void gpio_set_inover(uint gpio, uint value) {
+    if (pin_ok(gpio)) g_gpio[gpio].inover = value;
+}
+
+void gpio_set_outover(uint gpio, uint value) {
+    (void)gpio;
+    (void)value;
+}
+
+void gpio_set_input_hysteresis_enabled(uint gpio, bool enabled) {
+    (void)gpio;
+    (void)enabled;
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t events, bool enabled) {
+    if (!pin_ok(gpio)) return;
+    pthread_mutex_lock(&g_gpio_lock);
+    if (enabled) g_gpio[gpio].irq_events |= events;
+    else g_gpio[gpio].irq_events &= ~events;
+    pthread_mutex_unlock(&g_gpio_lock);
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t events, bool enabled,
+                                        gpio_irq_callback_t callback) {
+    gpio_set_irq_enabled(gpio, events, enabled);
+    if (enabled) g_gpio_cb = callback;
+}
+
+static void drive_pin(uint gpio, bool driven, bool level) {
+    if (!pin_ok(gpio)) return;
+    pthread_mutex_lock(&g_gpio_lock);
+    bool before = pin_level(&g_gpio[gpio]);
+    g_gpio[gpio].driven = driven;
+    g_gpio[gpio].drive_level = level;
+    bool after = pin_level(&g_gpio[gpio]);
+    uint32_t events = 0;
+    if (before && !after) events = GPIO_IRQ_EDGE_FALL;
+    if (!before && after) events = GPIO_IRQ_EDGE_RISE;
+    events &= g_gpio[gpio].irq_events;
+    gpio_irq_callback_t cb = g_gpio_cb;
+    pthread_mutex_unlock(&g_gpio_lock);
+
+    // Runs on the harness thread, which stands in for the core 0 IRQ
+    if (events && cb) {
+        uint core = t_core;
+        t_core = 0;
+        cb(gpio, events);
+        t_core = core;
+    }
+}
+
+void sim_gpio_drive(uint gpio, bool level) {
+    drive_pin(gpio, true, level);
+}
+
+void sim_gpio_release(uint gpio) {
+    drive_pin(gpio, false, false);
+}
+
+// ============================================================================
+// Clocks
+// ============================================================================
+
+uint32_t clock_get_hz(enum clock_index clk_index) {
+    return clk_index < CLK_COUNT ? g_clk_hz[clk_index] : 0;
+}
+
+bool clock_configure(enum clock_index clk_index, uint32_t src, uint32_t auxsrc,
+                     uint32_t src_freq, uint32_t freq) {
+    (void)src;
+    (void)auxsrc;
+    if (clk_index >= CLK_COUNT || freq > src_freq) return false;
+    g_clk_hz[clk_index] = freq;
+    return true;
+}
+
+// Same search as the SDK: highest VCO first, then post dividers
+bool check_sys_clock_khz(uint32_t freq_khz, uint *vco_freq_out, uint *post_div1_out, uint *post_div2_out) {
+    for (uint fbdiv = 320; fbdiv >= 16; fbdiv--) {
+        uint vco_khz = fbdiv * XOSC_KHZ;
+        if (vco_khz < PLL_VCO_MIN_KHZ || vco_khz > PLL_VCO_MAX_KHZ) continue;
+        for (uint pd1 = 7; pd1 >= 1; pd1--) {
+            for (uint pd2 = pd1; pd2 >= 1; pd2--) {
+                if (vco_khz % (pd1 * pd2)) continue;
+                if (vco_khz / (pd1 * pd2) == freq_khz) {
+                    if (vco_freq_out) *vco_freq_out = vco_khz * 1000u;
+                    if (post_div1_out) *post_div1_out = pd1;
+                    if (post_div2_out) *post_div2_out = pd2;
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+// Like the SDK, clk_peri is re-pointed at the new clk_sys
+bool set_sys_clock_khz(uint32_t freq_khz, bool required) {
+    if (!check_sys_clock_khz(freq_khz, NULL, NULL, NULL)) {
+        if (required) {
+            fprintf(stderr, "[SIM] clk_sys %u kHz is not reachable\n", (unsigned)freq_khz);
+        }
+        return false;
+    }
+    if (freq_khz > 133000u && g_vreg < VREG_VOLTAGE_1_15) {
+        printf("[SIM] [WARN] clk_sys %u kHz at default core voltage\n", (unsigned)freq_khz);
+    }
+    g_clk_hz[clk_sys] = freq_khz * 1000u;
+    g_clk_hz[clk_peri] = freq_khz * 1000u;
+    return true;
+}
+
+void vreg_set_voltage(enum vreg_voltage voltage) {
+    g_vreg = voltage;
+}
+
+// ============================================================================
+// RTC
+// ============================================================================
+
+void rtc_init(void) {
+    g_rtc_running = false;
+}
+
+bool rtc_set_datetime(const datetime_t *t) {
+    g_rtc_set = *t;
+    g_rtc_set_us = time_us_64();
+    g_rtc_running = true;
+    return true;
+}
+
+bool rtc_get_datetime(datetime_t *t) {
+    if (!g_rtc_running) return false;
+    struct tm tm = {0};
+    tm.tm_year = g_rtc_set.year - 1900;
+    tm.tm_mon = g_rtc_set.month - 1;
+    tm.tm_mday = g_rtc_set.day;
+    tm.tm_hour = g_rtc_set.hour;
+    tm.tm_min = g_rtc_set.min;
+    tm.tm_sec = g_rtc_set.sec;
+    time_t secs = timegm(&tm) + (time_t)((time_us_64() - g_rtc_set_us) / 1000000u);
+    gmtime_r(&secs, &tm);
+    t->year = (int16_t)(tm.tm_year + 1900);
+    t->month = (int8_t)(tm.tm_mon + 1);
+    t->day = (int8_t)tm.tm_mday;
+    t->dotw = (int8_t)tm.tm_wday;
+    t->hour = (int8_t)tm.tm_hour;
+    t->min = (int8_t)tm.tm_min;
+    t->sec = (int8_t)tm.tm_sec;
+    return true;
+}
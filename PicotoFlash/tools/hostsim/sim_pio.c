@@ -0,0 +1,134 @@
+/*
+ * Host Simulation: PIO Shim
+ * No state machine is modelled. pio_spi_init() and pio_pp_begin() report
+ * failure, so the firmware runs its PL022 fallbacks exactly as on a board
+ * whose PIO block is taken; the instruction encoders are the real ones.
+ */
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "pio_spi.h"
+#include "pio_pp.h"
+
+static pio_hw_t g_pio[2];
+pio_hw_t *const pio0 = &g_pio[0];
+pio_hw_t *const pio1 = &g_pio[1];
+
+// ============================================================================
+// Instruction encoders (same bit layout as hardware/pio_instructions.h)
+// ============================================================================
+
+enum { OP_JMP = 0x0000, OP_WAIT = 0x2000, OP_IN = 0x4000, OP_OUT = 0x6000,
+       OP_PUSH_PULL = 0x8000, OP_MOV = 0xA000, OP_SET = 0xE000 };
+
+static uint encode(uint op, uint arg1, uint arg2) {
+    return op | ((arg1 & 7u) << 5) | (arg2 & 0x1Fu);
+}
+
+uint pio_encode_jmp(uint addr)       { return encode(OP_JMP, 0, addr); }
+uint pio_encode_jmp_not_x(uint addr) { return encode(OP_JMP, 1, addr); }
+uint pio_encode_jmp_x_dec(uint addr) { return encode(OP_JMP, 2, addr); }
+uint pio_encode_jmp_not_y(uint addr) { return encode(OP_JMP, 3, addr); }
+uint pio_encode_jmp_y_dec(uint addr) { return encode(OP_JMP, 4, addr); }
+uint pio_encode_jmp_pin(uint addr)   { return encode(OP_JMP, 6, addr); }
+
+uint pio_encode_wait_pin(bool polarity, uint pin) {
+    return encode(OP_WAIT, 1u | (polarity ? 4u : 0u), pin);
+}
+
+uint pio_encode_in(enum pio_src_dest src, uint count)  { return encode(OP_IN, src, count); }
+uint pio_encode_out(enum pio_src_dest dest, uint count) { return encode(OP_OUT, dest, count); }
+
+uint pio_encode_push(bool if_full, bool block) {
+    return encode(OP_PUSH_PULL, (if_full ? 2u : 0u) | (block ? 1u : 0u), 0);
+}
+
+uint pio_encode_pull(bool if_empty, bool block) {
+    return encode(OP_PUSH_PULL, 4u | (if_empty ? 2u : 0u) | (block ? 1u : 0u), 0);
+}
+
+uint pio_encode_mov(enum pio_src_dest dest, enum pio_src_dest src)     { return encode(OP_MOV, dest, src & 7u); }
+uint pio_encode_mov_not(enum pio_src_dest dest, enum pio_src_dest src) { return encode(OP_MOV, dest, (1u << 3) | (src & 7u)); }
+uint pio_encode_set(enum pio_src_dest dest, uint value)                { return encode(OP_SET, dest, value); }
+uint pio_encode_nop(void)                                              { return pio_encode_mov(pio_y, pio_y); }
+
+// ============================================================================
+// Configuration and state machines (none available)
+// ============================================================================
+
+pio_sm_config pio_get_default_sm_config(void) {
+    pio_sm_config c;
+    memset(&c, 0, sizeof(c));
+    c.clkdiv = 1u << 16;
+    return c;
+}
+
+void sm_config_set_in_pins(pio_sm_config *c, uint in_base) { (void)c; (void)in_base; }
+void sm_config_set_jmp_pin(pio_sm_config *c, uint pin) { (void)c; (void)pin; }
+void sm_config_set_wrap(pio_sm_config *c, uint wrap_target, uint wrap) { (void)c; (void)wrap_target; (void)wrap; }
+
+void sm_config_set_clkdiv_int_frac(pio_sm_config *c, uint16_t div_int, uint8_t div_frac) {
+    c->clkdiv = ((uint32_t)div_int << 16) | ((uint32_t)div_frac << 8);
+}
+
+bool pio_can_add_program(PIO pio, const pio_program_t *program) { (void)pio; (void)program; return false; }
+uint pio_add_program(PIO pio, const pio_program_t *program) { (void)pio; (void)program; return 0; }
+void pio_remove_program(PIO pio, const pio_program_t *program, uint loaded_offset) { (void)pio; (void)program; (void)loaded_offset; }
+int pio_claim_unused_sm(PIO pio, bool required) { (void)pio; (void)required; return -1; }
+void pio_sm_unclaim(PIO pio, uint sm) { (void)pio; (void)sm; }
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config) { (void)pio; (void)sm; (void)initial_pc; (void)config; }
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled) { (void)pio; (void)sm; (void)enabled; }
+void pio_sm_restart(PIO pio, uint sm) { (void)pio; (void)sm; }
+void pio_sm_clear_fifos(PIO pio, uint sm) { (void)pio; (void)sm; }
+void pio_sm_exec(PIO pio, uint sm, uint instr) { (void)pio; (void)sm; (void)instr; }
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm) { (void)pio; (void)sm; return true; }
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data) { (void)pio; (void)sm; (void)data; }
+uint32_t pio_sm_get(PIO pio, uint sm) { (void)pio; (void)sm; return 0; }
+
+// ============================================================================
+// pio_spi / pio_pp transports
+// ============================================================================
+
+bool pio_spi_init(pio_spi_t *s, PIO pio, uint sck_pin, uint mosi_pin, uint miso_pin) {
+    memset(s, 0, sizeof(*s));
+    s->pio = pio;
+    s->sck_pin = sck_pin;
+    s->mosi_pin = mosi_pin;
+    s->miso_pin = miso_pin;
+    s->dma_tx = -1;
+    s->dma_rx = -1;
+    s->sample_step = PIO_SPI_SAMPLE_DEFAULT;
+    return false;
+}
+
+bool pio_spi_enable_quad(pio_spi_t *s, uint io2_pin, uint io3_pin) { (void)s; (void)io2_pin; (void)io3_pin; return false; }
+bool pio_spi_op_supported(const pio_spi_t *s, const pio_spi_op_t *op) { (void)s; (void)op; return false; }
+
+bool pio_spi_read_op(pio_spi_t *s, const pio_spi_op_t *op, uint32_t addr, uint8_t *buf, size_t len) {
+    (void)s; (void)op; (void)addr;
+    memset(buf, 0xFF, len);
+    return false;
+}
+
+uint32_t pio_spi_set_hz(pio_spi_t *s, uint32_t hz) {
+    s->hz = hz;
+    return hz;
+}
+
+void pio_spi_set_sample_step(pio_spi_t *s, uint8_t step) { s->sample_step = step; }
+int32_t pio_spi_sample_offset_ps(const pio_spi_t *s, uint8_t step) { (void)s; (void)step; return 0; }
+bool pio_spi_lend_imem(pio_spi_t *s) { (void)s; return false; }
+void pio_spi_reclaim_imem(pio_spi_t *s) { (void)s; }
+void pio_spi_attach(pio_spi_t *s) { s->attached = true; }
+void pio_spi_detach(pio_spi_t *s) { s->attached = false; }
+
+void pio_spi_transfer(pio_spi_t *s, const uint8_t *tx, uint8_t *rx, size_t len) {
+    (void)s; (void)tx;
+    if (rx) memset(rx, 0xFF, len);
+}
+
+bool pio_pp_begin(pio_spi_t *s, uint cs_pin) { (void)s; (void)cs_pin; return false; }
+void pio_pp_end(void) {}
+bool pio_pp_active(void) { return false; }
+bool pio_pp_write(uint32_t addr, const uint8_t *data, size_t len) { (void)addr; (void)data; (void)len; return false; }
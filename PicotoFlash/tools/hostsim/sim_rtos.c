@@ -0,0 +1,621 @@
+/*
+ * Host Simulation: FreeRTOS Kernel Shim
+ * Every kernel object lives under one mutex with one condition variable;
+ * any state change broadcasts and waiters re-check their own condition.
+ * That is slow for a real kernel and plenty for a firmware that blocks on a
+ * handful of queues. The harness uses sim_rtos_idle() to tell when every
+ * task is parked on an RTOS wait and no timer is pending.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pico/stdlib.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "event_groups.h"
+#include "timers.h"
+#include "sim.h"
+
+#define SIM_MAX_TASKS 32
+#define SIM_MAX_TIMERS 16
+
+struct sim_task {
+    pthread_t thread;
+    char name[16];
+    TaskFunction_t fn;
+    void *param;
+    UBaseType_t priority;
+    UBaseType_t core_mask;
+    uint32_t stack_words;
+    uint32_t notify;
+    bool alive;
+};
+
+struct sim_queue {
+    uint8_t *buf;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t count;
+    UBaseType_t head;
+};
+
+struct sim_event_group {
+    EventBits_t bits;
+};
+
+struct sim_timer {
+    char name[16];
+    TickType_t period;
+    bool auto_reload;
+    void *id;
+    TimerCallbackFunction_t cb;
+    bool active;
+    uint64_t expiry_us;
+};
+
+static pthread_mutex_t g_k = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cv;
+static pthread_mutex_t g_crit;
+static bool g_started = false;
+static struct sim_task g_tasks[SIM_MAX_TASKS];
+static int g_task_count = 0;
+static int g_alive = 0;
+static int g_parked = 0;            // Tasks inside an RTOS wait
+static struct sim_timer g_timers[SIM_MAX_TIMERS];
+static int g_timer_count = 0;
+static int g_timers_running = 0;    // Callbacks in progress
+static __thread struct sim_task *t_self = NULL;
+
+// ============================================================================
+// Time and locking
+// ============================================================================
+
+static void abs_deadline(struct timespec *ts, TickType_t ticks) {
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    uint64_t ns = (uint64_t)ts->tv_nsec + (uint64_t)ticks * (1000000000ull / configTICK_RATE_HZ);
+    ts->tv_sec += (time_t)(ns / 1000000000ull);
+    ts->tv_nsec = (long)(ns % 1000000000ull);
+}
+
+static void init_objects(void) {
+    pthread_condattr_t ca;
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_cv, &ca);
+    pthread_mutexattr_t ma;
+    pthread_mutexattr_init(&ma);
+    pthread_mutexattr_settype(&ma, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&g_crit, &ma);
+}
+
+static void init_once(void) {
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, init_objects);
+}
+
+// Wait on the kernel condition until pred() or the timeout; g_k held
+typedef bool (*wait_pred_t)(void *arg);
+
+static bool wait_until(wait_pred_t pred, void *arg, TickType_t ticks) {
+    if (pred(arg)) return true;
+    if (ticks == 0) return false;
+    struct timespec ts;
+    if (ticks != portMAX_DELAY) abs_deadline(&ts, ticks);
+    g_parked++;
+    pthread_cond_broadcast(&g_cv);
+    bool ok = true;
+    while (!pred(arg)) {
+        int rc = (ticks == portMAX_DELAY) ? pthread_cond_wait(&g_cv, &g_k)
+                                          : pthread_cond_timedwait(&g_cv, &g_k, &ts);
+        if (rc == ETIMEDOUT) {
+            ok = pred(arg);
+            break;
+        }
+    }
+    g_parked--;
+    return ok;
+}
+
+void sim_rtos_assert(const char *file, int line) {
+    fprintf(stderr, "[SIM] configASSERT failed at %s:%d\n", file, line);
+    abort();
+}
+
+void sim_rtos_yield(void) {
+    sched_yield();
+}
+
+void sim_rtos_enter_critical(void) {
+    init_once();
+    pthread_mutex_lock(&g_crit);
+}
+
+void sim_rtos_exit_critical(void) {
+    pthread_mutex_unlock(&g_crit);
+}
+
+bool sim_rtos_idle(void) {
+    pthread_mutex_lock(&g_k);
+    bool timers = g_timers_running > 0;
+    for (int i = 0; i < g_timer_count; i++) timers = timers || g_timers[i].active;
+    bool idle = g_started && g_parked == g_alive && !timers;
+    pthread_mutex_unlock(&g_k);
+    return idle;
+}
+
+// ============================================================================
+// Tasks
+// ============================================================================
+
+static void *task_entry(void *arg) {
+    struct sim_task *t = (struct sim_task *)arg;
+    t_self = t;
+    sim_set_core(t->core_mask & 1u ? 0 : 1);
+
+    pthread_mutex_lock(&g_k);
+    while (!g_started) pthread_cond_wait(&g_cv, &g_k);
+    pthread_mutex_unlock(&g_k);
+
+    t->fn(t->param);
+
+    pthread_mutex_lock(&g_k);
+    t->alive = false;
+    g_alive--;
+    pthread_cond_broadcast(&g_cv);
+    pthread_mutex_unlock(&g_k);
+    return NULL;
+}
+
+BaseType_t xTaskCreateAffinitySet(TaskFunction_t fn, const char *name, configSTACK_DEPTH_TYPE stack_depth,
+                                  void *param, UBaseType_t priority, UBaseType_t core_mask,
+                                  TaskHandle_t *created) {
+    init_once();
+    pthread_mutex_lock(&g_k);
+    if (g_task_count >= SIM_MAX_TASKS) {
+        pthread_mutex_unlock(&g_k);
+        return pdFAIL;
+    }
+    struct sim_task *t = &g_tasks[g_task_count++];
+    memset(t, 0, sizeof(*t));
+    snprintf(t->name, sizeof(t->name), "%s", name ? name : "");
+    t->fn = fn;
+    t->param = param;
+    t->priority = priority;
+    t->core_mask = core_mask ? core_mask : tskNO_AFFINITY;
+    t->stack_words = stack_depth;
+    t->alive = true;
+    g_alive++;
+    pthread_mutex_unlock(&g_k);
+
+    if (pthread_create(&t->thread, NULL, task_entry, t) != 0) return pdFAIL;
+    pthread_detach(t->thread);
+    if (created) *created = t;
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, configSTACK_DEPTH_TYPE stack_depth,
+                       void *param, UBaseType_t priority, TaskHandle_t *created) {
+    return xTaskCreateAffinitySet(fn, name, stack_depth, param, priority, tskNO_AFFINITY, created);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task != NULL && task != t_self) {
+        fprintf(stderr, "[SIM] vTaskDelete of another task is not supported\n");
+        return;
+    }
+    pthread_mutex_lock(&g_k);
+    if (t_self) {
+        t_self->alive = false;
+        g_alive--;
+    }
+    pthread_cond_broadcast(&g_cv);
+    pthread_mutex_unlock(&g_k);
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    sleep_us((uint64_t)ticks * (1000000u / configTICK_RATE_HZ));
+}
+
+static void *timer_thread(void *arg);
+
+// Releases the tasks; the calling thread (main) then just parks
+void vTaskStartScheduler(void) {
+    init_once();
+    pthread_t th;
+    pthread_create(&th, NULL, timer_thread, NULL);
+    pthread_detach(th);
+
+    pthread_mutex_lock(&g_k);
+    g_started = true;
+    pthread_cond_broadcast(&g_cv);
+    for (;;) pthread_cond_wait(&g_cv, &g_k);
+}
+
+void vTaskSuspendAll(void) {
+    sim_rtos_enter_critical();
+}
+
+BaseType_t xTaskResumeAll(void) {
+    sim_rtos_exit_critical();
+    return pdFALSE;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return t_self;
+}
+
+BaseType_t xTaskGetSchedulerState(void) {
+    return g_started ? taskSCHEDULER_RUNNING : taskSCHEDULER_NOT_STARTED;
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(time_us_64() / (1000000u / configTICK_RATE_HZ));
+}
+
+const char *pcTaskGetName(TaskHandle_t task) {
+    if (!task) task = t_self;
+    return task ? task->name : "main";
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void) {
+    return (UBaseType_t)g_alive;
+}
+
+// Host threads have megabytes of stack; report the configured depth as unused
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    if (!task) task = t_self;
+    return task ? task->stack_words : 0;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t max, uint32_t *total_runtime) {
+    UBaseType_t n = 0;
+    pthread_mutex_lock(&g_k);
+    for (int i = 0; i < g_task_count && n < max; i++) {
+        if (!g_tasks[i].alive) continue;
+        status[n].xHandle = &g_tasks[i];
+        status[n].pcTaskName = g_tasks[i].name;
+        status[n].uxCurrentPriority = g_tasks[i].priority;
+        status[n].usStackHighWaterMark = g_tasks[i].stack_words;
+        n++;
+    }
+    pthread_mutex_unlock(&g_k);
+    if (total_runtime) *total_runtime = 0;
+    return n;
+}
+
+// Kernel objects come from host malloc; the firmware's heap stays untouched
+size_t xPortGetFreeHeapSize(void) {
+    return configTOTAL_HEAP_SIZE;
+}
+
+size_t xPortGetMinimumEverFreeHeapSize(void) {
+    return configTOTAL_HEAP_SIZE;
+}
+
+void vTaskCoreAffinitySet(TaskHandle_t task, UBaseType_t core_mask) {
+    if (!task) task = t_self;
+    if (!task) return;
+    task->core_mask = core_mask;
+    if (task == t_self) sim_set_core(core_mask & 1u ? 0 : 1);
+}
+
+// ============================================================================
+// Task notifications
+// ============================================================================
+
+static bool notified(void *arg) {
+    return ((struct sim_task *)arg)->notify != 0;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    pthread_mutex_lock(&g_k);
+    task->notify++;
+    pthread_cond_broadcast(&g_cv);
+    pthread_mutex_unlock(&g_k);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken) {
+    xTaskNotifyGive(task);
+    if (woken) *woken = pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    struct sim_task *t = t_self;
+    if (!t) return 0;
+    pthread_mutex_lock(&g_k);
+    uint32_t v = 0;
+    if (wait_until(notified, t, ticks)) {
+        v = t->notify;
+        t->notify = clear_on_exit ? 0 : t->notify - 1;
+    }
+    pthread_mutex_unlock(&g_k);
+    return v;
+}
+
+BaseType_t xTaskNotifyStateClear(TaskHandle_t task) {
+    if (!task) task = t_self;
+    pthread_mutex_lock(&g_k);
+    BaseType_t was = task->notify ? pdTRUE : pdFALSE;
+    task->notify = 0;
+    pthread_mutex_unlock(&g_k);
+    return was;
+}
+
+// ============================================================================
+// Queues and semaphores
+// ============================================================================
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    init_once();
+    struct sim_queue *q = (struct sim_queue *)calloc(1, sizeof(*q));
+    if (!q) return NULL;
+    q->length = length;
+    q->item_size = item_size;
+    if (item_size) {
+        q->buf = (uint8_t *)calloc(length, item_size);
+        if (!q->buf) {
+            free(q);
+            return NULL;
+        }
+    }
+    return q;
+}
+
+SemaphoreHandle_t sim_rtos_semaphore_create(UBaseType_t max, UBaseType_t initial) {
+    struct sim_queue *q = xQueueCreate(max, 0);
+    if (q) q->count = initial;
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t q) {
+    if (!q) return;
+    free(q->buf);
+    free(q);
+}
+
+static bool has_space(void *arg) {
+    struct sim_queue *q = (struct sim_queue *)arg;
+    return q->count < q->length;
+}
+
+static bool has_item(void *arg) {
+    return ((struct sim_queue *)arg)->count > 0;
+}
+
+static BaseType_t queue_put(QueueHandle_t q, const void *item, TickType_t ticks, bool front) {
+    pthread_mutex_lock(&g_k);
+    if (!wait_until(has_space, q, ticks)) {
+        pthread_mutex_unlock(&g_k);
+        return errQUEUE_FULL;
+    }
+    if (q->item_size) {
+        UBaseType_t slot;
+        if (front) {
+            q->head = (q->head + q->length - 1) % q->length;
+            slot = q->head;
+        } else {
+            slot = (q->head + q->count) % q->length;
+        }
+        memcpy(q->buf + slot * q->item_size, item, q->item_size);
+    }
+    q->count++;
+    pthread_cond_broadcast(&g_cv);
+    pthread_mutex_unlock(&g_k);
+    return pdPASS;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks) {
+    return queue_put(q, item, ticks, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t q, const void *item, TickType_t ticks) {
+    return queue_put(q, item, ticks, true);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken) {
+    BaseType_t rc = queue_put(q, item, 0, false);
+    if (woken) *woken = rc;
+    return rc;
+}
+
+static BaseType_t queue_get(QueueHandle_t q, void *item, TickType_t ticks, bool remove) {
+    pthread_mutex_lock(&g_k);
+    if (!wait_until(has_item, q, ticks)) {
+        pthread_mutex_unlock(&g_k);
+        return errQUEUE_EMPTY;
+    }
+    if (q->item_size && item) memcpy(item, q->buf + q->head * q->item_size, q->item_size);
+    if (remove) {
+        if (q->item_size) q->head = (q->head + 1) % q->length;
+        q->count--;
+        pthread_cond_broadcast(&g_cv);
+    }
+    pthread_mutex_unlock(&g_k);
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks) {
+    return queue_get(q, item, ticks, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t q, void *item, TickType_t ticks) {
+    return queue_get(q, item, ticks, false);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+    pthread_mutex_lock(&g_k);
+    UBaseType_t n = q->count;
+    pthread_mutex_unlock(&g_k);
+    return n;
+}
+
+BaseType_t xQueueReset(QueueHandle_t q) {
+    pthread_mutex_lock(&g_k);
+    q->count = 0;
+    q->head = 0;
+    pthread_cond_broadcast(&g_cv);
+    pthread_mutex_unlock(&g_k);
+    return pdPASS;
+}
+
+// ============================================================================
+// Event groups
+// ============================================================================
+
+EventGroupHandle_t xEventGroupCreate(void) {
+    init_once();
+    return (EventGroupHandle_t)calloc(1, sizeof(struct sim_event_group));
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t g, EventBits_t bits) {
+    pthread_mutex_lock(&g_k);
+    g->bits |= bits;
+    EventBits_t v = g->bits;
+    pthread_cond_broadcast(&g_cv);
+    pthread_mutex_unlock(&g_k);
+    return v;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t g, EventBits_t bits) {
+    pthread_mutex_lock(&g_k);
+    EventBits_t v = g->bits;
+    g->bits &= ~bits;
+    pthread_mutex_unlock(&g_k);
+    return v;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t g) {
+    pthread_mutex_lock(&g_k);
+    EventBits_t v = g->bits;
+    pthread_mutex_unlock(&g_k);
+    return v;
+}
+
+typedef struct {
+    struct sim_event_group *g;
+    EventBits_t bits;
+    bool all;
+} bits_wait_t;
+
+static bool bits_ready(void *arg) {
+    bits_wait_t *w = (bits_wait_t *)arg;
+    EventBits_t have = w->g->bits & w->bits;
+    return w->all ? have == w->bits : have != 0;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t g, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all, TickType_t ticks) {
+    bits_wait_t w = {g, bits, wait_for_all != pdFALSE};
+    pthread_mutex_lock(&g_k);
+    bool ok = wait_until(bits_ready, &w, ticks);
+    EventBits_t v = g->bits;
+    if (ok && clear_on_exit) g->bits &= ~bits;
+    pthread_mutex_unlock(&g_k);
+    return v;
+}
+
+// ============================================================================
+// Software timers
+// ============================================================================
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload,
+                           void *id, TimerCallbackFunction_t callback) {
+    init_once();
+    pthread_mutex_lock(&g_k);
+    if (g_timer_count >= SIM_MAX_TIMERS) {
+        pthread_mutex_unlock(&g_k);
+        return NULL;
+    }
+    struct sim_timer *t = &g_timers[g_timer_count++];
+    memset(t, 0, sizeof(*t));
+    snprintf(t->name, sizeof(t->name), "%s", name ? name : "");
+    t->period = period;
+    t->auto_reload = auto_reload != 0;
+    t->id = id;
+    t->cb = callback;
+    pthread_mutex_unlock(&g_k);
+    return t;
+}
+
+static BaseType_t timer_arm(TimerHandle_t t, bool on) {
+    pthread_mutex_lock(&g_k);
+    t->active = on;
+    t->expiry_us = time_us_64() + (uint64_t)t->period * (1000000u / configTICK_RATE_HZ);
+    pthread_cond_broadcast(&g_cv);
+    pthread_mutex_unlock(&g_k);
+    return pdPASS;
+}
+
+BaseType_t xTimerStart(TimerHandle_t t, TickType_t ticks) {
+    (void)ticks;
+    return timer_arm(t, true);
+}
+
+BaseType_t xTimerStop(TimerHandle_t t, TickType_t ticks) {
+    (void)ticks;
+    return timer_arm(t, false);
+}
+
+BaseType_t xTimerReset(TimerHandle_t t, TickType_t ticks) {
+    (void)ticks;
+    return timer_arm(t, true);
+}
+
+BaseType_t xTimerResetFromISR(TimerHandle_t t, BaseType_t *woken) {
+    if (woken) *woken = pdFALSE;
+    return timer_arm(t, true);
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t t) {
+    pthread_mutex_lock(&g_k);
+    BaseType_t a = t->active ? pdTRUE : pdFALSE;
+    pthread_mutex_unlock(&g_k);
+    return a;
+}
+
+void *pvTimerGetTimerID(TimerHandle_t t) {
+    return t->id;
+}
+
+static void *timer_thread(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&g_k);
+    for (;;) {
+        struct sim_timer *next = NULL;
+        for (int i = 0; i < g_timer_count; i++) {
+            if (g_timers[i].active && (!next || g_timers[i].expiry_us < next->expiry_us)) next = &g_timers[i];
+        }
+        if (!next) {
+            pthread_cond_wait(&g_cv, &g_k);
+            continue;
+        }
+        uint64_t now = time_us_64();
+        if (now < next->expiry_us) {
+            TickType_t ticks = (TickType_t)((next->expiry_us - now + 999u) / 1000u);
+            struct timespec ts;
+            abs_deadline(&ts, ticks);
+            pthread_cond_timedwait(&g_cv, &g_k, &ts);
+            continue;
+        }
+        if (next->auto_reload) {
+            next->expiry_us += (uint64_t)next->period * (1000000u / configTICK_RATE_HZ);
+        } else {
+            next->active = false;
+        }
+        g_timers_running++;
+        pthread_mutex_unlock(&g_k);
+        next->cb(next);
+        pthread_mutex_lock(&g_k);
+        g_timers_running--;
+        pthread_cond_broadcast(&g_cv);
+    }
+    return NULL;
+}
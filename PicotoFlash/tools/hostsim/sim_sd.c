@@ -0,0 +1,273 @@
+/*
+ * Host Simulation: File-Backed SD Card
+ * Replaces hw_config.c and the FatFs_SPI sd_driver: one sd_card_t whose
+ * init/read_blocks/write_blocks hooks do pread/pwrite on an image file, so
+ * glue.c, FatFs and every firmware module run unmodified on top. Block
+ * transfers are paced to the spi1 wire time like the PL022 transfers.
+ * A missing image is created and formatted (f_mkfs) on first use.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "pico/stdlib.h"
+#include "hardware/spi.h"
+#include "hardware/rtc.h"
+#include "ff.h"
+#include "diskio.h"
+#include "hw_config.h"
+#include "sim.h"
+
+#define SD_SECTOR 512u
+#define SD_CMD_OVERHEAD 16u         // Command, token and CRC bytes per block
+
+static int g_fd = -1;
+
+static spi_t g_spis[] = {
+    {
+        .hw_inst = NULL,            // spi1, set in sim_sd_open()
+        .miso_gpio = 12,
+        .mosi_gpio = 11,
+        .sck_gpio = 10,
+        .baud_rate = 12500000,
+        .set_drive_strength = false,
+    }
+};
+
+static int sim_sd_init(sd_card_t *sd);
+static int sim_sd_read_blocks(sd_card_t *sd, uint8_t *buffer, uint64_t sector, uint32_t count);
+static int sim_sd_write_blocks(sd_card_t *sd, const uint8_t *buffer, uint64_t sector, uint32_t count);
+
+static sd_card_t g_sd_cards[] = {
+    {
+        .pcName = "0:",
+        .spi = &g_spis[0],
+        .ss_gpio = 15,
+        .use_card_detect = false,
+        .set_drive_strength = false,
+        .m_Status = STA_NOINIT,
+        .init = sim_sd_init,
+        .write_blocks = sim_sd_write_blocks,
+        .read_blocks = sim_sd_read_blocks,
+    }
+};
+
+// ============================================================================
+// hw_config.h / sd_card.h
+// ============================================================================
+
+size_t sd_get_num() { return count_of(g_sd_cards); }
+
+sd_card_t *sd_get_by_num(size_t num) {
+    return num < sd_get_num() ? &g_sd_cards[num] : NULL;
+}
+
+size_t spi_get_num() { return count_of(g_spis); }
+
+spi_t *spi_get_by_num(size_t num) {
+    return num < spi_get_num() ? &g_spis[num] : NULL;
+}
+
+bool sd_init_driver() {
+    return g_fd >= 0;
+}
+
+bool sd_card_detect(sd_card_t *sd) {
+    if (g_fd < 0) {
+        sd->m_Status |= STA_NODISK;
+        return false;
+    }
+    sd->m_Status &= ~STA_NODISK;
+    return true;
+}
+
+uint64_t sd_sectors(sd_card_t *sd) {
+    return sd->sectors;
+}
+
+DWORD get_fattime(void) {
+    datetime_t t;
+    if (!rtc_get_datetime(&t)) return ((DWORD)(FF_NORTC_YEAR - 1980) << 25) | ((DWORD)FF_NORTC_MON << 21) | ((DWORD)FF_NORTC_MDAY << 16);
+    return ((DWORD)(t.year - 1980) << 25) | ((DWORD)t.month << 21) | ((DWORD)t.day << 16) |
+           ((DWORD)t.hour << 11) | ((DWORD)t.min << 5) | ((DWORD)t.sec >> 1);
+}
+
+// ============================================================================
+// Block device
+// ============================================================================
+
+static int sim_sd_init(sd_card_t *sd) {
+    if (!sd_card_detect(sd)) return sd->m_Status;
+    if (!sd->spi->initialized) {
+        spi_init(sd->spi->hw_inst, 400 * 1000);
+        sd->spi->initialized = true;
+    }
+    if (sd->set_drive_strength) gpio_set_drive_strength(sd->ss_gpio, sd->ss_gpio_drive_strength);
+    if (sd->spi->set_drive_strength) {
+        gpio_set_drive_strength(sd->spi->mosi_gpio, sd->spi->mosi_gpio_drive_strength);
+        gpio_set_drive_strength(sd->spi->sck_gpio, sd->spi->sck_gpio_drive_strength);
+    }
+    spi_set_baudrate(sd->spi->hw_inst, sd->spi->baud_rate);
+
+    struct stat st;
+    if (fstat(g_fd, &st) != 0) return sd->m_Status;
+    sd->sectors = (uint64_t)st.st_size / SD_SECTOR;
+    sd->card_type = 3;              // SDHC: block addressed
+    sd->m_Status &= ~STA_NOINIT;
+    return sd->m_Status;
+}
+
+// FatFs_SPI's transfer observer (spi.c is not part of the host build); each
+// block operation reports as one transfer led by its SD command frame
+spi_transfer_hook_t spi_transfer_hook = NULL;
+
+static void report_transfer(sd_card_t *sd, bool rd, uint64_t sector, uint32_t count, size_t bytes, uint64_t start) {
+    uint8_t cmd = rd ? (count > 1 ? 18 : 17) : (count > 1 ? 25 : 24);
+    uint8_t frame[6] = {(uint8_t)(0x40 | cmd), (uint8_t)(sector >> 24), (uint8_t)(sector >> 16),
+                        (uint8_t)(sector >> 8), (uint8_t)sector, 0x01};
+    spi_transfer_hook(sd->spi, frame, sizeof(frame) + bytes, (uint32_t)(start / 1000u));
+}
+
+static int block_io(sd_card_t *sd, uint8_t *rd, const uint8_t *wr, uint64_t sector, uint32_t count) {
+    if (sd->m_Status & (STA_NOINIT | STA_NODISK)) return SD_BLOCK_DEVICE_ERROR_NO_INIT;
+    if (sector + count > sd->sectors) return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    uint64_t start = sim_now_ns();
+    size_t bytes = (size_t)count * SD_SECTOR;
+    off_t off = (off_t)(sector * SD_SECTOR);
+    ssize_t n = rd ? pread(g_fd, rd, bytes, off) : pwrite(g_fd, wr, bytes, off);
+    if (n != (ssize_t)bytes) {
+        return rd ? SD_BLOCK_DEVICE_ERROR_NO_RESPONSE : SD_BLOCK_DEVICE_ERROR_WRITE;
+    }
+    sim_spi_pace(sd->spi->hw_inst, start, bytes + (size_t)count * SD_CMD_OVERHEAD);
+    if (spi_transfer_hook) report_transfer(sd, rd != NULL, sector, count, bytes, start);
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+static int sim_sd_read_blocks(sd_card_t *sd, uint8_t *buffer, uint64_t sector, uint32_t count) {
+    return block_io(sd, buffer, NULL, sector, count);
+}
+
+static int sim_sd_write_blocks(sd_card_t *sd, const uint8_t *buffer, uint64_t sector, uint32_t count) {
+    return block_io(sd, NULL, buffer, sector, count);
+}
+
+// ============================================================================
+// Image management (harness side)
+// ============================================================================
+
+bool sim_sd_open(const char *image_path, uint32_t size_mib) {
+    g_spis[0].hw_inst = spi1;
+    bool fresh = access(image_path, F_OK) != 0;
+    g_fd = open(image_path, O_RDWR | O_CREAT, 0644);
+    if (g_fd < 0) {
+        fprintf(stderr, "[SIM] cannot open %s: %s\n", image_path, strerror(errno));
+        return false;
+    }
+    if (!fresh) return true;
+
+    if (ftruncate(g_fd, (off_t)size_mib * 1024 * 1024) != 0) {
+        fprintf(stderr, "[SIM] cannot size %s: %s\n", image_path, strerror(errno));
+        return false;
+    }
+    static BYTE work[FF_MAX_SS * 8];
+    MKFS_PARM opt = {FM_ANY | FM_SFD, 0, 0, 0, 0};
+    FRESULT fr = f_mkfs("0:", &opt, work, sizeof(work));
+    if (fr != FR_OK) {
+        fprintf(stderr, "[SIM] f_mkfs failed (%d)\n", fr);
+        return false;
+    }
+    g_sd_cards[0].m_Status = STA_NOINIT;
+    printf("[SIM] Created %u MiB SD image %s\n", (unsigned)size_mib, image_path);
+    return true;
+}
+
+// Works whether or not the firmware currently has the volume mounted
+static bool with_volume(bool *own) {
+    DIR dir;
+    *own = false;
+    if (f_opendir(&dir, "0:/") == FR_OK) {
+        f_closedir(&dir);
+        return true;
+    }
+    *own = true;
+    return f_mount(&g_sd_cards[0].fatfs, "0:", 1) == FR_OK;
+}
+
+static void release_volume(bool own) {
+    if (own) f_unmount("0:");
+}
+
+bool sim_sd_put(const char *host_path, const char *volume_name) {
+    FILE *in = fopen(host_path, "rb");
+    if (!in) {
+        fprintf(stderr, "[SIM] cannot read %s: %s\n", host_path, strerror(errno));
+        return false;
+    }
+    bool own;
+    bool ok = with_volume(&own);
+    if (ok) {
+        char path[300];
+        snprintf(path, sizeof(path), "0:/%s", volume_name);
+        FIL f;
+        ok = f_open(&f, path, FA_CREATE_ALWAYS | FA_WRITE) == FR_OK;
+        char buf[4096];
+        size_t n;
+        while (ok && (n = fread(buf, 1, sizeof(buf), in)) > 0) {
+            UINT bw;
+            ok = f_write(&f, buf, (UINT)n, &bw) == FR_OK && bw == n;
+        }
+        if (ok) ok = f_close(&f) == FR_OK;
+        release_volume(own);
+    }
+    fclose(in);
+    if (!ok) fprintf(stderr, "[SIM] cannot import %s as %s\n", host_path, volume_name);
+    return ok;
+}
+
+bool sim_sd_get(const char *volume_name, const char *host_path) {
+    bool own;
+    if (!with_volume(&own)) return false;
+    char path[300];
+    snprintf(path, sizeof(path), "0:/%s", volume_name);
+    FIL f;
+    bool ok = f_open(&f, path, FA_READ) == FR_OK;
+    if (ok) {
+        FILE *out = fopen(host_path, "wb");
+        ok = out != NULL;
+        char buf[4096];
+        UINT br;
+        while (ok && f_read(&f, buf, sizeof(buf), &br) == FR_OK && br > 0) {
+            ok = fwrite(buf, 1, br, out) == br;
+        }
+        if (out) fclose(out);
+        f_close(&f);
+    }
+    release_volume(own);
+    if (!ok) fprintf(stderr, "[SIM] cannot export %s to %s\n", volume_name, host_path);
+    return ok;
+}
+
+bool sim_sd_exists(const char *volume_name) {
+    bool own;
+    if (!with_volume(&own)) return false;
+    char path[300];
+    snprintf(path, sizeof(path), "0:/%s", volume_name);
+    FILINFO fno;
+    bool found = f_stat(path, &fno) == FR_OK;
+    release_volume(own);
+    return found;
+}
+
+// Leave the volume mounted for callers that use FatFs without the firmware
+bool sim_sd_mount(void) {
+    bool own;
+    return with_volume(&own);
+}
+
+void sim_sd_close(void) {
+    if (g_fd >= 0) close(g_fd);
+    g_fd = -1;
+}
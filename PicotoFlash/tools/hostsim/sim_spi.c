@@ -0,0 +1,146 @@
+/*
+ * Host Simulation: PL022 SPI Shim
+ * Baud rates use the SDK's prescale/postdiv search against the simulated
+ * clk_peri and are re-derived from the stored dividers on every read, so a
+ * clk_sys/clk_peri switch changes the effective SCK exactly as on the chip.
+ * Each blocking call is paced to its wire time (8 SCK per byte) unless
+ * disabled with sim_spi_set_wire_time(false).
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/spi.h"
+#include "hardware/clocks.h"
+#include "sim.h"
+
+#define SIM_SPI_MAX_DEVICES 4
+
+struct spi_inst {
+    uint index;
+    uint prescale;
+    uint postdiv;
+    bool enabled;
+};
+
+typedef struct {
+    spi_inst_t *spi;
+    uint cs_gpio;
+    bool selected;
+    sim_spi_device_t dev;
+} sim_spi_slot_t;
+
+static spi_inst_t g_spi[2] = {{0, 2, 1, false}, {1, 2, 1, false}};
+spi_inst_t *const spi0 = &g_spi[0];
+spi_inst_t *const spi1 = &g_spi[1];
+
+static sim_spi_slot_t g_slots[SIM_SPI_MAX_DEVICES];
+static int g_slot_count = 0;
+static bool g_wire_time = true;
+
+static void cs_hook(uint gpio, bool level) {
+    for (int i = 0; i < g_slot_count; i++) {
+        sim_spi_slot_t *s = &g_slots[i];
+        if (s->cs_gpio != gpio) continue;
+        s->selected = !level;
+        if (s->dev.select) s->dev.select(s->dev.ctx, s->selected);
+    }
+}
+
+bool sim_spi_attach(spi_inst_t *spi, uint cs_gpio, const sim_spi_device_t *dev) {
+    if (g_slot_count >= SIM_SPI_MAX_DEVICES) return false;
+    sim_spi_slot_t *s = &g_slots[g_slot_count++];
+    s->spi = spi;
+    s->cs_gpio = cs_gpio;
+    s->selected = false;
+    s->dev = *dev;
+    sim_gpio_set_output_hook(cs_hook);
+    return true;
+}
+
+void sim_spi_set_wire_time(bool enabled) {
+    g_wire_time = enabled;
+}
+
+// Holds the caller until `bytes` would have left the PL022 at the current SCK
+void sim_spi_pace(spi_inst_t *spi, uint64_t start_ns, size_t bytes) {
+    if (!g_wire_time || bytes == 0) return;
+    uint64_t ns = (uint64_t)bytes * 8u * 1000000000ull / spi_get_baudrate(spi);
+    sim_wait_until_ns(start_ns + ns);
+}
+
+// ============================================================================
+// Configuration
+// ============================================================================
+
+uint spi_set_baudrate(spi_inst_t *spi, uint baudrate) {
+    uint32_t freq_in = clock_get_hz(clk_peri);
+    uint prescale, postdiv;
+    if (baudrate == 0) baudrate = 1;
+    for (prescale = 2; prescale <= 254; prescale += 2) {
+        if (freq_in < (prescale + 2) * 256 * (uint64_t)baudrate) break;
+    }
+    if (prescale > 254) prescale = 254;
+    for (postdiv = 256; postdiv > 1; --postdiv) {
+        if (freq_in / (prescale * (postdiv - 1)) > baudrate) break;
+    }
+    spi->prescale = prescale;
+    spi->postdiv = postdiv;
+    return spi_get_baudrate(spi);
+}
+
+uint spi_get_baudrate(const spi_inst_t *spi) {
+    return clock_get_hz(clk_peri) / (spi->prescale * spi->postdiv);
+}
+
+uint spi_init(spi_inst_t *spi, uint baudrate) {
+    spi->enabled = true;
+    return spi_set_baudrate(spi, baudrate);
+}
+
+void spi_deinit(spi_inst_t *spi) {
+    spi->enabled = false;
+}
+
+uint spi_get_index(const spi_inst_t *spi) {
+    return spi->index;
+}
+
+// ============================================================================
+// Transfers
+// ============================================================================
+
+static sim_spi_slot_t *selected_slot(spi_inst_t *spi) {
+    for (int i = 0; i < g_slot_count; i++) {
+        if (g_slots[i].spi == spi && g_slots[i].selected) return &g_slots[i];
+    }
+    return NULL;
+}
+
+static void transfer(spi_inst_t *spi, const uint8_t *tx, uint8_t fill, uint8_t *rx, size_t len) {
+    uint64_t start = sim_now_ns();
+    sim_spi_slot_t *s = selected_slot(spi);
+    if (s && s->dev.sck) s->dev.sck(s->dev.ctx, spi_get_baudrate(spi));
+    for (size_t i = 0; i < len; i++) {
+        uint8_t mosi = tx ? tx[i] : fill;
+        uint8_t miso = s ? s->dev.xfer(s->dev.ctx, mosi) : 0xFF;
+        if (rx) rx[i] = miso;
+    }
+    sim_spi_pace(spi, start, len);
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len) {
+    transfer(spi, src, 0, NULL, len);
+    return (int)len;
+}
+
+int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len) {
+    transfer(spi, NULL, repeated_tx_data, dst, len);
+    return (int)len;
+}
+
+int spi_write_read_blocking(spi_inst_t *spi, const uint8_t *src, uint8_t *dst, size_t len) {
+    transfer(spi, src, 0, dst, len);
+    return (int)len;
+}
@@ -0,0 +1,487 @@
+/*
+ * SPI Trace Tool
+ * Decodes a Trace/spi_*.bin recording (spi_trace.c) and splits the flash
+ * bus time into command overhead, data, status polling, CPU time spent
+ * with CS held and idle gaps between transactions. SD-bus records, when
+ * present, are summarised on their own.
+ *
+ * --replay feeds the flash transactions to the NOR model at their recorded
+ * times (header bytes as traced, filler for the payload) and compares the
+ * busy times the firmware observed with the ones the part's profile
+ * predicts. Multi-lane and PIO-queued records are counted but not replayed.
+ *
+ *   picotoflash_sim --put DATASHEET.csv --get Trace/spi_20240101_000000.bin:trace.bin
+ *   picotoflash_spitrace trace.bin --replay --profile DATASHEET.csv
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spi_trace.h"
+#include "nor_model.h"
+#include "nor_profile.h"
+
+#define TOOL_FILLER 0xFF            // Programs as a no-op, reads as anything
+
+typedef enum {
+    CLS_READ = 0,
+    CLS_PROGRAM,
+    CLS_ERASE,
+    CLS_POLL,
+    CLS_STATUS_WRITE,
+    CLS_ID,
+    CLS_CONTROL,
+    CLS_OTHER,
+    CLS_COUNT
+} op_class_t;
+
+static const char *const k_class_names[CLS_COUNT] = {
+    "read", "program", "erase", "status poll", "status write", "id/sfdp", "control", "other",
+};
+
+// Per-opcode framing: bytes ahead of the payload as the transports trace
+// them, and the SCK clocks they take (dual/quad addresses clock faster)
+typedef struct {
+    uint8_t opcode;
+    uint8_t cmd_bytes;
+    uint8_t cmd_clocks;
+    op_class_t cls;
+} op_info_t;
+
+static const op_info_t k_ops[] = {
+    {0x03, 4, 32, CLS_READ},         {0x0B, 5, 40, CLS_READ},          {0x3B, 5, 40, CLS_READ},
+    {0x6B, 5, 40, CLS_READ},         {0xBB, 5, 24, CLS_READ},          {0xEB, 7, 20, CLS_READ},
+    {0x02, 4, 32, CLS_PROGRAM},      {0x32, 4, 32, CLS_PROGRAM},       {0x20, 4, 32, CLS_ERASE},
+    {0x52, 4, 32, CLS_ERASE},        {0xD8, 4, 32, CLS_ERASE},         {0xC7, 1, 8, CLS_ERASE},
+    {0x60, 1, 8, CLS_ERASE},         {0x05, 1, 8, CLS_POLL},           {0x35, 1, 8, CLS_POLL},
+    {0x15, 1, 8, CLS_POLL},          {0x01, 1, 8, CLS_STATUS_WRITE},   {0x31, 1, 8, CLS_STATUS_WRITE},
+    {0x11, 1, 8, CLS_STATUS_WRITE},  {0x9F, 1, 8, CLS_ID},             {0x90, 4, 32, CLS_ID},
+    {0xAB, 4, 32, CLS_ID},           {0x4B, 5, 40, CLS_ID},            {0x5A, 5, 40, CLS_ID},
+    {0x06, 1, 8, CLS_CONTROL},       {0x04, 1, 8, CLS_CONTROL},        {0x50, 1, 8, CLS_CONTROL},
+    {0x66, 1, 8, CLS_CONTROL},       {0x99, 1, 8, CLS_CONTROL},        {0xB9, 1, 8, CLS_CONTROL},
+    {0xB7, 1, 8, CLS_CONTROL},       {0xE9, 1, 8, CLS_CONTROL},
+};
+
+static const op_info_t k_unknown = {0x00, 1, 8, CLS_OTHER};
+
+typedef struct {
+    uint64_t t_us;                  // Unwrapped, relative to the trace start
+    uint8_t hdr[SPI_TRACE_HDR_BYTES];
+    uint8_t nhdr;
+    uint32_t len;
+    uint8_t flags;
+    uint32_t cs_us;
+    uint32_t hz;
+} rec_t;
+
+typedef struct {
+    uint32_t count;
+    uint64_t bytes;
+    double cs_us;
+    double cmd_us;
+    double data_us;
+} class_sum_t;
+
+// Busy time of one program/erase/status write: from CS rising to the start
+// of the poll that first saw WIP clear, as the firmware saw it and as the
+// model would have had it
+typedef struct {
+    uint32_t count;
+    double measured_ms;
+    double model_ms;
+    float measured_max_ms;
+    uint32_t over_max;
+} busy_sum_t;
+
+static uint64_t g_now_ns;
+
+// nor_model's clock: the replay cursor, not the host
+uint64_t sim_now_ns(void) {
+    return g_now_ns;
+}
+
+static const op_info_t *op_info(uint8_t opcode) {
+    for (size_t i = 0; i < sizeof(k_ops) / sizeof(k_ops[0]); i++) {
+        if (k_ops[i].opcode == opcode) return &k_ops[i];
+    }
+    return &k_unknown;
+}
+
+static int rec_lanes(const rec_t *r) {
+    uint8_t code = (r->flags & SPI_TRACE_F_LANES_MASK) >> SPI_TRACE_F_LANES_SHIFT;
+    return code == 2 ? 4 : code == 1 ? 2 : 1;
+}
+
+static nor_op_t busy_op(uint8_t opcode) {
+    switch (opcode) {
+        case 0x02: case 0x32: return NOR_OP_PP;
+        case 0x20: return NOR_OP_SE;
+        case 0x52: return NOR_OP_BE32;
+        case 0xD8: return NOR_OP_BE64;
+        case 0xC7: case 0x60: return NOR_OP_CE;
+        case 0x01: case 0x31: case 0x11: return NOR_OP_WRSR;
+        default: return NOR_OP_COUNT;
+    }
+}
+
+// ============================================================================
+// Loading
+// ============================================================================
+
+static rec_t *load_trace(const char *path, spi_trace_file_hdr_t *hdr, size_t *count) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "[ERROR] cannot open %s\n", path);
+        return NULL;
+    }
+    if (fread(hdr, sizeof(*hdr), 1, f) != 1 || hdr->magic != SPI_TRACE_MAGIC) {
+        fprintf(stderr, "[ERROR] %s is not an SPI trace\n", path);
+        fclose(f);
+        return NULL;
+    }
+    if (hdr->version != SPI_TRACE_VERSION || hdr->record_size != sizeof(spi_trace_rec_t)) {
+        fprintf(stderr, "[ERROR] %s: trace version %u, record size %u not supported\n", path, hdr->version,
+                hdr->record_size);
+        fclose(f);
+        return NULL;
+    }
+    fseek(f, hdr->header_size, SEEK_SET);
+
+    size_t cap = 4096, n = 0;
+    rec_t *recs = malloc(cap * sizeof(rec_t));
+    spi_trace_rec_t raw;
+    uint32_t prev = hdr->start_us;
+    uint64_t t = 0;
+    while (recs && fread(&raw, sizeof(raw), 1, f) == 1) {
+        if (n == cap) {
+            cap *= 2;
+            rec_t *grown = realloc(recs, cap * sizeof(rec_t));
+            if (!grown) break;
+            recs = grown;
+        }
+        // time_us_32() wraps every 71 minutes; records are in CS order
+        // except SD transfers, which can start just before a flash record
+        int32_t d = (int32_t)(raw.t_us - prev);
+        t = (d < 0 && (uint64_t)-d > t) ? 0 : t + (int64_t)d;
+        prev = raw.t_us;
+
+        rec_t *r = &recs[n++];
+        memset(r, 0, sizeof(*r));
+        r->t_us = t;
+        r->flags = (uint8_t)(raw.len_flags >> 24);
+        r->len = raw.len_flags & SPI_TRACE_LEN_MAX;
+        r->nhdr = (r->flags & SPI_TRACE_F_HDR_MASK) >> SPI_TRACE_F_HDR_SHIFT;
+        if (r->nhdr > SPI_TRACE_HDR_BYTES) r->nhdr = SPI_TRACE_HDR_BYTES;
+        for (int i = 0; i < r->nhdr; i++) r->hdr[i] = (uint8_t)(raw.op_addr >> (24 - 8 * i));
+        r->cs_us = spi_trace_cs_decode(raw.cs);
+        r->hz = raw.sck_100khz * 100000u;
+    }
+    fclose(f);
+    if (!recs) {
+        fprintf(stderr, "[ERROR] out of memory\n");
+        return NULL;
+    }
+    *count = n;
+    return recs;
+}
+
+static bool cs_saturated(const rec_t *r) {
+    return r->cs_us == spi_trace_cs_decode(SPI_TRACE_CS_COARSE | 0x7FFFu);
+}
+
+static uint32_t rec_addr(const rec_t *r) {
+    uint32_t a = 0;
+    for (int i = 1; i < 4; i++) a = (a << 8) | (i < r->nhdr ? r->hdr[i] : 0);
+    return a;
+}
+
+// ============================================================================
+// Summary
+// ============================================================================
+
+static void dump(const rec_t *recs, size_t n) {
+    printf("%12s %4s %3s %8s %9s %7s %6s %s\n", "t_us", "bus", "op", "addr", "len", "cs_us", "MHz", "flags");
+    for (size_t i = 0; i < n; i++) {
+        const rec_t *r = &recs[i];
+        bool sd = r->flags & SPI_TRACE_F_SD;
+        printf("%12llu %4s %02X  %06lX %9lu %7lu %6.1f %s%s%s x%d\n", (unsigned long long)r->t_us,
+               sd ? "sd" : "nor", r->nhdr ? r->hdr[0] : 0, (unsigned long)rec_addr(r), (unsigned long)r->len,
+               (unsigned long)r->cs_us, r->hz / 1e6, r->flags & SPI_TRACE_F_PIO ? "pio " : "",
+               r->flags & SPI_TRACE_F_QUEUED ? "queued " : "",
+               cs_saturated(r) ? "sat " : "", rec_lanes(r));
+    }
+}
+
+static void summarise(const spi_trace_file_hdr_t *hdr, const rec_t *recs, size_t n) {
+    class_sum_t cls[CLS_COUNT] = {{0}};
+    class_sum_t sd = {0};
+    double idle_us = 0, span_us = 0, busy_wait_us = 0;
+    uint32_t polls_busy_op = 0, nor_records = 0, queued = 0;
+    uint64_t last_end = 0;
+    bool have_last = false, waiting = false;
+    uint64_t wait_from = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        const rec_t *r = &recs[i];
+        double sck = r->hz ? (double)r->hz : 1e6;
+        if (r->flags & SPI_TRACE_F_SD) {
+            sd.count++;
+            sd.bytes += r->len;
+            sd.cs_us += r->cs_us;
+            sd.data_us += r->len * 8.0 * 1e6 / sck;
+            continue;
+        }
+        nor_records++;
+        const op_info_t *oi = op_info(r->nhdr ? r->hdr[0] : 0);
+        class_sum_t *c = &cls[oi->cls];
+        uint32_t cmd = oi->cmd_bytes < r->len ? oi->cmd_bytes : r->len;
+        c->count++;
+        c->bytes += r->len - cmd;
+        c->cs_us += r->cs_us;
+        if (r->flags & SPI_TRACE_F_QUEUED) {
+            // One record per PIO batch: payload and framing are not separable
+            queued++;
+            c->data_us += r->len * 8.0 * 1e6 / sck;
+        } else {
+            c->cmd_us += (cmd ? oi->cmd_clocks : 0) * 1e6 / sck;
+            c->data_us += (r->len - cmd) * 8.0 * 1e6 / (sck * rec_lanes(r));
+        }
+
+        // Time from a busy command's CS rising to its last status poll
+        if (oi->cls == CLS_PROGRAM || oi->cls == CLS_ERASE || oi->cls == CLS_STATUS_WRITE) {
+            waiting = !(r->flags & SPI_TRACE_F_QUEUED);
+            wait_from = r->t_us + r->cs_us;
+        } else if (oi->cls == CLS_POLL) {
+            if (waiting && r->t_us >= wait_from) {
+                polls_busy_op++;
+                busy_wait_us += (double)(r->t_us - wait_from);
+                wait_from = r->t_us;
+            }
+        } else if (oi->cls != CLS_CONTROL) {
+            waiting = false;
+        }
+
+        if (have_last && r->t_us > last_end) idle_us += (double)(r->t_us - last_end);
+        uint64_t end = r->t_us + r->cs_us;
+        if (!have_last || end > last_end) last_end = end;
+        if (!have_last) span_us = -(double)r->t_us;
+        have_last = true;
+    }
+    if (have_last) span_us += (double)last_end;
+
+    printf("Trace: JEDEC %02X %02X %02X, clk_sys %.0f MHz, %zu records (%lu flash, %lu SD)\n", hdr->jedec[0],
+           hdr->jedec[1], hdr->jedec[2], hdr->clk_sys_hz / 1e6, n, (unsigned long)nor_records,
+           (unsigned long)sd.count);
+    if (!nor_records) return;
+
+    double cs_total = 0, cmd_total = 0, data_total = 0;
+    printf("\n%-13s %8s %12s %10s %10s %10s %10s\n", "Flash class", "count", "bytes", "CS ms", "cmd ms", "data ms",
+           "CPU ms");
+    for (int k = 0; k < CLS_COUNT; k++) {
+        const class_sum_t *c = &cls[k];
+        if (!c->count) continue;
+        double cpu = c->cs_us - c->cmd_us - c->data_us;
+        printf("%-13s %8lu %12llu %10.2f %10.2f %10.2f %10.2f\n", k_class_names[k], (unsigned long)c->count,
+               (unsigned long long)c->bytes, c->cs_us / 1e3, c->cmd_us / 1e3, c->data_us / 1e3,
+               (cpu > 0 ? cpu : 0) / 1e3);
+        cs_total += c->cs_us;
+        cmd_total += c->cmd_us;
+        data_total += c->data_us;
+    }
+
+    double pct = span_us > 0 ? 100.0 / span_us : 0;
+    double cpu_total = cs_total - cmd_total - data_total;
+    if (cpu_total < 0) cpu_total = 0;
+    printf("\nFlash bus over %.1f ms:\n", span_us / 1e3);
+    printf("  command overhead  %10.2f ms  %5.1f%%\n", cmd_total / 1e3, cmd_total * pct);
+    printf("  data              %10.2f ms  %5.1f%%\n", data_total / 1e3, data_total * pct);
+    printf("  status polling    %10.2f ms  %5.1f%%  (%lu polls, %.2f ms waiting on busy ops)\n",
+           cls[CLS_POLL].cs_us / 1e3, cls[CLS_POLL].cs_us * pct, (unsigned long)polls_busy_op, busy_wait_us / 1e3);
+    printf("  CPU with CS low   %10.2f ms  %5.1f%%\n", cpu_total / 1e3, cpu_total * pct);
+    printf("  idle between CS   %10.2f ms  %5.1f%%\n", idle_us / 1e3, idle_us * pct);
+    if (queued) printf("  (%lu PIO page-program batches counted as data)\n", (unsigned long)queued);
+
+    if (sd.count) {
+        printf("\nSD bus: %lu transfers, %llu bytes, %.2f ms under transfer, %.2f ms wire\n", (unsigned long)sd.count,
+               (unsigned long long)sd.bytes, sd.cs_us / 1e3, sd.data_us / 1e3);
+    }
+}
+
+// ============================================================================
+// Replay
+// ============================================================================
+
+// One transaction, CS falling at t_us and rising cs_us later (busy times
+// start from the rising edge)
+static void replay_bytes(nor_model_t *nor, const rec_t *r, uint32_t hz) {
+    g_now_ns = r->t_us * 1000u;
+    nor_model_sck(nor, hz);
+    nor_model_select(nor, true);
+    for (uint32_t i = 0; i < r->len; i++) {
+        nor_model_xfer(nor, i < r->nhdr ? r->hdr[i] : TOOL_FILLER);
+    }
+    g_now_ns = (r->t_us + r->cs_us) * 1000u;
+    nor_model_select(nor, false);
+}
+
+static int replay(const rec_t *recs, size_t n, const nor_config_t *cfg, const nor_profile_ref_t *ref) {
+    nor_model_t nor;
+    if (!nor_model_init(&nor, cfg)) {
+        fprintf(stderr, "[ERROR] NOR model init failed\n");
+        return 1;
+    }
+
+    busy_sum_t busy[NOR_OP_COUNT] = {{0}};
+    uint32_t replayed = 0, skipped = 0, slower = 0;
+    nor_op_t pending = NOR_OP_COUNT;
+    uint64_t pending_end_us = 0, pending_model_ns = 0, last_poll_us = 0;
+    bool polled = false;
+
+    for (size_t i = 0; i < n; i++) {
+        const rec_t *r = &recs[i];
+        if (r->flags & SPI_TRACE_F_SD) continue;
+        if ((r->flags & SPI_TRACE_F_QUEUED) || rec_lanes(r) != 1 || r->nhdr == 0) {
+            skipped++;
+            continue;
+        }
+        uint8_t opcode = r->hdr[0];
+        op_class_t cls = op_info(opcode)->cls;
+
+        // First non-poll command after a busy op: the firmware saw the op
+        // finish at its last poll
+        if (pending != NOR_OP_COUNT && cls != CLS_POLL) {
+            if (polled) {
+                busy_sum_t *b = &busy[pending];
+                float ms = (float)(last_poll_us - pending_end_us) / 1e3f;
+                float model_ms = (float)(pending_model_ns - pending_end_us * 1000u) / 1e6f;
+                b->count++;
+                b->measured_ms += ms;
+                b->model_ms += model_ms;
+                if (ms > b->measured_max_ms) b->measured_max_ms = ms;
+                if (ms > cfg->t[pending].max_ms) b->over_max++;
+                if (ms - model_ms > (model_ms > 10.0f ? model_ms * 0.1f : 1.0f)) slower++;
+            }
+            pending = NOR_OP_COUNT;
+        }
+
+        replay_bytes(&nor, r, r->hz ? r->hz : 1000000u);
+        replayed++;
+
+        nor_op_t op = busy_op(opcode);
+        if (op != NOR_OP_COUNT) {
+            pending = op;
+            pending_end_us = r->t_us + r->cs_us;
+            pending_model_ns = nor.busy_until_ns > g_now_ns ? nor.busy_until_ns : pending_end_us * 1000u;
+            polled = false;
+        } else if (pending != NOR_OP_COUNT && cls == CLS_POLL) {
+            last_poll_us = r->t_us;
+            polled = true;
+        }
+    }
+
+    printf("\nReplay against %s %s: %lu transactions, %lu skipped (multi-lane or queued)\n", cfg->company,
+           cfg->model, (unsigned long)replayed, (unsigned long)skipped);
+    printf("%-10s %7s %12s %12s %10s %10s %8s\n", "Busy op", "count", "trace avg", "model avg", "typ", "max",
+           "> max");
+    for (int k = 0; k < NOR_OP_COUNT; k++) {
+        const busy_sum_t *b = &busy[k];
+        if (!b->count) continue;
+        printf("%-10s %7lu %9.3f ms %9.3f ms %7.2f ms %7.2f ms %8lu\n", nor_op_name((nor_op_t)k),
+               (unsigned long)b->count, b->measured_ms / b->count, b->model_ms / b->count, cfg->t[k].typ_ms,
+               cfg->t[k].max_ms, (unsigned long)b->over_max);
+    }
+    if (ref && busy[NOR_OP_PP].count) {
+        printf("Datasheet page program typ %.2f ms, trace %.3f ms\n", ref->typ_pp_ms,
+               busy[NOR_OP_PP].measured_ms / busy[NOR_OP_PP].count);
+    }
+    // Ops the firmware still saw busy well after the model had finished
+    // (1 ms, or 10% of longer ops) mean a part slower than its profile; the
+    // model's busy_ignored counts the opposite (the firmware moved on while
+    // the model was still busy)
+    printf("Ops done well after the model: %lu\n", (unsigned long)slower);
+    nor_model_print_stats(&nor);
+    nor_model_free(&nor);
+    return 0;
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+static void usage(const char *argv0) {
+    printf("Usage: %s TRACE.bin [options]\n"
+           "  --dump              print every record\n"
+           "  --replay            replay the flash records against the NOR model\n"
+           "  --profile CSV[:KEY] model profile from DATASHEET.csv (default: the trace's JEDEC ID)\n"
+           "  --sfdp FILE         raw SFDP table for the model\n",
+           argv0);
+}
+
+int main(int argc, char **argv) {
+    enum { O_DUMP = 1, O_REPLAY, O_PROFILE, O_SFDP };
+    static const struct option longopts[] = {
+        {"dump", no_argument, NULL, O_DUMP},
+        {"replay", no_argument, NULL, O_REPLAY},
+        {"profile", required_argument, NULL, O_PROFILE},
+        {"sfdp", required_argument, NULL, O_SFDP},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    bool do_dump = false, do_replay = false;
+    const char *profile = NULL, *sfdp = NULL;
+    int c;
+    while ((c = getopt_long(argc, argv, "h", longopts, NULL)) != -1) {
+        switch (c) {
+            case O_DUMP: do_dump = true; break;
+            case O_REPLAY: do_replay = true; break;
+            case O_PROFILE: profile = optarg; break;
+            case O_SFDP: sfdp = optarg; break;
+            default: usage(argv[0]); return c == 'h' ? 0 : 2;
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    spi_trace_file_hdr_t hdr;
+    size_t n = 0;
+    rec_t *recs = load_trace(argv[optind], &hdr, &n);
+    if (!recs) return 1;
+
+    if (do_dump) dump(recs, n);
+    summarise(&hdr, recs, n);
+
+    int rc = 0;
+    if (do_replay) {
+        nor_config_t cfg;
+        nor_profile_ref_t ref;
+        bool have_ref = false;
+        nor_config_default(&cfg);
+        if (profile) {
+            char path[256];
+            char jedec[8];
+            snprintf(path, sizeof(path), "%s", profile);
+            char *key = strchr(path, ':');
+            if (key) *key++ = '\0';
+            if (!key && (hdr.jedec[0] | hdr.jedec[1] | hdr.jedec[2])) {
+                snprintf(jedec, sizeof(jedec), "%02X%02X%02X", hdr.jedec[0], hdr.jedec[1], hdr.jedec[2]);
+                key = jedec;
+            }
+            if (!nor_profile_find(path, key, &cfg, &ref)) {
+                fprintf(stderr, "[ERROR] no profile %s in %s\n", key ? key : "(first row)", path);
+                free(recs);
+                return 1;
+            }
+            have_ref = true;
+        }
+        if (sfdp && !nor_config_load_sfdp(&cfg, sfdp)) {
+            free(recs);
+            return 1;
+        }
+        rc = replay(recs, n, &cfg, have_ref ? &ref : NULL);
+    }
+    free(recs);
+    return rc;
+}
@@ -0,0 +1,362 @@
+/*
+ * runrec - PicotoFlash run record decoder and aggregator (host tool)
+ *
+ * Decodes run_records.bin files written by the firmware (run_record.h),
+ * validates header/payload CRCs, resynchronises past torn or corrupt
+ * records, and aggregates all runs per JEDEC ID or per matched model.
+ *
+ *   runrec [--by jedec|model] [--dump] [--csv] run_records.bin [...]
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "run_record.h"
+#include "crc32.h"
+
+namespace {
+
+const char *const kReadLabels[RR_READ_SIZES] = {"1-byte", "page", "sector", "block32k", "block64k"};
+const char *const kEraseLabels[RR_ERASE_TYPES] = {"4K", "32K", "64K"};
+
+struct Record {
+    rr_header_t header;
+    rr_payload_v1_t payload;
+    std::string source;
+};
+
+struct DecodeStats {
+    size_t records = 0;
+    size_t bad_header = 0;
+    size_t bad_payload = 0;
+    size_t unknown_version = 0;
+};
+
+// Running mean/min/max/stddev (Welford)
+struct Stat {
+    size_t n = 0;
+    double mean = 0.0, m2 = 0.0;
+    double lo = 0.0, hi = 0.0;
+
+    void add(double v) {
+        if (n == 0) lo = hi = v;
+        lo = std::min(lo, v);
+        hi = std::max(hi, v);
+        ++n;
+        double d = v - mean;
+        mean += d / static_cast<double>(n);
+        m2 += d * (v - mean);
+    }
+    double stddev() const { return n > 1 ? std::sqrt(m2 / static_cast<double>(n - 1)) : 0.0; }
+};
+
+struct Hist {
+    uint64_t count[RR_HIST_BUCKETS] = {};
+
+    void add(const rr_hist_t &h) {
+        for (int k = 0; k < RR_HIST_BUCKETS; ++k) count[k] += h.count[k];
+    }
+    uint64_t total() const {
+        uint64_t t = 0;
+        for (uint64_t c : count) t += c;
+        return t;
+    }
+    // Upper bound (us) of the bucket holding quantile q
+    double quantile(double q) const {
+        uint64_t t = total();
+        if (t == 0) return 0.0;
+        uint64_t target = static_cast<uint64_t>(std::ceil(q * static_cast<double>(t)));
+        uint64_t acc = 0;
+        for (int k = 0; k < RR_HIST_BUCKETS; ++k) {
+            acc += count[k];
+            if (acc >= target) return std::ldexp(1.0, k);
+        }
+        return std::ldexp(1.0, RR_HIST_BUCKETS);
+    }
+};
+
+struct Group {
+    size_t runs = 0;
+    size_t cached = 0;
+    std::map<std::string, size_t> models;
+    Stat read50, erase64;
+    // clock MHz -> size -> MB/s
+    std::map<int, Stat> read_mbs[RR_READ_SIZES];
+    std::map<int, Hist> read_hist[RR_READ_SIZES];
+    std::map<int, Stat> write_mbs[RR_WRITE_SIZES];
+    Stat erase_ms[RR_ERASE_TYPES];
+    Hist erase_hist[RR_ERASE_TYPES];
+};
+
+std::string jedec_str(const rr_payload_v1_t &p) {
+    char b[16];
+    std::snprintf(b, sizeof b, "%02X %02X %02X", p.jedec[0], p.jedec[1], p.jedec[2]);
+    return b;
+}
+
+std::string model_str(const rr_payload_v1_t &p) {
+    std::string company(p.match_company, strnlen(p.match_company, RR_NAME_LEN));
+    std::string model(p.match_model, strnlen(p.match_model, RR_NAME_LEN));
+    if (model.empty()) return "UNKNOWN";
+    return company.empty() ? model : company + " " + model;
+}
+
+std::vector<uint8_t> read_file(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return {};
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void decode(const std::string &path, std::vector<Record> &out, DecodeStats &st) {
+    std::vector<uint8_t> data = read_file(path);
+    if (data.empty()) {
+        std::fprintf(stderr, "runrec: cannot read %s\n", path.c_str());
+        return;
+    }
+
+    size_t off = 0;
+    while (off + sizeof(rr_header_t) <= data.size()) {
+        rr_header_t h;
+        std::memcpy(&h, &data[off], sizeof h);
+
+        if (h.magic != RUN_RECORD_MAGIC) {
+            off += RUN_RECORD_ALIGN;
+            continue;
+        }
+        if (h.header_crc32 != crc32_calc(&h, offsetof(rr_header_t, header_crc32)) ||
+            h.header_size != sizeof(rr_header_t) || h.record_size == 0 ||
+            h.record_size % RUN_RECORD_ALIGN != 0) {
+            ++st.bad_header;
+            off += RUN_RECORD_ALIGN;
+            continue;
+        }
+        if (h.version != 1 || h.payload_size != sizeof(rr_payload_v1_t)) {
+            ++st.unknown_version;
+            off += h.record_size;
+            continue;
+        }
+        if (off + sizeof(rr_header_t) + h.payload_size > data.size() ||
+            h.payload_crc32 != crc32_calc(&data[off + sizeof(rr_header_t)], h.payload_size)) {
+            ++st.bad_payload;  // Torn write: resync at the next sector
+            off += RUN_RECORD_ALIGN;
+            continue;
+        }
+
+        Record r;
+        r.header = h;
+        std::memcpy(&r.payload, &data[off + sizeof(rr_header_t)], sizeof r.payload);
+        r.source = path;
+        out.push_back(r);
+        ++st.records;
+        off += h.record_size;
+    }
+}
+
+void dump(const Record &r) {
+    const rr_payload_v1_t &p = r.payload;
+    std::printf("#%u %04u-%02u-%02u %02u:%02u:%02u  JEDEC %s  UID ", r.header.sequence,
+                p.year, p.month, p.day, p.hour, p.min, p.sec, jedec_str(p).c_str());
+    for (int i = 0; i < p.uid_len; ++i) std::printf("%02X", p.uid[i]);
+    std::printf("  %s (%.1f%%)%s\n", model_str(p).c_str(), p.match_confidence,
+                (r.header.flags & RR_FLAG_CACHED) ? " [cached]" : "");
+    std::printf("  read50=%.2f MB/s  erase64k=%.1f ms  cap=%.1f Mbit", p.read_speed_50mhz,
+                p.erase_64k_ms, p.capacity_mbit);
+    if (r.header.flags & RR_FLAG_IMAGE_VALID) {
+        std::printf("  image=%u B crc=%08X", p.image_bytes, p.image_crc32);
+    }
+    std::printf("\n");
+    for (int c = 0; c < p.read_count && c < RR_READ_CLOCKS; ++c) {
+        if (!p.read[c].valid) continue;
+        unsigned lanes = p.read[c].lanes ? p.read[c].lanes : 0x11;
+        std::printf("  read  %3u MHz %u-%u-%u:", p.read[c].clock_mhz, 1u, lanes >> 4, lanes & 0xF);
+        for (int s = 0; s < RR_READ_SIZES; ++s) std::printf(" %8.4f", p.read[c].size[s].mb_s);
+        std::printf("  MB/s\n");
+    }
+    for (int c = 0; c < p.write_count && c < RR_WRITE_CLOCKS; ++c) {
+        if (!p.write[c].valid) continue;
+        std::printf("  write %3u MHz:", p.write[c].clock_mhz_actual);
+        for (int s = 0; s < p.write[c].num_results && s < RR_WRITE_SIZES; ++s) {
+            std::printf(" %8.4f", p.write[c].size[s].mb_s);
+        }
+        std::printf("  MB/s\n");
+    }
+    if (p.erase_valid) {
+        std::printf("  erase @%u MHz:", p.erase_clock_mhz);
+        for (int t = 0; t < RR_ERASE_TYPES; ++t) {
+            std::printf(" %s=%.1fms", kEraseLabels[t], p.erase[t].avg_ms);
+        }
+        std::printf("\n");
+    }
+}
+
+void accumulate(Group &g, const Record &r) {
+    const rr_payload_v1_t &p = r.payload;
+    ++g.runs;
+    if (r.header.flags & RR_FLAG_CACHED) ++g.cached;
+    ++g.models[model_str(p)];
+    if (p.read_speed_50mhz > 0) g.read50.add(p.read_speed_50mhz);
+    if (p.erase_64k_ms > 0) g.erase64.add(p.erase_64k_ms);
+
+    for (int c = 0; c < p.read_count && c < RR_READ_CLOCKS; ++c) {
+        const rr_read_clock_t &rc = p.read[c];
+        if (!rc.valid) continue;
+        if (rc.lanes > 0x11) continue;     // Per-clock tables are single-lane
+        for (int s = 0; s < RR_READ_SIZES; ++s) {
+            g.read_mbs[s][rc.clock_mhz].add(rc.size[s].mb_s);
+            g.read_hist[s][rc.clock_mhz].add(rc.size[s].hist);
+        }
+    }
+    for (int c = 0; c < p.write_count && c < RR_WRITE_CLOCKS; ++c) {
+        const rr_write_clock_t &wc = p.write[c];
+        if (!wc.valid) continue;
+        for (int s = 0; s < wc.num_results && s < RR_WRITE_SIZES; ++s) {
+            g.write_mbs[s][wc.clock_mhz_actual].add(wc.size[s].mb_s);
+        }
+    }
+    if (p.erase_valid) {
+        for (int t = 0; t < RR_ERASE_TYPES; ++t) {
+            if (p.erase[t].avg_ms > 0) g.erase_ms[t].add(p.erase[t].avg_ms);
+            g.erase_hist[t].add(p.erase[t].hist);
+        }
+    }
+}
+
+void print_group(const std::string &key, const Group &g) {
+    std::printf("\n=== %s ===\n", key.c_str());
+    std::printf("runs: %zu (cached %zu)\n", g.runs, g.cached);
+    if (g.models.size() > 1 || (g.models.size() == 1 && g.models.begin()->first != key)) {
+        std::printf("matched as:");
+        for (const auto &m : g.models) std::printf("  %s x%zu", m.first.c_str(), m.second);
+        std::printf("\n");
+    }
+    if (g.read50.n) {
+        std::printf("read 50MHz (4KB): mean %.3f  sd %.3f  min %.3f  max %.3f MB/s\n",
+                    g.read50.mean, g.read50.stddev(), g.read50.lo, g.read50.hi);
+    }
+    if (g.erase64.n) {
+        std::printf("erase 64KB:       mean %.1f  sd %.1f  min %.1f  max %.1f ms\n",
+                    g.erase64.mean, g.erase64.stddev(), g.erase64.lo, g.erase64.hi);
+    }
+
+    if (!g.read_mbs[0].empty()) {
+        std::printf("\nread MB/s (mean)   ");
+        for (const char *l : kReadLabels) std::printf(" %9s", l);
+        std::printf("\n");
+        for (const auto &kv : g.read_mbs[0]) {
+            int mhz = kv.first;
+            std::printf("  %3d MHz (n=%4zu)  ", mhz, kv.second.n);
+            for (int s = 0; s < RR_READ_SIZES; ++s) {
+                auto it = g.read_mbs[s].find(mhz);
+                std::printf(" %9.4f", it != g.read_mbs[s].end() ? it->second.mean : 0.0);
+            }
+            std::printf("\n");
+        }
+        std::printf("read latency p50/p99 (us, sector):");
+        for (const auto &kv : g.read_hist[2]) {
+            std::printf("  %dMHz %.0f/%.0f", kv.first, kv.second.quantile(0.5), kv.second.quantile(0.99));
+        }
+        std::printf("\n");
+    }
+
+    if (!g.write_mbs[0].empty()) {
+        std::printf("\nwrite MB/s (mean)  ");
+        for (const char *l : kReadLabels) std::printf(" %9s", l);
+        std::printf("\n");
+        for (const auto &kv : g.write_mbs[0]) {
+            int mhz = kv.first;
+            std::printf("  %3d MHz (n=%4zu)  ", mhz, kv.second.n);
+            for (int s = 0; s < RR_WRITE_SIZES; ++s) {
+                auto it = g.write_mbs[s].find(mhz);
+                std::printf(" %9.4f", it != g.write_mbs[s].end() ? it->second.mean : 0.0);
+            }
+            std::printf("\n");
+        }
+    }
+
+    bool any_erase = false;
+    for (const Stat &s : g.erase_ms) any_erase |= (s.n > 0);
+    if (any_erase) {
+        std::printf("\nerase   |   mean(ms) |     sd |   min |   max | p50(us) | p99(us)\n");
+        for (int t = 0; t < RR_ERASE_TYPES; ++t) {
+            const Stat &s = g.erase_ms[t];
+            if (!s.n) continue;
+            std::printf("%-7s | %10.1f | %6.1f | %5.1f | %5.1f | %7.0f | %7.0f\n", kEraseLabels[t],
+                        s.mean, s.stddev(), s.lo, s.hi,
+                        g.erase_hist[t].quantile(0.5), g.erase_hist[t].quantile(0.99));
+        }
+    }
+}
+
+void print_csv(const std::map<std::string, Group> &groups) {
+    std::printf("key,runs,cached,read50_mean,read50_sd,read50_min,read50_max,"
+                "erase64_mean,erase64_sd,erase4k_mean,erase32k_mean\n");
+    for (const auto &kv : groups) {
+        const Group &g = kv.second;
+        std::printf("\"%s\",%zu,%zu,%.4f,%.4f,%.4f,%.4f,%.2f,%.2f,%.2f,%.2f\n", kv.first.c_str(),
+                    g.runs, g.cached, g.read50.mean, g.read50.stddev(), g.read50.lo, g.read50.hi,
+                    g.erase64.mean, g.erase64.stddev(), g.erase_ms[0].mean, g.erase_ms[1].mean);
+    }
+}
+
+void usage() {
+    std::fprintf(stderr, "usage: runrec [--by jedec|model] [--dump] [--csv] run_records.bin [...]\n");
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    bool by_model = false, do_dump = false, csv = false;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--by" && i + 1 < argc) {
+            std::string v = argv[++i];
+            if (v == "model") by_model = true;
+            else if (v != "jedec") { usage(); return 2; }
+        } else if (a == "--dump") {
+            do_dump = true;
+        } else if (a == "--csv") {
+            csv = true;
+        } else if (a == "-h" || a == "--help") {
+            usage();
+            return 0;
+        } else {
+            files.push_back(a);
+        }
+    }
+    if (files.empty()) {
+        usage();
+        return 2;
+    }
+
+    std::vector<Record> records;
+    DecodeStats st;
+    for (const std::string &f : files) decode(f, records, st);
+
+    std::fprintf(stderr, "runrec: %zu records, %zu bad headers, %zu bad payloads, %zu unknown versions\n",
+                 st.records, st.bad_header, st.bad_payload, st.unknown_version);
+
+    if (do_dump) {
+        for (const Record &r : records) dump(r);
+    }
+
+    std::map<std::string, Group> groups;
+    for (const Record &r : records) {
+        accumulate(groups[by_model ? model_str(r.payload) : jedec_str(r.payload)], r);
+    }
+
+    if (csv) {
+        print_csv(groups);
+    } else {
+        for (const auto &kv : groups) print_group(kv.first, kv.second);
+    }
+    return (st.bad_header || st.bad_payload) ? 1 : 0;
+}
@@ -3,6 +3,10 @@
 // BATCH TIMING VERSION - Times entire batch then averages
 
 #include "write.h"
+#include "pio_pp.h"
+#include "spi_trace.h"
+#include "span_trace.h"
+#include "buf_pool.h"
 #include "pico/stdlib.h"
 #include "hardware/spi.h"
 #include "hardware/gpio.h"
@@ -14,22 +18,40 @@
 #define PAGE_SIZE 256
 #define SECTOR_4K 4096
 
+// Global results storage
+write_bench_capture_t g_write_results[WRITE_MAX_CLOCKS];
+int g_write_result_count = 0;
+
+// PIO transport for queued page programs (NULL: CPU-driven PL022)
+static pio_spi_t *g_write_pio = NULL;
+
+void write_reset_results(void) {
+    g_write_result_count = 0;
+    memset(g_write_results, 0, sizeof(g_write_results));
+}
+
+void write_bench_set_pio(pio_spi_t *pio) {
+    g_write_pio = pio;
+}
+
 // Internal flash command functions
-static inline void cs_low(uint8_t pin) { gpio_put(pin, 0); }
-static inline void cs_high(uint8_t pin) { gpio_put(pin, 1); }
+static inline void cs_low(uint8_t pin) { gpio_put(pin, 0); spi_trace_cs(true); }
+static inline void cs_high(uint8_t pin) { spi_trace_cs(false); gpio_put(pin, 1); }
+static inline void spi_tx(spi_inst_t *spi, const uint8_t *b, size_t n) { spi_trace_pl022(spi, b, n); spi_write_blocking(spi, b, n); }
+static inline void spi_rx(spi_inst_t *spi, uint8_t *b, size_t n) { spi_trace_pl022(spi, NULL, n); spi_read_blocking(spi, 0x00, b, n); }
 
 static void flash_wren(spi_inst_t *spi, uint8_t cs) {
     uint8_t cmd = 0x06;
     cs_low(cs);
-    spi_write_blocking(spi, &cmd, 1);
+    spi_tx(spi, &cmd, 1);
     cs_high(cs);
 }
 
 static uint8_t flash_rdsr(spi_inst_t *spi, uint8_t cs) {
     uint8_t cmd = 0x05, status = 0;
     cs_low(cs);
-    spi_write_blocking(spi, &cmd, 1);
-    spi_read_blocking(spi, 0x00, &status, 1);
+    spi_tx(spi, &cmd, 1);
+    spi_rx(spi, &status, 1);
     cs_high(cs);
     return status;
 }
@@ -49,7 +71,7 @@ static void flash_erase_sector(spi_inst_t *spi, uint8_t cs, uint32_t addr) {
     flash_wren(spi, cs);
     uint8_t cmd[4] = {0x20, (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)addr};
     cs_low(cs);
-    spi_write_blocking(spi, cmd, 4);
+    spi_tx(spi, cmd, 4);
     cs_high(cs);
 }
 
@@ -59,8 +81,8 @@ static void flash_page_program(spi_inst_t *spi, uint8_t cs, uint32_t addr,
     flash_wren(spi, cs);
     uint8_t cmd[4] = {0x02, (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)addr};
     cs_low(cs);
-    spi_write_blocking(spi, cmd, 4);
-    spi_write_blocking(spi, data, len);
+    spi_tx(spi, cmd, 4);
+    spi_tx(spi, data, len);
     cs_high(cs);
 }
 
@@ -68,8 +90,8 @@ static void flash_read(spi_inst_t *spi, uint8_t cs, uint32_t addr,
                       uint8_t *buf, size_t len) {
     uint8_t cmd[4] = {0x03, (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)addr};
     cs_low(cs);
-    spi_write_blocking(spi, cmd, 4);
-    spi_read_blocking(spi, 0x00, buf, len);
+    spi_tx(spi, cmd, 4);
+    spi_rx(spi, buf, len);
     cs_high(cs);
 }
 
@@ -87,8 +109,9 @@ bool write_bench_run(void *spi_inst, uint8_t cs_pin, int mhz_req,
     
     spi_inst_t *spi = (spi_inst_t *)spi_inst;
     
-    // Set SPI clock
+    // Set SPI clock (erase + verify stay on the PL022)
     uint32_t actual_hz = spi_set_baudrate(spi, (uint32_t)mhz_req * 1000000);
+    if (g_write_pio) actual_hz = pio_spi_set_hz(g_write_pio, (uint32_t)mhz_req * 1000000);
     int actual_mhz = (int)(actual_hz / 1000000);
     
     capture->clock_mhz_requested = mhz_req;
@@ -96,10 +119,11 @@ bool write_bench_run(void *spi_inst, uint8_t cs_pin, int mhz_req,
     capture->valid = true;
     capture->num_results = 0;
     
-    printf("  [SPI] Write bench: req=%d MHz, actual=%d MHz\n", mhz_req, actual_mhz);
+    printf("  [SPI] Write bench: req=%d MHz, actual=%d MHz (%s)\n", mhz_req, actual_mhz,
+           g_write_pio ? "PIO+DMA queue" : "SPI0");
     
     // Allocate test buffer
-    uint8_t *test_buf = malloc(65536);
+    uint8_t *test_buf = buf_pool_get(65536, "write_bench");
     if (!test_buf) {
         printf("  [ERR] Failed to allocate test buffer\n");
         capture->valid = false;
@@ -121,6 +145,7 @@ bool write_bench_run(void *spi_inst, uint8_t cs_pin, int mhz_req,
         result->size_bytes = sz;
         result->label = labels[si];
         result->verify_ok = true;
+        bench_hist_reset(&result->hist);
         
         // Calculate sectors needed
         uint32_t bytes_needed = sz * iterations;
@@ -130,18 +155,45 @@ bool write_bench_run(void *spi_inst, uint8_t cs_pin, int mhz_req,
                (unsigned)sectors_needed, labels[si]);
         
         // Erase sectors
+        span_begin_n("write_prep_erase", sectors_needed);
         for (uint32_t s = 0; s < sectors_needed; s++) {
             flash_erase_sector(spi, cs_pin, base_addr + (s * SECTOR_4K));
             if (!flash_wait_busy(spi, cs_pin, 5000)) {
                 printf("  [WARN] Erase timeout at sector %u\n", (unsigned)s);
             }
         }
+        span_end("write_prep_erase");
+        
+        // Hand the pins to the page-program engine for the timed part only
+        bool queued = false;
+        if (g_write_pio) {
+            pio_spi_attach(g_write_pio);
+            queued = pio_pp_begin(g_write_pio, cs_pin);
+            if (!queued) {
+                pio_spi_detach(g_write_pio);
+                printf("  [WARN] PIO page-program engine unavailable, using SPI0\n");
+            }
+        }
         
         // TIME THE ENTIRE BATCH OF WRITE OPERATIONS
+        span_begin_n("write_batch", (uint32_t)sz);
         uint32_t addr = base_addr;
         uint64_t batch_start = time_us_64();
+        uint64_t iter_start = batch_start;
         
         for (int iter = 0; iter < iterations; iter++) {
+            if (queued) {
+                // Whole iteration as one DMA chain; the CPU sleeps until it ends
+                if (!pio_pp_write(addr, test_buf, sz)) {
+                    printf("  [WARN] Write timeout at 0x%06X\n", (unsigned)addr);
+                }
+                addr += sz;
+                uint64_t iter_end = time_us_64();
+                bench_hist_add(&result->hist, (uint32_t)(iter_end - iter_start));
+                iter_start = iter_end;
+                continue;
+            }
+            
             // Write data in page-sized chunks
             size_t remaining = sz;
             uint32_t current_addr = addr;
@@ -162,10 +214,20 @@ bool write_bench_run(void *spi_inst, uint8_t cs_pin, int mhz_req,
             }
             
             addr += sz;
+            
+            uint64_t iter_end = time_us_64();
+            bench_hist_add(&result->hist, (uint32_t)(iter_end - iter_start));
+            iter_start = iter_end;
         }
         
-        uint64_t batch_end = time_us_64();
+        uint64_t batch_end = iter_start;
         uint32_t total_us = (uint32_t)(batch_end - batch_start);
+        span_end("write_batch");
+        
+        if (queued) {
+            pio_pp_end();
+            pio_spi_detach(g_write_pio);
+        }
         
         // Calculate average time per write
         double avg_us = (double)total_us / (double)iterations;
@@ -201,7 +263,7 @@ bool write_bench_run(void *spi_inst, uint8_t cs_pin, int mhz_req,
         capture->num_results++;
     }
     
-    free(test_buf);
+    buf_pool_put(test_buf);
     
     return true;
 }
@@ -222,12 +284,18 @@ int write_bench_run_multi_clock(void *spi_inst, uint8_t cs_pin,
     for (int i = 0; i < num_clocks; i++) {
         printf("\n=== WRITE BENCHMARK @ %d MHz (requested) ===\n", clocks[i]);
         
-        if (write_bench_run(spi_inst, cs_pin, clocks[i], 
-                           base_addr + (i * 0x20000), // Offset each test
-                           default_sizes, default_labels, num_sizes,
-                           WRITE_ITERS_DEFAULT, &captures[i])) {
+        span_begin_n("write_bench", (uint32_t)clocks[i]);
+        bool ran = write_bench_run(spi_inst, cs_pin, clocks[i],
+                                   base_addr + (i * 0x20000), // Offset each test
+                                   default_sizes, default_labels, num_sizes,
+                                   WRITE_ITERS_DEFAULT, &captures[i]);
+        span_end("write_bench");
+        if (ran) {
             write_bench_print_results(&captures[i]);
             success_count++;
+            if (g_write_result_count < WRITE_MAX_CLOCKS) {
+                g_write_results[g_write_result_count++] = captures[i];
+            }
         } else {
             printf("  [ERR] Write benchmark failed at %d MHz\n", clocks[i]);
         }
@@ -7,10 +7,13 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include "bench_hist.h"
+#include "pio_spi.h"
 
 // Write benchmark configuration
 #define WRITE_ITERS_DEFAULT 10
 #define WRITE_TEST_SIZES 5
+#define WRITE_MAX_CLOCKS 4
 
 // Statistics structure for write benchmarks
 typedef struct {
@@ -26,6 +29,7 @@ typedef struct {
     size_t size_bytes;
     const char *label;
     write_stats_t stats;
+    bench_hist_t hist;          // Per-write latency distribution
     bool verify_ok;
 } write_bench_result_t;
 
@@ -38,8 +42,25 @@ typedef struct {
     int num_results;
 } write_bench_capture_t;
 
+// Results of the last write_bench_run_multi_clock()
+extern write_bench_capture_t g_write_results[WRITE_MAX_CLOCKS];
+extern int g_write_result_count;
+
 // Function prototypes
 
+/**
+ * Clear the stored write benchmark results
+ */
+void write_reset_results(void);
+
+/**
+ * Program pages through the PIO/DMA page-program engine (pio_pp.c)
+ * instead of the PL022; NULL switches back
+ *
+ * @param pio PIO transport on the same flash pins (e.g., &g_flash_pio)
+ */
+void write_bench_set_pio(pio_spi_t *pio);
+
 /**
  * Run write benchmarks at specified clock speed
  * 